@@ -0,0 +1,88 @@
+#!/bin/sh
+
+# Compares the orders in which the items of a folder can be split (listing, inode, disk)
+# on a tree whose forks have to be read from the disk.
+#
+# usage: disk_order.sh <goldin_bench> [<folder of the image>] [-- <goldin_bench options>...]
+#
+# Must be run as root: the image is loop-mounted (ext4 on Linux, HFS+ with hdiutil on Mac OS X)
+# and the caches of the system are dropped before every split (goldin_bench -C). Put the image
+# on the disk to measure (e.g. a rotating disk or a network volume): on flash storage the three
+# orders should take about the same time. Every order is run 3 times on a fresh tree generated
+# with the same seed.
+
+BENCH="$1"
+FOLDER="/tmp"
+
+if [ -z "$BENCH" ]; then
+	echo "usage: $0 <goldin_bench> [<folder of the image>] [-- <goldin_bench options>...]" >&2
+	exit 1
+fi
+
+shift
+
+if [ $# -gt 0 ] && [ "$1" != "--" ]; then
+	FOLDER="$1"
+	shift
+fi
+
+if [ "$1" = "--" ]; then
+	shift
+fi
+
+OPTIONS="$*"
+
+if [ -z "$OPTIONS" ]; then
+	OPTIONS="-d 2 -f 8 -n 1000 -r 3000:60 -i 30"
+fi
+
+WORKDIR=`mktemp -d "$FOLDER/goldin_disk_order.XXXXXX"` || exit 1
+MOUNTPOINT="$WORKDIR/mnt"
+
+mkdir "$MOUNTPOINT" || exit 1
+
+if [ "`uname`" = "Darwin" ]; then
+	IMAGE="$WORKDIR/bench.sparseimage"
+
+	hdiutil create -quiet -size 8g -type SPARSE -fs HFS+J -volname GoldinBench "$IMAGE" || exit 1
+	hdiutil attach -quiet -nobrowse -mountpoint "$MOUNTPOINT" "$IMAGE" || exit 1
+
+	cleanup()
+	{
+		hdiutil detach -quiet "$MOUNTPOINT"
+		rm -rf "$WORKDIR"
+	}
+else
+	IMAGE="$WORKDIR/bench.img"
+
+	truncate -s 8G "$IMAGE" || exit 1
+	mkfs.ext4 -q -F "$IMAGE" || exit 1
+	mount -o loop "$IMAGE" "$MOUNTPOINT" || exit 1
+
+	cleanup()
+	{
+		umount "$MOUNTPOINT"
+		rm -rf "$WORKDIR"
+	}
+fi
+
+trap cleanup EXIT
+
+printf "%10s %12s %14s %16s\n" "order" "run" "seconds" "files/sec"
+
+for ORDER in listing inode disk; do
+
+	RUN=1
+
+	while [ $RUN -le 3 ]; do
+
+		RESULT=`"$BENCH" $OPTIONS -O $ORDER -C -o "$MOUNTPOINT"` || exit 1
+
+		ELAPSED=`echo "$RESULT" | awk -F'[:,]' '/"seconds"/ { print $2 }'`
+		FILES_PER_SEC=`echo "$RESULT" | awk -F'[:,]' '/"files_per_sec"/ { print $2 }'`
+
+		printf "%10s %12d %14.3f %16.1f\n" "$ORDER" "$RUN" "$ELAPSED" "$FILES_PER_SEC"
+
+		RUN=`expr $RUN + 1`
+	done
+done
@@ -0,0 +1,107 @@
+#!/bin/sh
+
+# Measures the time goldin needs to split a single folder whose items all need a ._ file,
+# for an increasing number of items.
+#
+# usage: folder_scaling.sh <goldin> [<reference goldin>] [-- <number of items>...]
+#
+# The folders are created on a sparse HFS+ disk image (goldin only works on hfs volumes).
+# Every run is made on a fresh copy of the folder so that all the binaries have the same
+# amount of work to do. With a reference binary (e.g. a build of the previous revision),
+# the two columns can be compared directly.
+
+GOLDIN="$1"
+REFERENCE=""
+
+if [ -z "$GOLDIN" ]; then
+	echo "usage: $0 <goldin> [<reference goldin>] [-- <number of items>...]" >&2
+	exit 1
+fi
+
+shift
+
+if [ $# -gt 0 ] && [ "$1" != "--" ]; then
+	REFERENCE="$1"
+	shift
+fi
+
+if [ "$1" = "--" ]; then
+	shift
+fi
+
+COUNTS="$*"
+
+if [ -z "$COUNTS" ]; then
+	COUNTS="1000 2000 5000 10000 20000 50000"
+fi
+
+WORKDIR=`mktemp -d /tmp/goldin_bench.XXXXXX` || exit 1
+IMAGE="$WORKDIR/bench.sparseimage"
+
+hdiutil create -quiet -size 4g -type SPARSE -fs HFS+J -volname GoldinBench "$IMAGE" || exit 1
+
+MOUNTPOINT=`hdiutil attach -nobrowse "$IMAGE" | awk -F'\t' '/GoldinBench/ { print $NF }'`
+
+if [ -z "$MOUNTPOINT" ]; then
+	echo "Unable to mount the disk image" >&2
+	rm -rf "$WORKDIR"
+	exit 1
+fi
+
+cleanup()
+{
+	hdiutil detach -quiet "$MOUNTPOINT"
+	rm -rf "$WORKDIR"
+}
+
+trap cleanup EXIT
+
+# Template item: type TEXT, creator ttxt
+
+touch "$MOUNTPOINT/template"
+xattr -wx com.apple.FinderInfo "5445585474747874000000000000000000000000000000000000000000000000" "$MOUNTPOINT/template"
+
+run_once()
+{
+	# $1 binary, $2 source folder
+
+	rm -rf "$MOUNTPOINT/run"
+	ditto "$2" "$MOUNTPOINT/run"
+
+	START=`perl -MTime::HiRes=time -e 'printf "%.6f", time'`
+	"$1" "$MOUNTPOINT/run" > /dev/null || return 1
+	END=`perl -MTime::HiRes=time -e 'printf "%.6f", time'`
+
+	echo "$START $END" | awk '{ printf "%.3f", $2-$1 }'
+}
+
+if [ -n "$REFERENCE" ]; then
+	printf "%10s %14s %14s %20s %20s\n" "items" "reference (s)" "goldin (s)" "reference (us/item)" "goldin (us/item)"
+else
+	printf "%10s %14s %16s\n" "items" "goldin (s)" "goldin (us/item)"
+fi
+
+for COUNT in $COUNTS; do
+
+	SOURCE="$MOUNTPOINT/source_$COUNT"
+
+	mkdir "$SOURCE"
+
+	i=0
+	while [ $i -lt $COUNT ]; do
+		cp -p "$MOUNTPOINT/template" "$SOURCE/item_$i"
+		i=`expr $i + 1`
+	done
+
+	TIME=`run_once "$GOLDIN" "$SOURCE"` || exit 1
+
+	if [ -n "$REFERENCE" ]; then
+		REFERENCE_TIME=`run_once "$REFERENCE" "$SOURCE"` || exit 1
+
+		echo "$COUNT $REFERENCE_TIME $TIME" | awk '{ printf "%10d %14.3f %14.3f %20.1f %20.1f\n", $1, $2, $3, $2*1000000/$1, $3*1000000/$1 }'
+	else
+		echo "$COUNT $TIME" | awk '{ printf "%10d %14.3f %16.1f\n", $1, $2, $2*1000000/$1 }'
+	fi
+
+	rm -rf "$SOURCE"
+done
@@ -0,0 +1,808 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: goldin_bench.c
+              Project: goldin
+
+    Notes:
+
+    o Generates a reproducible tree (same seed, same tree), splits it with the split engine and prints the
+      throughput as JSON:
+    
+      files/sec        items found while walking the tree, per second
+      MB/sec           bytes written to the ._ files, per second
+      syscalls/file    the "calls per item" goldin counter
+      peak RSS         of the whole process, in kilobytes
+    
+    o With -D, the tree is first scanned with a dry run (nothing is written) and the time of the scan is reported with
+      its estimates and how much faster it was than the split. syscalls/file then covers both runs.
+    
+    o With -C, the caches of the system are dropped after the tree is generated (and between the dry run and the split)
+      so that the forks are read from the disk. It requires root. With -O, the items of every folder are split in
+      inode or disk order (see disk_order.sh).
+    
+    o With -b or -F, the split is throttled (GoldinThrottle.h). The ._ files and bytes written are sampled every 100 ms
+      and the rates of the samples are reported with the cap: mean, standard deviation relative to the mean (jitter)
+      and highest rate over a sample (see rate_limit.sh). The first sample and the last one are left out: they include
+      the start and the end of the run.
+    
+    o The FinderInfo and the resource forks are written as extended attributes (user.com.apple.* on Linux). Most Linux
+      file systems limit the size of an extended attribute (ext4: a block, i.e. 4 KB), so are the resource fork sizes.
+    
+    o To build it:
+    
+      Linux:     cc -O2 -I.. -o goldin_bench goldin_bench.c ../Goldin*.c -lpthread -lm
+      Mac OS X:  cc -O2 -I.. -o goldin_bench goldin_bench.c ../Goldin*.c -framework CoreServices
+*/
+
+#include "Goldin.h"
+#include "GoldinAppleDouble.h"
+#include "GoldinAsync.h"
+#include "GoldinBackend.h"
+#include "GoldinCounters.h"
+#include "GoldinEstimate.h"
+#include "GoldinXattr.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+#define GOLDIN_BENCH_MAX_FORK_SIZES		16
+
+#define GOLDIN_BENCH_SAMPLE_INTERVAL	100000		/* us */
+
+typedef struct _GoldinBenchForkSize
+{
+	uint64_t size;
+	double fraction;
+	
+} GoldinBenchForkSize;
+
+typedef struct _GoldinBenchParameters
+{
+	long depth;
+	long fanOut;
+	long filesPerFolder;
+	double finderInfoFraction;
+	
+	GoldinBenchForkSize forkSizes[GOLDIN_BENCH_MAX_FORK_SIZES];
+	int numberOfForkSizes;
+	
+	uint64_t seed;
+	
+} GoldinBenchParameters;
+
+typedef struct _GoldinBenchTree
+{
+	uint64_t files;
+	uint64_t folders;
+	uint64_t filesWithFinderInfo;
+	uint64_t filesWithResourceFork;
+	uint64_t resourceForkBytes;
+	
+} GoldinBenchTree;
+
+typedef struct _GoldinBenchSample
+{
+	double time;
+	uint64_t files;
+	uint64_t bytes;
+	
+} GoldinBenchSample;
+
+typedef struct _GoldinBenchSampler
+{
+	pthread_t thread;
+	volatile int stop;
+	
+	GoldinBenchSample * samples;
+	size_t count;
+	size_t capacity;
+	
+} GoldinBenchSampler;
+
+typedef struct _GoldinBenchRate
+{
+	double mean;
+	double jitter;				/* Standard deviation divided by the mean */
+	double maximum;
+	
+} GoldinBenchRate;
+
+static uint64_t sRandomState=1;
+
+/* xorshift64*: the tree only depends on the seed */
+
+static uint64_t GoldinBenchRandom(void)
+{
+	sRandomState^=sRandomState>>12;
+	sRandomState^=sRandomState<<25;
+	sRandomState^=sRandomState>>27;
+	
+	return sRandomState*0x2545F4914F6CDD1DULL;
+}
+
+static double GoldinBenchRandomUnit(void)
+{
+	return (GoldinBenchRandom()>>11)*(1.0/9007199254740992.0);
+}
+
+static double GoldinBenchGetTime(void)
+{
+	struct timeval tTime;
+	
+	gettimeofday(&tTime,NULL);
+	
+	return tTime.tv_sec+tTime.tv_usec/1000000.0;
+}
+
+/* ._ files written or linked, and their bytes */
+
+static uint64_t GoldinBenchGetWrittenFiles(void)
+{
+	return GoldinCounterGetValue(kGoldinCounterSplitItems)+GoldinCounterGetValue(kGoldinCounterLinkedItems);
+}
+
+static uint64_t GoldinBenchGetWrittenBytes(void)
+{
+	return GoldinCounterGetValue(kGoldinCounterSplitItems)*GOLDIN_APPLEDOUBLE_HEADER_SIZE+
+		   GoldinCounterGetValue(kGoldinCounterBytesBuffered);
+}
+
+static void * GoldinBenchSamplerRun(void * inSampler)
+{
+	GoldinBenchSampler * tSampler=(GoldinBenchSampler *) inSampler;
+	
+	while (tSampler->stop==0)
+	{
+		if (tSampler->count==tSampler->capacity)
+		{
+			size_t tCapacity=(tSampler->capacity==0) ? 1024 : tSampler->capacity*2;
+			GoldinBenchSample * tSamples=(GoldinBenchSample *) realloc(tSampler->samples,tCapacity*sizeof(GoldinBenchSample));
+			
+			if (tSamples==NULL)
+				break;
+			
+			tSampler->samples=tSamples;
+			tSampler->capacity=tCapacity;
+		}
+		
+		tSampler->samples[tSampler->count].time=GoldinBenchGetTime();
+		tSampler->samples[tSampler->count].files=GoldinBenchGetWrittenFiles();
+		tSampler->samples[tSampler->count].bytes=GoldinBenchGetWrittenBytes();
+		tSampler->count++;
+		
+		usleep(GOLDIN_BENCH_SAMPLE_INTERVAL);
+	}
+	
+	return NULL;
+}
+
+/* The rates between the samples, without the first and last intervals. Returns -1 if there are not enough samples */
+
+static int GoldinBenchGetRate(const GoldinBenchSampler * inSampler,Boolean inBytes,GoldinBenchRate * outRate)
+{
+	double tSum=0;
+	double tSquareSum=0;
+	size_t tCount=0;
+	size_t i;
+	
+	memset(outRate,0,sizeof(GoldinBenchRate));
+	
+	for(i=2;i+1<inSampler->count;i++)
+	{
+		const GoldinBenchSample * tPrevious=&inSampler->samples[i-1];
+		const GoldinBenchSample * tSample=&inSampler->samples[i];
+		double tRate;
+		
+		if (tSample->time<=tPrevious->time)
+			continue;
+		
+		tRate=((inBytes==TRUE) ? (double) (tSample->bytes-tPrevious->bytes) : (double) (tSample->files-tPrevious->files))/(tSample->time-tPrevious->time);
+		
+		tSum+=tRate;
+		tSquareSum+=tRate*tRate;
+		
+		if (tRate>outRate->maximum)
+			outRate->maximum=tRate;
+		
+		tCount++;
+	}
+	
+	if (tCount<2)
+		return -1;
+	
+	outRate->mean=tSum/tCount;
+	
+	if (outRate->mean>0)
+	{
+		double tVariance=tSquareSum/tCount-outRate->mean*outRate->mean;
+		
+		outRate->jitter=(tVariance>0) ? sqrt(tVariance)/outRate->mean : 0;
+	}
+	
+	return 0;
+}
+
+/* size:percent[,size:percent...] */
+
+static int GoldinBenchParseForkSizes(const char * inString,GoldinBenchParameters * outParameters)
+{
+	const char * tString=inString;
+	double tTotal=0;
+	
+	outParameters->numberOfForkSizes=0;
+	
+	while (*tString!='\0')
+	{
+		char * tEnd;
+		GoldinBenchForkSize * tForkSize;
+		
+		if (outParameters->numberOfForkSizes==GOLDIN_BENCH_MAX_FORK_SIZES)
+			return -1;
+		
+		tForkSize=&outParameters->forkSizes[outParameters->numberOfForkSizes];
+		
+		tForkSize->size=strtoull(tString,&tEnd,10);
+		
+		if (tEnd==tString || *tEnd!=':' || tForkSize->size==0)
+			return -1;
+		
+		tString=tEnd+1;
+		
+		tForkSize->fraction=strtod(tString,&tEnd)/100.0;
+		
+		if (tEnd==tString || tForkSize->fraction<0 || (*tEnd!=',' && *tEnd!='\0'))
+			return -1;
+		
+		tTotal+=tForkSize->fraction;
+		
+		tString=(*tEnd==',') ? tEnd+1 : tEnd;
+		
+		outParameters->numberOfForkSizes++;
+	}
+	
+	return (tTotal>1.0) ? -1 : 0;
+}
+
+static int GoldinBenchCreateFile(const char * inPath,const GoldinBenchParameters * inParameters,GoldinBenchTree * ioTree)
+{
+	static const char sDataFork[]="goldin\n";
+	double tDraw;
+	int i;
+	int tDescriptor;
+	
+	tDescriptor=open(inPath,O_WRONLY|O_CREAT|O_EXCL,S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	
+	if (tDescriptor==-1)
+		return -1;
+	
+	if (write(tDescriptor,sDataFork,sizeof(sDataFork)-1)!=(ssize_t) (sizeof(sDataFork)-1))
+	{
+		close(tDescriptor);
+		
+		return -1;
+	}
+	
+	close(tDescriptor);
+	
+	ioTree->files++;
+	
+	/* FinderInfo: type TEXT, creator ttxt */
+	
+	if (GoldinBenchRandomUnit()<inParameters->finderInfoFraction)
+	{
+		uint8_t tFinderInfo[32];
+		
+		memset(tFinderInfo,0,sizeof(tFinderInfo));
+		memcpy(tFinderInfo,"TEXTttxt",8);
+		
+		if (GoldinXattrSet(inPath,GOLDIN_XATTR_FINDERINFO,tFinderInfo,sizeof(tFinderInfo))!=0)
+			return -1;
+		
+		ioTree->filesWithFinderInfo++;
+	}
+	
+	/* Resource fork */
+	
+	tDraw=GoldinBenchRandomUnit();
+	
+	for(i=0;i<inParameters->numberOfForkSizes;i++)
+	{
+		if (tDraw<inParameters->forkSizes[i].fraction)
+		{
+			uint64_t tSize=inParameters->forkSizes[i].size;
+			uint8_t * tBytes=(uint8_t *) malloc((size_t) tSize);
+			uint64_t tOffset;
+			
+			if (tBytes==NULL)
+				return -1;
+			
+			for(tOffset=0;tOffset<tSize;tOffset++)
+				tBytes[tOffset]=(uint8_t) GoldinBenchRandom();
+			
+			if (GoldinXattrSet(inPath,GOLDIN_XATTR_RESOURCEFORK,tBytes,(size_t) tSize)!=0)
+			{
+				free(tBytes);
+				
+				return -1;
+			}
+			
+			free(tBytes);
+			
+			ioTree->filesWithResourceFork++;
+			ioTree->resourceForkBytes+=tSize;
+			
+			break;
+		}
+		
+		tDraw-=inParameters->forkSizes[i].fraction;
+	}
+	
+	return 0;
+}
+
+static int GoldinBenchCreateTree(const char * inPath,long inDepth,const GoldinBenchParameters * inParameters,GoldinBenchTree * ioTree)
+{
+	char tPath[PATH_MAX];
+	long i;
+	
+	if (mkdir(inPath,S_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH)!=0)
+		return -1;
+	
+	ioTree->folders++;
+	
+	for(i=0;i<inParameters->filesPerFolder;i++)
+	{
+		if (snprintf(tPath,PATH_MAX,"%s/file_%ld",inPath,i)>=PATH_MAX)
+		{
+			errno=ENAMETOOLONG;
+			
+			return -1;
+		}
+		
+		if (GoldinBenchCreateFile(tPath,inParameters,ioTree)!=0)
+		{
+			logerror("An error occurred while creating %s (%s)\n",tPath,strerror(errno));
+			
+			return -1;
+		}
+	}
+	
+	if (inDepth==0)
+		return 0;
+	
+	for(i=0;i<inParameters->fanOut;i++)
+	{
+		if (snprintf(tPath,PATH_MAX,"%s/folder_%ld",inPath,i)>=PATH_MAX)
+		{
+			errno=ENAMETOOLONG;
+			
+			return -1;
+		}
+		
+		if (GoldinBenchCreateTree(tPath,inDepth-1,inParameters,ioTree)!=0)
+			return -1;
+	}
+	
+	return 0;
+}
+
+static int GoldinBenchRemoveTree(const char * inPath)
+{
+	char tCommand[PATH_MAX+16];
+	
+	if (snprintf(tCommand,sizeof(tCommand),"rm -rf '%s'",inPath)>=(int) sizeof(tCommand))
+		return -1;
+	
+	return system(tCommand);
+}
+
+static long GoldinBenchGetPeakResidentSize(void)
+{
+	struct rusage tUsage;
+	
+	if (getrusage(RUSAGE_SELF,&tUsage)!=0)
+		return -1;
+	
+#ifdef __APPLE__
+	return tUsage.ru_maxrss/1024;		/* bytes */
+#else
+	return tUsage.ru_maxrss;			/* kilobytes */
+#endif
+}
+
+/* The dirty pages are written first so that the tree is really on the disk */
+
+static int GoldinBenchDropCaches(void)
+{
+#ifdef __APPLE__
+	sync();
+	
+	return (system("purge")==0) ? 0 : -1;
+#else
+	int tDescriptor;
+	int tError=0;
+	
+	sync();
+	
+	tDescriptor=open("/proc/sys/vm/drop_caches",O_WRONLY);
+	
+	if (tDescriptor==-1)
+		return -1;
+	
+	if (write(tDescriptor,"3\n",2)!=2)
+		tError=-1;
+	
+	close(tDescriptor);
+	
+	return tError;
+#endif
+}
+
+/* Returns the time needed to go through the tree. The job must be released by the caller */
+
+static double GoldinBenchRun(const char * inRootPath,const GoldinJobOptions * inOptions,GoldinJobRef * outJob)
+{
+	double tStartTime=GoldinBenchGetTime();
+	double tElapsedTime;
+	
+	*outJob=GoldinJobCreate(inOptions);
+	
+	if (*outJob==NULL)
+	{
+		logerror("An error occurred while creating the worker threads\n");
+		
+		return -1;
+	}
+	
+	GoldinJobSplit(*outJob,inRootPath);
+	
+	GoldinJobFinish(*outJob);
+	
+	tElapsedTime=GoldinBenchGetTime()-tStartTime;
+	
+	return (tElapsedTime>0) ? tElapsedTime : 1e-6;
+}
+
+static void usage(const char * inProcessName)
+{
+	printf("usage: %s [-d depth][-f fan-out][-n files][-i percent][-r size:percent,...][-S seed][-j jobs][-B backend][-A][-D][-O order][-b bytes/sec][-F files/sec][-C][-o directory][-k]\n",inProcessName);
+	printf("       -d  --  Depth of the tree (default: 3)\n");
+	printf("       -f  --  Number of folders per folder (default: 4)\n");
+	printf("       -n  --  Number of files per folder (default: 100)\n");
+	printf("       -i  --  Percentage of files with FinderInfo (default: 50)\n");
+	printf("       -r  --  Resource fork sizes and the percentage of files for each (default: 1024:10,3000:5)\n");
+	printf("       -S  --  Seed of the tree (default: 1)\n");
+	printf("       -j  --  Number of folders processed in parallel (default: 1)\n");
+	printf("       -B  --  Backend: %s (default: xattr)\n",GoldinBackendGetNames());
+	printf("       -A  --  Write the ._ files with io_uring (xattr backend)\n");
+	printf("       -D  --  Scan the tree with a dry run before splitting it\n");
+	printf("       -O  --  Order in which the items of a folder are split: listing, inode or disk (default: listing)\n");
+	printf("       -b  --  Do not write more than this number of resource fork bytes per second\n");
+	printf("       -F  --  Do not write more than this number of ._ files per second\n");
+	printf("       -C  --  Drop the caches of the system before every run (root)\n");
+	printf("       -o  --  Folder in which the tree is created (default: /tmp)\n");
+	printf("       -k  --  Keep the tree\n");
+	
+	exit(1);
+}
+
+int main(int argc,const char * argv[])
+{
+	GoldinBenchParameters tParameters;
+	GoldinBenchTree tTree;
+	GoldinJobOptions tOptions;
+	GoldinJobRef tJob=NULL;
+	const GoldinBackend * tBackend;
+	const char * tParentPath="/tmp";
+	char tTreePath[PATH_MAX];
+	char tResolvedPath[PATH_MAX];
+	char tRootPath[PATH_MAX];
+	Boolean tKeepTree=FALSE;
+	Boolean tDryRun=FALSE;
+	Boolean tDropCaches=FALSE;
+	long tNumberOfJobs=1;
+	double tDryRunTime=0;
+	uint64_t tDryRunItems=0;
+	uint64_t tEstimatedItems=0;
+	uint64_t tEstimatedResourceForkSize=0;
+	double tElapsedTime;
+	uint64_t tItems;
+	uint64_t tWrittenBytes;
+	GoldinBenchSampler tSampler;
+	int ch;
+	
+	memset(&tParameters,0,sizeof(tParameters));
+	memset(&tTree,0,sizeof(tTree));
+	
+	tParameters.depth=3;
+	tParameters.fanOut=4;
+	tParameters.filesPerFolder=100;
+	tParameters.finderInfoFraction=0.5;
+	tParameters.seed=1;
+	
+	GoldinBenchParseForkSizes("1024:10,3000:5",&tParameters);
+	
+	GoldinJobOptionsInitialize(&tOptions);
+	
+	tBackend=&kGoldinXattrBackend;
+	
+	while ((ch=getopt(argc,(char ** const) argv,"d:f:n:i:r:S:j:B:ADO:b:F:Co:ku"))!=-1)
+	{
+		switch (ch)
+		{
+			case 'd':
+				tParameters.depth=strtol(optarg,NULL,10);
+				break;
+			case 'f':
+				tParameters.fanOut=strtol(optarg,NULL,10);
+				break;
+			case 'n':
+				tParameters.filesPerFolder=strtol(optarg,NULL,10);
+				break;
+			case 'i':
+				tParameters.finderInfoFraction=strtod(optarg,NULL)/100.0;
+				break;
+			case 'r':
+				if (GoldinBenchParseForkSizes(optarg,&tParameters)!=0)
+				{
+					logerror("Invalid resource fork sizes: %s\n",optarg);
+					
+					return -1;
+				}
+				break;
+			case 'S':
+				tParameters.seed=strtoull(optarg,NULL,10);
+				break;
+			case 'j':
+				tNumberOfJobs=strtol(optarg,NULL,10);
+				
+				if (tNumberOfJobs==0)
+					tNumberOfJobs=sysconf(_SC_NPROCESSORS_ONLN);
+				break;
+			case 'B':
+				tBackend=GoldinBackendGetNamed(optarg);
+				
+				if (tBackend==NULL)
+				{
+					logerror("Unknown backend: %s\n",optarg);
+					
+					return -1;
+				}
+				break;
+			case 'A':
+				if (GoldinAsyncIsAvailable()==FALSE)
+				{
+					logerror("io_uring is not available (%s)\n",strerror(errno));
+					
+					return -1;
+				}
+				
+				tOptions.asynchronousMode=TRUE;
+				break;
+			case 'D':
+				tDryRun=TRUE;
+				break;
+			case 'O':
+				if (GoldinOrderGetNamed(optarg,&tOptions.order)!=0)
+				{
+					logerror("Unknown order: %s\n",optarg);
+					
+					return -1;
+				}
+				break;
+			case 'b':
+				tOptions.bytesPerSecond=strtoull(optarg,NULL,10);
+				break;
+			case 'F':
+				tOptions.filesPerSecond=strtoull(optarg,NULL,10);
+				break;
+			case 'C':
+				tDropCaches=TRUE;
+				break;
+			case 'o':
+				tParentPath=optarg;
+				break;
+			case 'k':
+				tKeepTree=TRUE;
+				break;
+			case 'u':
+			case '?':
+			default:
+				usage(argv[0]);
+				break;
+		}
+	}
+	
+	if (tParameters.depth<0 || tParameters.fanOut<0 || tParameters.filesPerFolder<0 || tNumberOfJobs<1)
+		usage(argv[0]);
+	
+	sRandomState=(tParameters.seed==0) ? 1 : tParameters.seed;
+	
+	/* 1. Generate the tree */
+	
+	if (snprintf(tTreePath,PATH_MAX,"%s/goldin_bench.XXXXXX",tParentPath)>=PATH_MAX || mkdtemp(tTreePath)==NULL)
+	{
+		logerror("Unable to create a folder in %s\n",tParentPath);
+		
+		return -1;
+	}
+	
+	/* The split engine expects a path without symbolic links */
+	
+	if (realpath(tTreePath,tResolvedPath)==NULL || snprintf(tRootPath,PATH_MAX,"%s/root",tResolvedPath)>=PATH_MAX)
+	{
+		GoldinBenchRemoveTree(tTreePath);
+		
+		return -1;
+	}
+	
+	if (GoldinBenchCreateTree(tRootPath,tParameters.depth,&tParameters,&tTree)!=0)
+	{
+		GoldinBenchRemoveTree(tTreePath);
+		
+		return -1;
+	}
+	
+	/* 2. Scan it */
+	
+	if (tDropCaches==TRUE && GoldinBenchDropCaches()!=0)
+	{
+		logerror("Unable to drop the caches\n");
+		
+		GoldinBenchRemoveTree(tTreePath);
+		
+		return -1;
+	}
+	
+	tOptions.backendName=tBackend->name;
+	tOptions.numberOfWorkers=(unsigned long) tNumberOfJobs;
+	
+	if (tDryRun==TRUE)
+	{
+		GoldinJobOptions tDryRunOptions=tOptions;
+		
+		tDryRunOptions.asynchronousMode=FALSE;
+		tDryRunOptions.dryRunMode=TRUE;
+		
+		tDryRunTime=GoldinBenchRun(tRootPath,&tDryRunOptions,&tJob);
+		
+		if (tJob!=NULL)
+		{
+			tEstimatedItems=GoldinEstimateGetItemCount(GoldinJobGetEstimate(tJob));
+			tEstimatedResourceForkSize=GoldinEstimateGetResourceForkSize(GoldinJobGetEstimate(tJob));
+			
+			GoldinJobRelease(tJob);
+		}
+		
+		/* The counters are shared with the split */
+		
+		tDryRunItems=GoldinCounterGetValue(kGoldinCounterItems);
+		
+		if (tDropCaches==TRUE)
+			GoldinBenchDropCaches();
+	}
+	
+	/* 3. Split it */
+	
+	memset(&tSampler,0,sizeof(tSampler));
+	
+	if ((tOptions.bytesPerSecond>0 || tOptions.filesPerSecond>0) && pthread_create(&tSampler.thread,NULL,GoldinBenchSamplerRun,&tSampler)!=0)
+	{
+		logerror("Unable to create the sampling thread\n");
+		
+		GoldinBenchRemoveTree(tTreePath);
+		
+		return -1;
+	}
+	
+	tElapsedTime=GoldinBenchRun(tRootPath,&tOptions,&tJob);
+	
+	if (tOptions.bytesPerSecond>0 || tOptions.filesPerSecond>0)
+	{
+		tSampler.stop=1;
+		
+		pthread_join(tSampler.thread,NULL);
+	}
+	
+	GoldinJobRelease(tJob);
+	
+	if (tElapsedTime<0 || tDryRunTime<0)
+	{
+		GoldinBenchRemoveTree(tTreePath);
+		
+		return -1;
+	}
+	
+	/* 4. Report */
+	
+	tItems=GoldinCounterGetValue(kGoldinCounterItems)-tDryRunItems;
+	
+	tWrittenBytes=GoldinBenchGetWrittenBytes();
+	
+	printf("{\n");
+	printf("  \"backend\": \"%s\",\n",tBackend->name);
+	printf("  \"jobs\": %ld,\n",tNumberOfJobs);
+	printf("  \"async\": %s,\n",(tOptions.asynchronousMode==TRUE) ? "true" : "false");
+	printf("  \"order\": \"%s\",\n",(tOptions.order==kGoldinOrderDisk) ? "disk" : ((tOptions.order==kGoldinOrderFileID) ? "inode" : "listing"));
+	printf("  \"cold_caches\": %s,\n",(tDropCaches==TRUE) ? "true" : "false");
+	printf("  \"tree\": { \"seed\": %llu, \"depth\": %ld, \"fan_out\": %ld, \"files_per_folder\": %ld, \"folders\": %llu, \"files\": %llu, \"files_with_finderinfo\": %llu, \"files_with_resource_fork\": %llu, \"resource_fork_bytes\": %llu },\n",
+		   (unsigned long long) tParameters.seed,tParameters.depth,tParameters.fanOut,tParameters.filesPerFolder,
+		   (unsigned long long) tTree.folders,(unsigned long long) tTree.files,(unsigned long long) tTree.filesWithFinderInfo,
+		   (unsigned long long) tTree.filesWithResourceFork,(unsigned long long) tTree.resourceForkBytes);
+	printf("  \"items\": %llu,\n",(unsigned long long) tItems);
+	printf("  \"split_items\": %llu,\n",(unsigned long long) GoldinCounterGetValue(kGoldinCounterSplitItems));
+	printf("  \"seconds\": %.6f,\n",tElapsedTime);
+	printf("  \"files_per_sec\": %.1f,\n",tItems/tElapsedTime);
+	printf("  \"mb_per_sec\": %.3f,\n",(tWrittenBytes/1048576.0)/tElapsedTime);
+	printf("  \"syscalls_per_file\": %.3f,\n",GoldinCountersGetCallsPerItem());
+	if (tDryRun==TRUE)
+	{
+		printf("  \"dry_run\": { \"seconds\": %.6f, \"files_per_sec\": %.1f, \"estimated_split_items\": %llu, \"estimated_resource_fork_bytes\": %llu, \"speedup\": %.2f },\n",
+			   tDryRunTime,tDryRunItems/tDryRunTime,
+			   (unsigned long long) tEstimatedItems,(unsigned long long) tEstimatedResourceForkSize,
+			   tElapsedTime/tDryRunTime);
+	}
+	
+	if (tOptions.bytesPerSecond>0 || tOptions.filesPerSecond>0)
+	{
+		GoldinBenchRate tFileRate;
+		GoldinBenchRate tByteRate;
+		
+		/* The overall rates include the start of the run (empty bucket) and the walk of the tree */
+		
+		if (GoldinBenchGetRate(&tSampler,FALSE,&tFileRate)!=0 || GoldinBenchGetRate(&tSampler,TRUE,&tByteRate)!=0)
+		{
+			printf("  \"throttle\": { \"bytes_per_sec_cap\": %llu, \"files_per_sec_cap\": %llu, \"samples\": %lu },\n",
+				   (unsigned long long) tOptions.bytesPerSecond,(unsigned long long) tOptions.filesPerSecond,(unsigned long) tSampler.count);
+		}
+		else
+		{
+			printf("  \"throttle\": { \"bytes_per_sec_cap\": %llu, \"files_per_sec_cap\": %llu, \"samples\": %lu,\n",
+				   (unsigned long long) tOptions.bytesPerSecond,(unsigned long long) tOptions.filesPerSecond,(unsigned long) tSampler.count);
+			printf("                \"files_per_sec\": { \"overall\": %.1f, \"mean\": %.1f, \"jitter\": %.4f, \"max\": %.1f },\n",
+				   GoldinBenchGetWrittenFiles()/tElapsedTime,tFileRate.mean,tFileRate.jitter,tFileRate.maximum);
+			printf("                \"bytes_per_sec\": { \"overall\": %.1f, \"mean\": %.1f, \"jitter\": %.4f, \"max\": %.1f } },\n",
+				   tWrittenBytes/tElapsedTime,tByteRate.mean,tByteRate.jitter,tByteRate.maximum);
+		}
+		
+		free(tSampler.samples);
+	}
+	
+	printf("  \"peak_rss_kb\": %ld\n",GoldinBenchGetPeakResidentSize());
+	printf("}\n");
+	
+	if (tKeepTree==FALSE)
+		GoldinBenchRemoveTree(tTreePath);
+	else
+	{
+		logerror("The tree was kept in %s\n",tRootPath);
+	}
+	
+	return 0;
+}
@@ -0,0 +1,57 @@
+#!/bin/sh
+
+# Checks that the throttles of goldin meet their caps: the same tree is split with an increasing
+# limit on the ._ files per second, then on the bytes per second, and the rates measured every
+# 100 ms by goldin_bench are printed next to the cap (mean, jitter = standard deviation / mean,
+# highest rate over 100 ms).
+#
+# usage: rate_limit.sh <goldin_bench> [-- <goldin_bench options>...]
+#
+# The runs should last a few seconds at least: the first and last 100 ms are not measured.
+# The default forks are kept small enough to fit in an extended attribute on Linux.
+
+BENCH="$1"
+
+if [ -z "$BENCH" ]; then
+	echo "usage: $0 <goldin_bench> [-- <goldin_bench options>...]" >&2
+	exit 1
+fi
+
+shift
+
+if [ "$1" = "--" ]; then
+	shift
+fi
+
+OPTIONS="$*"
+
+if [ -z "$OPTIONS" ]; then
+	OPTIONS="-d 2 -f 4 -n 100 -r 1024:20,3000:20 -j 4"
+fi
+
+# $1: "files_per_sec" or "bytes_per_sec", $2: JSON output of goldin_bench
+
+rate()
+{
+	echo "$2" | awk -F'[:,}]' -v KEY="\"$1\"" '$0 ~ KEY" *: *\\{" { print $3, $5, $7, $9 }'
+}
+
+printf "%14s %14s %14s %14s %10s %14s\n" "limit" "cap" "overall" "mean" "jitter" "max"
+
+for CAP in 250 500 1000 2000; do
+
+	RESULT=`"$BENCH" $OPTIONS -F $CAP` || exit 1
+
+	set -- `rate files_per_sec "$RESULT"`
+
+	printf "%14s %14d %14.1f %14.1f %10.4f %14.1f\n" "files/sec" "$CAP" "$1" "$2" "$3" "$4"
+done
+
+for CAP in 262144 524288 1048576; do
+
+	RESULT=`"$BENCH" $OPTIONS -b $CAP` || exit 1
+
+	set -- `rate bytes_per_sec "$RESULT"`
+
+	printf "%14s %14d %14.1f %14.1f %10.4f %14.1f\n" "bytes/sec" "$CAP" "$1" "$2" "$3" "$4"
+done
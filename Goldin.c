@@ -0,0 +1,561 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: Goldin.c
+              Project: goldin
+*/
+
+#include "Goldin.h"
+
+#include "GoldinAsync.h"
+#include "GoldinSplit.h"
+#include "GoldinSync.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <sys/stat.h>
+
+void GoldinJobLogError(GoldinJobRef inJob,const char * inFormat,...)
+{
+	char tMessage[PATH_MAX*2+256];
+	size_t tLength;
+	va_list tArguments;
+	
+	va_start(tArguments,inFormat);
+	vsnprintf(tMessage,sizeof(tMessage),inFormat,tArguments);
+	va_end(tArguments);
+	
+	tLength=strlen(tMessage);
+	
+	if (tLength>0 && tMessage[tLength-1]=='\n')
+		tMessage[tLength-1]='\0';
+	
+	__sync_fetch_and_add(&inJob->statistics.errors,1);
+	
+	if (inJob->errorCallback!=NULL)
+		inJob->errorCallback(tMessage,inJob->callbackContext);
+	else
+		logerror("%s\n",tMessage);
+}
+
+void GoldinJobOptionsInitialize(GoldinJobOptions * outOptions)
+{
+	if (outOptions==NULL)
+		return;
+	
+	memset(outOptions,0,sizeof(GoldinJobOptions));
+	
+	outOptions->order=kGoldinOrderListing;
+}
+
+/* The options that can not be combined. Returns NULL if there is no conflict, why they can not be combined otherwise */
+
+static const char * GoldinJobOptionsGetConflict(const GoldinJobOptions * inOptions,const GoldinBackend * inBackend)
+{
+	if (inOptions->resume==TRUE && inOptions->journalPath==NULL)
+		return "A journal is required to resume a run";
+	
+	/* The items of an archive are always sorted by name and written by the calling thread */
+	
+	if (inOptions->archiveMode==TRUE && (inOptions->stripResourceForks==TRUE || inOptions->incrementalMode==TRUE || inOptions->asynchronousMode==TRUE || inOptions->journalPath!=NULL || inOptions->numberOfWorkers>1 || inOptions->deduplicate==TRUE || inOptions->order!=kGoldinOrderListing))
+		return "An archive can not be written with the resource forks stripped, incrementally, asynchronously, with a journal, with workers, with the deduplication or in another order";
+	
+	if (inOptions->dryRunMode==TRUE && (inOptions->stripResourceForks==TRUE || inOptions->asynchronousMode==TRUE || inOptions->journalPath!=NULL || inOptions->archiveMode==TRUE || inOptions->deduplicate==TRUE))
+		return "A dry run can not strip the resource forks or be combined with the asynchronous engine, a journal, an archive or the deduplication";
+	
+	/* The stale ._ files are reported by a verification, the asynchronous engine only writes the ._ files */
+	
+	if (inOptions->pruneStale==TRUE && (inOptions->dryRunMode==TRUE || inOptions->verifyMode==TRUE || inOptions->archiveMode==TRUE || inOptions->asynchronousMode==TRUE))
+		return "The stale ._ files can not be removed during a dry run, a verification, an archive or asynchronously";
+	
+	/* Nothing is written during a verification */
+	
+	if (inOptions->verifyMode==TRUE && (inOptions->stripResourceForks==TRUE || inOptions->incrementalMode==TRUE || inOptions->dryRunMode==TRUE || inOptions->asynchronousMode==TRUE || inOptions->journalPath!=NULL || inOptions->archiveMode==TRUE || inOptions->deduplicate==TRUE))
+		return "A verification can not strip the resource forks or be combined with the incremental mode, a dry run, the asynchronous engine, a journal, an archive or the deduplication";
+	
+	/* The contents of the ._ files are hashed before they are written, the asynchronous engine writes them without reading them */
+	
+	if (inOptions->deduplicate==TRUE && inOptions->asynchronousMode==TRUE)
+		return "The deduplication can not be combined with the asynchronous engine";
+	
+	if (inOptions->asynchronousMode==TRUE && inBackend!=&kGoldinXattrBackend)
+		return "The asynchronous engine requires the xattr backend";
+	
+	return NULL;
+}
+
+GoldinJobRef GoldinJobCreate(const GoldinJobOptions * inOptions)
+{
+	const GoldinBackend * tBackend;
+	const char * tConflict;
+	GoldinJobRef tJob;
+	
+	if (inOptions==NULL)
+	{
+		errno=EINVAL;
+		
+		return NULL;
+	}
+	
+	tBackend=(inOptions->backendName==NULL) ? GoldinBackendGetDefault() : GoldinBackendGetNamed(inOptions->backendName);
+	
+	if (tBackend==NULL)
+	{
+		errno=EINVAL;
+		
+		return NULL;
+	}
+	
+	tConflict=GoldinJobOptionsGetConflict(inOptions,tBackend);
+	
+	if (tConflict!=NULL)
+	{
+		if (inOptions->errorCallback!=NULL)
+			inOptions->errorCallback(tConflict,inOptions->callbackContext);
+		else
+			logerror("%s\n",tConflict);
+		
+		errno=EINVAL;
+		
+		return NULL;
+	}
+	
+	tJob=(GoldinJobRef) calloc(1,sizeof(struct _GoldinJob));
+	
+	if (tJob==NULL)
+		return NULL;
+	
+	tJob->backend=tBackend;
+	tJob->stripResourceForks=inOptions->stripResourceForks;
+	tJob->incrementalMode=inOptions->incrementalMode;
+	tJob->asynchronousMode=(inOptions->asynchronousMode==TRUE && GoldinAsyncIsAvailable()==TRUE);
+	tJob->archiveMode=inOptions->archiveMode;
+	tJob->dryRunMode=inOptions->dryRunMode;
+	tJob->verifyMode=inOptions->verifyMode;
+	tJob->pruneStale=inOptions->pruneStale;
+	tJob->syncWhenDone=(inOptions->syncWhenDone==TRUE || inOptions->checkpointInterval>0);
+	tJob->filter=inOptions->filter;
+	tJob->entryOrder=inOptions->order;
+	tJob->checkpointInterval=inOptions->checkpointInterval;
+	tJob->progressCallback=inOptions->progressCallback;
+	tJob->errorCallback=inOptions->errorCallback;
+	tJob->callbackContext=inOptions->callbackContext;
+	
+	tJob->estimate=GoldinEstimateCreate();
+	
+	if (tJob->estimate==NULL)
+		goto bail;
+	
+	/* The items with many links are split once (an archive keeps its own table for each top item) */
+	
+	tJob->hardLinkTable=GoldinHardLinkTableCreate();
+	
+	if (tJob->hardLinkTable==NULL)
+		goto bail;
+	
+	if (inOptions->deduplicate==TRUE)
+	{
+		tJob->dedupIndex=GoldinDedupIndexCreate();
+		
+		if (tJob->dedupIndex==NULL)
+			goto bail;
+	}
+	
+	if (inOptions->bytesPerSecond>0)
+	{
+		tJob->byteThrottle=GoldinThrottleCreate(inOptions->bytesPerSecond,0);
+		
+		if (tJob->byteThrottle==NULL)
+			goto bail;
+	}
+	
+	if (inOptions->filesPerSecond>0)
+	{
+		tJob->fileThrottle=GoldinThrottleCreate(inOptions->filesPerSecond,0);
+		
+		if (tJob->fileThrottle==NULL)
+			goto bail;
+	}
+	
+	if (inOptions->journalPath!=NULL)
+	{
+		/* The records must not reach the disk before the ._ files when these are flushed */
+		
+		tJob->journal=GoldinJournalCreate(inOptions->journalPath,inOptions->resume,tJob->syncWhenDone);
+		
+		if (tJob->journal==NULL)
+			goto bail;
+	}
+	
+	if (inOptions->numberOfWorkers>1)
+	{
+		tJob->workQueue=GoldinWorkQueueCreate((unsigned int) inOptions->numberOfWorkers,SplitForksWorkFunction);
+		
+		if (tJob->workQueue==NULL)
+		{
+			errno=EAGAIN;
+			
+			goto bail;
+		}
+	}
+	
+	return tJob;
+	
+bail:
+	
+	{
+		int tError=errno;
+		
+		GoldinJobRelease(tJob);
+		
+		errno=tError;
+	}
+	
+	return NULL;
+}
+
+static void GoldinJobLogVolumeError(GoldinJobRef inJob,const char * inPath,int inError)
+{
+	switch(inError)
+	{
+		case ENOENT:
+			/* No such file or directory */
+			
+			GoldinJobLogError(inJob,"\"%s\" was not found\n",inPath);
+			break;
+		
+		case ENOTSUP:
+			
+			GoldinJobLogError(inJob,"\"%s\" is not on a volume the %s backend can deal with\n",inPath,inJob->backend->name);
+			break;
+		
+		default:
+			
+			GoldinJobLogError(inJob,"An error occurred while getting the maximum length for a file name (%s)\n",strerror(inError));
+			break;
+	}
+}
+
+/* The backend only knows about the last volume prepared */
+
+static int GoldinJobPrepareVolume(GoldinJobRef inJob,const char * inPath,GoldinJobVolume ** outVolume)
+{
+	struct stat tStat;
+	GoldinJobVolume * tVolume=NULL;
+	size_t i;
+	
+	if (stat(inPath,&tStat)!=0)
+		return errno;
+	
+	if (inJob->currentVolume!=NULL && inJob->currentVolume->device==tStat.st_dev)
+	{
+		*outVolume=inJob->currentVolume;
+		
+		return 0;
+	}
+	
+	/* The folders of the previous volume may still be waiting in the queue, and the workers use the list of volumes */
+	
+	GoldinWorkQueueWaitUntilDone(inJob->workQueue);
+	
+	for(i=0;i<inJob->volumeCount;i++)
+	{
+		if (inJob->volumes[i].device==tStat.st_dev)
+		{
+			tVolume=&inJob->volumes[i];
+			
+			/* Why the backend can not deal with this volume has already been reported */
+			
+			if (tVolume->error!=0)
+				return tVolume->error;
+			
+			break;
+		}
+	}
+	
+	if (tVolume==NULL)
+	{
+		GoldinJobVolume * tVolumes=(GoldinJobVolume *) realloc(inJob->volumes,(inJob->volumeCount+1)*sizeof(GoldinJobVolume));
+		
+		if (tVolumes==NULL)
+			return ENOMEM;
+		
+		/* The current volume may have moved */
+		
+		inJob->volumes=tVolumes;
+		inJob->currentVolume=NULL;
+		
+		tVolume=&inJob->volumes[inJob->volumeCount];
+		
+		tVolume->device=tStat.st_dev;
+		tVolume->written=FALSE;
+		tVolume->cloneUnsupported=0;
+		tVolume->path=strdup(inPath);
+		
+		if (tVolume->path==NULL)
+			return ENOMEM;
+		
+		inJob->volumeCount++;
+	}
+	
+	tVolume->error=inJob->backend->prepareVolume(inPath,&inJob->maxFileNameLength);
+	
+	if (tVolume->error!=0)
+	{
+		GoldinJobLogVolumeError(inJob,inPath,tVolume->error);
+		
+		inJob->currentVolume=NULL;
+		
+		return tVolume->error;
+	}
+	
+	inJob->currentVolume=tVolume;
+	
+	*outVolume=tVolume;
+	
+	return 0;
+}
+
+static int GoldinJobPrepareRoot(GoldinJobRef inJob,const char * inPath,char outResolvedPath[PATH_MAX],GoldinJobVolume ** outVolume)
+{
+	int tError;
+	
+	if (inJob==NULL || inPath==NULL || inJob->finished==TRUE)
+		return EINVAL;
+	
+	if (realpath(inPath,outResolvedPath)==NULL)
+	{
+		tError=errno;
+		
+		switch(tError)
+		{
+			case ENOENT:
+				/* No such file or directory */
+				
+				GoldinJobLogError(inJob,"\"%s\" was not found\n",inPath);
+				break;
+			
+			/* A COMPLETER */
+			
+			default:
+				/* A COMPLETER */
+				break;
+		}
+		
+		return tError;
+	}
+	
+	return GoldinJobPrepareVolume(inJob,outResolvedPath,outVolume);
+}
+
+int GoldinJobSplit(GoldinJobRef inJob,const char * inPath)
+{
+	return GoldinJobUpdate(inJob,inPath,0,TRUE);
+}
+
+int GoldinJobUpdate(GoldinJobRef inJob,const char * inPath,unsigned long inDepth,Boolean inContents)
+{
+	char tResolvedPath[PATH_MAX];
+	GoldinJobVolume * tVolume;
+	int tError;
+	
+	if (inJob->archiveMode==TRUE)
+	{
+		GoldinJobLogError(inJob,"The job only writes archives\n");
+		
+		return EINVAL;
+	}
+	
+	tError=GoldinJobPrepareRoot(inJob,inPath,tResolvedPath,&tVolume);
+	
+	if (tError!=0)
+		return tError;
+	
+	if (inJob->dryRunMode==FALSE && inJob->verifyMode==FALSE)
+		tVolume->written=TRUE;
+	
+	return (SplitForks(inJob,tResolvedPath,inDepth,inContents)==0) ? 0 : EIO;
+}
+
+int GoldinJobArchive(GoldinJobRef inJob,const char * inPath,GoldinArchiveRef inArchive)
+{
+	char tResolvedPath[PATH_MAX];
+	GoldinJobVolume * tVolume;
+	int tError;
+	
+	if (inJob==NULL || inArchive==NULL)
+		return EINVAL;
+	
+	/* The options that can not be combined with an archive were rejected when the job was created */
+	
+	if (inJob->archiveMode==FALSE)
+	{
+		GoldinJobLogError(inJob,"The job was not created to write archives\n");
+		
+		return EINVAL;
+	}
+	
+	tError=GoldinJobPrepareRoot(inJob,inPath,tResolvedPath,&tVolume);
+	
+	if (tError!=0)
+		return tError;
+	
+	return (ArchiveForks(inJob,tResolvedPath,inArchive)==0) ? 0 : EIO;
+}
+
+int GoldinJobSyncVolumes(GoldinJobRef inJob)
+{
+	int tStatus=0;
+	size_t i;
+	
+	for(i=0;i<inJob->volumeCount;i++)
+	{
+		int tError;
+		
+		if (inJob->volumes[i].error!=0 || inJob->volumes[i].written==FALSE)
+			continue;
+		
+		tError=GoldinSyncVolume(inJob->volumes[i].path);
+		
+		if (tError!=0)
+		{
+			GoldinJobLogError(inJob,"An error occurred while flushing the volume of %s (%s)\n",inJob->volumes[i].path,strerror(tError));
+			
+			tStatus=EIO;
+		}
+	}
+	
+	return tStatus;
+}
+
+typedef struct _GoldinJobSyncContext
+{
+	GoldinJobRef job;
+	int status;
+	
+} GoldinJobSyncContext;
+
+static int GoldinJobSyncVolumesForJournal(void * inContext)
+{
+	GoldinJobSyncContext * tContext=(GoldinJobSyncContext *) inContext;
+	
+	tContext->status=GoldinJobSyncVolumes(tContext->job);
+	
+	return tContext->status;
+}
+
+int GoldinJobCheckpoint(GoldinJobRef inJob)
+{
+	GoldinJobSyncContext tContext;
+	
+	if (inJob->journal==NULL)
+		return GoldinJobSyncVolumes(inJob);
+	
+	tContext.job=inJob;
+	tContext.status=0;
+	
+	if (GoldinJournalFlush(inJob->journal,GoldinJobSyncVolumesForJournal,&tContext)!=0)
+	{
+		/* The errors of the volumes have been reported */
+		
+		if (tContext.status==0)
+			GoldinJobLogError(inJob,"An error occurred while writing the journal (%s)\n",strerror(errno));
+		
+		return EIO;
+	}
+	
+	return 0;
+}
+
+int GoldinJobFinish(GoldinJobRef inJob)
+{
+	int tStatus=0;
+	
+	if (inJob==NULL)
+		return EINVAL;
+	
+	if (inJob->finished==TRUE)
+		return (inJob->failed!=0) ? EIO : 0;
+	
+	inJob->finished=TRUE;
+	
+	GoldinWorkQueueWaitUntilDone(inJob->workQueue);
+	
+	/* Before the journal is compacted: the records must not outlive the ._ files after a crash */
+	
+	if (inJob->syncWhenDone==TRUE)
+		tStatus=GoldinJobCheckpoint(inJob);
+	
+	if (inJob->journal!=NULL)
+	{
+		/* Only the records of the top folders are kept */
+		
+		if (GoldinJournalCompact(inJob->journal)!=0)
+			GoldinJobLogError(inJob,"An error occurred while compacting the journal (%s)\n",strerror(errno));
+	}
+	
+	return (inJob->failed!=0) ? EIO : tStatus;
+}
+
+void GoldinJobRelease(GoldinJobRef inJob)
+{
+	size_t i;
+	
+	if (inJob==NULL)
+		return;
+	
+	/* The workers must be done before what they use is released */
+	
+	GoldinWorkQueueRelease(inJob->workQueue);
+	
+	GoldinHardLinkTableRelease(inJob->hardLinkTable);
+	GoldinDedupIndexRelease(inJob->dedupIndex);
+	GoldinJournalRelease(inJob->journal);
+	GoldinEstimateRelease(inJob->estimate);
+	GoldinThrottleRelease(inJob->byteThrottle);
+	GoldinThrottleRelease(inJob->fileThrottle);
+	
+	for(i=0;i<inJob->volumeCount;i++)
+		free(inJob->volumes[i].path);
+	
+	free(inJob->volumes);
+	
+	free(inJob);
+}
+
+void GoldinJobGetStatistics(GoldinJobRef inJob,GoldinJobStatistics * outStatistics)
+{
+	if (inJob==NULL || outStatistics==NULL)
+		return;
+	
+	*outStatistics=inJob->statistics;
+}
+
+GoldinEstimateRef GoldinJobGetEstimate(GoldinJobRef inJob)
+{
+	return (inJob!=NULL) ? inJob->estimate : NULL;
+}
+
+size_t GoldinJobGetResumedRecordCount(GoldinJobRef inJob)
+{
+	return (inJob!=NULL && inJob->journal!=NULL) ? GoldinJournalGetLoadedCount(inJob->journal) : 0;
+}
@@ -0,0 +1,171 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: Goldin.h
+              Project: goldin
+
+    Notes:
+
+    o The interface of the split engine for the applications that embed it (libgoldin): a job splits the forks of
+      the trees it is given, with its own options, workers, journal and callbacks. Many jobs can run at the same time
+      in the same process, each job must only be used by one thread at a time.
+    
+    o The counters (GoldinCounters.h) and the trace (GoldinTrace.h) are shared by all the jobs of the process. The
+      statistics of a job only count its own items. The rest of the state shared by the jobs is either constant
+      (the name of the resource fork) or per thread (the copy buffers): the limit of folders kept open while a tree
+      is walked applies to each tree, not to the process.
+    
+    o The errors are reported through the error callback, one message per error. Without a callback, they are
+      written to the standard error.
+    
+    o A verification reports every ._ file that does not match its item, is missing or is orphaned as an error. These
+      differences do not make the job fail.
+*/
+
+#ifndef __GOLDIN_H__
+#define __GOLDIN_H__
+
+#include "GoldinAppleDouble.h"
+#include "GoldinArchive.h"
+#include "GoldinCommon.h"
+#include "GoldinDiskOrder.h"
+#include "GoldinEstimate.h"
+#include "GoldinFilter.h"
+#include "GoldinThrottle.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct _GoldinJob * GoldinJobRef;
+
+typedef enum
+{
+	kGoldinProgressSplitting=0,		/* A ._ file is about to be written, inSize is its size */
+	kGoldinProgressLinking,			/* A ._ file is about to be linked to the ._ file of another link to the same item */
+	kGoldinProgressWouldSplit,		/* Dry run: a ._ file would be written, inSize is its size */
+	kGoldinProgressWouldLink,		/* Dry run: a ._ file would be linked */
+	kGoldinProgressArchiving,		/* An item is about to be written to the archive */
+	kGoldinProgressVerifying,		/* A ._ file is about to be compared with its item, inSize is the size it should have */
+	kGoldinProgressRemoving			/* A stale ._ file is about to be removed, inSize is its size */
+	
+} GoldinProgressEvent;
+
+/* The callbacks can be called by any worker of the job, at the same time */
+
+typedef void (*GoldinProgressCallback)(GoldinProgressEvent inEvent,const char * inPath,uint64_t inSize,void * inContext);
+
+typedef void (*GoldinErrorCallback)(const char * inMessage,void * inContext);
+
+typedef struct _GoldinJobOptions
+{
+	const char * backendName;				/* NULL for the default backend (GoldinBackend.h) */
+	
+	unsigned long numberOfWorkers;			/* Number of folders processed in parallel, 0 or 1 to split on the calling thread */
+	
+	Boolean stripResourceForks;
+	Boolean incrementalMode;				/* Do not rewrite the ._ files that are up to date */
+	Boolean dryRunMode;						/* Only count the ._ files that would be written (GoldinJobGetEstimate) */
+	Boolean asynchronousMode;				/* Write the ._ files with io_uring (GoldinAsync.h), xattr backend only. Synchronously if io_uring is not available */
+	Boolean deduplicate;					/* Clone or link the ._ files identical to one already written (GoldinDedup.h) */
+	Boolean verifyMode;						/* Only compare the existing ._ files with their items, nothing is written */
+	Boolean pruneStale;						/* Remove the ._ files whose item is gone or does not need one anymore, not asynchronous */
+	Boolean archiveMode;					/* The trees are written to archives (GoldinJobArchive), not split */
+	
+	const char * journalPath;				/* NULL when the progress is not recorded (GoldinJournal.h) */
+	Boolean resume;							/* Skip the items and folders recorded in the journal by a previous run */
+	
+	unsigned long checkpointInterval;		/* Number of ._ files written between two flushes of the volumes and of the journal, 0 for none */
+	Boolean syncWhenDone;					/* Flush the volumes when the job is finished */
+	
+	GoldinFilterRef filter;					/* NULL when no item is pruned. It belongs to the caller and must outlive the job */
+	
+	GoldinOrder order;						/* Order in which the items of a folder are split */
+	
+	uint64_t bytesPerSecond;				/* Bytes of resource fork copied or read per second by all the workers, 0 for no limit */
+	uint64_t filesPerSecond;				/* ._ files created per second by all the workers, 0 for no limit (GoldinThrottle.h) */
+	
+	GoldinProgressCallback progressCallback;	/* Can be NULL */
+	GoldinErrorCallback errorCallback;			/* Can be NULL */
+	void * callbackContext;
+	
+} GoldinJobOptions;
+
+typedef struct _GoldinJobStatistics
+{
+	uint64_t splitItems;					/* ._ files written */
+	uint64_t upToDateItems;					/* ._ files left untouched (incremental mode) */
+	uint64_t rewrittenItems;				/* ._ files replaced because they were out of date */
+	uint64_t linkedItems;					/* ._ files linked to the ._ file of another link to the same item */
+	uint64_t deduplicatedItems;				/* ._ files sharing the blocks of an identical ._ file */
+	uint64_t journaledItems;				/* Items and folders skipped because the journal says they are done */
+	uint64_t prunedItems;					/* Items and folders skipped by the filter */
+	uint64_t verifiedItems;					/* ._ files matching their item (verification) */
+	uint64_t mismatchedItems;				/* ._ files not matching their item (verification) */
+	uint64_t missingItems;					/* Items needing a ._ file without one (verification) */
+	uint64_t orphanedItems;					/* ._ files without an item needing them (verification) */
+	uint64_t removedItems;					/* Stale ._ files removed */
+	uint64_t errors;						/* Messages sent to the error callback */
+	
+} GoldinJobStatistics;
+
+/* The options are set to their default values: default backend, no worker, nothing else */
+
+void GoldinJobOptionsInitialize(GoldinJobOptions * outOptions);
+
+/* Returns NULL and sets errno on failure: EINVAL if the options can not be combined (the reason is sent to the error
+   callback) or the backend is unknown */
+
+GoldinJobRef GoldinJobCreate(const GoldinJobOptions * inOptions);
+
+/* Splits the forks of a file or directory and of its contents. With workers, the folders may still be processed when
+   this returns. Returns 0 on success, ENOTSUP if the backend can not deal with the volume of the item, another errno
+   value otherwise (the error has been reported). EINVAL if the job was created in archive mode */
+
+int GoldinJobSplit(GoldinJobRef inJob,const char * inPath);
+
+/* Splits the forks of an item found inDepth levels below a root (0 for a root), without its contents unless inContents
+   is TRUE: the filter sees the same depths as when the whole root is split. Same return values as GoldinJobSplit */
+
+int GoldinJobUpdate(GoldinJobRef inJob,const char * inPath,unsigned long inDepth,Boolean inContents);
+
+/* Writes the item and its contents to the archive, each ._ file right before its item: nothing is written on the volume.
+   Same return values as GoldinJobSplit, EINVAL if the job was not created in archive mode. The archive is not finished:
+   many items can be written to it */
+
+int GoldinJobArchive(GoldinJobRef inJob,const char * inPath,GoldinArchiveRef inArchive);
+
+/* Waits for the workers, flushes the volumes if asked to and compacts the journal. Nothing can be split once the job
+   is finished. Returns 0 if every item could be split, EIO otherwise */
+
+int GoldinJobFinish(GoldinJobRef inJob);
+
+void GoldinJobRelease(GoldinJobRef inJob);
+
+void GoldinJobGetStatistics(GoldinJobRef inJob,GoldinJobStatistics * outStatistics);
+
+/* The estimate of a dry run. It belongs to the job */
+
+GoldinEstimateRef GoldinJobGetEstimate(GoldinJobRef inJob);
+
+/* Number of records loaded from the journal when the job resumes a previous run */
+
+size_t GoldinJobGetResumedRecordCount(GoldinJobRef inJob);
+
+/* GoldinAppleDoubleEncode builds a ._ file in memory (GoldinAppleDouble.h) */
+
+#endif
@@ -0,0 +1,203 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinAppleDouble.c
+              Project: goldin
+*/
+
+#include "GoldinAppleDouble.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#define GOLDIN_APPLEDOUBLE_MAGIC_NUMBER		0x00051607
+#define GOLDIN_APPLEDOUBLE_VERSION_NUMBER	0x00020000
+
+#define GOLDIN_APPLEDOUBLE_NUMBER_OF_ENTRIES	2
+
+#define GOLDIN_APPLEDOUBLE_ENTRY_FINDERINFO		9
+#define GOLDIN_APPLEDOUBLE_ENTRY_RESOURCEFORK	2
+
+static uint8_t * GoldinWriteBigEndian32(uint8_t * inBuffer,uint32_t inValue)
+{
+	inBuffer[0]=(uint8_t) (inValue>>24);
+	inBuffer[1]=(uint8_t) (inValue>>16);
+	inBuffer[2]=(uint8_t) (inValue>>8);
+	inBuffer[3]=(uint8_t) inValue;
+	
+	return inBuffer+4;
+}
+
+static uint32_t GoldinReadBigEndian32(const uint8_t * inBuffer)
+{
+	return ((uint32_t) inBuffer[0]<<24) | ((uint32_t) inBuffer[1]<<16) | ((uint32_t) inBuffer[2]<<8) | (uint32_t) inBuffer[3];
+}
+
+int GoldinAppleDoubleHasSignature(const uint8_t inBytes[GOLDIN_APPLEDOUBLE_SIGNATURE_SIZE])
+{
+	return (GoldinReadBigEndian32(inBytes)==GOLDIN_APPLEDOUBLE_MAGIC_NUMBER && GoldinReadBigEndian32(inBytes+4)==GOLDIN_APPLEDOUBLE_VERSION_NUMBER);
+}
+
+void GoldinAppleDoubleEncodeHeader(uint8_t outHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE],const uint8_t inFinderInfo[GOLDIN_APPLEDOUBLE_FINDERINFO_SIZE],uint32_t inResourceForkLength)
+{
+	uint8_t * tCursor=outHeader;
+	uint32_t tFinderInfoOffset;
+	
+	/* Magic Number, Version Number and Filler */
+	
+	tCursor=GoldinWriteBigEndian32(tCursor,GOLDIN_APPLEDOUBLE_MAGIC_NUMBER);
+	tCursor=GoldinWriteBigEndian32(tCursor,GOLDIN_APPLEDOUBLE_VERSION_NUMBER);
+	
+	memset(tCursor,0,16);
+	tCursor+=16;
+	
+	/* Number of Entries */
+	
+	tCursor[0]=0;
+	tCursor[1]=GOLDIN_APPLEDOUBLE_NUMBER_OF_ENTRIES;
+	tCursor+=2;
+	
+	/* Entries Descriptors */
+	
+	tFinderInfoOffset=(uint32_t) (tCursor-outHeader)+GOLDIN_APPLEDOUBLE_NUMBER_OF_ENTRIES*12;
+	
+	tCursor=GoldinWriteBigEndian32(tCursor,GOLDIN_APPLEDOUBLE_ENTRY_FINDERINFO);
+	tCursor=GoldinWriteBigEndian32(tCursor,tFinderInfoOffset);
+	tCursor=GoldinWriteBigEndian32(tCursor,GOLDIN_APPLEDOUBLE_FINDERINFO_SIZE);
+	
+	tCursor=GoldinWriteBigEndian32(tCursor,GOLDIN_APPLEDOUBLE_ENTRY_RESOURCEFORK);
+	tCursor=GoldinWriteBigEndian32(tCursor,GOLDIN_APPLEDOUBLE_HEADER_SIZE);
+	tCursor=GoldinWriteBigEndian32(tCursor,inResourceForkLength);		/* As you can see the AppleDouble format file is not ready for forks bigger than 2 GB */
+	
+	/* Finder Info */
+	
+	memcpy(tCursor,inFinderInfo,GOLDIN_APPLEDOUBLE_FINDERINFO_SIZE);
+}
+
+int GoldinAppleDoubleEncode(const uint8_t inFinderInfo[GOLDIN_APPLEDOUBLE_FINDERINFO_SIZE],const void * inResourceFork,uint64_t inResourceForkSize,void * outBuffer,size_t inBufferSize,size_t * outSize)
+{
+	if (inFinderInfo==NULL || outSize==NULL || (inResourceFork==NULL && inResourceForkSize>0))
+		return EINVAL;
+	
+	if (inResourceForkSize>0xFFFFFFFF || inResourceForkSize>SIZE_MAX-GOLDIN_APPLEDOUBLE_HEADER_SIZE)
+		return EFBIG;
+	
+	*outSize=GOLDIN_APPLEDOUBLE_HEADER_SIZE+(size_t) inResourceForkSize;
+	
+	if (outBuffer==NULL || inBufferSize<*outSize)
+		return ENOSPC;
+	
+	GoldinAppleDoubleEncodeHeader((uint8_t *) outBuffer,inFinderInfo,(uint32_t) inResourceForkSize);
+	
+	if (inResourceForkSize>0)
+		memcpy(((uint8_t *) outBuffer)+GOLDIN_APPLEDOUBLE_HEADER_SIZE,inResourceFork,(size_t) inResourceForkSize);
+	
+	return 0;
+}
+
+uint32_t GoldinAppleDoubleGetHostIdentifier(void)
+{
+	static volatile uint32_t sHostIdentifier=0;
+	
+	if (sHostIdentifier==0)
+	{
+		char tHostName[256];
+		uint32_t tHash=2166136261U;
+		size_t i;
+		
+		/* FNV-1a: the same host always gets the same identifier */
+		
+		if (gethostname(tHostName,sizeof(tHostName))!=0)
+			tHostName[0]='\0';
+		
+		tHostName[sizeof(tHostName)-1]='\0';
+		
+		for(i=0;tHostName[i]!='\0';i++)
+		{
+			tHash^=(uint8_t) tHostName[i];
+			tHash*=16777619U;
+		}
+		
+		sHostIdentifier=(tHash==0) ? 1 : tHash;
+	}
+	
+	return sHostIdentifier;
+}
+
+int GoldinAppleDoubleMakeTemporaryName(char * outName,size_t inSize)
+{
+	static unsigned long sCount=0;
+	int tLength;
+	
+	tLength=snprintf(outName,inSize,GOLDIN_APPLEDOUBLE_TEMPORARY_PREFIX "%08lx-%lx-%lx",(unsigned long) GoldinAppleDoubleGetHostIdentifier(),(unsigned long) getpid(),__sync_fetch_and_add(&sCount,1));
+	
+	if (tLength<0 || (size_t) tLength>=inSize)
+		return ENAMETOOLONG;
+	
+	return 0;
+}
+
+int GoldinAppleDoubleIsTemporaryName(const char * inName,uint32_t * outHostIdentifier,pid_t * outProcessID)
+{
+	const char * tCursor;
+	char * tEnd;
+	unsigned long tHostIdentifier;
+	unsigned long tProcessID;
+	int i;
+	
+	if (strncmp(inName,GOLDIN_APPLEDOUBLE_TEMPORARY_PREFIX,sizeof(GOLDIN_APPLEDOUBLE_TEMPORARY_PREFIX)-1)!=0)
+		return 0;
+	
+	/* A file of the user can have a name starting with the prefix too: the whole name must match */
+	
+	tCursor=inName+sizeof(GOLDIN_APPLEDOUBLE_TEMPORARY_PREFIX)-1;
+	
+	for(i=0;i<8;i++)
+	{
+		if (isxdigit((unsigned char) tCursor[i])==0)
+			return 0;
+	}
+	
+	tHostIdentifier=strtoul(tCursor,&tEnd,16);
+	
+	if (tEnd!=tCursor+8 || tEnd[0]!='-' || isxdigit((unsigned char) tEnd[1])==0)
+		return 0;
+	
+	tProcessID=strtoul(tEnd+1,&tEnd,16);
+	
+	if (tEnd[0]!='-' || isxdigit((unsigned char) tEnd[1])==0)
+		return 0;
+	
+	for(tCursor=tEnd+1;isxdigit((unsigned char) tCursor[0])!=0;tCursor++)
+		;
+	
+	if (tCursor[0]!='\0')
+		return 0;
+	
+	if (outHostIdentifier!=NULL)
+		*outHostIdentifier=(uint32_t) tHostIdentifier;
+	
+	if (outProcessID!=NULL)
+		*outProcessID=(pid_t) tProcessID;
+	
+	return 1;
+}
@@ -0,0 +1,94 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinAppleDouble.h
+              Project: goldin
+
+    Notes:
+
+    o The layout is the one SplitForks and FixupResourceForks use: a Finder Info entry (ID 9) followed by a Resource
+      Fork entry (ID 2), even when the resource fork is empty.
+    
+      +--------+--------------------------------------------------+
+      | Offset | Contents                                         |
+      +--------+--------------------------------------------------+
+      |   0x00 | Magic number (0x00051607)                        |
+      |   0x04 | Version (0x00020000)                             |
+      |   0x08 | Filler (16 bytes)                                |
+      |   0x18 | Number of entries (2)                            |
+      |   0x1A | Entry 9: offset 0x32, length 32                  |
+      |   0x26 | Entry 2: offset 0x52, length of resource fork    |
+      |   0x32 | FinderInfo + ExtFinderInfo                       |
+      |   0x52 | Resource fork                                    |
+      +--------+--------------------------------------------------+
+    
+    o A ._ file is written under a temporary name in its folder and renamed once complete, so that a crash leaves either
+      the previous ._ file or the new one, never a truncated one.
+*/
+
+#ifndef __GOLDIN_APPLEDOUBLE_H__
+#define __GOLDIN_APPLEDOUBLE_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#define GOLDIN_APPLEDOUBLE_HEADER_SIZE				0x52
+
+#define GOLDIN_APPLEDOUBLE_FINDERINFO_SIZE			32
+
+/* Where the descriptor of the resource fork entry and the FinderInfo start in the header */
+
+#define GOLDIN_APPLEDOUBLE_RESOURCEFORK_ENTRY_OFFSET	0x26
+#define GOLDIN_APPLEDOUBLE_FINDERINFO_OFFSET			0x32
+
+/* inFinderInfo is big endian (i.e. FinderInfo and ExtFinderInfo already swapped on Intel processors) */
+
+void GoldinAppleDoubleEncodeHeader(uint8_t outHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE],const uint8_t inFinderInfo[GOLDIN_APPLEDOUBLE_FINDERINFO_SIZE],uint32_t inResourceForkLength);
+
+/* The whole ._ file, built in memory: the header followed by inResourceForkSize bytes of inResourceFork. outBuffer can be
+   NULL to only get the size. Returns 0, ENOSPC if the buffer is too small (*outSize is then the size needed) or EFBIG
+   if the resource fork does not fit in the format */
+
+int GoldinAppleDoubleEncode(const uint8_t inFinderInfo[GOLDIN_APPLEDOUBLE_FINDERINFO_SIZE],const void * inResourceFork,uint64_t inResourceForkSize,void * outBuffer,size_t inBufferSize,size_t * outSize);
+
+/* Magic number and version: a file can only be taken for an AppleDouble file (and removed) if it starts with them */
+
+#define GOLDIN_APPLEDOUBLE_SIGNATURE_SIZE			8
+
+int GoldinAppleDoubleHasSignature(const uint8_t inBytes[GOLDIN_APPLEDOUBLE_SIGNATURE_SIZE]);
+
+/* The temporary names start with this prefix, followed by the host and the process ID of the run that made them in
+   hexadecimal (the files left by a run that died on this host can be recognized) */
+
+#define GOLDIN_APPLEDOUBLE_TEMPORARY_PREFIX			".goldin-"
+
+/* A name no other thread or process uses at the same time. Returns 0 or ENAMETOOLONG */
+
+int GoldinAppleDoubleMakeTemporaryName(char * outName,size_t inSize);
+
+/* Identifies this host in the temporary names: a hash of its name, never 0 */
+
+uint32_t GoldinAppleDoubleGetHostIdentifier(void);
+
+/* Returns 1 if the name was made by GoldinAppleDoubleMakeTemporaryName (*outHostIdentifier and *outProcessID are then
+   those of the run, the pointers can be NULL), 0 otherwise */
+
+int GoldinAppleDoubleIsTemporaryName(const char * inName,uint32_t * outHostIdentifier,pid_t * outProcessID);
+
+#endif
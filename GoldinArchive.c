@@ -0,0 +1,590 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinArchive.c
+              Project: goldin
+*/
+
+#include "GoldinArchive.h"
+
+#include "GoldinCopy.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/sysmacros.h>
+#endif
+
+#define GOLDIN_ARCHIVE_BLOCK_SIZE		512
+#define GOLDIN_ARCHIVE_RECORD_SIZE		10240		/* 20 blocks, as tar does */
+
+#define GOLDIN_ARCHIVE_BUFFER_SIZE		262144
+
+typedef struct _GoldinArchiveHeader
+{
+	char name[100];
+	char mode[8];
+	char ownerID[8];
+	char groupID[8];
+	char size[12];
+	char modificationTime[12];
+	char checksum[8];
+	char type;
+	char linkName[100];
+	char magic[6];
+	char version[2];
+	char ownerName[32];
+	char groupName[32];
+	char deviceMajor[8];
+	char deviceMinor[8];
+	char prefix[155];
+	char padding[12];
+	
+} GoldinArchiveHeader;
+
+struct _GoldinArchive
+{
+	int descriptor;
+	
+	dev_t device;						/* Of the archive when it's a regular file */
+	ino_t fileID;
+	Boolean isFile;
+	
+	uint8_t * buffer;
+	size_t length;
+	
+	uint64_t offset;					/* Bytes written so far (flushed or not) */
+	uint64_t remaining;					/* Data still expected for the current item */
+	
+	int sendFileUnsupported;			/* sendfile can not write to the archive (GoldinCopy.h) */
+	
+	int error;
+};
+
+GoldinArchiveRef GoldinArchiveCreate(int inDescriptor)
+{
+	GoldinArchiveRef tArchive;
+	struct stat tStat;
+	
+	tArchive=(GoldinArchiveRef) calloc(1,sizeof(struct _GoldinArchive));
+	
+	if (tArchive==NULL)
+		return NULL;
+	
+	tArchive->buffer=(uint8_t *) malloc(GOLDIN_ARCHIVE_BUFFER_SIZE);
+	
+	if (tArchive->buffer==NULL)
+	{
+		free(tArchive);
+		
+		errno=ENOMEM;
+		
+		return NULL;
+	}
+	
+	tArchive->descriptor=inDescriptor;
+	
+	if (fstat(inDescriptor,&tStat)==0 && S_ISREG(tStat.st_mode))
+	{
+		tArchive->isFile=TRUE;
+		tArchive->device=tStat.st_dev;
+		tArchive->fileID=tStat.st_ino;
+	}
+	
+	return tArchive;
+}
+
+Boolean GoldinArchiveIsOutput(GoldinArchiveRef inArchive,const struct stat * inStat)
+{
+	return (inArchive->isFile==TRUE && inStat->st_dev==inArchive->device && inStat->st_ino==inArchive->fileID);
+}
+
+static int GoldinArchiveFlush(GoldinArchiveRef inArchive)
+{
+	size_t tWritten=0;
+	
+	if (inArchive->error!=0)
+		return inArchive->error;
+	
+	while (tWritten<inArchive->length)
+	{
+		ssize_t tCount=write(inArchive->descriptor,inArchive->buffer+tWritten,inArchive->length-tWritten);
+		
+		if (tCount<0)
+		{
+			if (errno==EINTR)
+				continue;
+			
+			inArchive->error=errno;
+			
+			return inArchive->error;
+		}
+		
+		tWritten+=(size_t) tCount;
+	}
+	
+	inArchive->length=0;
+	
+	return 0;
+}
+
+/* Appends bytes that do not belong to the data of an item (headers and padding) */
+
+static int GoldinArchiveAppend(GoldinArchiveRef inArchive,const void * inBytes,size_t inSize)
+{
+	while (inSize>0)
+	{
+		size_t tCount=GOLDIN_ARCHIVE_BUFFER_SIZE-inArchive->length;
+		
+		if (tCount==0)
+		{
+			int tError=GoldinArchiveFlush(inArchive);
+			
+			if (tError!=0)
+				return tError;
+			
+			continue;
+		}
+		
+		if (tCount>inSize)
+			tCount=inSize;
+		
+		if (inBytes!=NULL)
+		{
+			memcpy(inArchive->buffer+inArchive->length,inBytes,tCount);
+			
+			inBytes=(const uint8_t *) inBytes+tCount;
+		}
+		else
+		{
+			memset(inArchive->buffer+inArchive->length,0,tCount);
+		}
+		
+		inArchive->length+=tCount;
+		inArchive->offset+=tCount;
+		inSize-=tCount;
+	}
+	
+	return 0;
+}
+
+static int GoldinArchivePad(GoldinArchiveRef inArchive,uint64_t inAlignment)
+{
+	uint64_t tRemainder=inArchive->offset%inAlignment;
+	
+	if (tRemainder==0)
+		return 0;
+	
+	return GoldinArchiveAppend(inArchive,NULL,(size_t) (inAlignment-tRemainder));
+}
+
+#pragma mark -
+
+/* Returns FALSE if the value does not fit in the field (a NUL terminated octal number) */
+
+static Boolean GoldinArchiveSetOctal(char * outField,size_t inSize,uint64_t inValue)
+{
+	char tString[32];
+	
+	snprintf(tString,sizeof(tString),"%0*llo",(int) (inSize-1),(unsigned long long) inValue);
+	
+	if (strlen(tString)>inSize-1)
+	{
+		memset(outField,'7',inSize-1);
+		outField[inSize-1]='\0';
+		
+		return FALSE;
+	}
+	
+	memcpy(outField,tString,inSize);
+	
+	return TRUE;
+}
+
+/* A pax record is "<length> <key>=<value>\n", the length including its own digits */
+
+static int GoldinArchiveAppendRecord(char * ioRecords,size_t inCapacity,size_t * ioLength,const char * inKey,const char * inValue)
+{
+	size_t tLength=strlen(inKey)+strlen(inValue)+3;		/* space, equal sign and newline */
+	size_t tDigits=1;
+	size_t tTotal;
+	
+	while (1)
+	{
+		char tNumber[32];
+		
+		tTotal=tLength+tDigits;
+		
+		if (snprintf(tNumber,sizeof(tNumber),"%lu",(unsigned long) tTotal)==(int) tDigits)
+			break;
+		
+		tDigits++;
+	}
+	
+	if (*ioLength+tTotal+1>inCapacity)
+		return ENAMETOOLONG;
+	
+	snprintf(ioRecords+*ioLength,inCapacity-*ioLength,"%lu %s=%s\n",(unsigned long) tTotal,inKey,inValue);
+	
+	*ioLength+=tTotal;
+	
+	return 0;
+}
+
+static void GoldinArchiveSetChecksum(GoldinArchiveHeader * ioHeader)
+{
+	const uint8_t * tBytes=(const uint8_t *) ioHeader;
+	unsigned long tChecksum=0;
+	size_t i;
+	
+	memset(ioHeader->checksum,' ',sizeof(ioHeader->checksum));
+	
+	for(i=0;i<sizeof(GoldinArchiveHeader);i++)
+		tChecksum+=tBytes[i];
+	
+	snprintf(ioHeader->checksum,sizeof(ioHeader->checksum),"%06lo",tChecksum);
+	ioHeader->checksum[7]=' ';
+}
+
+static void GoldinArchiveInitializeHeader(GoldinArchiveHeader * outHeader,char inType)
+{
+	memset(outHeader,0,sizeof(GoldinArchiveHeader));
+	
+	outHeader->type=inType;
+	memcpy(outHeader->magic,"ustar",6);
+	memcpy(outHeader->version,"00",2);
+}
+
+/* Fits the path in the name and prefix fields. Returns FALSE if a pax record is needed */
+
+static Boolean GoldinArchiveSetPath(GoldinArchiveHeader * ioHeader,const char * inPath)
+{
+	size_t tLength=strlen(inPath);
+	size_t i;
+	
+	if (tLength<=sizeof(ioHeader->name))
+	{
+		memcpy(ioHeader->name,inPath,tLength);
+		
+		return TRUE;
+	}
+	
+	/* Split on a / (a folder may end with one, it stays in the name) */
+	
+	for(i=1;i<tLength-1;i++)
+	{
+		if (inPath[i]=='/' && i<=sizeof(ioHeader->prefix) && tLength-i-1<=sizeof(ioHeader->name))
+		{
+			memcpy(ioHeader->prefix,inPath,i);
+			memcpy(ioHeader->name,inPath+i+1,tLength-i-1);
+			
+			return TRUE;
+		}
+	}
+	
+	memcpy(ioHeader->name,inPath,sizeof(ioHeader->name));
+	
+	return FALSE;
+}
+
+int GoldinArchiveBeginItem(GoldinArchiveRef inArchive,const GoldinArchiveItem * inItem)
+{
+	GoldinArchiveHeader tHeader;
+	char tRecords[PATH_MAX*3];
+	size_t tRecordsLength=0;
+	char tNumber[32];
+	int tError=0;
+	char tType;
+	
+	if (inArchive->error!=0)
+		return inArchive->error;
+	
+	if (inArchive->remaining!=0)
+		return EINVAL;
+	
+	switch(inItem->mode & S_IFMT)
+	{
+		case S_IFREG:
+			tType=(inItem->linkTarget!=NULL) ? '1' : '0';
+			break;
+		case S_IFDIR:
+			tType='5';
+			break;
+		case S_IFLNK:
+			tType='2';
+			break;
+		case S_IFCHR:
+			tType='3';
+			break;
+		case S_IFBLK:
+			tType='4';
+			break;
+		case S_IFIFO:
+			tType='6';
+			break;
+		default:
+			return ENOTSUP;		/* Sockets */
+	}
+	
+	GoldinArchiveInitializeHeader(&tHeader,tType);
+	
+	if (GoldinArchiveSetPath(&tHeader,inItem->path)==FALSE)
+		tError=GoldinArchiveAppendRecord(tRecords,sizeof(tRecords),&tRecordsLength,"path",inItem->path);
+	
+	if (tError==0 && (tType=='1' || tType=='2'))
+	{
+		size_t tLength=strlen(inItem->linkTarget);
+		
+		if (tLength<=sizeof(tHeader.linkName))
+			memcpy(tHeader.linkName,inItem->linkTarget,tLength);
+		else
+			tError=GoldinArchiveAppendRecord(tRecords,sizeof(tRecords),&tRecordsLength,"linkpath",inItem->linkTarget);
+	}
+	
+	GoldinArchiveSetOctal(tHeader.mode,sizeof(tHeader.mode),inItem->mode & 07777);
+	
+	if (tError==0 && GoldinArchiveSetOctal(tHeader.ownerID,sizeof(tHeader.ownerID),inItem->ownerID)==FALSE)
+	{
+		snprintf(tNumber,sizeof(tNumber),"%lu",(unsigned long) inItem->ownerID);
+		
+		tError=GoldinArchiveAppendRecord(tRecords,sizeof(tRecords),&tRecordsLength,"uid",tNumber);
+	}
+	
+	if (tError==0 && GoldinArchiveSetOctal(tHeader.groupID,sizeof(tHeader.groupID),inItem->groupID)==FALSE)
+	{
+		snprintf(tNumber,sizeof(tNumber),"%lu",(unsigned long) inItem->groupID);
+		
+		tError=GoldinArchiveAppendRecord(tRecords,sizeof(tRecords),&tRecordsLength,"gid",tNumber);
+	}
+	
+	if (tError==0 && GoldinArchiveSetOctal(tHeader.size,sizeof(tHeader.size),(tType=='0') ? inItem->size : 0)==FALSE)
+	{
+		snprintf(tNumber,sizeof(tNumber),"%llu",(unsigned long long) inItem->size);
+		
+		tError=GoldinArchiveAppendRecord(tRecords,sizeof(tRecords),&tRecordsLength,"size",tNumber);
+	}
+	
+	if (tError==0 && (inItem->modificationTime<0 || GoldinArchiveSetOctal(tHeader.modificationTime,sizeof(tHeader.modificationTime),(uint64_t) inItem->modificationTime)==FALSE))
+	{
+		GoldinArchiveSetOctal(tHeader.modificationTime,sizeof(tHeader.modificationTime),0);
+		
+		snprintf(tNumber,sizeof(tNumber),"%lld",(long long) inItem->modificationTime);
+		
+		tError=GoldinArchiveAppendRecord(tRecords,sizeof(tRecords),&tRecordsLength,"mtime",tNumber);
+	}
+	
+	if (tError!=0)
+		return tError;
+	
+	if (tType=='3' || tType=='4')
+	{
+		GoldinArchiveSetOctal(tHeader.deviceMajor,sizeof(tHeader.deviceMajor),major(inItem->device));
+		GoldinArchiveSetOctal(tHeader.deviceMinor,sizeof(tHeader.deviceMinor),minor(inItem->device));
+	}
+	
+	GoldinArchiveSetChecksum(&tHeader);
+	
+	/* The pax extended header comes first */
+	
+	if (tRecordsLength>0)
+	{
+		GoldinArchiveHeader tExtendedHeader;
+		
+		GoldinArchiveInitializeHeader(&tExtendedHeader,'x');
+		
+		memcpy(tExtendedHeader.name,"././@PaxHeader",14);
+		memcpy(tExtendedHeader.mode,tHeader.mode,sizeof(tHeader.mode));
+		memcpy(tExtendedHeader.ownerID,tHeader.ownerID,sizeof(tHeader.ownerID));
+		memcpy(tExtendedHeader.groupID,tHeader.groupID,sizeof(tHeader.groupID));
+		memcpy(tExtendedHeader.modificationTime,tHeader.modificationTime,sizeof(tHeader.modificationTime));
+		GoldinArchiveSetOctal(tExtendedHeader.size,sizeof(tExtendedHeader.size),tRecordsLength);
+		GoldinArchiveSetChecksum(&tExtendedHeader);
+		
+		if ((tError=GoldinArchiveAppend(inArchive,&tExtendedHeader,sizeof(tExtendedHeader)))!=0 ||
+			(tError=GoldinArchiveAppend(inArchive,tRecords,tRecordsLength))!=0 ||
+			(tError=GoldinArchivePad(inArchive,GOLDIN_ARCHIVE_BLOCK_SIZE))!=0)
+			return tError;
+	}
+	
+	tError=GoldinArchiveAppend(inArchive,&tHeader,sizeof(tHeader));
+	
+	if (tError!=0)
+		return tError;
+	
+	inArchive->remaining=(tType=='0') ? inItem->size : 0;
+	
+	return 0;
+}
+
+#pragma mark -
+
+int GoldinArchiveWriteData(GoldinArchiveRef inArchive,const void * inBuffer,size_t inSize)
+{
+	if (inArchive->error!=0)
+		return inArchive->error;
+	
+	if (inSize>inArchive->remaining)
+		return EINVAL;
+	
+	inArchive->remaining-=inSize;
+	
+	return GoldinArchiveAppend(inArchive,inBuffer,inSize);
+}
+
+int GoldinArchiveGetBuffer(GoldinArchiveRef inArchive,void ** outBuffer,size_t * outSize)
+{
+	size_t tSize;
+	
+	if (inArchive->error!=0)
+		return inArchive->error;
+	
+	if (inArchive->length==GOLDIN_ARCHIVE_BUFFER_SIZE)
+	{
+		int tError=GoldinArchiveFlush(inArchive);
+		
+		if (tError!=0)
+			return tError;
+	}
+	
+	tSize=GOLDIN_ARCHIVE_BUFFER_SIZE-inArchive->length;
+	
+	if (tSize>inArchive->remaining)
+		tSize=(size_t) inArchive->remaining;
+	
+	*outBuffer=inArchive->buffer+inArchive->length;
+	*outSize=tSize;
+	
+	return 0;
+}
+
+int GoldinArchiveCommitData(GoldinArchiveRef inArchive,size_t inSize)
+{
+	if (inArchive->error!=0)
+		return inArchive->error;
+	
+	if (inSize>inArchive->remaining || inSize>GOLDIN_ARCHIVE_BUFFER_SIZE-inArchive->length)
+		return EINVAL;
+	
+	inArchive->length+=inSize;
+	inArchive->offset+=inSize;
+	inArchive->remaining-=inSize;
+	
+	return 0;
+}
+
+int GoldinArchiveCopyData(GoldinArchiveRef inArchive,int inDescriptor,off_t inOffset,uint64_t inLength)
+{
+	int tError;
+	
+	if (inArchive->error!=0)
+		return inArchive->error;
+	
+	if (inLength>inArchive->remaining)
+		return EINVAL;
+	
+	/* Small files are read right into the buffer, the big ones are sent by the kernel */
+	
+	if (inLength<=GOLDIN_ARCHIVE_BUFFER_SIZE-inArchive->length)
+	{
+		uint64_t tRead=0;
+		
+		while (tRead<inLength)
+		{
+			ssize_t tCount=pread(inDescriptor,inArchive->buffer+inArchive->length+tRead,(size_t) (inLength-tRead),inOffset+(off_t) tRead);
+			
+			if (tCount<0)
+			{
+				if (errno==EINTR)
+					continue;
+				
+				return errno;
+			}
+			
+			if (tCount==0)
+				return EIO;		/* The file is shorter than expected */
+			
+			tRead+=(uint64_t) tCount;
+		}
+		
+		return GoldinArchiveCommitData(inArchive,(size_t) inLength);
+	}
+	
+	tError=GoldinArchiveFlush(inArchive);
+	
+	if (tError!=0)
+		return tError;
+	
+	if (GoldinCopyToStream(inDescriptor,inOffset,inArchive->descriptor,inLength,inArchive->buffer,GOLDIN_ARCHIVE_BUFFER_SIZE,&inArchive->sendFileUnsupported)!=0)
+	{
+		/* The archive is corrupted if some bytes have already been written */
+		
+		inArchive->error=errno;
+		
+		return inArchive->error;
+	}
+	
+	inArchive->offset+=inLength;
+	inArchive->remaining-=inLength;
+	
+	return 0;
+}
+
+int GoldinArchiveEndItem(GoldinArchiveRef inArchive)
+{
+	if (inArchive->error!=0)
+		return inArchive->error;
+	
+	if (inArchive->remaining!=0)
+		return EIO;
+	
+	return GoldinArchivePad(inArchive,GOLDIN_ARCHIVE_BLOCK_SIZE);
+}
+
+int GoldinArchiveFinish(GoldinArchiveRef inArchive)
+{
+	int tError;
+	
+	if (inArchive->error!=0)
+		return inArchive->error;
+	
+	/* Two empty blocks, then the rest of the record */
+	
+	tError=GoldinArchiveAppend(inArchive,NULL,2*GOLDIN_ARCHIVE_BLOCK_SIZE);
+	
+	if (tError==0)
+		tError=GoldinArchivePad(inArchive,GOLDIN_ARCHIVE_RECORD_SIZE);
+	
+	if (tError==0)
+		tError=GoldinArchiveFlush(inArchive);
+	
+	return tError;
+}
+
+void GoldinArchiveRelease(GoldinArchiveRef inArchive)
+{
+	if (inArchive==NULL)
+		return;
+	
+	free(inArchive->buffer);
+	free(inArchive);
+}
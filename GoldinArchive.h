@@ -0,0 +1,94 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinArchive.h
+              Project: goldin
+
+    Notes:
+
+    o Writes a tar archive (ustar, with pax extended headers for the long paths, the big files and the big ids) to a
+      file descriptor, which can be a pipe. The headers and the small items are gathered in a buffer; the data of the
+      big files is sent by the kernel (sendfile) when possible.
+    
+    o An item is written with GoldinArchiveBeginItem, then exactly its size in bytes of data, then GoldinArchiveEndItem.
+    
+    o All the functions return 0 on success or an errno value. Once a write has failed, all the calls fail.
+*/
+
+#ifndef __GOLDIN_ARCHIVE_H__
+#define __GOLDIN_ARCHIVE_H__
+
+#include "GoldinCommon.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+typedef struct _GoldinArchive * GoldinArchiveRef;
+
+typedef struct _GoldinArchiveItem
+{
+	const char * path;					/* Relative path in the archive. The folders end with a / */
+	
+	mode_t mode;						/* File type and permissions */
+	uid_t ownerID;
+	gid_t groupID;
+	
+	uint64_t size;						/* Regular files only, 0 for a hard link */
+	time_t modificationTime;
+	
+	const char * linkTarget;			/* Symbolic links, or path in the archive of a regular file this one is a hard link to */
+	dev_t device;						/* Character and block devices only */
+	
+} GoldinArchiveItem;
+
+/* The descriptor is not closed by GoldinArchiveRelease. Returns NULL and sets errno on failure */
+
+GoldinArchiveRef GoldinArchiveCreate(int inDescriptor);
+
+/* TRUE if the item described by inStat is the archive itself */
+
+Boolean GoldinArchiveIsOutput(GoldinArchiveRef inArchive,const struct stat * inStat);
+
+int GoldinArchiveBeginItem(GoldinArchiveRef inArchive,const GoldinArchiveItem * inItem);
+
+int GoldinArchiveWriteData(GoldinArchiveRef inArchive,const void * inBuffer,size_t inSize);
+
+/* Room for the data of the current item in the buffer of the archive (at most the bytes still expected). Once filled,
+   the bytes are added with GoldinArchiveCommitData. This is how the data is read without an intermediate buffer */
+
+int GoldinArchiveGetBuffer(GoldinArchiveRef inArchive,void ** outBuffer,size_t * outSize);
+
+int GoldinArchiveCommitData(GoldinArchiveRef inArchive,size_t inSize);
+
+/* Copies inLength bytes of a file. EIO if the file is shorter */
+
+int GoldinArchiveCopyData(GoldinArchiveRef inArchive,int inDescriptor,off_t inOffset,uint64_t inLength);
+
+/* EIO if the data of the item is incomplete */
+
+int GoldinArchiveEndItem(GoldinArchiveRef inArchive);
+
+/* Writes the end of the archive */
+
+int GoldinArchiveFinish(GoldinArchiveRef inArchive);
+
+void GoldinArchiveRelease(GoldinArchiveRef inArchive);
+
+#endif
@@ -0,0 +1,913 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinAsync.c
+              Project: goldin
+*/
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "GoldinAsync.h"
+
+#include <errno.h>
+#include <stdlib.h>
+
+#ifdef __linux__
+
+#include "GoldinAppleDouble.h"
+#include "GoldinCounters.h"
+#include "GoldinXattr.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+/* The operations of a chain, in the order they are linked */
+
+enum
+{
+	kGoldinAsyncGetResourceFork=0,
+	kGoldinAsyncOpen,
+	kGoldinAsyncWrite,
+	kGoldinAsyncClose,
+	kGoldinAsyncStat,
+	
+	kGoldinAsyncOperationsPerChain
+};
+
+/* The resource fork may change between the listing and the read. The chain is then submitted again with the new size */
+
+#define GOLDIN_ASYNC_MAXIMUM_ATTEMPTS	3
+
+typedef struct _GoldinAsyncChain
+{
+	struct _GoldinAsyncChain * next;		/* In the free list */
+	
+	unsigned int slot;						/* Fixed file slot used by openat, write and close */
+	
+	unsigned int pending;					/* Operations without a completion yet */
+	int results[kGoldinAsyncOperationsPerChain];
+	unsigned int attempts;
+	
+	char * path;
+	char * appleDoublePath;
+	char * temporaryPath;					/* In the same folder, renamed to appleDoublePath once complete */
+	
+	uint8_t finderInfo[32];
+	uid_t ownerID;
+	gid_t groupID;
+	mode_t mode;
+	
+	uint64_t resourceForkSize;
+	Boolean stripResourceFork;
+	
+	uint8_t * buffer;						/* The ._ file: header and resource fork */
+	size_t bufferSize;
+	
+	struct statx stat;
+	
+	GoldinAsyncCompletion completion;
+	void * context;
+	
+} GoldinAsyncChain;
+
+struct _GoldinAsync
+{
+	int descriptor;
+	
+	/* Submission queue */
+	
+	void * submissionRing;
+	size_t submissionRingSize;
+	
+	unsigned int * submissionHead;
+	unsigned int * submissionTail;
+	unsigned int submissionMask;
+	unsigned int submissionEntries;
+	unsigned int * submissionArray;
+	
+	struct io_uring_sqe * submissionQueueEntries;
+	size_t submissionQueueEntriesSize;
+	
+	unsigned int localTail;					/* Entries filled, the kernel sees them once the tail is published */
+	
+	/* Completion queue */
+	
+	void * completionRing;					/* Same as submissionRing with IORING_FEAT_SINGLE_MMAP */
+	size_t completionRingSize;
+	
+	unsigned int * completionHead;
+	unsigned int * completionTail;
+	unsigned int completionMask;
+	struct io_uring_cqe * completionQueueEntries;
+	
+	/* Chains */
+	
+	GoldinAsyncChain * chains;
+	unsigned int chainCount;
+	unsigned int busyChainCount;
+	
+	GoldinAsyncChain * freeChains;
+};
+
+static int GoldinAsyncSetup(unsigned int inEntries,struct io_uring_params * ioParameters)
+{
+	return (int) syscall(__NR_io_uring_setup,inEntries,ioParameters);
+}
+
+static int GoldinAsyncEnter(int inDescriptor,unsigned int inSubmitCount,unsigned int inWaitCount)
+{
+	return (int) syscall(__NR_io_uring_enter,inDescriptor,inSubmitCount,inWaitCount,(inWaitCount>0) ? IORING_ENTER_GETEVENTS : 0,NULL,0);
+}
+
+static int GoldinAsyncRegister(int inDescriptor,unsigned int inOperation,void * inArgument,unsigned int inCount)
+{
+	return (int) syscall(__NR_io_uring_register,inDescriptor,inOperation,inArgument,inCount);
+}
+
+Boolean GoldinAsyncIsAvailable(void)
+{
+	static const int sOperations[]={IORING_OP_GETXATTR,IORING_OP_OPENAT,IORING_OP_WRITE,IORING_OP_CLOSE,IORING_OP_STATX};
+	struct io_uring_params tParameters;
+	struct io_uring_probe * tProbe;
+	Boolean tAvailable=TRUE;
+	int tDescriptor;
+	size_t i;
+	
+	memset(&tParameters,0,sizeof(tParameters));
+	
+	tDescriptor=GoldinAsyncSetup(4,&tParameters);
+	
+	if (tDescriptor<0)
+		return FALSE;
+	
+	tProbe=(struct io_uring_probe *) calloc(1,sizeof(struct io_uring_probe)+256*sizeof(struct io_uring_probe_op));
+	
+	if (tProbe==NULL)
+	{
+		close(tDescriptor);
+		
+		errno=ENOMEM;
+		
+		return FALSE;
+	}
+	
+	if (GoldinAsyncRegister(tDescriptor,IORING_REGISTER_PROBE,tProbe,256)!=0)
+	{
+		/* No probe before Linux 5.6, and no openat into a fixed file slot either */
+		
+		tAvailable=FALSE;
+		errno=ENOTSUP;
+	}
+	else
+	{
+		for(i=0;i<sizeof(sOperations)/sizeof(sOperations[0]);i++)
+		{
+			if (sOperations[i]>tProbe->last_op || (tProbe->ops[sOperations[i]].flags & IO_URING_OP_SUPPORTED)==0)
+			{
+				tAvailable=FALSE;
+				errno=ENOTSUP;
+				
+				break;
+			}
+		}
+	}
+	
+	free(tProbe);
+	
+	close(tDescriptor);
+	
+	return tAvailable;
+}
+
+GoldinAsyncRef GoldinAsyncCreate(unsigned int inQueueDepth)
+{
+	struct io_uring_params tParameters;
+	GoldinAsyncRef tAsync;
+	int * tSlots;
+	unsigned int i;
+	int tError;
+	
+	tAsync=(GoldinAsyncRef) calloc(1,sizeof(struct _GoldinAsync));
+	
+	if (tAsync==NULL)
+		return NULL;
+	
+	tAsync->submissionRing=MAP_FAILED;
+	tAsync->completionRing=MAP_FAILED;
+	tAsync->submissionQueueEntries=MAP_FAILED;
+	
+	memset(&tParameters,0,sizeof(tParameters));
+	
+	tAsync->descriptor=GoldinAsyncSetup((inQueueDepth<kGoldinAsyncOperationsPerChain) ? kGoldinAsyncOperationsPerChain : inQueueDepth,&tParameters);
+	
+	if (tAsync->descriptor<0)
+	{
+		free(tAsync);
+		
+		return NULL;
+	}
+	
+	/* Map the rings */
+	
+	tAsync->submissionRingSize=tParameters.sq_off.array+tParameters.sq_entries*sizeof(unsigned int);
+	tAsync->completionRingSize=tParameters.cq_off.cqes+tParameters.cq_entries*sizeof(struct io_uring_cqe);
+	
+	if ((tParameters.features & IORING_FEAT_SINGLE_MMAP)!=0)
+	{
+		if (tAsync->completionRingSize>tAsync->submissionRingSize)
+			tAsync->submissionRingSize=tAsync->completionRingSize;
+		
+		tAsync->completionRingSize=0;
+	}
+	
+	tAsync->submissionRing=mmap(NULL,tAsync->submissionRingSize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,tAsync->descriptor,IORING_OFF_SQ_RING);
+	
+	if (tAsync->submissionRing==MAP_FAILED)
+		goto bail;
+	
+	if (tAsync->completionRingSize==0)
+	{
+		tAsync->completionRing=tAsync->submissionRing;
+	}
+	else
+	{
+		tAsync->completionRing=mmap(NULL,tAsync->completionRingSize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,tAsync->descriptor,IORING_OFF_CQ_RING);
+		
+		if (tAsync->completionRing==MAP_FAILED)
+			goto bail;
+	}
+	
+	tAsync->submissionQueueEntriesSize=tParameters.sq_entries*sizeof(struct io_uring_sqe);
+	
+	tAsync->submissionQueueEntries=(struct io_uring_sqe *) mmap(NULL,tAsync->submissionQueueEntriesSize,PROT_READ|PROT_WRITE,MAP_SHARED|MAP_POPULATE,tAsync->descriptor,IORING_OFF_SQES);
+	
+	if (tAsync->submissionQueueEntries==MAP_FAILED)
+		goto bail;
+	
+	tAsync->submissionHead=(unsigned int *) ((uint8_t *) tAsync->submissionRing+tParameters.sq_off.head);
+	tAsync->submissionTail=(unsigned int *) ((uint8_t *) tAsync->submissionRing+tParameters.sq_off.tail);
+	tAsync->submissionMask=*(unsigned int *) ((uint8_t *) tAsync->submissionRing+tParameters.sq_off.ring_mask);
+	tAsync->submissionEntries=tParameters.sq_entries;
+	tAsync->submissionArray=(unsigned int *) ((uint8_t *) tAsync->submissionRing+tParameters.sq_off.array);
+	
+	tAsync->localTail=*tAsync->submissionTail;
+	
+	tAsync->completionHead=(unsigned int *) ((uint8_t *) tAsync->completionRing+tParameters.cq_off.head);
+	tAsync->completionTail=(unsigned int *) ((uint8_t *) tAsync->completionRing+tParameters.cq_off.tail);
+	tAsync->completionMask=*(unsigned int *) ((uint8_t *) tAsync->completionRing+tParameters.cq_off.ring_mask);
+	tAsync->completionQueueEntries=(struct io_uring_cqe *) ((uint8_t *) tAsync->completionRing+tParameters.cq_off.cqes);
+	
+	/* A chain needs at most kGoldinAsyncOperationsPerChain entries: as many chains as the submission queue can hold.
+	   The completion queue is twice as large so it can not overflow */
+	
+	tAsync->chainCount=tParameters.sq_entries/kGoldinAsyncOperationsPerChain;
+	
+	tAsync->chains=(GoldinAsyncChain *) calloc(tAsync->chainCount,sizeof(GoldinAsyncChain));
+	
+	if (tAsync->chains==NULL)
+	{
+		errno=ENOMEM;
+		
+		goto bail;
+	}
+	
+	for(i=tAsync->chainCount;i>0;i--)
+	{
+		GoldinAsyncChain * tChain=&tAsync->chains[i-1];
+		
+		tChain->slot=i-1;
+		tChain->next=tAsync->freeChains;
+		
+		tAsync->freeChains=tChain;
+	}
+	
+	/* One empty fixed file slot per chain */
+	
+	tSlots=(int *) malloc(tAsync->chainCount*sizeof(int));
+	
+	if (tSlots==NULL)
+	{
+		errno=ENOMEM;
+		
+		goto bail;
+	}
+	
+	for(i=0;i<tAsync->chainCount;i++)
+		tSlots[i]=-1;
+	
+	tError=GoldinAsyncRegister(tAsync->descriptor,IORING_REGISTER_FILES,tSlots,tAsync->chainCount);
+	
+	free(tSlots);
+	
+	if (tError!=0)
+		goto bail;
+	
+	return tAsync;
+	
+bail:
+	
+	tError=errno;
+	
+	GoldinAsyncRelease(tAsync);
+	
+	errno=tError;
+	
+	return NULL;
+}
+
+#pragma mark -
+
+static struct io_uring_sqe * GoldinAsyncGetSubmissionEntry(GoldinAsyncRef inAsync,GoldinAsyncChain * inChain,unsigned int inOperation,uint8_t inFlags)
+{
+	unsigned int tIndex=inAsync->localTail & inAsync->submissionMask;
+	struct io_uring_sqe * tEntry=&inAsync->submissionQueueEntries[tIndex];
+	
+	memset(tEntry,0,sizeof(struct io_uring_sqe));
+	
+	tEntry->flags=inFlags;
+	tEntry->user_data=(uint64_t) inChain->slot*kGoldinAsyncOperationsPerChain+inOperation;
+	
+	inAsync->submissionArray[tIndex]=tIndex;
+	inAsync->localTail++;
+	
+	inChain->pending++;
+	
+	GoldinCounterIncrement(kGoldinCounterRingOperations);
+	
+	return tEntry;
+}
+
+static void GoldinAsyncQueueChain(GoldinAsyncRef inAsync,GoldinAsyncChain * inChain)
+{
+	struct io_uring_sqe * tEntry;
+	unsigned int i;
+	
+	for(i=0;i<kGoldinAsyncOperationsPerChain;i++)
+		inChain->results[i]=0;
+	
+	GoldinAppleDoubleEncodeHeader(inChain->buffer,inChain->finderInfo,(uint32_t) inChain->resourceForkSize);
+	
+	/* 1. Read the resource fork right after the header (getxattr follows the symbolic links, the items listed are not) */
+	
+	if (inChain->resourceForkSize>0)
+	{
+		tEntry=GoldinAsyncGetSubmissionEntry(inAsync,inChain,kGoldinAsyncGetResourceFork,IOSQE_IO_LINK);
+		
+		tEntry->opcode=IORING_OP_GETXATTR;
+		tEntry->addr=(uint64_t) (uintptr_t) GOLDIN_XATTR_RESOURCEFORK;
+		tEntry->addr2=(uint64_t) (uintptr_t) (inChain->buffer+GOLDIN_APPLEDOUBLE_HEADER_SIZE);
+		tEntry->addr3=(uint64_t) (uintptr_t) inChain->path;
+		tEntry->len=(uint32_t) inChain->resourceForkSize;
+	}
+	
+	/* 2. Create the temporary file with the final permissions */
+	
+	tEntry=GoldinAsyncGetSubmissionEntry(inAsync,inChain,kGoldinAsyncOpen,IOSQE_IO_LINK);
+	
+	tEntry->opcode=IORING_OP_OPENAT;
+	tEntry->fd=AT_FDCWD;
+	tEntry->addr=(uint64_t) (uintptr_t) inChain->temporaryPath;
+	tEntry->open_flags=O_WRONLY|O_CREAT|O_EXCL|O_NOFOLLOW;
+	tEntry->len=inChain->mode;
+	tEntry->file_index=inChain->slot+1;
+	
+	/* 3. Write the header and the resource fork at once (the file is closed even if the write fails) */
+	
+	tEntry=GoldinAsyncGetSubmissionEntry(inAsync,inChain,kGoldinAsyncWrite,IOSQE_FIXED_FILE|IOSQE_IO_HARDLINK);
+	
+	tEntry->opcode=IORING_OP_WRITE;
+	tEntry->fd=(int32_t) inChain->slot;
+	tEntry->addr=(uint64_t) (uintptr_t) inChain->buffer;
+	tEntry->len=(uint32_t) (GOLDIN_APPLEDOUBLE_HEADER_SIZE+inChain->resourceForkSize);
+	tEntry->off=0;
+	
+	/* 4. Close */
+	
+	tEntry=GoldinAsyncGetSubmissionEntry(inAsync,inChain,kGoldinAsyncClose,IOSQE_IO_LINK);
+	
+	tEntry->opcode=IORING_OP_CLOSE;
+	tEntry->file_index=inChain->slot+1;
+	
+	/* 5. Owner, group and permissions the file ended up with */
+	
+	tEntry=GoldinAsyncGetSubmissionEntry(inAsync,inChain,kGoldinAsyncStat,0);
+	
+	tEntry->opcode=IORING_OP_STATX;
+	tEntry->fd=AT_FDCWD;
+	tEntry->addr=(uint64_t) (uintptr_t) inChain->temporaryPath;
+	tEntry->statx_flags=AT_SYMLINK_NOFOLLOW;
+	tEntry->len=STATX_MODE|STATX_UID|STATX_GID;
+	tEntry->addr2=(uint64_t) (uintptr_t) &inChain->stat;
+}
+
+/* Publishes the entries filled and waits for inWaitCount completions */
+
+static int GoldinAsyncSubmit(GoldinAsyncRef inAsync,unsigned int inWaitCount)
+{
+	while (1)
+	{
+		unsigned int tSubmitCount;
+		
+		__atomic_store_n(inAsync->submissionTail,inAsync->localTail,__ATOMIC_RELEASE);
+		
+		tSubmitCount=inAsync->localTail-__atomic_load_n(inAsync->submissionHead,__ATOMIC_ACQUIRE);
+		
+		if (tSubmitCount==0 && inWaitCount==0)
+			return 0;
+		
+		GoldinCounterIncrement(kGoldinCounterRingSubmissions);
+		
+		if (GoldinAsyncEnter(inAsync->descriptor,tSubmitCount,inWaitCount)>=0)
+			return 0;
+		
+		if (errno!=EINTR && errno!=EAGAIN)
+			return errno;
+	}
+}
+
+static void GoldinAsyncFinishChain(GoldinAsyncRef inAsync,GoldinAsyncChain * inChain,const GoldinAsyncResult * inResult)
+{
+	GoldinAsyncCompletion tCompletion=inChain->completion;
+	void * tContext=inChain->context;
+	
+	/* The temporary file was not renamed */
+	
+	if (inResult->didSplit==FALSE)
+		unlink(inChain->temporaryPath);
+	
+	free(inChain->path);
+	inChain->path=NULL;
+	
+	free(inChain->appleDoublePath);
+	inChain->appleDoublePath=NULL;
+	
+	free(inChain->temporaryPath);
+	inChain->temporaryPath=NULL;
+	
+	inChain->next=inAsync->freeChains;
+	inAsync->freeChains=inChain;
+	
+	inAsync->busyChainCount--;
+	
+	if (tCompletion!=NULL)
+		(*tCompletion)(inResult,tContext);
+}
+
+static int GoldinAsyncPrepareBuffer(GoldinAsyncChain * inChain)
+{
+	size_t tSize=GOLDIN_APPLEDOUBLE_HEADER_SIZE+(size_t) inChain->resourceForkSize;
+	
+	if (tSize>inChain->bufferSize)
+	{
+		uint8_t * tBuffer=(uint8_t *) realloc(inChain->buffer,tSize);
+		
+		if (tBuffer==NULL)
+			return ENOMEM;
+		
+		inChain->buffer=tBuffer;
+		inChain->bufferSize=tSize;
+	}
+	
+	return 0;
+}
+
+/* The resource fork is not the one listed anymore: get its new size and submit the chain again */
+
+static void GoldinAsyncRetryChain(GoldinAsyncRef inAsync,GoldinAsyncChain * inChain,GoldinAsyncResult * ioResult)
+{
+	Boolean tWritten=(inChain->results[kGoldinAsyncOpen]>=0);
+	ssize_t tSize;
+	
+	inChain->attempts++;
+	
+	tSize=GoldinXattrGet(inChain->path,GOLDIN_XATTR_RESOURCEFORK,NULL,0);
+	
+	if (tSize<0)
+	{
+		if (errno!=GOLDIN_XATTR_NOT_FOUND && errno!=ENOTSUP)
+		{
+			ioResult->error=errno;
+			ioResult->stage=kGoldinAsyncStageReadFork;
+			
+			GoldinAsyncFinishChain(inAsync,inChain,ioResult);
+			
+			return;
+		}
+		
+		tSize=0;
+	}
+	
+	/* The temporary file written with the stale fork is removed */
+	
+	if (tWritten==TRUE)
+		unlink(inChain->temporaryPath);
+	
+	if (tSize==0 && GoldinFinderInfoNeedsSplit(inChain->finderInfo)==0)
+	{
+		/* Nothing to split anymore */
+		
+		GoldinAsyncFinishChain(inAsync,inChain,ioResult);
+		
+		return;
+	}
+	
+	if ((uint64_t) tSize>0xFFFFFFFF)
+		ioResult->error=EFBIG;
+	else if (inChain->attempts>=GOLDIN_ASYNC_MAXIMUM_ATTEMPTS)
+		ioResult->error=EBUSY;
+	
+	if (ioResult->error==0)
+	{
+		inChain->resourceForkSize=(uint64_t) tSize;
+		
+		ioResult->error=GoldinAsyncPrepareBuffer(inChain);
+	}
+	
+	if (ioResult->error!=0)
+	{
+		ioResult->stage=kGoldinAsyncStageReadFork;
+		
+		GoldinAsyncFinishChain(inAsync,inChain,ioResult);
+		
+		return;
+	}
+	
+	/* The entries of the chain have all completed: there is room for the new ones */
+	
+	GoldinAsyncQueueChain(inAsync,inChain);
+}
+
+static void GoldinAsyncCompleteChain(GoldinAsyncRef inAsync,GoldinAsyncChain * inChain)
+{
+	GoldinAsyncResult tResult;
+	int tWriteCount;
+	
+	memset(&tResult,0,sizeof(tResult));
+	
+	tResult.resourceForkSize=inChain->resourceForkSize;
+	
+	if (inChain->resourceForkSize>0)
+	{
+		int tForkSize=inChain->results[kGoldinAsyncGetResourceFork];
+		
+		/* Too small a buffer, no fork anymore or a smaller one */
+		
+		if (tForkSize==-ERANGE || tForkSize==-GOLDIN_XATTR_NOT_FOUND || (tForkSize>=0 && (uint64_t) tForkSize!=inChain->resourceForkSize))
+		{
+			GoldinAsyncRetryChain(inAsync,inChain,&tResult);
+			
+			return;
+		}
+		
+		if (tForkSize<0)
+		{
+			tResult.error=-tForkSize;
+			tResult.stage=kGoldinAsyncStageReadFork;
+			
+			GoldinAsyncFinishChain(inAsync,inChain,&tResult);
+			
+			return;
+		}
+		
+		GoldinCounterIncrement(kGoldinCounterAttributeReads);
+		GoldinCounterAdd(kGoldinCounterBytesBuffered,inChain->resourceForkSize);
+	}
+	
+	tWriteCount=(int) (GOLDIN_APPLEDOUBLE_HEADER_SIZE+inChain->resourceForkSize);
+	
+	if (inChain->results[kGoldinAsyncOpen]<0)
+	{
+		tResult.error=-inChain->results[kGoldinAsyncOpen];
+		tResult.stage=kGoldinAsyncStageCreate;
+	}
+	else if (inChain->results[kGoldinAsyncWrite]<0)
+	{
+		tResult.error=-inChain->results[kGoldinAsyncWrite];
+		tResult.stage=kGoldinAsyncStageWrite;
+	}
+	else if (inChain->results[kGoldinAsyncWrite]!=tWriteCount)
+	{
+		/* A short write on a regular file: there is no room left */
+		
+		tResult.error=ENOSPC;
+		tResult.stage=kGoldinAsyncStageWrite;
+	}
+	else if (inChain->results[kGoldinAsyncClose]<0)
+	{
+		tResult.error=-inChain->results[kGoldinAsyncClose];
+		tResult.stage=kGoldinAsyncStageClose;
+	}
+	else if (inChain->results[kGoldinAsyncStat]<0)
+	{
+		tResult.error=-inChain->results[kGoldinAsyncStat];
+		tResult.stage=kGoldinAsyncStageClose;
+	}
+	else
+	{
+		Boolean tOwnerChanged=FALSE;
+		mode_t tMode=inChain->mode;
+		
+		/* Set the owner. It resets the setuid and setgid bits. Only root can give a file away: otherwise the ._ file keeps
+		   the owner of the caller, without the setuid and setgid bits that were meant for another owner */
+		
+		if (inChain->stat.stx_uid!=inChain->ownerID || inChain->stat.stx_gid!=inChain->groupID)
+		{
+			if (lchown(inChain->temporaryPath,inChain->ownerID,inChain->groupID)!=0)
+			{
+				if (errno==EPERM)
+				{
+					tMode&=~(S_ISUID|S_ISGID);
+				}
+				else
+				{
+					tResult.error=errno;
+					tResult.stage=kGoldinAsyncStageClose;
+				}
+			}
+			
+			tOwnerChanged=TRUE;
+		}
+		
+		/* The umask may have removed some permissions */
+		
+		if (tResult.error==0 && (tOwnerChanged==TRUE || (inChain->stat.stx_mode & 07777)!=tMode))
+		{
+			if (chmod(inChain->temporaryPath,tMode)!=0)
+			{
+				tResult.error=errno;
+				tResult.stage=kGoldinAsyncStageClose;
+			}
+		}
+		
+		/* The previous ._ file is replaced at once */
+		
+		if (tResult.error==0 && rename(inChain->temporaryPath,inChain->appleDoublePath)!=0)
+		{
+			tResult.error=errno;
+			tResult.stage=kGoldinAsyncStageClose;
+		}
+	}
+	
+	if (tResult.error==0)
+	{
+		tResult.didSplit=TRUE;
+		
+		if (inChain->stripResourceFork==TRUE && inChain->resourceForkSize>0)
+		{
+			if (GoldinXattrRemove(inChain->path,GOLDIN_XATTR_RESOURCEFORK)!=0 && errno!=GOLDIN_XATTR_NOT_FOUND)
+			{
+				tResult.error=errno;
+				tResult.stage=kGoldinAsyncStageStrip;
+			}
+		}
+	}
+	
+	GoldinAsyncFinishChain(inAsync,inChain,&tResult);
+}
+
+static void GoldinAsyncReap(GoldinAsyncRef inAsync)
+{
+	unsigned int tHead=*inAsync->completionHead;
+	unsigned int tTail=__atomic_load_n(inAsync->completionTail,__ATOMIC_ACQUIRE);
+	
+	while (tHead!=tTail)
+	{
+		struct io_uring_cqe * tCompletion=&inAsync->completionQueueEntries[tHead & inAsync->completionMask];
+		GoldinAsyncChain * tChain=&inAsync->chains[tCompletion->user_data/kGoldinAsyncOperationsPerChain];
+		
+		tChain->results[tCompletion->user_data%kGoldinAsyncOperationsPerChain]=tCompletion->res;
+		
+		tHead++;
+		
+		/* The entry is released before the chain may be submitted again */
+		
+		__atomic_store_n(inAsync->completionHead,tHead,__ATOMIC_RELEASE);
+		
+		tChain->pending--;
+		
+		if (tChain->pending==0)
+			GoldinAsyncCompleteChain(inAsync,tChain);
+		
+		tTail=__atomic_load_n(inAsync->completionTail,__ATOMIC_ACQUIRE);
+	}
+}
+
+#pragma mark -
+
+int GoldinAsyncWriteAppleDouble(GoldinAsyncRef inAsync,const char * inPath,const GoldinEntry * inEntry,Boolean inStripResourceFork,GoldinAsyncCompletion inCompletion,void * inContext)
+{
+	GoldinAsyncChain * tChain;
+	char tTemporaryName[NAME_MAX];
+	const char * tName;
+	int tLength;
+	int tError;
+	
+	if (inAsync==NULL || inPath==NULL || inEntry==NULL || inEntry->resourceForkSize<0)
+		return EINVAL;
+	
+	if ((uint64_t) inEntry->resourceForkSize>0xFFFFFFFF)
+		return EFBIG;
+	
+	GoldinAsyncReap(inAsync);
+	
+	while (inAsync->freeChains==NULL)
+	{
+		tError=GoldinAsyncSubmit(inAsync,1);
+		
+		if (tError!=0)
+			return tError;
+		
+		GoldinAsyncReap(inAsync);
+	}
+	
+	tChain=inAsync->freeChains;
+	
+	tName=strrchr(inPath,'/');
+	tName=(tName==NULL) ? inPath : tName+1;
+	
+	tError=GoldinAppleDoubleMakeTemporaryName(tTemporaryName,sizeof(tTemporaryName));
+	
+	if (tError!=0)
+		return tError;
+	
+	tLength=(int) (tName-inPath);
+	
+	tChain->path=strdup(inPath);
+	tChain->appleDoublePath=(char *) malloc(strlen(inPath)+3);
+	tChain->temporaryPath=(char *) malloc(tLength+strlen(tTemporaryName)+1);
+	
+	if (tChain->path==NULL || tChain->appleDoublePath==NULL || tChain->temporaryPath==NULL)
+	{
+		free(tChain->path);
+		tChain->path=NULL;
+		
+		free(tChain->appleDoublePath);
+		tChain->appleDoublePath=NULL;
+		
+		free(tChain->temporaryPath);
+		tChain->temporaryPath=NULL;
+		
+		return ENOMEM;
+	}
+	
+	sprintf(tChain->appleDoublePath,"%.*s._%s",tLength,inPath,tName);
+	sprintf(tChain->temporaryPath,"%.*s%s",tLength,inPath,tTemporaryName);
+	
+	memcpy(tChain->finderInfo,inEntry->finderInfo,sizeof(tChain->finderInfo));
+	tChain->ownerID=inEntry->ownerID;
+	tChain->groupID=inEntry->groupID;
+	tChain->mode=inEntry->mode & 07777;
+	tChain->resourceForkSize=(uint64_t) inEntry->resourceForkSize;
+	tChain->stripResourceFork=inStripResourceFork;
+	tChain->attempts=0;
+	tChain->completion=inCompletion;
+	tChain->context=inContext;
+	
+	tError=GoldinAsyncPrepareBuffer(tChain);
+	
+	if (tError!=0)
+	{
+		free(tChain->path);
+		tChain->path=NULL;
+		
+		free(tChain->appleDoublePath);
+		tChain->appleDoublePath=NULL;
+		
+		free(tChain->temporaryPath);
+		tChain->temporaryPath=NULL;
+		
+		return tError;
+	}
+	
+	inAsync->freeChains=tChain->next;
+	inAsync->busyChainCount++;
+	
+	GoldinAsyncQueueChain(inAsync,tChain);
+	
+	/* The chains are submitted by batches: a quarter of the queue per io_uring_enter */
+	
+	if (inAsync->localTail-__atomic_load_n(inAsync->submissionHead,__ATOMIC_ACQUIRE)>=inAsync->submissionEntries/4)
+		return GoldinAsyncSubmit(inAsync,0);
+	
+	return 0;
+}
+
+int GoldinAsyncWaitUntilDone(GoldinAsyncRef inAsync)
+{
+	if (inAsync==NULL)
+		return 0;
+	
+	GoldinAsyncReap(inAsync);
+	
+	while (inAsync->busyChainCount>0)
+	{
+		int tError=GoldinAsyncSubmit(inAsync,1);
+		
+		if (tError!=0)
+			return tError;
+		
+		GoldinAsyncReap(inAsync);
+	}
+	
+	return 0;
+}
+
+void GoldinAsyncRelease(GoldinAsyncRef inAsync)
+{
+	unsigned int i;
+	
+	if (inAsync==NULL)
+		return;
+	
+	if (inAsync->chains!=NULL)
+	{
+		GoldinAsyncWaitUntilDone(inAsync);
+		
+		for(i=0;i<inAsync->chainCount;i++)
+			free(inAsync->chains[i].buffer);
+		
+		free(inAsync->chains);
+	}
+	
+	if (inAsync->submissionQueueEntries!=MAP_FAILED)
+		munmap(inAsync->submissionQueueEntries,inAsync->submissionQueueEntriesSize);
+	
+	if (inAsync->completionRing!=MAP_FAILED && inAsync->completionRing!=inAsync->submissionRing)
+		munmap(inAsync->completionRing,inAsync->completionRingSize);
+	
+	if (inAsync->submissionRing!=MAP_FAILED)
+		munmap(inAsync->submissionRing,inAsync->submissionRingSize);
+	
+	close(inAsync->descriptor);
+	
+	free(inAsync);
+}
+
+#else
+
+Boolean GoldinAsyncIsAvailable(void)
+{
+	errno=ENOTSUP;
+	
+	return FALSE;
+}
+
+GoldinAsyncRef GoldinAsyncCreate(unsigned int inQueueDepth)
+{
+	(void) inQueueDepth;
+	
+	errno=ENOTSUP;
+	
+	return NULL;
+}
+
+int GoldinAsyncWriteAppleDouble(GoldinAsyncRef inAsync,const char * inPath,const GoldinEntry * inEntry,Boolean inStripResourceFork,GoldinAsyncCompletion inCompletion,void * inContext)
+{
+	(void) inAsync;
+	(void) inPath;
+	(void) inEntry;
+	(void) inStripResourceFork;
+	(void) inCompletion;
+	(void) inContext;
+	
+	return ENOTSUP;
+}
+
+int GoldinAsyncWaitUntilDone(GoldinAsyncRef inAsync)
+{
+	(void) inAsync;
+	
+	return 0;
+}
+
+void GoldinAsyncRelease(GoldinAsyncRef inAsync)
+{
+	(void) inAsync;
+}
+
+#endif
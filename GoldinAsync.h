@@ -0,0 +1,98 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinAsync.h
+              Project: goldin
+
+    Notes:
+
+    o The asynchronous engine (Linux, io_uring). The ._ file of an item is written by a chain of linked operations:
+    
+      getxattr (resource fork) -> openat (temporary name) -> write (header and fork) -> close -> statx
+    
+      Once the chain is complete, the temporary file is renamed over the previous ._ file.
+    
+      The file is opened in a fixed file slot so that the write and the close can be linked to the open. Many chains
+      are kept in flight at the same time: the submissions are only blocking when the ring is full.
+    
+    o The resource fork and the FinderInfo are read from the extended attributes, like the xattr backend does. The fork
+      is written from memory (there is no descriptor to splice from). io_uring has no fchown or fchmod: the permissions
+      are passed to openat and statx tells whether the owner, the group or the umask require a chown(2) or chmod(2).
+    
+    o A ring must only be used by the thread that created it.
+    
+    o Mac OS X: not available (ENOTSUP).
+*/
+
+#ifndef __GOLDIN_ASYNC_H__
+#define __GOLDIN_ASYNC_H__
+
+#include "GoldinCommon.h"
+#include "GoldinEnumerator.h"
+
+#include <stdint.h>
+
+typedef struct _GoldinAsync * GoldinAsyncRef;
+
+typedef enum
+{
+	kGoldinAsyncStageNone=0,
+	kGoldinAsyncStageReadFork,			/* The resource fork could not be read */
+	kGoldinAsyncStageCreate,			/* The ._ file could not be created */
+	kGoldinAsyncStageWrite,				/* The ._ file could not be written */
+	kGoldinAsyncStageClose,				/* The ._ file could not be closed or its owner and permissions could not be set */
+	kGoldinAsyncStageStrip				/* The ._ file was written but the resource fork could not be removed */
+	
+} GoldinAsyncStage;
+
+typedef struct _GoldinAsyncResult
+{
+	int error;							/* 0 or an errno value */
+	GoldinAsyncStage stage;
+	
+	Boolean didSplit;					/* FALSE if there was nothing to split anymore */
+	uint64_t resourceForkSize;
+	
+} GoldinAsyncResult;
+
+/* Called by GoldinAsyncWriteAppleDouble or GoldinAsyncWaitUntilDone on the thread of the ring */
+
+typedef void (*GoldinAsyncCompletion)(const GoldinAsyncResult * inResult,void * inContext);
+
+/* Returns TRUE if the kernel supports all the operations of the chain. Otherwise FALSE and errno is set */
+
+Boolean GoldinAsyncIsAvailable(void);
+
+/* Returns NULL and sets errno on failure. inQueueDepth is the maximum number of operations in flight */
+
+GoldinAsyncRef GoldinAsyncCreate(unsigned int inQueueDepth);
+
+/* Queues the ._ file of the item at inPath. inEntry provides the FinderInfo, the size of the resource fork (as listed),
+   the owner, the group and the permissions. Returns 0, or an errno value if the chain could not be queued */
+
+int GoldinAsyncWriteAppleDouble(GoldinAsyncRef inAsync,const char * inPath,const GoldinEntry * inEntry,Boolean inStripResourceFork,GoldinAsyncCompletion inCompletion,void * inContext);
+
+/* Blocks until all the chains queued have completed. Returns 0, or an errno value if io_uring_enter failed */
+
+int GoldinAsyncWaitUntilDone(GoldinAsyncRef inAsync);
+
+/* Waits for the chains in flight */
+
+void GoldinAsyncRelease(GoldinAsyncRef inAsync);
+
+#endif
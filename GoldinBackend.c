@@ -0,0 +1,116 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinBackend.c
+              Project: goldin
+*/
+
+#include "GoldinBackend.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const GoldinBackend * sBackends[]=
+{
+#ifdef __APPLE__
+	&kGoldinCoreServicesBackend,
+#endif
+	&kGoldinXattrBackend,
+	NULL
+};
+
+const GoldinBackend * GoldinBackendGetDefault(void)
+{
+	return sBackends[0];
+}
+
+const GoldinBackend * GoldinBackendGetNamed(const char * inName)
+{
+	int i;
+	
+	if (inName==NULL)
+		return NULL;
+	
+	for(i=0;sBackends[i]!=NULL;i++)
+	{
+		if (strcmp(sBackends[i]->name,inName)==0)
+			return sBackends[i];
+	}
+	
+	return NULL;
+}
+
+const char * GoldinBackendGetNames(void)
+{
+#ifdef __APPLE__
+	return "coreservices|xattr";
+#else
+	return "xattr";
+#endif
+}
+
+#pragma mark -
+
+#define GOLDIN_ENTRY_LIST_INITIAL_CAPACITY	256
+
+int GoldinEntryListAppend(GoldinEntryList * inList,const GoldinEntry * inEntry)
+{
+	GoldinEntry * tEntry;
+	
+	if (inList->count==inList->capacity)
+	{
+		size_t tCapacity=(inList->capacity==0) ? GOLDIN_ENTRY_LIST_INITIAL_CAPACITY : inList->capacity*2;
+		GoldinEntry * tNewEntries=(GoldinEntry *) realloc(inList->entries,tCapacity*sizeof(GoldinEntry));
+		
+		if (tNewEntries==NULL)
+			return ENOMEM;
+		
+		inList->entries=tNewEntries;
+		inList->capacity=tCapacity;
+	}
+	
+	tEntry=&inList->entries[inList->count];
+	
+	*tEntry=*inEntry;
+	tEntry->name=strdup(inEntry->name);
+	
+	if (tEntry->name==NULL)
+		return ENOMEM;
+	
+	inList->count++;
+	
+	return 0;
+}
+
+void GoldinEntryListRelease(GoldinEntryList * inList)
+{
+	size_t i;
+	
+	if (inList==NULL)
+		return;
+	
+	for(i=0;i<inList->count;i++)
+		free((char *) inList->entries[i].name);
+	
+	free(inList->entries);
+	
+	inList->entries=NULL;
+	inList->count=0;
+	inList->capacity=0;
+}
@@ -0,0 +1,167 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinBackend.h
+              Project: goldin
+
+    Notes:
+
+    o A backend is the way the resource forks and the FinderInfo of a volume are read and the way the ._ files are
+      written. The split engine (GoldinSplit.c) only talks to a backend:
+    
+      coreservices: File Manager (FSRef, FSOpenFork, FSCreateFileUnicode, ...). Mac OS X, hfs volumes only.
+      xattr: POSIX calls and extended attributes (com.apple.* on Mac OS X, user.com.apple.* on Linux).
+    
+    o All the functions return 0 on success or an errno value. The backends log their own errors only when the split
+      engine can not describe them.
+    
+    o A GoldinDirectoryRef does not open the folder before it is needed so that many of them can wait in the work queue.
+      The xattr backend then keeps it open and works relative to its descriptor until it is released.
+*/
+
+#ifndef __GOLDIN_BACKEND_H__
+#define __GOLDIN_BACKEND_H__
+
+#include "GoldinAppleDouble.h"
+#include "GoldinCommon.h"
+#include "GoldinEnumerator.h"
+
+#include <stddef.h>
+#include <sys/types.h>
+
+typedef struct _GoldinDirectory * GoldinDirectoryRef;
+
+typedef struct _GoldinFork * GoldinForkRef;
+
+typedef struct _GoldinAppleDoubleFile * GoldinAppleDoubleFileRef;
+
+/* Returns TRUE if the entry needs to be kept in the list.
+   The entries flagged kGoldinEntryIsUnreadable are passed to the filter so that they can be reported, they are never kept */
+
+typedef Boolean (*GoldinEntryFilter)(const GoldinEntry * inEntry,void * inContext);
+
+typedef struct _GoldinEntryList
+{
+	GoldinEntry * entries;			/* The names are owned by the list */
+	size_t count;
+	size_t capacity;
+	
+} GoldinEntryList;
+
+typedef struct _GoldinBackend
+{
+	const char * name;
+	
+	/* Checks that the volume can be split and returns the maximum length of a file name minus 2 (for the ._ prefix).
+	   ENOTSUP if the volume is not supported. The errors are not logged: the job describes them (Goldin.c) */
+	
+	int (*prepareVolume)(const char * inPath,long * outMaxFileNameLength);
+	
+	/* The first item to split and the folder it lives in. The name of the entry must be freed */
+	
+	int (*copyRoot)(const char * inPath,GoldinDirectoryRef * outParentDirectory,GoldinEntry * outEntry);
+	
+	int (*copyDirectory)(GoldinDirectoryRef inParentDirectory,const GoldinEntry * inEntry,GoldinDirectoryRef * outDirectory);
+	
+	void (*releaseDirectory)(GoldinDirectoryRef inDirectory);
+	
+	/* Snapshot of the contents of the folder: the ._ files created afterwards are not part of it */
+	
+	int (*copyEntries)(GoldinDirectoryRef inDirectory,GoldinEntryFilter inFilter,void * inContext,GoldinEntryList * outList);
+	
+	/* Path of the entry (of the folder if inEntry is NULL), for the messages */
+	
+	int (*copyPath)(GoldinDirectoryRef inDirectory,const GoldinEntry * inEntry,char * outPath,size_t inSize);
+	
+	/* ENOENT if there is no resource fork or if it is empty, EFBIG if it is too big for an AppleDouble file */
+	
+	int (*openResourceFork)(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,GoldinForkRef * outFork,uint64_t * outSize);
+	
+	/* Less than inSize bytes are read only at the end of the fork */
+	
+	int (*readResourceFork)(GoldinForkRef inFork,uint64_t inOffset,void * outBuffer,size_t inSize,size_t * outReadSize);
+	
+	/* -1 if the fork is not a file that can be read with pread (the archive then reads it with readResourceFork) */
+	
+	int (*getResourceForkDescriptor)(GoldinForkRef inFork,off_t * outOffset);
+	
+	void (*closeResourceFork)(GoldinForkRef inFork);
+	
+	int (*deleteResourceFork)(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry);
+	
+	/* Header of the existing ._ file and its modification time in nanoseconds since 1970. ENOENT if there is none */
+	
+	int (*readAppleDouble)(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,uint8_t outHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE],uint64_t * outModificationTime);
+	
+	/* The file is written under a temporary name in the folder of the entry. ENAMETOOLONG, ENOSPC and EDQUOT are reported
+	   by the split engine */
+	
+	int (*createAppleDouble)(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,GoldinAppleDoubleFileRef * outFile);
+	
+	int (*writeAppleDouble)(GoldinAppleDoubleFileRef inFile,const void * inBuffer,size_t inSize);
+	
+	/* -1 if the file can not be used with GoldinCopyClone */
+	
+	int (*getAppleDoubleDescriptor)(GoldinAppleDoubleFileRef inFile,off_t * outOffset);
+	
+	/* If inEntry is not NULL, its owner, group and permissions are applied to the file which then replaces the ._ file of
+	   the entry (rename). Otherwise the temporary file is removed */
+	
+	int (*closeAppleDouble)(GoldinAppleDoubleFileRef inFile,const GoldinEntry * inEntry);
+	
+	/* Replaces the ._ file of the entry with a hard link to inAppleDoublePath, the ._ file of another link to the same item.
+	   EEXIST if it already is a link to this file (nothing is done), EXDEV, EMLINK or EPERM if a link can not be made */
+	
+	int (*linkAppleDouble)(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,const char * inAppleDoublePath);
+	
+	/* Position on the disk of the metadata or resource fork of the entry, to split the items in disk order
+	   (GoldinDiskOrder.h). ENOTSUP if it can not be obtained */
+	
+	int (*getDiskOffset)(GoldinDirectoryRef inDirectory,const GoldinEntry * inEntry,uint64_t * outOffset);
+	
+} GoldinBackend;
+
+#ifdef __APPLE__
+
+extern const GoldinBackend kGoldinCoreServicesBackend;
+
+#endif
+
+extern const GoldinBackend kGoldinXattrBackend;
+
+/* coreservices on Mac OS X, xattr otherwise */
+
+const GoldinBackend * GoldinBackendGetDefault(void);
+
+/* NULL if there is no backend with this name */
+
+const GoldinBackend * GoldinBackendGetNamed(const char * inName);
+
+/* The names of the backends available, separated with | */
+
+const char * GoldinBackendGetNames(void);
+
+#pragma mark -
+
+/* Copies the entry and its name. Returns 0 or ENOMEM */
+
+int GoldinEntryListAppend(GoldinEntryList * inList,const GoldinEntry * inEntry);
+
+void GoldinEntryListRelease(GoldinEntryList * inList);
+
+#endif
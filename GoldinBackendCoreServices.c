@@ -0,0 +1,1117 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinBackendCoreServices.c
+              Project: goldin
+
+    Notes:
+
+    o The File Manager backend (hfs volumes only). The FSRef of an item is cached in the backend data of its entry so
+      that the path is only converted to a FSRef once, when the item needs to be split.
+    
+    o The FinderInfo returned by FSGetCatalogInfo is host endian, it is swapped to the big endian order of the entries.
+*/
+
+#include "GoldinBackend.h"
+
+#ifdef __APPLE__
+
+#include "GoldinCounters.h"
+#include "GoldinDiskOrder.h"
+
+#include <CoreServices/CoreServices.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/param.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+
+#define GOLDIN_CATALOG_INFO_BITMAP	(kFSCatInfoFinderInfo+kFSCatInfoFinderXInfo+kFSCatInfoPermissions+kFSCatInfoNodeFlags+kFSCatInfoAttrMod)
+
+/* Seconds between 01/01/1904 (UTCDateTime) and 01/01/1970 */
+
+#define GOLDIN_UTCDATETIME_EPOCH_OFFSET	2082844800ULL
+
+#define GOLDIN_SNAPSHOT_INITIAL_CAPACITY	256
+
+#define SWAP_RECT(inRect)   do {												\
+								(inRect).top=CFSwapInt16((inRect).top);			\
+								(inRect).left=CFSwapInt16((inRect).left);		\
+								(inRect).bottom=CFSwapInt16((inRect).bottom);	\
+								(inRect).right=CFSwapInt16((inRect).right);		\
+							} while (0);
+							
+#define SWAP_POINT(inPoint)   do {												\
+								(inPoint).h=CFSwapInt16((inPoint).h);			\
+								(inPoint).v=CFSwapInt16((inPoint).v);			\
+							} while (0);
+
+struct _GoldinDirectory
+{
+	char * path;
+	
+	Boolean resolved;
+	FSRef reference;
+};
+
+struct _GoldinFork
+{
+	FSIORefNum forkRefNum;
+};
+
+struct _GoldinAppleDoubleFile
+{
+	FSIORefNum forkRefNum;
+	FSRef reference;
+	
+	char temporaryPath[PATH_MAX*2+1];	/* Renamed to path once complete (the File Manager can not replace a file) */
+	char path[PATH_MAX*2+1];
+};
+
+typedef struct _GoldinCoreServicesEntryData
+{
+	Boolean resolved;
+	FSRef reference;
+	
+} GoldinCoreServicesEntryData;
+
+#define GoldinCoreServicesGetEntryData(inEntry)	((GoldinCoreServicesEntryData *) (inEntry)->backendData.bytes)
+
+/* The name of the resource fork is the same for all the volumes and all the jobs: it is only asked for once */
+
+static HFSUniStr255 sResourceForkName={0,{}};
+static OSErr sResourceForkNameErr=noErr;
+static pthread_once_t sResourceForkNameOnce=PTHREAD_ONCE_INIT;
+
+/* Only HFS volumes are prepared: their names are at most 255 UTF-16 characters long, minus 2 for the ._ prefix */
+
+#define GOLDIN_HFS_MAX_FILE_NAME_LENGTH		(255-2)
+
+static void GoldinCoreServicesGetResourceForkName(void)
+{
+	sResourceForkNameErr=FSGetResourceForkName(&sResourceForkName);
+}
+
+static int GoldinCoreServicesErrorToErrno(OSErr inErr)
+{
+	switch(inErr)
+	{
+		case noErr:
+			return 0;
+		case fnfErr:
+		case dirNFErr:
+		case errFSForkNotFound:
+		case eofErr:
+			return ENOENT;
+		case bdNamErr:
+		case fsmBadFFSNameErr:
+		case errFSNameTooLong:
+			return ENAMETOOLONG;
+		case dskFulErr:
+			return ENOSPC;
+		case errFSQuotaExceeded:
+			return EDQUOT;
+		case dupFNErr:
+			return EEXIST;
+		case memFullErr:
+			return ENOMEM;
+		case afpAccessDenied:
+		case permErr:
+			return EACCES;
+		case afpVolLocked:
+		case wPrErr:
+		case vLckdErr:
+			return EROFS;
+		default:
+			break;
+	}
+	
+	return EIO;
+}
+
+static int GoldinCoreServicesMakePath(const char * inDirectoryPath,const char * inName,char * outPath,size_t inSize)
+{
+	int tLength;
+	
+	if (inName==NULL)
+		tLength=snprintf(outPath,inSize,"%s",inDirectoryPath);
+	else if (inDirectoryPath[0]=='/' && inDirectoryPath[1]=='\0')
+		tLength=snprintf(outPath,inSize,"/%s",inName);
+	else
+		tLength=snprintf(outPath,inSize,"%s/%s",inDirectoryPath,inName);
+	
+	if (tLength<0 || (size_t) tLength>=inSize)
+		return ENAMETOOLONG;
+	
+	return 0;
+}
+
+static void GoldinCoreServicesCopyFinderInfo(FSCatalogInfo * inCatalogInfo,uint8_t outFinderInfo[32])
+{
+#ifdef __LITTLE_ENDIAN__
+
+	/* Intel Processors */
+	
+	/* Even though it's referenced as a bytes field in the File API, this is actually a structure we need to swap... */
+
+	if (inCatalogInfo->nodeFlags & kFSNodeIsDirectoryMask)
+	{
+		/* It's a fragging folder */
+	
+		FolderInfo * tFolderInfoStruct;
+		ExtendedFolderInfo * tExtendedFolderInfoStruct;
+		
+		/* Swap FolderInfo Structure */
+		
+		tFolderInfoStruct=(FolderInfo *) inCatalogInfo->finderInfo;
+		
+		SWAP_RECT(tFolderInfoStruct->windowBounds);
+		tFolderInfoStruct->finderFlags=CFSwapInt16(tFolderInfoStruct->finderFlags);
+		SWAP_POINT(tFolderInfoStruct->location);
+		tFolderInfoStruct->reservedField=CFSwapInt16(tFolderInfoStruct->reservedField);
+		
+		/* Swap ExtendedFolderInfo Info Structure */
+		
+		tExtendedFolderInfoStruct=(ExtendedFolderInfo *) inCatalogInfo->extFinderInfo;
+		
+		SWAP_POINT(tExtendedFolderInfoStruct->scrollPosition);
+		tExtendedFolderInfoStruct->reserved1=CFSwapInt32(tExtendedFolderInfoStruct->reserved1);
+		tExtendedFolderInfoStruct->extendedFinderFlags=CFSwapInt16(tExtendedFolderInfoStruct->extendedFinderFlags);
+		tExtendedFolderInfoStruct->reserved2=CFSwapInt16(tExtendedFolderInfoStruct->reserved2);
+		tExtendedFolderInfoStruct->putAwayFolderID=CFSwapInt32(tExtendedFolderInfoStruct->putAwayFolderID);
+	}
+	else
+	{
+		/* I'm just a file, you know */
+		
+		FileInfo * tFileInfoStruct;
+		ExtendedFileInfo * tExtendedFileInfoStruct;
+		
+		/* Swap FileInfo Structure */
+		
+		tFileInfoStruct=(FileInfo *) inCatalogInfo->finderInfo;
+		
+		tFileInfoStruct->fileType=CFSwapInt32(tFileInfoStruct->fileType);
+		tFileInfoStruct->fileCreator=CFSwapInt32(tFileInfoStruct->fileCreator);
+		tFileInfoStruct->finderFlags=CFSwapInt16(tFileInfoStruct->finderFlags);
+		SWAP_POINT(tFileInfoStruct->location);
+		tFileInfoStruct->reservedField=CFSwapInt16(tFileInfoStruct->reservedField);
+		
+		/* Swap ExtendedFileInfo Structure */
+		
+		tExtendedFileInfoStruct=(ExtendedFileInfo *) inCatalogInfo->extFinderInfo;
+		
+		tExtendedFileInfoStruct->reserved1[0]=CFSwapInt16(tExtendedFileInfoStruct->reserved1[0]);
+		tExtendedFileInfoStruct->reserved1[1]=CFSwapInt16(tExtendedFileInfoStruct->reserved1[1]);
+		tExtendedFileInfoStruct->reserved1[2]=CFSwapInt16(tExtendedFileInfoStruct->reserved1[2]);
+		tExtendedFileInfoStruct->reserved1[3]=CFSwapInt16(tExtendedFileInfoStruct->reserved1[3]);
+		tExtendedFileInfoStruct->extendedFinderFlags=CFSwapInt16(tExtendedFileInfoStruct->extendedFinderFlags);
+		tExtendedFileInfoStruct->reserved2=CFSwapInt16(tExtendedFileInfoStruct->reserved2);
+		tExtendedFileInfoStruct->putAwayFolderID=CFSwapInt32(tExtendedFileInfoStruct->putAwayFolderID);
+	}
+
+#endif
+	
+	memcpy(outFinderInfo,inCatalogInfo->finderInfo,16);
+	memcpy(outFinderInfo+16,inCatalogInfo->extFinderInfo,16);
+}
+
+static void GoldinCoreServicesFillEntry(GoldinEntry * outEntry,FSCatalogInfo * inCatalogInfo,const FSRef * inReference)
+{
+	FSPermissionInfo * tPermissionInfo=(FSPermissionInfo *) inCatalogInfo->permissions;
+	GoldinCoreServicesEntryData * tEntryData=GoldinCoreServicesGetEntryData(outEntry);
+	
+	memset(outEntry,0,sizeof(GoldinEntry));
+	
+	if (inCatalogInfo->nodeFlags & kFSNodeIsDirectoryMask)
+		outEntry->flags|=kGoldinEntryIsDirectory;
+	
+	if (inCatalogInfo->nodeFlags & kFSNodeHardLinkMask)
+		outEntry->flags|=kGoldinEntryIsHardLink;
+	
+	if ((tPermissionInfo->mode & S_IFMT)==S_IFLNK)
+		outEntry->flags|=kGoldinEntryIsSymbolicLink;
+	
+	outEntry->ownerID=tPermissionInfo->userID;
+	outEntry->groupID=tPermissionInfo->groupID;
+	outEntry->mode=tPermissionInfo->mode & 07777;
+	
+	/* The attribute modification date is the change time of the File Manager */
+	
+	{
+		uint64_t tSeconds=(((uint64_t) inCatalogInfo->attributeModDate.highSeconds)<<32)+inCatalogInfo->attributeModDate.lowSeconds;
+		
+		if (tSeconds>GOLDIN_UTCDATETIME_EPOCH_OFFSET)
+			outEntry->changeTime=(tSeconds-GOLDIN_UTCDATETIME_EPOCH_OFFSET)*1000000000ULL+(((uint64_t) inCatalogInfo->attributeModDate.fraction)*1000000000ULL)/65536;
+	}
+	
+	/* Not asked to the File Manager, the fork is opened when needed */
+	
+	outEntry->resourceForkSize=kGoldinUnknownSize;
+	
+	GoldinCoreServicesCopyFinderInfo(inCatalogInfo,outEntry->finderInfo);
+	
+	tEntryData->resolved=TRUE;
+	tEntryData->reference=*inReference;
+}
+
+static int GoldinCoreServicesResolveDirectory(GoldinDirectoryRef inDirectory)
+{
+	OSErr tErr;
+	
+	if (inDirectory->resolved==TRUE)
+		return 0;
+	
+	tErr=FSPathMakeRef((const UInt8 *) inDirectory->path,&inDirectory->reference,NULL);
+	
+	GoldinCounterIncrement(kGoldinCounterReferenceLookups);
+	
+	if (tErr!=noErr)
+		return GoldinCoreServicesErrorToErrno(tErr);
+	
+	inDirectory->resolved=TRUE;
+	
+	return 0;
+}
+
+static int GoldinCoreServicesResolveEntry(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry)
+{
+	GoldinCoreServicesEntryData * tEntryData=GoldinCoreServicesGetEntryData(inEntry);
+	char tPath[PATH_MAX*2+1];
+	OSErr tErr;
+	int tError;
+	
+	if (tEntryData->resolved==TRUE)
+		return 0;
+	
+	tError=GoldinCoreServicesMakePath(inDirectory->path,inEntry->name,tPath,sizeof(tPath));
+	
+	if (tError!=0)
+		return tError;
+	
+	tErr=FSPathMakeRefWithOptions((const UInt8 *) tPath,kFSPathMakeRefDoNotFollowLeafSymlink,&tEntryData->reference,NULL);
+	
+	GoldinCounterIncrement(kGoldinCounterReferenceLookups);
+	
+	if (tErr!=noErr)
+		return GoldinCoreServicesErrorToErrno(tErr);
+	
+	tEntryData->resolved=TRUE;
+	
+	return 0;
+}
+
+static GoldinDirectoryRef GoldinCoreServicesCreateDirectory(const char * inPath,size_t inLength)
+{
+	GoldinDirectoryRef tDirectory=(GoldinDirectoryRef) malloc(sizeof(struct _GoldinDirectory));
+	
+	if (tDirectory==NULL)
+		return NULL;
+	
+	tDirectory->path=strndup(inPath,inLength);
+	tDirectory->resolved=FALSE;
+	
+	if (tDirectory->path==NULL)
+	{
+		free(tDirectory);
+		
+		return NULL;
+	}
+	
+	return tDirectory;
+}
+
+#pragma mark -
+
+static int GoldinCoreServicesPrepareVolume(const char * inPath,long * outMaxFileNameLength)
+{
+	struct statfs tStatFileSystem;
+	long tMaxFileNameLength;
+	OSErr tErr;
+	
+	if (statfs(inPath,&tStatFileSystem)!=0)
+		return errno;
+	
+	/* Not an hfs disk */
+	
+	if (strcmp(tStatFileSystem.f_fstypename,"hfs")!=0)
+		return ENOTSUP;
+	
+	tMaxFileNameLength=pathconf(inPath,_PC_NAME_MAX);
+	
+	if (tMaxFileNameLength<0)
+		return errno;
+	
+	pthread_once(&sResourceForkNameOnce,GoldinCoreServicesGetResourceForkName);
+	
+	tErr=sResourceForkNameErr;
+	
+	if (tErr!=noErr)
+		return GoldinCoreServicesErrorToErrno(tErr);
+	
+	*outMaxFileNameLength=tMaxFileNameLength-2;
+	
+	return 0;
+}
+
+static int GoldinCoreServicesCopyRoot(const char * inPath,GoldinDirectoryRef * outParentDirectory,GoldinEntry * outEntry)
+{
+	FSRef tReference;
+	FSRef tParentReference;
+	FSCatalogInfo tInfo;
+	const char * tName;
+	GoldinDirectoryRef tParentDirectory;
+	OSErr tErr;
+	
+	memset(outEntry,0,sizeof(GoldinEntry));
+	
+	tName=strrchr(inPath,'/');
+	
+	if (tName==NULL || tName[1]=='\0')
+		return EINVAL;		/* The root of the volume does not have a ._ file */
+	
+	tErr=FSPathMakeRef((const UInt8 *) inPath,&tReference,NULL);
+	
+	GoldinCounterIncrement(kGoldinCounterReferenceLookups);
+	
+	if (tErr!=noErr)
+		return GoldinCoreServicesErrorToErrno(tErr);
+	
+	tErr=FSGetCatalogInfo(&tReference,GOLDIN_CATALOG_INFO_BITMAP,&tInfo,NULL,NULL,&tParentReference);
+	
+	GoldinCounterIncrement(kGoldinCounterItems);
+	GoldinCounterIncrement(kGoldinCounterCatalogReads);
+	
+	if (tErr!=noErr)
+		return GoldinCoreServicesErrorToErrno(tErr);
+	
+	GoldinCoreServicesFillEntry(outEntry,&tInfo,&tReference);
+	
+	tParentDirectory=GoldinCoreServicesCreateDirectory((tName==inPath) ? "/" : inPath,(tName==inPath) ? 1 : (size_t) (tName-inPath));
+	
+	if (tParentDirectory==NULL)
+		return ENOMEM;
+	
+	tParentDirectory->resolved=TRUE;
+	tParentDirectory->reference=tParentReference;
+	
+	outEntry->name=strdup(tName+1);
+	
+	if (outEntry->name==NULL)
+	{
+		free(tParentDirectory->path);
+		free(tParentDirectory);
+		
+		return ENOMEM;
+	}
+	
+	*outParentDirectory=tParentDirectory;
+	
+	return 0;
+}
+
+static int GoldinCoreServicesCopyDirectory(GoldinDirectoryRef inParentDirectory,const GoldinEntry * inEntry,GoldinDirectoryRef * outDirectory)
+{
+	char tPath[PATH_MAX*2+1];
+	GoldinDirectoryRef tDirectory;
+	const GoldinCoreServicesEntryData * tEntryData=(const GoldinCoreServicesEntryData *) inEntry->backendData.bytes;
+	int tError;
+	
+	tError=GoldinCoreServicesMakePath(inParentDirectory->path,inEntry->name,tPath,sizeof(tPath));
+	
+	if (tError!=0)
+		return tError;
+	
+	tDirectory=GoldinCoreServicesCreateDirectory(tPath,strlen(tPath));
+	
+	if (tDirectory==NULL)
+		return ENOMEM;
+	
+	if (tEntryData->resolved==TRUE)
+	{
+		tDirectory->resolved=TRUE;
+		tDirectory->reference=tEntryData->reference;
+	}
+	
+	*outDirectory=tDirectory;
+	
+	return 0;
+}
+
+static void GoldinCoreServicesReleaseDirectory(GoldinDirectoryRef inDirectory)
+{
+	if (inDirectory==NULL)
+		return;
+	
+	free(inDirectory->path);
+	free(inDirectory);
+}
+
+/* Returns ENOTSUP if the folder can not be listed in bulk */
+
+static int GoldinCoreServicesCopyEntriesInBulk(GoldinDirectoryRef inDirectory,GoldinEntryFilter inFilter,void * inContext,GoldinEntryList * outList)
+{
+	int tDirectoryDescriptor;
+	GoldinEnumeratorRef tEnumerator;
+	int tError=0;
+	
+	tDirectoryDescriptor=open(inDirectory->path,O_RDONLY);
+	
+	if (tDirectoryDescriptor==-1)
+		return ENOTSUP;
+	
+	tEnumerator=GoldinEnumeratorCreate(tDirectoryDescriptor);
+	
+	if (tEnumerator==NULL)
+	{
+		close(tDirectoryDescriptor);
+		
+		return ENOTSUP;
+	}
+	
+	/* The ._ files we create are not part of this list so we can create them while walking it */
+	
+	while (tError==0)
+	{
+		GoldinEntry * tEntries;
+		size_t tCount;
+		size_t i;
+		
+		if (GoldinEnumeratorGetEntries(tEnumerator,&tEntries,&tCount)!=0)
+		{
+			tError=ENOTSUP;
+			break;
+		}
+		
+		if (tCount==0)
+			break;
+		
+		for(i=0;i<tCount && tError==0;i++)
+		{
+			if (inFilter!=NULL && inFilter(&tEntries[i],inContext)==FALSE)
+				continue;
+			
+			if ((tEntries[i].flags & kGoldinEntryIsUnreadable)!=0)
+				continue;
+			
+			tError=GoldinEntryListAppend(outList,&tEntries[i]);
+		}
+	}
+	
+	GoldinEnumeratorRelease(tEnumerator);
+	
+	close(tDirectoryDescriptor);
+	
+	return tError;
+}
+
+static OSErr GoldinCoreServicesCopyChildren(FSRef * inFileReferencePtr,FSRef ** outReferences,ItemCount * outNumberOfReferences)
+{
+	FSIterator tIterator;
+	FSRef * tReferences=NULL;
+	ItemCount tCapacity=0;
+	ItemCount tCount=0;
+	OSErr tErr;
+	
+	*outReferences=NULL;
+	*outNumberOfReferences=0;
+	
+	tErr=FSOpenIterator(inFileReferencePtr,kFSIterateFlat,&tIterator);
+	
+	if (tErr!=noErr)
+		return tErr;
+	
+	do
+	{
+		ItemCount tFoundItems=0;
+		
+		if (tCount==tCapacity)
+		{
+			FSRef * tNewReferences;
+			
+			tCapacity=(tCapacity==0) ? GOLDIN_SNAPSHOT_INITIAL_CAPACITY : tCapacity*2;
+			
+			tNewReferences=(FSRef *) realloc(tReferences,tCapacity*sizeof(FSRef));
+			
+			if (tNewReferences==NULL)
+			{
+				tErr=memFullErr;
+				break;
+			}
+			
+			tReferences=tNewReferences;
+		}
+		
+		/* Only the references are requested, FSGetCatalogInfoBulk is buggy on Yosemite when asked for Catalog Information */
+		
+		tErr=FSGetCatalogInfoBulk(tIterator,tCapacity-tCount,&tFoundItems,NULL,kFSCatInfoNone,NULL,tReferences+tCount,NULL,NULL);
+		
+		GoldinCounterIncrement(kGoldinCounterDirectoryReads);
+		
+		if (tErr==noErr || tErr==errFSNoMoreItems)
+			tCount+=tFoundItems;
+	}
+	while (tErr==noErr);
+	
+	FSCloseIterator(tIterator);
+	
+	if (tErr!=errFSNoMoreItems)
+	{
+		free(tReferences);
+		
+		return tErr;
+	}
+	
+	*outReferences=tReferences;
+	*outNumberOfReferences=tCount;
+	
+	GoldinCounterAdd(kGoldinCounterItems,tCount);
+	
+	return noErr;
+}
+
+static int GoldinCoreServicesCopyEntries(GoldinDirectoryRef inDirectory,GoldinEntryFilter inFilter,void * inContext,GoldinEntryList * outList)
+{
+	FSRef * tFoundReferences;
+	ItemCount tNumberOfReferences;
+	ItemCount i;
+	OSErr tErr;
+	int tError;
+	
+	memset(outList,0,sizeof(GoldinEntryList));
+	
+	tError=GoldinCoreServicesCopyEntriesInBulk(inDirectory,inFilter,inContext,outList);
+	
+	if (tError!=ENOTSUP)
+	{
+		if (tError!=0)
+			GoldinEntryListRelease(outList);
+		
+		return tError;
+	}
+	
+	/* The folder could not be listed in bulk, use the File Manager iterator */
+	
+	GoldinEntryListRelease(outList);
+	
+	tError=GoldinCoreServicesResolveDirectory(inDirectory);
+	
+	if (tError!=0)
+		return tError;
+	
+	tErr=GoldinCoreServicesCopyChildren(&inDirectory->reference,&tFoundReferences,&tNumberOfReferences);
+	
+	if (tErr!=noErr)
+		return GoldinCoreServicesErrorToErrno(tErr);
+	
+	for(i=0;i<tNumberOfReferences && tError==0;i++)
+	{
+		FSCatalogInfo tInfo;
+		HFSUniStr255 tUnicodeFileName;
+		char tName[PATH_MAX];
+		CFStringRef tNameString;
+		GoldinEntry tEntry;
+		
+		/* Retrieve the CatalogInfo with FSGetCatalogInfo because FSGetCatalogInfoBulk is buggy on Yosemite */
+		
+		tErr=FSGetCatalogInfo(&tFoundReferences[i],GOLDIN_CATALOG_INFO_BITMAP,&tInfo,&tUnicodeFileName,NULL,NULL);
+		
+		GoldinCounterIncrement(kGoldinCounterCatalogReads);
+		
+		if (tErr==noErr)
+		{
+			GoldinCoreServicesFillEntry(&tEntry,&tInfo,&tFoundReferences[i]);
+		}
+		else
+		{
+			/* Only the name is needed to report the item */
+			
+			if (FSGetCatalogInfo(&tFoundReferences[i],kFSCatInfoNone,NULL,&tUnicodeFileName,NULL,NULL)!=noErr)
+				continue;
+			
+			memset(&tEntry,0,sizeof(GoldinEntry));
+			
+			tEntry.flags=kGoldinEntryIsUnreadable;
+			tEntry.error=GoldinCoreServicesErrorToErrno(tErr);
+		}
+		
+		tNameString=CFStringCreateWithCharacters(kCFAllocatorDefault,tUnicodeFileName.unicode,tUnicodeFileName.length);
+		
+		if (tNameString==NULL)
+		{
+			tError=ENOMEM;
+			
+			break;
+		}
+		
+		if (CFStringGetFileSystemRepresentation(tNameString,tName,sizeof(tName))==FALSE)
+			tName[0]='\0';
+		
+		CFRelease(tNameString);
+		
+		if (tName[0]=='\0')
+			continue;
+		
+		tEntry.name=tName;
+		
+		if (inFilter!=NULL && inFilter(&tEntry,inContext)==FALSE)
+			continue;
+		
+		if ((tEntry.flags & kGoldinEntryIsUnreadable)!=0)
+			continue;
+		
+		tError=GoldinEntryListAppend(outList,&tEntry);
+	}
+	
+	free(tFoundReferences);
+	
+	if (tError!=0)
+		GoldinEntryListRelease(outList);
+	
+	return tError;
+}
+
+static int GoldinCoreServicesCopyPath(GoldinDirectoryRef inDirectory,const GoldinEntry * inEntry,char * outPath,size_t inSize)
+{
+	return GoldinCoreServicesMakePath(inDirectory->path,(inEntry!=NULL) ? inEntry->name : NULL,outPath,inSize);
+}
+
+#pragma mark -
+
+static int GoldinCoreServicesOpenResourceFork(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,GoldinForkRef * outFork,uint64_t * outSize)
+{
+	FSIORefNum tForkRefNum;
+	SInt64 tForkSize;
+	GoldinForkRef tFork;
+	OSErr tErr;
+	int tError;
+	
+	tError=GoldinCoreServicesResolveEntry(inDirectory,inEntry);
+	
+	if (tError!=0)
+		return tError;
+	
+	tErr=FSOpenFork(&GoldinCoreServicesGetEntryData(inEntry)->reference,sResourceForkName.length,sResourceForkName.unicode,fsRdPerm,&tForkRefNum);
+	
+	if (tErr!=noErr)
+		return GoldinCoreServicesErrorToErrno(tErr);
+	
+	/* Get the size of the resource fork */
+	
+	tErr=FSGetForkSize(tForkRefNum,&tForkSize);
+	
+	if (tErr!=noErr)
+	{
+		FSCloseFork(tForkRefNum);
+		
+		return GoldinCoreServicesErrorToErrno(tErr);
+	}
+	
+	if (tForkSize<=0 || tForkSize>0xFFFFFFFF)
+	{
+		FSCloseFork(tForkRefNum);
+		
+		return (tForkSize<=0) ? ENOENT : EFBIG;
+	}
+	
+	tFork=(GoldinForkRef) malloc(sizeof(struct _GoldinFork));
+	
+	if (tFork==NULL)
+	{
+		FSCloseFork(tForkRefNum);
+		
+		return ENOMEM;
+	}
+	
+	tFork->forkRefNum=tForkRefNum;
+	
+	*outFork=tFork;
+	*outSize=(uint64_t) tForkSize;
+	
+	return 0;
+}
+
+static int GoldinCoreServicesReadResourceFork(GoldinForkRef inFork,uint64_t inOffset,void * outBuffer,size_t inSize,size_t * outReadSize)
+{
+	ByteCount tReadActualCount=0;
+	OSErr tErr;
+	
+	tErr=FSReadFork(inFork->forkRefNum,fsFromStart,(SInt64) inOffset,inSize,outBuffer,&tReadActualCount);
+	
+	*outReadSize=tReadActualCount;
+	
+	if (tErr!=noErr && tErr!=eofErr)
+		return GoldinCoreServicesErrorToErrno(tErr);
+	
+	return 0;
+}
+
+static int GoldinCoreServicesGetResourceForkDescriptor(GoldinForkRef inFork,off_t * outOffset)
+{
+	/* The File Manager only gives us fork reference numbers */
+	
+	(void) inFork;
+	
+	*outOffset=0;
+	
+	return -1;
+}
+
+static void GoldinCoreServicesCloseResourceFork(GoldinForkRef inFork)
+{
+	if (inFork==NULL)
+		return;
+	
+	FSCloseFork(inFork->forkRefNum);
+	
+	free(inFork);
+}
+
+static int GoldinCoreServicesDeleteResourceFork(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry)
+{
+	OSErr tErr;
+	int tError;
+	
+	tError=GoldinCoreServicesResolveEntry(inDirectory,inEntry);
+	
+	if (tError!=0)
+		return tError;
+	
+	tErr=FSDeleteFork(&GoldinCoreServicesGetEntryData(inEntry)->reference,sResourceForkName.length,sResourceForkName.unicode);
+	
+	if (tErr==errFSForkNotFound)
+	{
+		/* This is not important */
+		
+		return 0;
+	}
+	
+	return GoldinCoreServicesErrorToErrno(tErr);
+}
+
+#pragma mark -
+
+static int GoldinCoreServicesReadAppleDouble(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,uint8_t outHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE],uint64_t * outModificationTime)
+{
+	char tPath[PATH_MAX*2+1];
+	struct stat tStat;
+	ssize_t tRead;
+	int tDescriptor;
+	int tError=0;
+	int tLength;
+	
+	/* A plain read is enough, the ._ file does not have a resource fork */
+	
+	if (inDirectory->path[0]=='/' && inDirectory->path[1]=='\0')
+		tLength=snprintf(tPath,sizeof(tPath),"/._%s",inEntry->name);
+	else
+		tLength=snprintf(tPath,sizeof(tPath),"%s/._%s",inDirectory->path,inEntry->name);
+	
+	if (tLength<0 || (size_t) tLength>=sizeof(tPath))
+		return ENAMETOOLONG;
+	
+	tDescriptor=open(tPath,O_RDONLY|O_NOFOLLOW);
+	
+	if (tDescriptor==-1)
+		return errno;
+	
+	if (fstat(tDescriptor,&tStat)!=0)
+	{
+		tError=errno;
+	}
+	else
+	{
+		tRead=pread(tDescriptor,outHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE,0);
+		
+		if (tRead<0)
+			tError=errno;
+		else if (tRead<GOLDIN_APPLEDOUBLE_HEADER_SIZE)
+			tError=EINVAL;		/* Not one of ours */
+		
+		*outModificationTime=(uint64_t) tStat.st_mtimespec.tv_sec*1000000000ULL+(uint64_t) tStat.st_mtimespec.tv_nsec;
+	}
+	
+	close(tDescriptor);
+	
+	return tError;
+}
+
+static int GoldinCoreServicesCreateAppleDouble(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,GoldinAppleDoubleFileRef * outFile)
+{
+	CFStringRef tNameString;
+	CFIndex tLength;
+	HFSUniStr255 tNewFileName;
+	char tTemporaryName[NAME_MAX];
+	FSRef tNewFileReference;
+	FSIORefNum tNewFileRefNum;
+	GoldinAppleDoubleFileRef tFile;
+	OSErr tErr;
+	int tError;
+	size_t i;
+	
+	tError=GoldinCoreServicesResolveDirectory(inDirectory);
+	
+	if (tError!=0)
+		return tError;
+	
+	tNameString=CFStringCreateWithFileSystemRepresentation(kCFAllocatorDefault,inEntry->name);
+	
+	if (tNameString==NULL)
+		return ENOMEM;
+	
+	tLength=CFStringGetLength(tNameString);
+	
+	/* Check that we do not explode the current limit for file names */
+	
+	if (tLength>GOLDIN_HFS_MAX_FILE_NAME_LENGTH)
+	{
+		/* We do not have enough space to add the ._ prefix */
+		
+		CFRelease(tNameString);
+		
+		return ENAMETOOLONG;
+	}
+	
+	CFRelease(tNameString);
+	
+	tFile=(GoldinAppleDoubleFileRef) malloc(sizeof(struct _GoldinAppleDoubleFile));
+	
+	if (tFile==NULL)
+		return ENOMEM;
+	
+	if (inDirectory->path[0]=='/' && inDirectory->path[1]=='\0')
+		tLength=snprintf(tFile->path,sizeof(tFile->path),"/._%s",inEntry->name);
+	else
+		tLength=snprintf(tFile->path,sizeof(tFile->path),"%s/._%s",inDirectory->path,inEntry->name);
+	
+	if (tLength<0 || (size_t) tLength>=sizeof(tFile->path))
+	{
+		free(tFile);
+		
+		return ENAMETOOLONG;
+	}
+	
+	/* The ._ file is written under a temporary name (ASCII only) and renamed over the previous one when it is closed */
+	
+	do
+	{
+		tError=GoldinAppleDoubleMakeTemporaryName(tTemporaryName,sizeof(tTemporaryName));
+		
+		if (tError==0)
+			tError=GoldinCoreServicesMakePath(inDirectory->path,tTemporaryName,tFile->temporaryPath,sizeof(tFile->temporaryPath));
+		
+		if (tError!=0)
+		{
+			free(tFile);
+			
+			return tError;
+		}
+		
+		tNewFileName.length=(UInt16) strlen(tTemporaryName);
+		
+		for(i=0;i<tNewFileName.length;i++)
+			tNewFileName.unicode[i]=(UniChar) tTemporaryName[i];
+		
+		/* Left by a run that died with the same process ID: try the next name */
+		
+		tErr=FSCreateFileUnicode(&inDirectory->reference,tNewFileName.length,tNewFileName.unicode,0,NULL,&tNewFileReference,NULL);
+	}
+	while (tErr==dupFNErr);
+	
+	if (tErr!=noErr)
+	{
+		free(tFile);
+		
+		return GoldinCoreServicesErrorToErrno(tErr);
+	}
+	
+	tErr=FSOpenFork(&tNewFileReference,0,NULL,fsWrPerm,&tNewFileRefNum);
+	
+	if (tErr!=noErr)
+	{
+		FSDeleteObject(&tNewFileReference);
+		
+		free(tFile);
+		
+		return GoldinCoreServicesErrorToErrno(tErr);
+	}
+	
+	tFile->forkRefNum=tNewFileRefNum;
+	tFile->reference=tNewFileReference;
+	
+	*outFile=tFile;
+	
+	return 0;
+}
+
+static int GoldinCoreServicesWriteAppleDouble(GoldinAppleDoubleFileRef inFile,const void * inBuffer,size_t inSize)
+{
+	return GoldinCoreServicesErrorToErrno(FSWriteFork(inFile->forkRefNum,fsAtMark,0,inSize,inBuffer,NULL));
+}
+
+static int GoldinCoreServicesGetAppleDoubleDescriptor(GoldinAppleDoubleFileRef inFile,off_t * outOffset)
+{
+	(void) inFile;
+	
+	*outOffset=0;
+	
+	return -1;
+}
+
+static int GoldinCoreServicesCloseAppleDouble(GoldinAppleDoubleFileRef inFile,const GoldinEntry * inEntry)
+{
+	OSErr tErr;
+	int tError;
+	
+	tErr=FSCloseFork(inFile->forkRefNum);
+	
+	if (tErr==noErr && inEntry!=NULL)
+	{
+		FSCatalogInfo tInfo;
+		FSPermissionInfo * tPermissionInfo=(FSPermissionInfo *) tInfo.permissions;
+		
+		/* Set the owner */
+		
+		memset(&tInfo,0,sizeof(FSCatalogInfo));
+		
+		tPermissionInfo->userID=inEntry->ownerID;
+		tPermissionInfo->groupID=inEntry->groupID;
+		tPermissionInfo->mode=S_IFREG | (inEntry->mode & 07777);
+		
+		tErr=FSSetCatalogInfo(&inFile->reference,kFSCatInfoPermissions,&tInfo);
+	}
+	
+	tError=GoldinCoreServicesErrorToErrno(tErr);
+	
+	/* The previous ._ file is replaced at once */
+	
+	if (tError==0 && inEntry!=NULL && rename(inFile->temporaryPath,inFile->path)!=0)
+		tError=errno;
+	
+	if (tError!=0 || inEntry==NULL)
+		FSDeleteObject(&inFile->reference);
+	
+	free(inFile);
+	
+	return tError;
+}
+
+static int GoldinCoreServicesLinkAppleDouble(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,const char * inAppleDoublePath)
+{
+	char tPath[PATH_MAX*2+1];
+	char tTemporaryPath[PATH_MAX*2+1];
+	struct stat tSourceStat;
+	struct stat tStat;
+	int tLength;
+	int tError=0;
+	
+	/* The File Manager can not create hard links, hfs volumes support link(2) for files */
+	
+	if (inDirectory->path[0]=='/' && inDirectory->path[1]=='\0')
+		tLength=snprintf(tPath,sizeof(tPath),"/._%s",inEntry->name);
+	else
+		tLength=snprintf(tPath,sizeof(tPath),"%s/._%s",inDirectory->path,inEntry->name);
+	
+	if (tLength<0 || (size_t) tLength>=sizeof(tPath))
+		return ENAMETOOLONG;
+	
+	if (lstat(inAppleDoublePath,&tSourceStat)!=0)
+		return errno;
+	
+	if (lstat(tPath,&tStat)==0 && tStat.st_dev==tSourceStat.st_dev && tStat.st_ino==tSourceStat.st_ino)
+		return EEXIST;
+	
+	/* The link is made under a temporary name and renamed over the previous ._ file */
+	
+	while (1)
+	{
+		char tName[NAME_MAX];
+		
+		tError=GoldinAppleDoubleMakeTemporaryName(tName,sizeof(tName));
+		
+		if (tError==0)
+			tError=GoldinCoreServicesMakePath(inDirectory->path,tName,tTemporaryPath,sizeof(tTemporaryPath));
+		
+		if (tError!=0)
+			return tError;
+		
+		if (link(inAppleDoublePath,tTemporaryPath)==0)
+			break;
+		
+		if (errno!=EEXIST)
+			return errno;
+	}
+	
+	if (rename(tTemporaryPath,tPath)!=0)
+		tError=errno;
+	
+	/* rename does nothing if both names are links to the same file */
+	
+	unlink(tTemporaryPath);
+	
+	return tError;
+}
+
+#pragma mark -
+
+/* The resource fork is located through its path */
+
+static int GoldinCoreServicesGetDiskOffset(GoldinDirectoryRef inDirectory,const GoldinEntry * inEntry,uint64_t * outOffset)
+{
+	char tPath[PATH_MAX];
+	int tError;
+	
+	tError=GoldinCoreServicesCopyPath(inDirectory,inEntry,tPath,PATH_MAX);
+	
+	if (tError!=0)
+		return tError;
+	
+	return GoldinDiskOrderGetOffset(AT_FDCWD,tPath,outOffset);
+}
+
+const GoldinBackend kGoldinCoreServicesBackend=
+{
+	"coreservices",
+	GoldinCoreServicesPrepareVolume,
+	GoldinCoreServicesCopyRoot,
+	GoldinCoreServicesCopyDirectory,
+	GoldinCoreServicesReleaseDirectory,
+	GoldinCoreServicesCopyEntries,
+	GoldinCoreServicesCopyPath,
+	GoldinCoreServicesOpenResourceFork,
+	GoldinCoreServicesReadResourceFork,
+	GoldinCoreServicesGetResourceForkDescriptor,
+	GoldinCoreServicesCloseResourceFork,
+	GoldinCoreServicesDeleteResourceFork,
+	GoldinCoreServicesReadAppleDouble,
+	GoldinCoreServicesCreateAppleDouble,
+	GoldinCoreServicesWriteAppleDouble,
+	GoldinCoreServicesGetAppleDoubleDescriptor,
+	GoldinCoreServicesCloseAppleDouble,
+	GoldinCoreServicesLinkAppleDouble,
+	GoldinCoreServicesGetDiskOffset
+};
+
+#endif
@@ -0,0 +1,960 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinBackendXattr.c
+              Project: goldin
+
+    Notes:
+
+    o The FinderInfo and the resource fork are read from the extended attributes and the ._ files are created with
+      open(2) under a temporary name, then renamed over the previous ._ file. This backend does not depend on the
+      volume format.
+    
+    o Mac OS X: the resource fork is read through the ..namedfork/rsrc path so that it can be copied like a file.
+      Linux: there is no such path, the whole extended attribute is loaded.
+    
+    o A folder is opened when its contents are listed and stays open until it is released: the items are then
+      reached relative to its descriptor (openat, fstatat, unlinkat, GoldinXattr*At) instead of walking their whole
+      path again. The absolute paths are only built for the messages.
+*/
+
+#include "GoldinBackend.h"
+
+#include "GoldinCounters.h"
+#include "GoldinDiskOrder.h"
+#include "GoldinXattr.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#ifdef __APPLE__
+#include <sys/paths.h>
+#endif
+
+#ifdef __APPLE__
+#define GoldinStatTime(inStat,inField)	((uint64_t) (inStat)->st_##inField##timespec.tv_sec*1000000000ULL+(uint64_t) (inStat)->st_##inField##timespec.tv_nsec)
+#else
+#define GoldinStatTime(inStat,inField)	((uint64_t) (inStat)->st_##inField##tim.tv_sec*1000000000ULL+(uint64_t) (inStat)->st_##inField##tim.tv_nsec)
+#endif
+
+/* Past this number of open folders, the items are found through their paths (the folders of a very deep tree are
+   all open when it is split on the main thread). The folders of a tree share this budget, the trees of the other jobs
+   have their own */
+
+#define GOLDIN_XATTR_MAX_OPEN_DIRECTORIES	256
+
+typedef struct _GoldinXattrTree
+{
+	volatile long openDirectoryCount;
+	volatile long referenceCount;		/* Folders of the tree */
+	
+} GoldinXattrTree;
+
+struct _GoldinDirectory
+{
+	char * path;
+	
+	int descriptor;		/* -1 until the folder is needed */
+	
+	GoldinXattrTree * tree;
+};
+
+struct _GoldinFork
+{
+	int descriptor;		/* -1 when the fork is in memory */
+	
+	uint8_t * bytes;
+	uint64_t size;
+};
+
+struct _GoldinAppleDoubleFile
+{
+	int descriptor;
+	
+	int directoryDescriptor;
+	char temporaryPath[PATH_MAX];	/* Renamed to path once complete */
+	char path[PATH_MAX];
+};
+
+static int GoldinXattrMakePath(const char * inDirectoryPath,const char * inPrefix,const char * inName,char * outPath,size_t inSize)
+{
+	int tLength;
+	
+	if (inName==NULL)
+		tLength=snprintf(outPath,inSize,"%s",inDirectoryPath);
+	else if (inDirectoryPath[0]=='/' && inDirectoryPath[1]=='\0')
+		tLength=snprintf(outPath,inSize,"/%s%s",inPrefix,inName);
+	else
+		tLength=snprintf(outPath,inSize,"%s/%s%s",inDirectoryPath,inPrefix,inName);
+	
+	if (tLength<0 || (size_t) tLength>=inSize)
+		return ENAMETOOLONG;
+	
+	return 0;
+}
+
+/* inPath is owned by the folder (NULL is returned if it is NULL). A new tree starts when inParentDirectory is NULL */
+
+static GoldinDirectoryRef GoldinXattrCreateDirectory(char * inPath,GoldinDirectoryRef inParentDirectory)
+{
+	GoldinDirectoryRef tDirectory;
+	
+	if (inPath==NULL)
+		return NULL;
+	
+	tDirectory=(GoldinDirectoryRef) malloc(sizeof(struct _GoldinDirectory));
+	
+	if (tDirectory==NULL)
+	{
+		free(inPath);
+		
+		return NULL;
+	}
+	
+	if (inParentDirectory!=NULL)
+	{
+		tDirectory->tree=inParentDirectory->tree;
+		
+		__sync_add_and_fetch(&tDirectory->tree->referenceCount,1);
+	}
+	else
+	{
+		tDirectory->tree=(GoldinXattrTree *) calloc(1,sizeof(GoldinXattrTree));
+		
+		if (tDirectory->tree==NULL)
+		{
+			free(inPath);
+			free(tDirectory);
+			
+			return NULL;
+		}
+		
+		tDirectory->tree->referenceCount=1;
+	}
+	
+	tDirectory->path=inPath;
+	tDirectory->descriptor=-1;
+	
+	return tDirectory;
+}
+
+/* Returns -1 if the folder could not be opened */
+
+static int GoldinXattrGetDirectoryDescriptor(GoldinDirectoryRef inDirectory)
+{
+	if (inDirectory->descriptor!=-1)
+		return inDirectory->descriptor;
+	
+	if (__sync_add_and_fetch(&inDirectory->tree->openDirectoryCount,1)<=GOLDIN_XATTR_MAX_OPEN_DIRECTORIES)
+		inDirectory->descriptor=open(inDirectory->path,O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+	
+	if (inDirectory->descriptor==-1)
+		__sync_sub_and_fetch(&inDirectory->tree->openDirectoryCount,1);
+	
+	return inDirectory->descriptor;
+}
+
+/* *outDirectoryDescriptor and outPath can be used with the *at calls: relative to the folder or, if it can not be
+   opened, the absolute path with AT_FDCWD */
+
+static int GoldinXattrLocate(GoldinDirectoryRef inDirectory,const char * inPrefix,const char * inName,int * outDirectoryDescriptor,char * outPath,size_t inSize)
+{
+	int tDescriptor=GoldinXattrGetDirectoryDescriptor(inDirectory);
+	int tLength;
+	
+	if (tDescriptor==-1)
+	{
+		*outDirectoryDescriptor=AT_FDCWD;
+		
+		return GoldinXattrMakePath(inDirectory->path,inPrefix,inName,outPath,inSize);
+	}
+	
+	*outDirectoryDescriptor=tDescriptor;
+	
+	tLength=snprintf(outPath,inSize,"%s%s",inPrefix,inName);
+	
+	if (tLength<0 || (size_t) tLength>=inSize)
+		return ENAMETOOLONG;
+	
+	return 0;
+}
+
+static void GoldinXattrFillEntry(GoldinEntry * outEntry,const struct stat * inStat)
+{
+	outEntry->ownerID=inStat->st_uid;
+	outEntry->groupID=inStat->st_gid;
+	outEntry->mode=inStat->st_mode & 07777;
+	outEntry->fileID=inStat->st_ino;
+	outEntry->changeTime=GoldinStatTime(inStat,c);
+	
+	if (S_ISDIR(inStat->st_mode))
+	{
+		outEntry->flags|=kGoldinEntryIsDirectory;
+	}
+	else
+	{
+		if (S_ISLNK(inStat->st_mode))
+			outEntry->flags|=kGoldinEntryIsSymbolicLink;
+		
+		if (inStat->st_nlink>1)
+			outEntry->flags|=kGoldinEntryIsHardLink;
+	}
+}
+
+#pragma mark -
+
+static int GoldinXattrPrepareVolume(const char * inPath,long * outMaxFileNameLength)
+{
+	long tMaxFileNameLength=pathconf(inPath,_PC_NAME_MAX);
+	
+	if (tMaxFileNameLength<0)
+		return errno;
+	
+	*outMaxFileNameLength=tMaxFileNameLength-2;
+	
+	return 0;
+}
+
+static void GoldinXattrReleaseDirectory(GoldinDirectoryRef inDirectory);
+
+static int GoldinXattrCopyRoot(const char * inPath,GoldinDirectoryRef * outParentDirectory,GoldinEntry * outEntry)
+{
+	struct stat tStat;
+	const char * tName;
+	GoldinDirectoryRef tParentDirectory;
+	
+	memset(outEntry,0,sizeof(GoldinEntry));
+	
+	if (lstat(inPath,&tStat)!=0)
+		return errno;
+	
+	GoldinCounterIncrement(kGoldinCounterItems);
+	GoldinCounterIncrement(kGoldinCounterCatalogReads);
+	
+	GoldinXattrFillEntry(outEntry,&tStat);
+	
+	if (S_ISREG(tStat.st_mode) || S_ISDIR(tStat.st_mode))
+	{
+		if (GoldinXattrReadMetadata(inPath,outEntry->finderInfo,&outEntry->resourceForkSize)!=0)
+			return errno;
+	}
+	
+	tName=strrchr(inPath,'/');
+	
+	if (tName==NULL || tName[1]=='\0')
+		return EINVAL;		/* The root of the volume does not have a ._ file */
+	
+	tParentDirectory=GoldinXattrCreateDirectory((tName==inPath) ? strdup("/") : strndup(inPath,tName-inPath),NULL);
+	
+	if (tParentDirectory==NULL)
+		return ENOMEM;
+	
+	outEntry->name=strdup(tName+1);
+	
+	if (outEntry->name==NULL)
+	{
+		GoldinXattrReleaseDirectory(tParentDirectory);
+		
+		return ENOMEM;
+	}
+	
+	*outParentDirectory=tParentDirectory;
+	
+	return 0;
+}
+
+static int GoldinXattrCopyDirectory(GoldinDirectoryRef inParentDirectory,const GoldinEntry * inEntry,GoldinDirectoryRef * outDirectory)
+{
+	char tPath[PATH_MAX];
+	GoldinDirectoryRef tDirectory;
+	int tError;
+	
+	tError=GoldinXattrMakePath(inParentDirectory->path,"",inEntry->name,tPath,PATH_MAX);
+	
+	if (tError!=0)
+		return tError;
+	
+	tDirectory=GoldinXattrCreateDirectory(strdup(tPath),inParentDirectory);
+	
+	if (tDirectory==NULL)
+		return ENOMEM;
+	
+	*outDirectory=tDirectory;
+	
+	return 0;
+}
+
+static void GoldinXattrReleaseDirectory(GoldinDirectoryRef inDirectory)
+{
+	if (inDirectory==NULL)
+		return;
+	
+	if (inDirectory->descriptor!=-1)
+	{
+		close(inDirectory->descriptor);
+		
+		__sync_sub_and_fetch(&inDirectory->tree->openDirectoryCount,1);
+	}
+	
+	if (__sync_sub_and_fetch(&inDirectory->tree->referenceCount,1)==0)
+		free(inDirectory->tree);
+	
+	free(inDirectory->path);
+	free(inDirectory);
+}
+
+/* When the folder can not be listed in bulk (Mac OS X 10.9 and earlier) */
+
+static int GoldinXattrCopyEntriesOneByOne(GoldinDirectoryRef inDirectory,GoldinEntryFilter inFilter,void * inContext,GoldinEntryList * outList)
+{
+	DIR * tDirectory;
+	struct dirent * tDirectoryEntry;
+	int tError=0;
+	
+	tDirectory=opendir(inDirectory->path);
+	
+	if (tDirectory==NULL)
+		return errno;
+	
+	while (1)
+	{
+		struct stat tStat;
+		GoldinEntry tEntry;
+		
+		errno=0;
+		
+		tDirectoryEntry=readdir(tDirectory);
+		
+		if (tDirectoryEntry==NULL)
+		{
+			tError=errno;
+			break;
+		}
+		
+		if (strcmp(tDirectoryEntry->d_name,".")==0 || strcmp(tDirectoryEntry->d_name,"..")==0)
+			continue;
+		
+		GoldinCounterIncrement(kGoldinCounterItems);
+		
+		GoldinCounterIncrement(kGoldinCounterCatalogReads);
+		
+		memset(&tEntry,0,sizeof(GoldinEntry));
+		
+		tEntry.name=tDirectoryEntry->d_name;
+		
+		if (fstatat(dirfd(tDirectory),tDirectoryEntry->d_name,&tStat,AT_SYMLINK_NOFOLLOW)==0)
+		{
+			GoldinXattrFillEntry(&tEntry,&tStat);
+			
+			if (S_ISREG(tStat.st_mode) || S_ISDIR(tStat.st_mode))
+			{
+				if (GoldinXattrReadMetadataAt(dirfd(tDirectory),tDirectoryEntry->d_name,tEntry.finderInfo,&tEntry.resourceForkSize)!=0)
+				{
+					tEntry.flags=kGoldinEntryIsUnreadable;
+					tEntry.error=errno;
+				}
+			}
+		}
+		else
+		{
+			tEntry.flags=kGoldinEntryIsUnreadable;
+			tEntry.error=errno;
+		}
+		
+		/* An item that is gone is skipped, one that can not be read is only passed to the filter so that it can be reported */
+		
+		if ((tEntry.flags & kGoldinEntryIsUnreadable)!=0 && tEntry.error==ENOENT)
+			continue;
+		
+		if (inFilter!=NULL && inFilter(&tEntry,inContext)==FALSE)
+			continue;
+		
+		if ((tEntry.flags & kGoldinEntryIsUnreadable)!=0)
+			continue;
+		
+		tError=GoldinEntryListAppend(outList,&tEntry);
+		
+		if (tError!=0)
+			break;
+	}
+	
+	closedir(tDirectory);
+	
+	return tError;
+}
+
+static int GoldinXattrCopyEntries(GoldinDirectoryRef inDirectory,GoldinEntryFilter inFilter,void * inContext,GoldinEntryList * outList)
+{
+	int tDirectoryDescriptor;
+	Boolean tOwnsDescriptor=FALSE;
+	GoldinEnumeratorRef tEnumerator;
+	int tError=0;
+	
+	memset(outList,0,sizeof(GoldinEntryList));
+	
+	tDirectoryDescriptor=GoldinXattrGetDirectoryDescriptor(inDirectory);
+	
+	if (tDirectoryDescriptor!=-1)
+	{
+		/* The listing starts from the beginning of the folder */
+		
+		lseek(tDirectoryDescriptor,0,SEEK_SET);
+	}
+	else
+	{
+		/* Too many folders are open, this one is only open while it is listed */
+		
+		tDirectoryDescriptor=open(inDirectory->path,O_RDONLY|O_DIRECTORY|O_CLOEXEC);
+		
+		if (tDirectoryDescriptor==-1)
+			return errno;
+		
+		tOwnsDescriptor=TRUE;
+	}
+	
+	tEnumerator=GoldinEnumeratorCreate(tDirectoryDescriptor);
+	
+	if (tEnumerator==NULL)
+	{
+		tError=errno;
+		
+		if (tOwnsDescriptor==TRUE)
+			close(tDirectoryDescriptor);
+		
+		if (tError==ENOTSUP)
+			tError=GoldinXattrCopyEntriesOneByOne(inDirectory,inFilter,inContext,outList);
+		
+		if (tError!=0)
+			GoldinEntryListRelease(outList);
+		
+		return tError;
+	}
+	
+	while (tError==0)
+	{
+		GoldinEntry * tEntries;
+		size_t tCount;
+		size_t i;
+		
+		if (GoldinEnumeratorGetEntries(tEnumerator,&tEntries,&tCount)!=0)
+		{
+			tError=errno;
+			break;
+		}
+		
+		if (tCount==0)
+			break;
+		
+		for(i=0;i<tCount && tError==0;i++)
+		{
+			if (inFilter!=NULL && inFilter(&tEntries[i],inContext)==FALSE)
+				continue;
+			
+			if ((tEntries[i].flags & kGoldinEntryIsUnreadable)!=0)
+				continue;
+			
+			tError=GoldinEntryListAppend(outList,&tEntries[i]);
+		}
+	}
+	
+	GoldinEnumeratorRelease(tEnumerator);
+	
+	if (tOwnsDescriptor==TRUE)
+		close(tDirectoryDescriptor);
+	
+	if (tError!=0)
+		GoldinEntryListRelease(outList);
+	
+	return tError;
+}
+
+static int GoldinXattrCopyPath(GoldinDirectoryRef inDirectory,const GoldinEntry * inEntry,char * outPath,size_t inSize)
+{
+	return GoldinXattrMakePath(inDirectory->path,"",(inEntry!=NULL) ? inEntry->name : NULL,outPath,inSize);
+}
+
+#pragma mark -
+
+static int GoldinXattrOpenResourceFork(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,GoldinForkRef * outFork,uint64_t * outSize)
+{
+	char tPath[PATH_MAX];
+	int tDirectoryDescriptor;
+	GoldinForkRef tFork;
+	int tError;
+	
+	tError=GoldinXattrLocate(inDirectory,"",inEntry->name,&tDirectoryDescriptor,tPath,PATH_MAX);
+	
+	if (tError!=0)
+		return tError;
+	
+	tFork=(GoldinForkRef) malloc(sizeof(struct _GoldinFork));
+	
+	if (tFork==NULL)
+		return ENOMEM;
+	
+	tFork->descriptor=-1;
+	tFork->bytes=NULL;
+	
+#ifdef __APPLE__
+	{
+		struct stat tStat;
+		
+		if (strlcat(tPath,_PATH_RSRCFORKSPEC,PATH_MAX)>=PATH_MAX)
+		{
+			free(tFork);
+			
+			return ENAMETOOLONG;
+		}
+		
+		tFork->descriptor=openat(tDirectoryDescriptor,tPath,O_RDONLY|O_CLOEXEC);
+		
+		if (tFork->descriptor==-1 || fstat(tFork->descriptor,&tStat)!=0)
+		{
+			tError=errno;
+			
+			goto bail;
+		}
+		
+		tFork->size=(uint64_t) tStat.st_size;
+	}
+#else
+	{
+		ssize_t tSize=GoldinXattrGetAt(tDirectoryDescriptor,tPath,GOLDIN_XATTR_RESOURCEFORK,NULL,0);
+		
+		if (tSize<0)
+		{
+			tError=errno;
+			
+			goto bail;
+		}
+		
+		tFork->size=(uint64_t) tSize;
+		
+		if (tSize>0 && tFork->size<=0xFFFFFFFF)
+		{
+			tFork->bytes=(uint8_t *) malloc(tSize);
+			
+			if (tFork->bytes==NULL)
+			{
+				tError=ENOMEM;
+				
+				goto bail;
+			}
+			
+			tSize=GoldinXattrGetAt(tDirectoryDescriptor,tPath,GOLDIN_XATTR_RESOURCEFORK,tFork->bytes,tSize);
+			
+			if (tSize<0)
+			{
+				tError=errno;
+				
+				goto bail;
+			}
+			
+			tFork->size=(uint64_t) tSize;
+		}
+	}
+#endif
+	
+	if (tFork->size==0)
+	{
+		tError=ENOENT;
+		
+		goto bail;
+	}
+	
+	if (tFork->size>0xFFFFFFFF)
+	{
+		tError=EFBIG;
+		
+		goto bail;
+	}
+	
+	*outFork=tFork;
+	*outSize=tFork->size;
+	
+	return 0;
+	
+bail:
+	
+	switch(tError)
+	{
+		case GOLDIN_XATTR_NOT_FOUND:
+		case ENOTSUP:
+			/* No resource fork */
+			
+			tError=ENOENT;
+			break;
+		default:
+			break;
+	}
+	
+	if (tFork->descriptor!=-1)
+		close(tFork->descriptor);
+	
+	free(tFork->bytes);
+	free(tFork);
+	
+	return tError;
+}
+
+static int GoldinXattrReadResourceFork(GoldinForkRef inFork,uint64_t inOffset,void * outBuffer,size_t inSize,size_t * outReadSize)
+{
+	*outReadSize=0;
+	
+	if (inFork->descriptor==-1)
+	{
+		if (inOffset<inFork->size)
+		{
+			if (inSize>inFork->size-inOffset)
+				inSize=(size_t) (inFork->size-inOffset);
+			
+			memcpy(outBuffer,inFork->bytes+inOffset,inSize);
+			
+			*outReadSize=inSize;
+		}
+		
+		return 0;
+	}
+	
+	while (*outReadSize<inSize)
+	{
+		ssize_t tRead=pread(inFork->descriptor,(uint8_t *) outBuffer+*outReadSize,inSize-*outReadSize,(off_t) (inOffset+*outReadSize));
+		
+		if (tRead<0)
+		{
+			if (errno==EINTR)
+				continue;
+			
+			return errno;
+		}
+		
+		if (tRead==0)
+			break;
+		
+		*outReadSize+=(size_t) tRead;
+	}
+	
+	return 0;
+}
+
+static int GoldinXattrGetResourceForkDescriptor(GoldinForkRef inFork,off_t * outOffset)
+{
+	*outOffset=0;
+	
+	return inFork->descriptor;
+}
+
+static void GoldinXattrCloseResourceFork(GoldinForkRef inFork)
+{
+	if (inFork==NULL)
+		return;
+	
+	if (inFork->descriptor!=-1)
+		close(inFork->descriptor);
+	
+	free(inFork->bytes);
+	free(inFork);
+}
+
+static int GoldinXattrDeleteResourceFork(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry)
+{
+	char tPath[PATH_MAX];
+	int tDirectoryDescriptor;
+	int tError;
+	
+	tError=GoldinXattrLocate(inDirectory,"",inEntry->name,&tDirectoryDescriptor,tPath,PATH_MAX);
+	
+	if (tError!=0)
+		return tError;
+	
+	if (GoldinXattrRemoveAt(tDirectoryDescriptor,tPath,GOLDIN_XATTR_RESOURCEFORK)!=0 && errno!=GOLDIN_XATTR_NOT_FOUND)
+		return errno;
+	
+	return 0;
+}
+
+#pragma mark -
+
+static int GoldinXattrReadAppleDouble(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,uint8_t outHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE],uint64_t * outModificationTime)
+{
+	char tPath[PATH_MAX];
+	int tDirectoryDescriptor;
+	struct stat tStat;
+	ssize_t tRead;
+	int tDescriptor;
+	int tError;
+	
+	tError=GoldinXattrLocate(inDirectory,"._",inEntry->name,&tDirectoryDescriptor,tPath,PATH_MAX);
+	
+	if (tError!=0)
+		return tError;
+	
+	tDescriptor=openat(tDirectoryDescriptor,tPath,O_RDONLY|O_NOFOLLOW|O_CLOEXEC);
+	
+	if (tDescriptor==-1)
+		return errno;
+	
+	if (fstat(tDescriptor,&tStat)!=0)
+	{
+		tError=errno;
+	}
+	else
+	{
+		tRead=pread(tDescriptor,outHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE,0);
+		
+		if (tRead<0)
+			tError=errno;
+		else if (tRead<GOLDIN_APPLEDOUBLE_HEADER_SIZE)
+			tError=EINVAL;		/* Not one of ours */
+		
+		*outModificationTime=GoldinStatTime(&tStat,m);
+	}
+	
+	close(tDescriptor);
+	
+	return tError;
+}
+
+/* The temporary file lives in the folder of the ._ file so that it can be renamed */
+
+static int GoldinXattrCreateTemporaryFile(GoldinDirectoryRef inDirectory,int * outDirectoryDescriptor,char * outPath,size_t inSize,int * outDescriptor)
+{
+	while (1)
+	{
+		char tName[NAME_MAX];
+		int tError;
+		
+		tError=GoldinAppleDoubleMakeTemporaryName(tName,sizeof(tName));
+		
+		if (tError==0)
+			tError=GoldinXattrLocate(inDirectory,"",tName,outDirectoryDescriptor,outPath,inSize);
+		
+		if (tError!=0)
+			return tError;
+		
+		*outDescriptor=openat(*outDirectoryDescriptor,outPath,O_WRONLY|O_CREAT|O_EXCL|O_NOFOLLOW|O_CLOEXEC,S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+		
+		if (*outDescriptor!=-1)
+			return 0;
+		
+		/* Left by a run that died with the same process ID: try the next name */
+		
+		if (errno!=EEXIST)
+			return errno;
+	}
+}
+
+static int GoldinXattrCreateAppleDouble(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,GoldinAppleDoubleFileRef * outFile)
+{
+	GoldinAppleDoubleFileRef tFile;
+	int tError;
+	
+	tFile=(GoldinAppleDoubleFileRef) malloc(sizeof(struct _GoldinAppleDoubleFile));
+	
+	if (tFile==NULL)
+		return ENOMEM;
+	
+	tError=GoldinXattrLocate(inDirectory,"._",inEntry->name,&tFile->directoryDescriptor,tFile->path,PATH_MAX);
+	
+	if (tError==0)
+		tError=GoldinXattrCreateTemporaryFile(inDirectory,&tFile->directoryDescriptor,tFile->temporaryPath,PATH_MAX,&tFile->descriptor);
+	
+	if (tError!=0)
+	{
+		free(tFile);
+		
+		return tError;
+	}
+	
+	*outFile=tFile;
+	
+	return 0;
+}
+
+static int GoldinXattrWriteAppleDouble(GoldinAppleDoubleFileRef inFile,const void * inBuffer,size_t inSize)
+{
+	size_t tWritten=0;
+	
+	while (tWritten<inSize)
+	{
+		ssize_t tCount=write(inFile->descriptor,(const uint8_t *) inBuffer+tWritten,inSize-tWritten);
+		
+		if (tCount<0)
+		{
+			if (errno==EINTR)
+				continue;
+			
+			return errno;
+		}
+		
+		tWritten+=(size_t) tCount;
+	}
+	
+	return 0;
+}
+
+static int GoldinXattrGetAppleDoubleDescriptor(GoldinAppleDoubleFileRef inFile,off_t * outOffset)
+{
+	*outOffset=lseek(inFile->descriptor,0,SEEK_CUR);
+	
+	return (*outOffset<0) ? -1 : inFile->descriptor;
+}
+
+static int GoldinXattrCloseAppleDouble(GoldinAppleDoubleFileRef inFile,const GoldinEntry * inEntry)
+{
+	int tError=0;
+	
+	if (inEntry!=NULL)
+	{
+		struct stat tStat;
+		mode_t tMode=inEntry->mode & 07777;
+		
+		/* Set the owner. Only root can give a file away: otherwise the ._ file keeps the owner of the caller, without the
+		   setuid and setgid bits that were meant for another owner */
+		
+		if (fstat(inFile->descriptor,&tStat)!=0)
+		{
+			tError=errno;
+		}
+		else
+		{
+			if ((tStat.st_uid!=inEntry->ownerID || tStat.st_gid!=inEntry->groupID) && fchown(inFile->descriptor,inEntry->ownerID,inEntry->groupID)!=0)
+			{
+				if (errno==EPERM)
+					tMode&=~(S_ISUID|S_ISGID);
+				else
+					tError=errno;
+			}
+			
+			if (tError==0 && fchmod(inFile->descriptor,tMode)!=0)
+				tError=errno;
+		}
+	}
+	
+	if (close(inFile->descriptor)!=0 && tError==0)
+		tError=errno;
+	
+	/* The previous ._ file is replaced at once */
+	
+	if (tError==0 && inEntry!=NULL && renameat(inFile->directoryDescriptor,inFile->temporaryPath,inFile->directoryDescriptor,inFile->path)!=0)
+		tError=errno;
+	
+	if (tError!=0 || inEntry==NULL)
+		unlinkat(inFile->directoryDescriptor,inFile->temporaryPath,0);
+	
+	free(inFile);
+	
+	return tError;
+}
+
+static int GoldinXattrLinkAppleDouble(GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,const char * inAppleDoublePath)
+{
+	char tPath[PATH_MAX];
+	char tTemporaryPath[PATH_MAX];
+	int tDirectoryDescriptor;
+	struct stat tSourceStat;
+	struct stat tStat;
+	int tError;
+	
+	tError=GoldinXattrLocate(inDirectory,"._",inEntry->name,&tDirectoryDescriptor,tPath,PATH_MAX);
+	
+	if (tError!=0)
+		return tError;
+	
+	if (lstat(inAppleDoublePath,&tSourceStat)!=0)
+		return errno;
+	
+	if (fstatat(tDirectoryDescriptor,tPath,&tStat,AT_SYMLINK_NOFOLLOW)==0 && tStat.st_dev==tSourceStat.st_dev && tStat.st_ino==tSourceStat.st_ino)
+		return EEXIST;
+	
+	/* The link is made under a temporary name and renamed over the previous ._ file */
+	
+	while (1)
+	{
+		char tName[NAME_MAX];
+		
+		tError=GoldinAppleDoubleMakeTemporaryName(tName,sizeof(tName));
+		
+		if (tError==0)
+			tError=GoldinXattrLocate(inDirectory,"",tName,&tDirectoryDescriptor,tTemporaryPath,PATH_MAX);
+		
+		if (tError!=0)
+			return tError;
+		
+		if (linkat(AT_FDCWD,inAppleDoublePath,tDirectoryDescriptor,tTemporaryPath,0)==0)
+			break;
+		
+		if (errno!=EEXIST)
+			return errno;
+	}
+	
+	if (renameat(tDirectoryDescriptor,tTemporaryPath,tDirectoryDescriptor,tPath)!=0)
+		tError=errno;
+	
+	/* rename does nothing if both names are links to the same file */
+	
+	unlinkat(tDirectoryDescriptor,tTemporaryPath,0);
+	
+	return tError;
+}
+
+#pragma mark -
+
+static int GoldinXattrGetDiskOffset(GoldinDirectoryRef inDirectory,const GoldinEntry * inEntry,uint64_t * outOffset)
+{
+	char tPath[PATH_MAX];
+	int tDirectoryDescriptor;
+	int tError;
+	
+	tError=GoldinXattrLocate(inDirectory,"",inEntry->name,&tDirectoryDescriptor,tPath,PATH_MAX);
+	
+	if (tError!=0)
+		return tError;
+	
+	return GoldinDiskOrderGetOffset(tDirectoryDescriptor,tPath,outOffset);
+}
+
+const GoldinBackend kGoldinXattrBackend=
+{
+	"xattr",
+	GoldinXattrPrepareVolume,
+	GoldinXattrCopyRoot,
+	GoldinXattrCopyDirectory,
+	GoldinXattrReleaseDirectory,
+	GoldinXattrCopyEntries,
+	GoldinXattrCopyPath,
+	GoldinXattrOpenResourceFork,
+	GoldinXattrReadResourceFork,
+	GoldinXattrGetResourceForkDescriptor,
+	GoldinXattrCloseResourceFork,
+	GoldinXattrDeleteResourceFork,
+	GoldinXattrReadAppleDouble,
+	GoldinXattrCreateAppleDouble,
+	GoldinXattrWriteAppleDouble,
+	GoldinXattrGetAppleDoubleDescriptor,
+	GoldinXattrCloseAppleDouble,
+	GoldinXattrLinkAppleDouble,
+	GoldinXattrGetDiskOffset
+};
@@ -0,0 +1,195 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinCopy.c
+              Project: goldin
+*/
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "GoldinCopy.h"
+
+#include "GoldinCounters.h"
+
+#include <errno.h>
+#include <unistd.h>
+
+#ifdef __linux__
+
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/sendfile.h>
+
+/* The other errors depend on the files (EXDEV, EINVAL for a special file, ...): the method can still work
+   with the next ones */
+
+static int GoldinErrorMeansUnsupported(int inError)
+{
+	switch(inError)
+	{
+		case ENOSYS:
+		case EOPNOTSUPP:
+#if EOPNOTSUPP!=ENOTSUP
+		case ENOTSUP:
+#endif
+			return 1;
+		default:
+			break;
+	}
+	
+	return 0;
+}
+
+/* Returns the number of bytes copied. The copy stops on the first error or at the end of the source */
+
+static uint64_t GoldinSendFile(int inSourceDescriptor,off_t inSourceOffset,int inDestinationDescriptor,uint64_t inLength,int * ioSendFileUnsupported)
+{
+	off_t tSourceOffset=inSourceOffset;
+	uint64_t tCopied=0;
+	
+	if (*ioSendFileUnsupported!=0)
+		return 0;
+	
+	while (tCopied<inLength)
+	{
+		ssize_t tCount=sendfile(inDestinationDescriptor,inSourceDescriptor,&tSourceOffset,(size_t) (inLength-tCopied));
+		
+		if (tCount<=0)
+		{
+			if (tCount<0 && errno==EINTR)
+				continue;
+			
+			if (tCount<0 && tCopied==0 && GoldinErrorMeansUnsupported(errno)!=0)
+				*ioSendFileUnsupported=1;
+			
+			break;
+		}
+		
+		tCopied+=(uint64_t) tCount;
+	}
+	
+	GoldinCounterAdd(kGoldinCounterBytesSent,tCopied);
+	
+	return tCopied;
+}
+
+#endif
+
+/* The bytes are written at the current offset of the destination */
+
+static int GoldinCopyToStreamWithBuffer(int inSourceDescriptor,off_t inSourceOffset,int inDestinationDescriptor,uint64_t inLength,void * inBuffer,size_t inBufferSize)
+{
+	uint64_t tCopied=0;
+	
+	if (inBuffer==NULL || inBufferSize==0)
+	{
+		errno=EINVAL;
+		
+		return -1;
+	}
+	
+	while (tCopied<inLength)
+	{
+		size_t tRequestCount=inBufferSize;
+		ssize_t tReadCount;
+		ssize_t tWrittenCount=0;
+		
+		if (tRequestCount>inLength-tCopied)
+			tRequestCount=(size_t) (inLength-tCopied);
+		
+		tReadCount=pread(inSourceDescriptor,inBuffer,tRequestCount,inSourceOffset+(off_t) tCopied);
+		
+		if (tReadCount<0)
+		{
+			if (errno==EINTR)
+				continue;
+			
+			return -1;
+		}
+		
+		if (tReadCount==0)
+		{
+			/* The source is shorter than expected */
+			
+			errno=EIO;
+			
+			return -1;
+		}
+		
+		while (tWrittenCount<tReadCount)
+		{
+			ssize_t tCount=write(inDestinationDescriptor,((char *) inBuffer)+tWrittenCount,(size_t) (tReadCount-tWrittenCount));
+			
+			if (tCount<0)
+			{
+				if (errno==EINTR)
+					continue;
+				
+				return -1;
+			}
+			
+			tWrittenCount+=tCount;
+		}
+		
+		tCopied+=(uint64_t) tReadCount;
+		
+		GoldinCounterAdd(kGoldinCounterBytesBuffered,(uint64_t) tReadCount);
+	}
+	
+	return 0;
+}
+
+int GoldinCopyToStream(int inSourceDescriptor,off_t inSourceOffset,int inDestinationDescriptor,uint64_t inLength,void * inBuffer,size_t inBufferSize,int * ioSendFileUnsupported)
+{
+#ifdef __linux__
+	uint64_t tCopied;
+	
+	if (inLength==0)
+		return 0;
+	
+	tCopied=GoldinSendFile(inSourceDescriptor,inSourceOffset,inDestinationDescriptor,inLength,ioSendFileUnsupported);
+	
+	if (tCopied==inLength)
+		return 0;
+	
+	/* Whatever is left goes through the buffer */
+	
+	return GoldinCopyToStreamWithBuffer(inSourceDescriptor,inSourceOffset+(off_t) tCopied,inDestinationDescriptor,inLength-tCopied,inBuffer,inBufferSize);
+#else
+	(void) ioSendFileUnsupported;
+	
+	return GoldinCopyToStreamWithBuffer(inSourceDescriptor,inSourceOffset,inDestinationDescriptor,inLength,inBuffer,inBufferSize);
+#endif
+}
+
+int GoldinCopyClone(int inSourceDescriptor,int inDestinationDescriptor)
+{
+#if defined(__linux__) && defined(FICLONE)
+	if (ioctl(inDestinationDescriptor,FICLONE,inSourceDescriptor)!=0)
+		return (GoldinErrorMeansUnsupported(errno)!=0) ? ENOTSUP : errno;
+	
+	return 0;
+#else
+	(void) inSourceDescriptor;
+	(void) inDestinationDescriptor;
+	
+	return ENOTSUP;
+#endif
+}
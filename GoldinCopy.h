@@ -0,0 +1,59 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinCopy.h
+              Project: goldin
+
+    Notes:
+
+    o Copies bytes from a file to a stream (a pipe or the archive file), letting the kernel do the work when it can:
+    
+      1. sendfile (Linux)
+      2. read/write through the buffer provided by the caller
+    
+      The number of bytes copied by each method is added to the goldin counters.
+    
+    o A whole file can also be cloned (deduplication of the ._ files).
+    
+    o There is no file to file copy for the resource forks: on Linux they are extended attributes, on Mac OS X there is
+      no copy in the kernel for a range of a file (sendfile only writes to sockets and clonefile only works with whole
+      files on APFS). They go through the copy buffer of the split engine.
+    
+    o Whether a method works depends on the files: the caller remembers it (per archive, per volume), only the errors
+      meaning the method does not exist or is not supported at all are reported as ENOTSUP.
+*/
+
+#ifndef __GOLDIN_COPY_H__
+#define __GOLDIN_COPY_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Copies inLength bytes of the source to the current offset of the destination. sendfile is not tried if
+   *ioSendFileUnsupported is not 0, it is set when sendfile is not supported. Returns 0 on success, -1 and sets errno on
+   failure. The copy fails with EIO if the source is shorter than inLength */
+
+int GoldinCopyToStream(int inSourceDescriptor,off_t inSourceOffset,int inDestinationDescriptor,uint64_t inLength,void * inBuffer,size_t inBufferSize,int * ioSendFileUnsupported);
+
+/* Makes the destination share all the blocks of the source (FICLONE, Linux only). Returns 0 or an errno value (ENOTSUP
+   when the volume can not do it) */
+
+int GoldinCopyClone(int inSourceDescriptor,int inDestinationDescriptor);
+
+#endif
@@ -0,0 +1,115 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinCounters.c
+              Project: goldin
+*/
+
+#include "GoldinCounters.h"
+
+static uint64_t sCounters[kGoldinCounterCount];
+
+static const char * sCounterNames[kGoldinCounterCount]=
+{
+	"items",
+	"directories",
+	"split items",
+	"up-to-date items",
+	"rewritten items",
+	"linked items",
+	"deduplicated items",
+	"journaled items",
+	"pruned items",
+	"verified items",
+	"mismatched items",
+	"missing items",
+	"orphaned items",
+	"removed items",
+	"directory reads",
+	"catalog reads",
+	"reference lookups",
+	"resource fork opens",
+	"xattr reads",
+	"extent lookups",
+	"io_uring submissions",
+	"io_uring operations",
+	"volume syncs",
+	"bytes sendfile",
+	"bytes buffered",
+	"bytes deduplicated"
+};
+
+void GoldinCounterAdd(GoldinCounter inCounter,uint64_t inValue)
+{
+	if (inCounter<0 || inCounter>=kGoldinCounterCount)
+		return;
+	
+	__sync_fetch_and_add(&sCounters[inCounter],inValue);
+}
+
+uint64_t GoldinCounterGetValue(GoldinCounter inCounter)
+{
+	if (inCounter<0 || inCounter>=kGoldinCounterCount)
+		return 0;
+	
+	return __sync_fetch_and_add(&sCounters[inCounter],0);
+}
+
+const char * GoldinCounterGetName(GoldinCounter inCounter)
+{
+	if (inCounter<0 || inCounter>=kGoldinCounterCount)
+		return NULL;
+	
+	return sCounterNames[inCounter];
+}
+
+double GoldinCountersGetCallsPerItem(void)
+{
+	uint64_t tItems;
+	uint64_t tMetadataCalls;
+	
+	/* A resource fork probe or an extent lookup is an open, a request and a close */
+	
+	tItems=GoldinCounterGetValue(kGoldinCounterItems);
+	
+	if (tItems==0)
+		return 0;
+	
+	tMetadataCalls=GoldinCounterGetValue(kGoldinCounterDirectoryReads)+
+				   GoldinCounterGetValue(kGoldinCounterCatalogReads)+
+				   GoldinCounterGetValue(kGoldinCounterReferenceLookups)+
+				   GoldinCounterGetValue(kGoldinCounterForkOpens)*3+
+				   GoldinCounterGetValue(kGoldinCounterAttributeReads)+
+				   GoldinCounterGetValue(kGoldinCounterExtentLookups)*3;
+	
+	return ((double) tMetadataCalls)/tItems;
+}
+
+void GoldinCountersPrint(FILE * inFile)
+{
+	int i;
+	
+	if (inFile==NULL)
+		return;
+	
+	for(i=0;i<kGoldinCounterCount;i++)
+		fprintf(inFile,"%20s: %llu\n",sCounterNames[i],(unsigned long long) GoldinCounterGetValue((GoldinCounter) i));
+	
+	if (GoldinCounterGetValue(kGoldinCounterItems)>0)
+		fprintf(inFile,"%20s: %.3f\n","calls per item",GoldinCountersGetCallsPerItem());
+}
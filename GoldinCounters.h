@@ -0,0 +1,84 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinCounters.h
+              Project: goldin
+
+    Notes:
+
+    o The counters are updated with atomic operations so that they can be incremented by any worker.
+*/
+
+#ifndef __GOLDIN_COUNTERS_H__
+#define __GOLDIN_COUNTERS_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum
+{
+	kGoldinCounterItems=0,				/* Items found while walking the tree */
+	kGoldinCounterDirectories,			/* Folders whose contents were listed */
+	kGoldinCounterSplitItems,			/* ._ files written */
+	kGoldinCounterUpToDateItems,		/* ._ files left untouched (incremental mode) */
+	kGoldinCounterRewrittenItems,		/* ._ files replaced because they were out of date (incremental mode) */
+	kGoldinCounterLinkedItems,			/* ._ files created as hard links to the ._ file of another link to the same item */
+	kGoldinCounterDeduplicatedItems,	/* ._ files sharing the blocks of an identical ._ file (clone or hard link) */
+	kGoldinCounterJournaledItems,		/* Items and folders skipped because the journal says they are done */
+	kGoldinCounterPrunedItems,			/* Items and folders skipped by the exclude patterns or the maximum depth (GoldinFilter.h) */
+	kGoldinCounterVerifiedItems,		/* ._ files matching their item (verification) */
+	kGoldinCounterMismatchedItems,		/* ._ files not matching their item (verification) */
+	kGoldinCounterMissingItems,			/* Items needing a ._ file without one (verification) */
+	kGoldinCounterOrphanedItems,		/* ._ files without an item needing them (verification) */
+	kGoldinCounterRemovedItems,			/* ._ files removed because their item is gone or does not need them anymore */
+	
+	kGoldinCounterDirectoryReads,		/* Calls returning many items at once (getattrlistbulk, FSGetCatalogInfoBulk) */
+	kGoldinCounterCatalogReads,			/* Calls returning the metadata of a single item (FSGetCatalogInfo) */
+	kGoldinCounterReferenceLookups,		/* Path <-> reference conversions (FSPathMakeRef, FSRefMakePath) */
+	kGoldinCounterForkOpens,			/* Resource forks opened to find out whether they are empty */
+	kGoldinCounterAttributeReads,		/* Extended attributes listed or read one item at a time */
+	kGoldinCounterExtentLookups,		/* Items located on the disk (FIEMAP, F_LOG2PHYS_EXT) to split them in disk order */
+	
+	kGoldinCounterRingSubmissions,		/* io_uring_enter calls (asynchronous engine) */
+	kGoldinCounterRingOperations,		/* Operations submitted through io_uring */
+	
+	kGoldinCounterVolumeSyncs,			/* syncfs or sync calls (checkpoints and end of the run) */
+	
+	kGoldinCounterBytesSent,			/* Bytes copied to the archive with sendfile */
+	kGoldinCounterBytesBuffered,		/* Resource fork bytes read into a buffer and written back */
+	kGoldinCounterBytesDeduplicated,	/* ._ file bytes not written because an identical ._ file was shared */
+	
+	kGoldinCounterCount
+	
+} GoldinCounter;
+
+void GoldinCounterAdd(GoldinCounter inCounter,uint64_t inValue);
+
+#define GoldinCounterIncrement(inCounter)	GoldinCounterAdd((inCounter),1)
+
+uint64_t GoldinCounterGetValue(GoldinCounter inCounter);
+
+const char * GoldinCounterGetName(GoldinCounter inCounter);
+
+/* Filesystem calls made to list the items and read their metadata, divided by the number of items */
+
+double GoldinCountersGetCallsPerItem(void);
+
+void GoldinCountersPrint(FILE * inFile);
+
+#endif
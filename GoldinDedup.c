@@ -0,0 +1,218 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinDedup.c
+              Project: goldin
+
+    Notes:
+
+    o The ._ files are kept in a hash table (open addressing) keyed by their size and hash. An entry is never removed.
+*/
+
+#include "GoldinDedup.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GOLDIN_DEDUP_INITIAL_CAPACITY	1024
+
+typedef struct _GoldinDedupEntry
+{
+	uint64_t size;
+	uint64_t hash;
+	char * path;				/* NULL if the slot is empty */
+	
+} GoldinDedupEntry;
+
+struct _GoldinDedupIndex
+{
+	pthread_mutex_t mutex;
+	
+	GoldinDedupEntry * entries;
+	size_t capacity;			/* Power of 2 */
+	size_t count;
+};
+
+uint64_t GoldinDedupHash(uint64_t inHash,const void * inBytes,size_t inSize)
+{
+	/* FNV-1a */
+	
+	const unsigned char * tCursor=(const unsigned char *) inBytes;
+	const unsigned char * tEnd=tCursor+inSize;
+	
+	for(;tCursor<tEnd;tCursor++)
+	{
+		inHash^=*tCursor;
+		inHash*=1099511628211ULL;
+	}
+	
+	return inHash;
+}
+
+static size_t GoldinDedupIndexFindSlot(GoldinDedupEntry * inEntries,size_t inCapacity,uint64_t inSize,uint64_t inHash)
+{
+	size_t tMask=inCapacity-1;
+	size_t tIndex=(size_t) (inHash^(inSize*0x9E3779B97F4A7C15ULL)) & tMask;
+	
+	while (inEntries[tIndex].path!=NULL && (inEntries[tIndex].size!=inSize || inEntries[tIndex].hash!=inHash))
+		tIndex=(tIndex+1) & tMask;
+	
+	return tIndex;
+}
+
+static int GoldinDedupIndexGrow(GoldinDedupIndexRef inIndex)
+{
+	GoldinDedupEntry * tEntries;
+	size_t tCapacity=inIndex->capacity*2;
+	size_t i;
+	
+	tEntries=(GoldinDedupEntry *) calloc(tCapacity,sizeof(GoldinDedupEntry));
+	
+	if (tEntries==NULL)
+	{
+		errno=ENOMEM;
+		
+		return -1;
+	}
+	
+	for(i=0;i<inIndex->capacity;i++)
+	{
+		GoldinDedupEntry * tEntry=&inIndex->entries[i];
+		
+		if (tEntry->path!=NULL)
+			tEntries[GoldinDedupIndexFindSlot(tEntries,tCapacity,tEntry->size,tEntry->hash)]=*tEntry;
+	}
+	
+	free(inIndex->entries);
+	
+	inIndex->entries=tEntries;
+	inIndex->capacity=tCapacity;
+	
+	return 0;
+}
+
+GoldinDedupIndexRef GoldinDedupIndexCreate(void)
+{
+	GoldinDedupIndexRef tIndex;
+	
+	tIndex=(GoldinDedupIndexRef) calloc(1,sizeof(struct _GoldinDedupIndex));
+	
+	if (tIndex==NULL)
+		return NULL;
+	
+	tIndex->entries=(GoldinDedupEntry *) calloc(GOLDIN_DEDUP_INITIAL_CAPACITY,sizeof(GoldinDedupEntry));
+	
+	if (tIndex->entries==NULL)
+	{
+		free(tIndex);
+		
+		errno=ENOMEM;
+		
+		return NULL;
+	}
+	
+	tIndex->capacity=GOLDIN_DEDUP_INITIAL_CAPACITY;
+	
+	pthread_mutex_init(&tIndex->mutex,NULL);
+	
+	return tIndex;
+}
+
+void GoldinDedupIndexRelease(GoldinDedupIndexRef inIndex)
+{
+	size_t i;
+	
+	if (inIndex==NULL)
+		return;
+	
+	for(i=0;i<inIndex->capacity;i++)
+		free(inIndex->entries[i].path);
+	
+	free(inIndex->entries);
+	
+	pthread_mutex_destroy(&inIndex->mutex);
+	
+	free(inIndex);
+}
+
+#pragma mark -
+
+char * GoldinDedupIndexCopyPath(GoldinDedupIndexRef inIndex,uint64_t inSize,uint64_t inHash)
+{
+	GoldinDedupEntry * tEntry;
+	char * tPath=NULL;
+	
+	if (inIndex==NULL)
+		return NULL;
+	
+	pthread_mutex_lock(&inIndex->mutex);
+	
+	tEntry=&inIndex->entries[GoldinDedupIndexFindSlot(inIndex->entries,inIndex->capacity,inSize,inHash)];
+	
+	if (tEntry->path!=NULL)
+		tPath=strdup(tEntry->path);
+	
+	pthread_mutex_unlock(&inIndex->mutex);
+	
+	return tPath;
+}
+
+int GoldinDedupIndexAdd(GoldinDedupIndexRef inIndex,uint64_t inSize,uint64_t inHash,const char * inPath)
+{
+	GoldinDedupEntry * tEntry;
+	int tError=0;
+	
+	if (inIndex==NULL)
+		return 0;
+	
+	pthread_mutex_lock(&inIndex->mutex);
+	
+	if ((inIndex->count+1)*2>inIndex->capacity && GoldinDedupIndexGrow(inIndex)!=0)
+	{
+		tError=-1;
+	}
+	else
+	{
+		tEntry=&inIndex->entries[GoldinDedupIndexFindSlot(inIndex->entries,inIndex->capacity,inSize,inHash)];
+		
+		if (tEntry->path==NULL)
+		{
+			tEntry->path=strdup(inPath);
+			
+			if (tEntry->path==NULL)
+			{
+				errno=ENOMEM;
+				
+				tError=-1;
+			}
+			else
+			{
+				tEntry->size=inSize;
+				tEntry->hash=inHash;
+				
+				inIndex->count++;
+			}
+		}
+	}
+	
+	pthread_mutex_unlock(&inIndex->mutex);
+	
+	return tError;
+}
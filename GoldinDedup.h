@@ -0,0 +1,64 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinDedup.h
+              Project: goldin
+
+    Notes:
+
+    o An index of the ._ files written during the run, keyed by the size and a hash of their contents (the header and the
+      resource fork). A ._ file with the same contents as one already written is replaced with a clone or a hard link of
+      it so that they share their blocks.
+    
+    o The hash is computed while the ._ file is written, so the resource fork is read once. It is only used to find a
+      candidate: the split engine compares the two ._ files before sharing the blocks.
+*/
+
+#ifndef __GOLDIN_DEDUP_H__
+#define __GOLDIN_DEDUP_H__
+
+#include "GoldinCommon.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define GOLDIN_DEDUP_HASH_INITIAL_VALUE		14695981039346656037ULL
+
+typedef struct _GoldinDedupIndex * GoldinDedupIndexRef;
+
+/* Returns NULL and sets errno on failure */
+
+GoldinDedupIndexRef GoldinDedupIndexCreate(void);
+
+void GoldinDedupIndexRelease(GoldinDedupIndexRef inIndex);
+
+/* Adds inSize bytes to the hash (start with GOLDIN_DEDUP_HASH_INITIAL_VALUE) */
+
+uint64_t GoldinDedupHash(uint64_t inHash,const void * inBytes,size_t inSize);
+
+/* The functions below can be called from any worker */
+
+/* Returns a copy of the path of the first ._ file of this size and hash that the caller must free, NULL if there is none */
+
+char * GoldinDedupIndexCopyPath(GoldinDedupIndexRef inIndex,uint64_t inSize,uint64_t inHash);
+
+/* Nothing is done if a ._ file of this size and hash is already known. Returns 0 on success, -1 and sets errno on failure */
+
+int GoldinDedupIndexAdd(GoldinDedupIndexRef inIndex,uint64_t inSize,uint64_t inHash,const char * inPath);
+
+#endif
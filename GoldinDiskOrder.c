@@ -0,0 +1,132 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinDiskOrder.c
+              Project: goldin
+*/
+
+#include "GoldinDiskOrder.h"
+
+#include "GoldinCounters.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __APPLE__
+#include <sys/paths.h>
+#endif
+
+#ifdef __linux__
+#include <linux/fiemap.h>
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#endif
+
+int GoldinOrderGetNamed(const char * inName,GoldinOrder * outOrder)
+{
+	if (inName==NULL || outOrder==NULL)
+		return -1;
+	
+	if (strcmp(inName,"listing")==0)
+		*outOrder=kGoldinOrderListing;
+	else if (strcmp(inName,"inode")==0)
+		*outOrder=kGoldinOrderFileID;
+	else if (strcmp(inName,"disk")==0)
+		*outOrder=kGoldinOrderDisk;
+	else
+		return -1;
+	
+	return 0;
+}
+
+int GoldinDiskOrderGetOffset(int inDirectoryDescriptor,const char * inPath,uint64_t * outOffset)
+{
+#if defined(__linux__) && defined(FS_IOC_FIEMAP) && defined(FIEMAP_FLAG_XATTR)
+	struct
+	{
+		struct fiemap map;
+		struct fiemap_extent extent;
+		
+	} tMap;
+	int tDescriptor;
+	int tError=0;
+	
+	GoldinCounterIncrement(kGoldinCounterExtentLookups);
+	
+	tDescriptor=openat(inDirectoryDescriptor,inPath,O_RDONLY|O_NOFOLLOW|O_NONBLOCK|O_CLOEXEC);
+	
+	if (tDescriptor==-1)
+		return errno;
+	
+	memset(&tMap,0,sizeof(tMap));
+	
+	tMap.map.fm_start=0;
+	tMap.map.fm_length=FIEMAP_MAX_OFFSET;
+	tMap.map.fm_flags=FIEMAP_FLAG_XATTR;
+	tMap.map.fm_extent_count=1;
+	
+	if (ioctl(tDescriptor,FS_IOC_FIEMAP,&tMap)!=0)
+		tError=(errno==EOPNOTSUPP || errno==ENOTTY || errno==EBADR) ? ENOTSUP : errno;
+	else if (tMap.map.fm_mapped_extents==0 || (tMap.extent.fe_flags & FIEMAP_EXTENT_UNKNOWN)!=0)
+		tError=ENOENT;
+	else
+		*outOffset=tMap.extent.fe_physical;
+	
+	close(tDescriptor);
+	
+	return tError;
+#elif defined(__APPLE__) && defined(F_LOG2PHYS_EXT)
+	char tPath[PATH_MAX];
+	struct log2phys tPhysical;
+	int tDescriptor;
+	int tError=0;
+	
+	if (strlcpy(tPath,inPath,PATH_MAX)>=PATH_MAX || strlcat(tPath,_PATH_RSRCFORKSPEC,PATH_MAX)>=PATH_MAX)
+		return ENAMETOOLONG;
+	
+	GoldinCounterIncrement(kGoldinCounterExtentLookups);
+	
+	tDescriptor=openat(inDirectoryDescriptor,tPath,O_RDONLY|O_NOFOLLOW|O_NONBLOCK|O_CLOEXEC);
+	
+	if (tDescriptor==-1)
+		return errno;
+	
+	memset(&tPhysical,0,sizeof(tPhysical));
+	
+	tPhysical.l2p_contigbytes=1;
+	tPhysical.l2p_devoffset=0;		/* Offset in the fork */
+	
+	if (fcntl(tDescriptor,F_LOG2PHYS_EXT,&tPhysical)==-1)
+		tError=(errno==ENOTSUP || errno==EINVAL) ? ENOTSUP : errno;
+	else
+		*outOffset=(uint64_t) tPhysical.l2p_devoffset;
+	
+	close(tDescriptor);
+	
+	return tError;
+#else
+	(void) inDirectoryDescriptor;
+	(void) inPath;
+	(void) outOffset;
+	
+	return ENOTSUP;
+#endif
+}
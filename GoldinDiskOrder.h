@@ -0,0 +1,58 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinDiskOrder.h
+              Project: goldin
+
+    Notes:
+
+    o The items of a folder are split in the order the listing returns them by default (the order of the hash of the
+      names on many volumes). On a rotating disk or an image on a network volume, the forks are then read all over the
+      disk. The items can instead be split in the order of their file ID or of the position of their metadata on the
+      disk, so that the reads (and the ._ files written in between) move in one direction.
+    
+    o Position on the disk:
+    
+      Linux: FIEMAP with FIEMAP_FLAG_XATTR, the block holding the extended attributes of the item (or its inode when
+             they are stored in it)
+      Mac OS X: F_LOG2PHYS_EXT, the first block of the resource fork
+*/
+
+#ifndef __GOLDIN_DISK_ORDER_H__
+#define __GOLDIN_DISK_ORDER_H__
+
+#include <stdint.h>
+
+typedef enum
+{
+	kGoldinOrderListing=0,		/* As listed */
+	kGoldinOrderFileID,			/* By inode number */
+	kGoldinOrderDisk			/* By position on the disk, by inode number when it is not known */
+	
+} GoldinOrder;
+
+/* Returns -1 if the name is unknown (listing, inode or disk) */
+
+int GoldinOrderGetNamed(const char * inName,GoldinOrder * outOrder);
+
+/* inPath is relative to the folder descriptor (AT_FDCWD for an absolute path). Returns 0 or an errno value: ENOTSUP if
+   the volume can not tell, ENOENT if there is no block to locate */
+
+int GoldinDiskOrderGetOffset(int inDirectoryDescriptor,const char * inPath,uint64_t * outOffset);
+
+#endif
@@ -0,0 +1,528 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinEnumerator.c
+              Project: goldin
+
+    Notes:
+
+    o Mac OS X: getattrlistbulk(2) (10.10 or later). The FinderInfo returned by the kernel is not swapped.
+    
+    o Linux: the items are listed with getdents64(2) so that a whole buffer of names is obtained with one call. The
+      metadata is then obtained relative to the folder file descriptor.
+*/
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "GoldinEnumerator.h"
+
+#include "GoldinCounters.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __APPLE__
+
+#include <AvailabilityMacros.h>
+
+#include <sys/attr.h>
+#include <sys/vnode.h>
+#include <time.h>
+#include <unistd.h>
+
+#endif
+
+#ifdef __linux__
+
+#include "GoldinXattr.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+typedef struct _GoldinLinuxDirectoryEntry
+{
+	uint64_t d_ino;
+	int64_t d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[];
+	
+} GoldinLinuxDirectoryEntry;
+
+#endif
+
+#define GOLDIN_ENUMERATOR_BUFFER_SIZE		(256*1024)
+
+#define GOLDIN_ENUMERATOR_INITIAL_CAPACITY	256
+
+struct _GoldinEnumerator
+{
+	int directoryDescriptor;
+	
+	char * buffer;
+	
+	GoldinEntry * entries;
+	size_t capacity;
+};
+
+int GoldinFinderInfoNeedsSplit(const uint8_t inFinderInfo[32])
+{
+	int i;
+	
+	for(i=0;i<16;i++)
+	{
+		if (inFinderInfo[i]!=0)
+		{
+			/* 01/02/07: Symbolic link looks like this */
+			
+			if (memcmp(inFinderInfo,"slnk",4)==0)
+				return 0;
+			
+			return 1;
+		}
+	}
+	
+	for(i=16;i<32;i++)
+	{
+		if (inFinderInfo[i]!=0)
+			return 1;
+	}
+	
+	return 0;
+}
+
+static int GoldinEnumeratorReserveEntries(GoldinEnumeratorRef inEnumerator,size_t inCount)
+{
+	GoldinEntry * tNewEntries;
+	size_t tNewCapacity;
+	
+	if (inCount<=inEnumerator->capacity)
+		return 0;
+	
+	tNewCapacity=(inEnumerator->capacity==0) ? GOLDIN_ENUMERATOR_INITIAL_CAPACITY : inEnumerator->capacity;
+	
+	while (tNewCapacity<inCount)
+		tNewCapacity*=2;
+	
+	tNewEntries=(GoldinEntry *) realloc(inEnumerator->entries,tNewCapacity*sizeof(GoldinEntry));
+	
+	if (tNewEntries==NULL)
+	{
+		errno=ENOMEM;
+		
+		return -1;
+	}
+	
+	inEnumerator->entries=tNewEntries;
+	inEnumerator->capacity=tNewCapacity;
+	
+	return 0;
+}
+
+GoldinEnumeratorRef GoldinEnumeratorCreate(int inDirectoryDescriptor)
+{
+	GoldinEnumeratorRef tEnumerator;
+	
+#ifdef __APPLE__
+
+#if MAC_OS_X_VERSION_MIN_REQUIRED < 101000
+	
+	/* Weak linked: getattrlistbulk is not available before Mac OS X 10.10 */
+	
+	if (getattrlistbulk==NULL)
+	{
+		errno=ENOTSUP;
+		
+		return NULL;
+	}
+	
+#endif
+
+#elif !defined(__linux__)
+	
+	errno=ENOTSUP;
+	
+	return NULL;
+	
+#endif
+	
+	tEnumerator=(GoldinEnumeratorRef) calloc(1,sizeof(struct _GoldinEnumerator));
+	
+	if (tEnumerator==NULL)
+		return NULL;
+	
+	tEnumerator->directoryDescriptor=inDirectoryDescriptor;
+	
+	tEnumerator->buffer=(char *) malloc(GOLDIN_ENUMERATOR_BUFFER_SIZE);
+	
+	if (tEnumerator->buffer==NULL || GoldinEnumeratorReserveEntries(tEnumerator,GOLDIN_ENUMERATOR_INITIAL_CAPACITY)!=0)
+	{
+		GoldinEnumeratorRelease(tEnumerator);
+		
+		errno=ENOMEM;
+		
+		return NULL;
+	}
+	
+	return tEnumerator;
+}
+
+void GoldinEnumeratorRelease(GoldinEnumeratorRef inEnumerator)
+{
+	if (inEnumerator==NULL)
+		return;
+	
+	free(inEnumerator->buffer);
+	free(inEnumerator->entries);
+	free(inEnumerator);
+}
+
+#ifdef __APPLE__
+
+int GoldinEnumeratorGetEntries(GoldinEnumeratorRef inEnumerator,GoldinEntry ** outEntries,size_t * outCount)
+{
+	struct attrlist tAttributeList;
+	char * tCursor;
+	int tCount;
+	int i;
+	
+	*outEntries=NULL;
+	*outCount=0;
+	
+	memset(&tAttributeList,0,sizeof(struct attrlist));
+	
+	tAttributeList.bitmapcount=ATTR_BIT_MAP_COUNT;
+	tAttributeList.commonattr=ATTR_CMN_RETURNED_ATTRS|
+							  ATTR_CMN_ERROR|
+							  ATTR_CMN_NAME|
+							  ATTR_CMN_OBJTYPE|
+							  ATTR_CMN_CHGTIME|
+							  ATTR_CMN_FNDRINFO|
+							  ATTR_CMN_OWNERID|
+							  ATTR_CMN_GRPID|
+							  ATTR_CMN_ACCESSMASK|
+							  ATTR_CMN_FILEID;
+	tAttributeList.dirattr=ATTR_DIR_LINKCOUNT;
+	tAttributeList.fileattr=ATTR_FILE_LINKCOUNT|ATTR_FILE_RSRCLENGTH;
+	
+	tCount=getattrlistbulk(inEnumerator->directoryDescriptor,&tAttributeList,inEnumerator->buffer,GOLDIN_ENUMERATOR_BUFFER_SIZE,0);
+	
+	GoldinCounterIncrement(kGoldinCounterDirectoryReads);
+	
+	if (tCount<=0)
+		return tCount;
+	
+	if (GoldinEnumeratorReserveEntries(inEnumerator,tCount)!=0)
+		return -1;
+	
+	tCursor=inEnumerator->buffer;
+	
+	for(i=0;i<tCount;i++)
+	{
+		GoldinEntry * tEntry=&inEnumerator->entries[*outCount];
+		char * tRecord=tCursor;
+		uint32_t tRecordLength;
+		attribute_set_t tReturnedAttributes;
+		uint32_t tLinkCount=1;
+		fsobj_type_t tObjectType=VNON;
+		
+		memcpy(&tRecordLength,tRecord,sizeof(uint32_t));
+		tCursor+=sizeof(uint32_t);
+		
+		memcpy(&tReturnedAttributes,tCursor,sizeof(attribute_set_t));
+		tCursor+=sizeof(attribute_set_t);
+		
+		memset(tEntry,0,sizeof(GoldinEntry));
+		
+		tEntry->resourceForkSize=0;
+		
+		if (tReturnedAttributes.commonattr & ATTR_CMN_ERROR)
+		{
+			uint32_t tError;
+			
+			memcpy(&tError,tCursor,sizeof(uint32_t));
+			tCursor+=sizeof(uint32_t);
+			
+			if (tError!=0)
+			{
+				/* The attributes of this item could not be obtained, only its name is returned so that it can be reported */
+				
+				tEntry->flags=kGoldinEntryIsUnreadable;
+				tEntry->error=(int) tError;
+				
+				if (tReturnedAttributes.commonattr & ATTR_CMN_NAME)
+				{
+					attrreference_t tNameReference;
+					
+					memcpy(&tNameReference,tCursor,sizeof(attrreference_t));
+					
+					tEntry->name=tCursor+tNameReference.attr_dataoffset;
+				}
+				
+				tCursor=tRecord+tRecordLength;
+				
+				if (tEntry->name!=NULL)
+					(*outCount)++;
+				
+				continue;
+			}
+		}
+		
+		if (tReturnedAttributes.commonattr & ATTR_CMN_NAME)
+		{
+			attrreference_t tNameReference;
+			
+			memcpy(&tNameReference,tCursor,sizeof(attrreference_t));
+			
+			tEntry->name=tCursor+tNameReference.attr_dataoffset;
+			
+			tCursor+=sizeof(attrreference_t);
+		}
+		
+		if (tReturnedAttributes.commonattr & ATTR_CMN_OBJTYPE)
+		{
+			memcpy(&tObjectType,tCursor,sizeof(fsobj_type_t));
+			tCursor+=sizeof(fsobj_type_t);
+		}
+		
+		if (tReturnedAttributes.commonattr & ATTR_CMN_CHGTIME)
+		{
+			struct timespec tChangeTime;
+			
+			memcpy(&tChangeTime,tCursor,sizeof(struct timespec));
+			tCursor+=sizeof(struct timespec);
+			
+			tEntry->changeTime=(uint64_t) tChangeTime.tv_sec*1000000000ULL+(uint64_t) tChangeTime.tv_nsec;
+		}
+		
+		if (tReturnedAttributes.commonattr & ATTR_CMN_FNDRINFO)
+		{
+			memcpy(tEntry->finderInfo,tCursor,32);
+			tCursor+=32;
+		}
+		
+		if (tReturnedAttributes.commonattr & ATTR_CMN_OWNERID)
+		{
+			memcpy(&tEntry->ownerID,tCursor,sizeof(uid_t));
+			tCursor+=sizeof(uid_t);
+		}
+		
+		if (tReturnedAttributes.commonattr & ATTR_CMN_GRPID)
+		{
+			memcpy(&tEntry->groupID,tCursor,sizeof(gid_t));
+			tCursor+=sizeof(gid_t);
+		}
+		
+		if (tReturnedAttributes.commonattr & ATTR_CMN_ACCESSMASK)
+		{
+			uint32_t tAccessMask;
+			
+			memcpy(&tAccessMask,tCursor,sizeof(uint32_t));
+			tCursor+=sizeof(uint32_t);
+			
+			tEntry->mode=(mode_t) (tAccessMask & 07777);
+		}
+		
+		if (tReturnedAttributes.commonattr & ATTR_CMN_FILEID)
+		{
+			memcpy(&tEntry->fileID,tCursor,sizeof(uint64_t));
+			tCursor+=sizeof(uint64_t);
+		}
+		
+		if (tReturnedAttributes.dirattr & ATTR_DIR_LINKCOUNT)
+		{
+			memcpy(&tLinkCount,tCursor,sizeof(uint32_t));
+			tCursor+=sizeof(uint32_t);
+		}
+		
+		if (tReturnedAttributes.fileattr & ATTR_FILE_LINKCOUNT)
+		{
+			memcpy(&tLinkCount,tCursor,sizeof(uint32_t));
+			tCursor+=sizeof(uint32_t);
+		}
+		
+		if (tReturnedAttributes.fileattr & ATTR_FILE_RSRCLENGTH)
+		{
+			off_t tResourceForkLength;
+			
+			memcpy(&tResourceForkLength,tCursor,sizeof(off_t));
+			tCursor+=sizeof(off_t);
+			
+			tEntry->resourceForkSize=tResourceForkLength;
+		}
+		else if (tObjectType!=VDIR)
+		{
+			tEntry->resourceForkSize=kGoldinUnknownSize;
+		}
+		
+		switch(tObjectType)
+		{
+			case VDIR:
+				tEntry->flags|=kGoldinEntryIsDirectory;
+				break;
+			case VLNK:
+				tEntry->flags|=kGoldinEntryIsSymbolicLink;
+				break;
+			default:
+				break;
+		}
+		
+		if (tLinkCount>1)
+			tEntry->flags|=kGoldinEntryIsHardLink;
+		
+		tCursor=tRecord+tRecordLength;
+		
+		if (tEntry->name!=NULL)
+			(*outCount)++;
+	}
+	
+	*outEntries=inEnumerator->entries;
+	
+	GoldinCounterAdd(kGoldinCounterItems,*outCount);
+	
+	return 0;
+}
+
+#elif defined(__linux__)
+
+int GoldinEnumeratorGetEntries(GoldinEnumeratorRef inEnumerator,GoldinEntry ** outEntries,size_t * outCount)
+{
+	long tRead;
+	long tOffset;
+	
+	*outEntries=NULL;
+	*outCount=0;
+	
+	tRead=syscall(SYS_getdents64,inEnumerator->directoryDescriptor,inEnumerator->buffer,GOLDIN_ENUMERATOR_BUFFER_SIZE);
+	
+	GoldinCounterIncrement(kGoldinCounterDirectoryReads);
+	
+	if (tRead<=0)
+		return (int) tRead;
+	
+	for(tOffset=0;tOffset<tRead;)
+	{
+		GoldinLinuxDirectoryEntry * tDirectoryEntry=(GoldinLinuxDirectoryEntry *) (inEnumerator->buffer+tOffset);
+		GoldinEntry * tEntry;
+		struct statx tStat;
+		const char * tName=tDirectoryEntry->d_name;
+		
+		tOffset+=tDirectoryEntry->d_reclen;
+		
+		if (tName[0]=='.' && (tName[1]=='\0' || (tName[1]=='.' && tName[2]=='\0')))
+			continue;
+		
+		GoldinCounterIncrement(kGoldinCounterCatalogReads);
+		
+		if (statx(inEnumerator->directoryDescriptor,tName,AT_SYMLINK_NOFOLLOW|AT_NO_AUTOMOUNT,STATX_TYPE|STATX_MODE|STATX_UID|STATX_GID|STATX_INO|STATX_NLINK|STATX_CTIME,&tStat)!=0)
+		{
+			/* An item that is gone is skipped, one that can not be read is returned so that it can be reported */
+			
+			if (errno==ENOENT)
+				continue;
+			
+			if (GoldinEnumeratorReserveEntries(inEnumerator,(*outCount)+1)!=0)
+				return -1;
+			
+			tEntry=&inEnumerator->entries[*outCount];
+			
+			memset(tEntry,0,sizeof(GoldinEntry));
+			
+			tEntry->name=tName;
+			tEntry->flags=kGoldinEntryIsUnreadable;
+			tEntry->error=errno;
+			
+			(*outCount)++;
+			
+			continue;
+		}
+		
+		if (GoldinEnumeratorReserveEntries(inEnumerator,(*outCount)+1)!=0)
+			return -1;
+		
+		tEntry=&inEnumerator->entries[*outCount];
+		
+		memset(tEntry,0,sizeof(GoldinEntry));
+		
+		tEntry->name=tName;
+		tEntry->ownerID=tStat.stx_uid;
+		tEntry->groupID=tStat.stx_gid;
+		tEntry->mode=(mode_t) (tStat.stx_mode & 07777);
+		tEntry->fileID=tStat.stx_ino;
+		tEntry->changeTime=(uint64_t) tStat.stx_ctime.tv_sec*1000000000ULL+tStat.stx_ctime.tv_nsec;
+		
+		if (S_ISDIR(tStat.stx_mode))
+		{
+			tEntry->flags|=kGoldinEntryIsDirectory;
+		}
+		else
+		{
+			if (S_ISLNK(tStat.stx_mode))
+				tEntry->flags|=kGoldinEntryIsSymbolicLink;
+			
+			if (tStat.stx_nlink>1)
+				tEntry->flags|=kGoldinEntryIsHardLink;
+		}
+		
+		/* Extended attributes (user.* attributes are only allowed on regular files and folders) */
+		
+		if (S_ISREG(tStat.stx_mode) || S_ISDIR(tStat.stx_mode))
+		{
+			if (GoldinXattrReadMetadataAt(inEnumerator->directoryDescriptor,tName,tEntry->finderInfo,&tEntry->resourceForkSize)!=0)
+			{
+				if (errno==ENOENT)
+					continue;
+				
+				tEntry->flags=kGoldinEntryIsUnreadable;
+				tEntry->error=errno;
+			}
+		}
+		
+		(*outCount)++;
+	}
+	
+	*outEntries=inEnumerator->entries;
+	
+	GoldinCounterAdd(kGoldinCounterItems,*outCount);
+	
+	/* A buffer full of . and .. is not the end of the folder */
+	
+	if (*outCount==0)
+		return GoldinEnumeratorGetEntries(inEnumerator,outEntries,outCount);
+	
+	return 0;
+}
+
+#else
+
+int GoldinEnumeratorGetEntries(GoldinEnumeratorRef inEnumerator,GoldinEntry ** outEntries,size_t * outCount)
+{
+	*outEntries=NULL;
+	*outCount=0;
+	
+	errno=ENOTSUP;
+	
+	return -1;
+}
+
+#endif
@@ -0,0 +1,99 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinEnumerator.h
+              Project: goldin
+
+    Notes:
+
+    o Lists the contents of a folder by batches: the name, type, owner, permissions, FinderInfo and resource fork size
+      of many items are obtained with a single call instead of one or two calls per item.
+    
+      Mac OS X: getattrlistbulk(2)
+      Linux: getdents64(2), then statx(2) and the user.com.apple.* extended attributes of every item, relative to the
+             folder descriptor. The extended attributes are listed first so that the items without any cost a single call.
+     
+    o The entries returned by GoldinEnumeratorGetEntries are valid until the next call.
+    
+    o The items whose attributes can not be read are returned with kGoldinEntryIsUnreadable instead of being skipped,
+      so that the job can report them. The items that are gone by the time they are read are skipped.
+*/
+
+#ifndef __GOLDIN_ENUMERATOR_H__
+#define __GOLDIN_ENUMERATOR_H__
+
+#include <stdint.h>
+#include <sys/types.h>
+
+enum
+{
+	kGoldinEntryIsDirectory=1<<0,
+	kGoldinEntryIsHardLink=1<<1,
+	kGoldinEntryIsSymbolicLink=1<<2,
+	kGoldinEntryIsUnreadable=1<<3		/* Only the name is valid, the error is in error */
+};
+
+#define kGoldinUnknownSize		(-1)
+
+typedef struct _GoldinEntry
+{
+	const char * name;					/* UTF-8 */
+	
+	uint32_t flags;
+	
+	uid_t ownerID;
+	gid_t groupID;
+	mode_t mode;						/* Permissions only */
+	
+	uint64_t fileID;
+	
+	uint64_t changeTime;				/* Status change time in nanoseconds since 1970, 0 if unknown */
+	
+	int64_t resourceForkSize;			/* kGoldinUnknownSize if it can not be obtained with the listing */
+	
+	uint8_t finderInfo[32];				/* FinderInfo + ExtFinderInfo, big endian (i.e. as in an AppleDouble file) */
+	
+	int error;							/* Why the attributes could not be read (kGoldinEntryIsUnreadable) */
+	
+	union
+	{
+		uint64_t alignment;
+		uint8_t bytes[96];
+		
+	} backendData;						/* Whatever the backend needs to find the item again. Zeroed by the enumerator */
+	
+} GoldinEntry;
+
+typedef struct _GoldinEnumerator * GoldinEnumeratorRef;
+
+/* The file descriptor must be a folder open for reading. It is not closed by GoldinEnumeratorRelease.
+   Returns NULL and sets errno on failure (ENOTSUP if bulk listing is not available on this system) */
+
+GoldinEnumeratorRef GoldinEnumeratorCreate(int inDirectoryDescriptor);
+
+/* Returns 0 and sets *outCount to 0 when there are no more items, -1 and sets errno on failure */
+
+int GoldinEnumeratorGetEntries(GoldinEnumeratorRef inEnumerator,GoldinEntry ** outEntries,size_t * outCount);
+
+void GoldinEnumeratorRelease(GoldinEnumeratorRef inEnumerator);
+
+/* TRUE if the FinderInfo or ExtFinderInfo needs to be saved in a ._ file (symbolic links are not split) */
+
+int GoldinFinderInfoNeedsSplit(const uint8_t inFinderInfo[32]);
+
+#endif
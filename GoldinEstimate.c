@@ -0,0 +1,165 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinEstimate.c
+              Project: goldin
+
+    Notes:
+
+    o The resource forks are sorted by powers of 4 starting at 1 KB, the last bucket gets everything above 64 MB.
+*/
+
+#include "GoldinEstimate.h"
+
+#include "GoldinAppleDouble.h"
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GOLDIN_ESTIMATE_BUCKET_COUNT	11
+
+struct _GoldinEstimate
+{
+	uint64_t itemCount;
+	uint64_t linkCount;
+	uint64_t resourceForkSize;
+	
+	uint64_t buckets[GOLDIN_ESTIMATE_BUCKET_COUNT];
+};
+
+static const char * sBucketNames[GOLDIN_ESTIMATE_BUCKET_COUNT]=
+{
+	"FinderInfo only",
+	"< 1 KB",
+	"1 KB - 4 KB",
+	"4 KB - 16 KB",
+	"16 KB - 64 KB",
+	"64 KB - 256 KB",
+	"256 KB - 1 MB",
+	"1 MB - 4 MB",
+	"4 MB - 16 MB",
+	"16 MB - 64 MB",
+	">= 64 MB"
+};
+
+static unsigned int GoldinEstimateGetBucket(uint64_t inResourceForkSize)
+{
+	unsigned int tBucket=1;
+	uint64_t tLimit=1024;
+	
+	if (inResourceForkSize==0)
+		return 0;
+	
+	while (tBucket<GOLDIN_ESTIMATE_BUCKET_COUNT-1 && inResourceForkSize>=tLimit)
+	{
+		tBucket++;
+		tLimit*=4;
+	}
+	
+	return tBucket;
+}
+
+GoldinEstimateRef GoldinEstimateCreate(void)
+{
+	GoldinEstimateRef tEstimate=(GoldinEstimateRef) calloc(1,sizeof(struct _GoldinEstimate));
+	
+	if (tEstimate==NULL)
+		errno=ENOMEM;
+	
+	return tEstimate;
+}
+
+void GoldinEstimateRelease(GoldinEstimateRef inEstimate)
+{
+	free(inEstimate);
+}
+
+void GoldinEstimateAddItem(GoldinEstimateRef inEstimate,uint64_t inResourceForkSize)
+{
+	__sync_fetch_and_add(&inEstimate->itemCount,1);
+	__sync_fetch_and_add(&inEstimate->resourceForkSize,inResourceForkSize);
+	__sync_fetch_and_add(&inEstimate->buckets[GoldinEstimateGetBucket(inResourceForkSize)],1);
+}
+
+void GoldinEstimateAddLink(GoldinEstimateRef inEstimate)
+{
+	__sync_fetch_and_add(&inEstimate->linkCount,1);
+}
+
+uint64_t GoldinEstimateGetItemCount(GoldinEstimateRef inEstimate)
+{
+	return __sync_fetch_and_add(&inEstimate->itemCount,0);
+}
+
+uint64_t GoldinEstimateGetLinkCount(GoldinEstimateRef inEstimate)
+{
+	return __sync_fetch_and_add(&inEstimate->linkCount,0);
+}
+
+uint64_t GoldinEstimateGetResourceForkSize(GoldinEstimateRef inEstimate)
+{
+	return __sync_fetch_and_add(&inEstimate->resourceForkSize,0);
+}
+
+void GoldinEstimatePrint(GoldinEstimateRef inEstimate,FILE * inFile)
+{
+	uint64_t tItemCount;
+	uint64_t tLinkCount;
+	uint64_t tResourceForkSize;
+	unsigned int i;
+	
+	if (inEstimate==NULL || inFile==NULL)
+		return;
+	
+	tItemCount=GoldinEstimateGetItemCount(inEstimate);
+	tLinkCount=GoldinEstimateGetLinkCount(inEstimate);
+	tResourceForkSize=GoldinEstimateGetResourceForkSize(inEstimate);
+	
+	fprintf(inFile,"%22s: %llu\n","._ files",(unsigned long long) tItemCount);
+	
+	if (tLinkCount>0)
+		fprintf(inFile,"%22s: %llu\n","linked ._ files",(unsigned long long) tLinkCount);
+	
+	fprintf(inFile,"%22s: %llu\n","resource fork bytes",(unsigned long long) tResourceForkSize);
+	fprintf(inFile,"%22s: %llu\n","._ bytes",(unsigned long long) (tItemCount*GOLDIN_APPLEDOUBLE_HEADER_SIZE+tResourceForkSize));
+	
+	if (tItemCount==0)
+		return;
+	
+	fprintf(inFile,"\n%22s  %10s\n","resource fork size","._ files");
+	
+	for(i=0;i<GOLDIN_ESTIMATE_BUCKET_COUNT;i++)
+	{
+		uint64_t tCount=__sync_fetch_and_add(&inEstimate->buckets[i],0);
+		char tBar[41];
+		unsigned int tBarLength;
+		
+		if (tCount==0)
+			continue;
+		
+		/* 40 characters for all the items */
+		
+		tBarLength=(unsigned int) ((tCount*40+tItemCount-1)/tItemCount);
+		
+		memset(tBar,'#',tBarLength);
+		tBar[tBarLength]='\0';
+		
+		fprintf(inFile,"%22s  %10llu  %6.2f%%  %s\n",sBucketNames[i],(unsigned long long) tCount,(tCount*100.0)/tItemCount,tBar);
+	}
+}
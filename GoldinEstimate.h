@@ -0,0 +1,63 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinEstimate.h
+              Project: goldin
+
+    Notes:
+
+    o What a run would do (dry run): the number of ._ files that would be written, the number of bytes of resource
+      fork that would be copied and the distribution of the sizes of the resource forks.
+    
+    o The totals are updated with atomic operations so that they can be updated by any worker. Every job has its own
+      estimate.
+*/
+
+#ifndef __GOLDIN_ESTIMATE_H__
+#define __GOLDIN_ESTIMATE_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef struct _GoldinEstimate * GoldinEstimateRef;
+
+/* Returns NULL and sets errno on failure */
+
+GoldinEstimateRef GoldinEstimateCreate(void);
+
+void GoldinEstimateRelease(GoldinEstimateRef inEstimate);
+
+/* inResourceForkSize is 0 if only the FinderInfo needs to be saved */
+
+void GoldinEstimateAddItem(GoldinEstimateRef inEstimate,uint64_t inResourceForkSize);
+
+/* A ._ file that would be a hard link to the ._ file of another link to the same item: it takes no space */
+
+void GoldinEstimateAddLink(GoldinEstimateRef inEstimate);
+
+uint64_t GoldinEstimateGetItemCount(GoldinEstimateRef inEstimate);
+
+uint64_t GoldinEstimateGetLinkCount(GoldinEstimateRef inEstimate);
+
+uint64_t GoldinEstimateGetResourceForkSize(GoldinEstimateRef inEstimate);
+
+/* The totals and the histogram of the sizes of the resource forks */
+
+void GoldinEstimatePrint(GoldinEstimateRef inEstimate,FILE * inFile);
+
+#endif
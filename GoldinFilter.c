@@ -0,0 +1,259 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinFilter.c
+              Project: goldin
+*/
+
+#include "GoldinFilter.h"
+
+#include <errno.h>
+#include <fnmatch.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef enum
+{
+	kGoldinPatternName=0,		/* name */
+	kGoldinPatternPrefix,		/* name* */
+	kGoldinPatternSuffix,		/* *name */
+	kGoldinPatternSubstring,	/* *name* */
+	kGoldinPatternAny,			/* * */
+	kGoldinPatternWildcards		/* Anything else, fnmatch(3) */
+	
+} GoldinPatternKind;
+
+typedef struct _GoldinPattern
+{
+	GoldinPatternKind kind;
+	
+	Boolean include;
+	Boolean directoriesOnly;
+	
+	char * string;				/* The pattern without the * at its ends (kGoldinPatternWildcards: the whole pattern) */
+	size_t length;
+	
+} GoldinPattern;
+
+struct _GoldinFilter
+{
+	GoldinPattern * patterns;
+	size_t count;
+	
+	long maximumDepth;
+};
+
+GoldinFilterRef GoldinFilterCreate(void)
+{
+	GoldinFilterRef tFilter;
+	
+	tFilter=(GoldinFilterRef) calloc(1,sizeof(struct _GoldinFilter));
+	
+	if (tFilter==NULL)
+	{
+		errno=ENOMEM;
+		
+		return NULL;
+	}
+	
+	tFilter->maximumDepth=GOLDIN_FILTER_NO_MAXIMUM_DEPTH;
+	
+	return tFilter;
+}
+
+void GoldinFilterRelease(GoldinFilterRef inFilter)
+{
+	size_t i;
+	
+	if (inFilter==NULL)
+		return;
+	
+	for(i=0;i<inFilter->count;i++)
+		free(inFilter->patterns[i].string);
+	
+	free(inFilter->patterns);
+	free(inFilter);
+}
+
+int GoldinFilterAddPattern(GoldinFilterRef inFilter,const char * inPattern,Boolean inInclude)
+{
+	GoldinPattern * tPatterns;
+	GoldinPattern tPattern;
+	size_t tLength;
+	size_t tStart=0;
+	size_t tEnd;
+	
+	if (inFilter==NULL || inPattern==NULL)
+	{
+		errno=EINVAL;
+		
+		return -1;
+	}
+	
+	memset(&tPattern,0,sizeof(GoldinPattern));
+	
+	tPattern.include=inInclude;
+	
+	tLength=strlen(inPattern);
+	
+	if (tLength>0 && inPattern[tLength-1]=='/')
+	{
+		tPattern.directoriesOnly=TRUE;
+		
+		tLength--;
+	}
+	
+	if (tLength==0 || memchr(inPattern,'/',tLength)!=NULL)
+	{
+		errno=EINVAL;
+		
+		return -1;
+	}
+	
+	/* Compile the pattern */
+	
+	tEnd=tLength;
+	
+	if (inPattern[tStart]=='*')
+		tStart++;
+	
+	if (tEnd>tStart && inPattern[tEnd-1]=='*')
+		tEnd--;
+	
+	if (memchr(inPattern,'?',tLength)!=NULL || memchr(inPattern,'[',tLength)!=NULL || memchr(inPattern,'\\',tLength)!=NULL ||
+		memchr(inPattern+tStart,'*',tEnd-tStart)!=NULL)
+	{
+		tPattern.kind=kGoldinPatternWildcards;
+		
+		tStart=0;
+		tEnd=tLength;
+	}
+	else if (tStart==tEnd)
+	{
+		tPattern.kind=kGoldinPatternAny;
+	}
+	else if (tStart==0)
+	{
+		tPattern.kind=(tEnd==tLength) ? kGoldinPatternName : kGoldinPatternPrefix;
+	}
+	else
+	{
+		tPattern.kind=(tEnd==tLength) ? kGoldinPatternSuffix : kGoldinPatternSubstring;
+	}
+	
+	tPattern.length=tEnd-tStart;
+	tPattern.string=(char *) malloc(tPattern.length+1);
+	
+	if (tPattern.string==NULL)
+	{
+		errno=ENOMEM;
+		
+		return -1;
+	}
+	
+	memcpy(tPattern.string,inPattern+tStart,tPattern.length);
+	tPattern.string[tPattern.length]='\0';
+	
+	tPatterns=(GoldinPattern *) realloc(inFilter->patterns,(inFilter->count+1)*sizeof(GoldinPattern));
+	
+	if (tPatterns==NULL)
+	{
+		free(tPattern.string);
+		
+		errno=ENOMEM;
+		
+		return -1;
+	}
+	
+	tPatterns[inFilter->count]=tPattern;
+	
+	inFilter->patterns=tPatterns;
+	inFilter->count++;
+	
+	return 0;
+}
+
+void GoldinFilterSetMaximumDepth(GoldinFilterRef inFilter,long inMaximumDepth)
+{
+	if (inFilter!=NULL)
+		inFilter->maximumDepth=(inMaximumDepth<0) ? GOLDIN_FILTER_NO_MAXIMUM_DEPTH : inMaximumDepth;
+}
+
+static Boolean GoldinPatternMatches(const GoldinPattern * inPattern,const char * inName,size_t inLength)
+{
+	switch(inPattern->kind)
+	{
+		case kGoldinPatternName:
+			
+			return (inLength==inPattern->length && memcmp(inName,inPattern->string,inLength)==0);
+			
+		case kGoldinPatternPrefix:
+			
+			return (inLength>=inPattern->length && memcmp(inName,inPattern->string,inPattern->length)==0);
+			
+		case kGoldinPatternSuffix:
+			
+			return (inLength>=inPattern->length && memcmp(inName+inLength-inPattern->length,inPattern->string,inPattern->length)==0);
+			
+		case kGoldinPatternSubstring:
+			
+			return (inLength>=inPattern->length && strstr(inName,inPattern->string)!=NULL);
+			
+		case kGoldinPatternAny:
+			
+			return TRUE;
+			
+		case kGoldinPatternWildcards:
+			
+			return (fnmatch(inPattern->string,inName,0)==0);
+	}
+	
+	return FALSE;
+}
+
+Boolean GoldinFilterExcludes(GoldinFilterRef inFilter,const char * inName,Boolean inIsDirectory)
+{
+	size_t tLength;
+	size_t i;
+	
+	if (inFilter==NULL || inFilter->count==0)
+		return FALSE;
+	
+	tLength=strlen(inName);
+	
+	for(i=0;i<inFilter->count;i++)
+	{
+		const GoldinPattern * tPattern=&inFilter->patterns[i];
+		
+		if (tPattern->directoriesOnly==TRUE && inIsDirectory==FALSE)
+			continue;
+		
+		if (GoldinPatternMatches(tPattern,inName,tLength)==TRUE)
+			return (tPattern->include==FALSE);
+	}
+	
+	return FALSE;
+}
+
+Boolean GoldinFilterCanDescend(GoldinFilterRef inFilter,unsigned long inDepth)
+{
+	if (inFilter==NULL || inFilter->maximumDepth==GOLDIN_FILTER_NO_MAXIMUM_DEPTH)
+		return TRUE;
+	
+	return (inDepth<(unsigned long) inFilter->maximumDepth);
+}
@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinFilter.h
+              Project: goldin
+
+    Notes:
+
+    o Decides which items of a tree are skipped (pruned) by the split engine: the items whose name matches an exclude
+      pattern and the contents of the folders deeper than the maximum depth. A pruned folder is neither split nor opened.
+    
+    o The patterns are shell wildcards (*, ? and [...]) matched against the name of the item, not its path. A pattern
+      ending with / only matches folders. The patterns are checked in the order they were added and the first one
+      matching the name decides (include or exclude), as with rsync. An item matching no pattern is not pruned.
+    
+    o The patterns are compiled when they are added: most of them are a plain name, a prefix or a suffix and are matched
+      without fnmatch(3).
+    
+    o The filter is not modified while the tree is split so it can be used by any worker.
+*/
+
+#ifndef __GOLDIN_FILTER_H__
+#define __GOLDIN_FILTER_H__
+
+#include "GoldinCommon.h"
+
+#define GOLDIN_FILTER_NO_MAXIMUM_DEPTH		(-1)
+
+typedef struct _GoldinFilter * GoldinFilterRef;
+
+/* Returns NULL and sets errno on failure */
+
+GoldinFilterRef GoldinFilterCreate(void);
+
+void GoldinFilterRelease(GoldinFilterRef inFilter);
+
+/* Returns 0 on success, -1 and sets errno on failure (EINVAL if the pattern is empty or contains a / before its end) */
+
+int GoldinFilterAddPattern(GoldinFilterRef inFilter,const char * inPattern,Boolean inInclude);
+
+/* The top items are at depth 0, their contents at depth 1 and so on. The default is GOLDIN_FILTER_NO_MAXIMUM_DEPTH */
+
+void GoldinFilterSetMaximumDepth(GoldinFilterRef inFilter,long inMaximumDepth);
+
+/* TRUE if the item must be skipped */
+
+Boolean GoldinFilterExcludes(GoldinFilterRef inFilter,const char * inName,Boolean inIsDirectory);
+
+/* TRUE if the contents of a folder at inDepth must be listed */
+
+Boolean GoldinFilterCanDescend(GoldinFilterRef inFilter,unsigned long inDepth);
+
+#endif
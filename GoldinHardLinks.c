@@ -0,0 +1,230 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinHardLinks.c
+              Project: goldin
+
+    Notes:
+
+    o The entries are kept in a hash table (open addressing) keyed by the device and the file ID (the file IDs of two
+      volumes can be the same). An entry is never removed.
+*/
+
+#include "GoldinHardLinks.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define GOLDIN_HARDLINKS_INITIAL_CAPACITY	256
+
+typedef struct _GoldinHardLink
+{
+	uint64_t device;
+	uint64_t fileID;
+	Boolean used;
+	Boolean resolved;
+	char * appleDoublePath;		/* NULL if the item does not need a ._ file */
+	
+} GoldinHardLink;
+
+struct _GoldinHardLinkTable
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t condition;
+	
+	GoldinHardLink * links;
+	size_t capacity;			/* Power of 2 */
+	size_t count;
+};
+
+static size_t GoldinHardLinkTableFindSlot(GoldinHardLink * inLinks,size_t inCapacity,uint64_t inDevice,uint64_t inFileID)
+{
+	size_t tMask=inCapacity-1;
+	size_t tIndex;
+	uint64_t tHash;
+	
+	/* The file IDs of a folder are often consecutive: mix the bits before masking */
+	
+	tHash=(inFileID^(inDevice*0xC2B2AE3D27D4EB4FULL))*0x9E3779B97F4A7C15ULL;
+	tIndex=(size_t) (tHash>>32) & tMask;
+	
+	while (inLinks[tIndex].used==TRUE && (inLinks[tIndex].fileID!=inFileID || inLinks[tIndex].device!=inDevice))
+		tIndex=(tIndex+1) & tMask;
+	
+	return tIndex;
+}
+
+static int GoldinHardLinkTableGrow(GoldinHardLinkTableRef inTable)
+{
+	GoldinHardLink * tLinks;
+	size_t tCapacity=inTable->capacity*2;
+	size_t i;
+	
+	tLinks=(GoldinHardLink *) calloc(tCapacity,sizeof(GoldinHardLink));
+	
+	if (tLinks==NULL)
+		return -1;
+	
+	for(i=0;i<inTable->capacity;i++)
+	{
+		if (inTable->links[i].used==TRUE)
+			tLinks[GoldinHardLinkTableFindSlot(tLinks,tCapacity,inTable->links[i].device,inTable->links[i].fileID)]=inTable->links[i];
+	}
+	
+	free(inTable->links);
+	
+	inTable->links=tLinks;
+	inTable->capacity=tCapacity;
+	
+	return 0;
+}
+
+GoldinHardLinkTableRef GoldinHardLinkTableCreate(void)
+{
+	GoldinHardLinkTableRef tTable;
+	
+	tTable=(GoldinHardLinkTableRef) calloc(1,sizeof(struct _GoldinHardLinkTable));
+	
+	if (tTable==NULL)
+		return NULL;
+	
+	tTable->links=(GoldinHardLink *) calloc(GOLDIN_HARDLINKS_INITIAL_CAPACITY,sizeof(GoldinHardLink));
+	
+	if (tTable->links==NULL)
+	{
+		free(tTable);
+		
+		errno=ENOMEM;
+		
+		return NULL;
+	}
+	
+	tTable->capacity=GOLDIN_HARDLINKS_INITIAL_CAPACITY;
+	
+	pthread_mutex_init(&tTable->mutex,NULL);
+	pthread_cond_init(&tTable->condition,NULL);
+	
+	return tTable;
+}
+
+void GoldinHardLinkTableRelease(GoldinHardLinkTableRef inTable)
+{
+	size_t i;
+	
+	if (inTable==NULL)
+		return;
+	
+	for(i=0;i<inTable->capacity;i++)
+		free(inTable->links[i].appleDoublePath);
+	
+	free(inTable->links);
+	
+	pthread_cond_destroy(&inTable->condition);
+	pthread_mutex_destroy(&inTable->mutex);
+	
+	free(inTable);
+}
+
+#pragma mark -
+
+Boolean GoldinHardLinkTableClaim(GoldinHardLinkTableRef inTable,uint64_t inDevice,uint64_t inFileID,char ** outAppleDoublePath)
+{
+	GoldinHardLink * tLink;
+	size_t tIndex;
+	
+	if (outAppleDoublePath!=NULL)
+		*outAppleDoublePath=NULL;
+	
+	if (inTable==NULL)
+		return TRUE;
+	
+	pthread_mutex_lock(&inTable->mutex);
+	
+	tIndex=GoldinHardLinkTableFindSlot(inTable->links,inTable->capacity,inDevice,inFileID);
+	
+	if (inTable->links[tIndex].used==FALSE)
+	{
+		if ((inTable->count+1)*2>inTable->capacity)
+		{
+			if (GoldinHardLinkTableGrow(inTable)!=0)
+			{
+				/* The item will be split as if it had a single link */
+				
+				pthread_mutex_unlock(&inTable->mutex);
+				
+				return TRUE;
+			}
+			
+			tIndex=GoldinHardLinkTableFindSlot(inTable->links,inTable->capacity,inDevice,inFileID);
+		}
+		
+		tLink=&inTable->links[tIndex];
+		
+		tLink->device=inDevice;
+		tLink->fileID=inFileID;
+		tLink->used=TRUE;
+		tLink->resolved=FALSE;
+		tLink->appleDoublePath=NULL;
+		
+		inTable->count++;
+		
+		pthread_mutex_unlock(&inTable->mutex);
+		
+		return TRUE;
+	}
+	
+	/* The table can grow while waiting: look for the entry again each time */
+	
+	while (inTable->links[GoldinHardLinkTableFindSlot(inTable->links,inTable->capacity,inDevice,inFileID)].resolved==FALSE)
+		pthread_cond_wait(&inTable->condition,&inTable->mutex);
+	
+	tLink=&inTable->links[GoldinHardLinkTableFindSlot(inTable->links,inTable->capacity,inDevice,inFileID)];
+	
+	if (tLink->appleDoublePath!=NULL && outAppleDoublePath!=NULL)
+		*outAppleDoublePath=strdup(tLink->appleDoublePath);
+	
+	pthread_mutex_unlock(&inTable->mutex);
+	
+	return FALSE;
+}
+
+void GoldinHardLinkTableResolve(GoldinHardLinkTableRef inTable,uint64_t inDevice,uint64_t inFileID,const char * inAppleDoublePath)
+{
+	GoldinHardLink * tLink;
+	
+	if (inTable==NULL)
+		return;
+	
+	pthread_mutex_lock(&inTable->mutex);
+	
+	tLink=&inTable->links[GoldinHardLinkTableFindSlot(inTable->links,inTable->capacity,inDevice,inFileID)];
+	
+	if (tLink->used==TRUE && tLink->resolved==FALSE)
+	{
+		/* If the copy fails, the other links are split as usual */
+		
+		tLink->appleDoublePath=(inAppleDoublePath!=NULL) ? strdup(inAppleDoublePath) : NULL;
+		tLink->resolved=TRUE;
+		
+		pthread_cond_broadcast(&inTable->condition);
+	}
+	
+	pthread_mutex_unlock(&inTable->mutex);
+}
@@ -0,0 +1,61 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinHardLinks.h
+              Project: goldin
+
+    Notes:
+
+    o The items with more than one link are split once. The table remembers, for each file ID of a volume, the ._ file
+      written for the first link found so that the ._ files of the other links can be hard links to it.
+    
+    o An archive stores the path in the archive of the first link instead: the other links are tar hard links to it.
+    
+    o The first worker to claim a file ID splits the item; the other workers claiming the same file ID wait until it
+      is resolved.
+*/
+
+#ifndef __GOLDIN_HARDLINKS_H__
+#define __GOLDIN_HARDLINKS_H__
+
+#include "GoldinCommon.h"
+
+#include <stdint.h>
+
+typedef struct _GoldinHardLinkTable * GoldinHardLinkTableRef;
+
+/* Returns NULL and sets errno on failure */
+
+GoldinHardLinkTableRef GoldinHardLinkTableCreate(void);
+
+void GoldinHardLinkTableRelease(GoldinHardLinkTableRef inTable);
+
+/* The functions below can be called from any worker */
+
+/* inDevice is the device of the volume of the item (st_dev): the file IDs are only unique on a volume.
+   Returns TRUE if the caller is the first to claim the file ID: it must then call GoldinHardLinkTableResolve.
+   Otherwise, *outAppleDoublePath is set to a copy of the path of the ._ file of the first link that the caller must
+   free, or to NULL if there is none (the link is then split as if it were the only one) */
+
+Boolean GoldinHardLinkTableClaim(GoldinHardLinkTableRef inTable,uint64_t inDevice,uint64_t inFileID,char ** outAppleDoublePath);
+
+/* inAppleDoublePath is the absolute path of the ._ file of the first link, NULL if it could not be written */
+
+void GoldinHardLinkTableResolve(GoldinHardLinkTableRef inTable,uint64_t inDevice,uint64_t inFileID,const char * inAppleDoublePath);
+
+#endif
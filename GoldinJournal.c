@@ -0,0 +1,589 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinJournal.c
+              Project: goldin
+
+    Notes:
+
+    o The records are kept in a hash set (open addressing) so that a lookup does not depend on the size of the journal.
+*/
+
+#include "GoldinJournal.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#define GOLDIN_JOURNAL_INITIAL_CAPACITY		1024
+
+struct _GoldinJournal
+{
+	pthread_mutex_t mutex;
+	
+	char * path;
+	int descriptor;
+	
+	char ** keys;				/* The type followed by the path */
+	size_t capacity;			/* Power of 2 */
+	size_t count;
+	
+	size_t loadedCount;
+	
+	Boolean deferred;
+	char * pendingRecords;		/* Not written yet (deferred journal) */
+	size_t pendingSize;
+	size_t pendingCapacity;
+};
+
+static uint64_t GoldinJournalHash(char inType,const char * inPath)
+{
+	/* FNV-1a */
+	
+	uint64_t tHash=14695981039346656037ULL;
+	const unsigned char * tCursor;
+	
+	tHash^=(unsigned char) inType;
+	tHash*=1099511628211ULL;
+	
+	for(tCursor=(const unsigned char *) inPath;*tCursor!='\0';tCursor++)
+	{
+		tHash^=*tCursor;
+		tHash*=1099511628211ULL;
+	}
+	
+	return tHash;
+}
+
+/* Index of the key or of the empty slot where it would go */
+
+static size_t GoldinJournalFindSlot(GoldinJournalRef inJournal,char inType,const char * inPath)
+{
+	size_t tMask=inJournal->capacity-1;
+	size_t tIndex=(size_t) GoldinJournalHash(inType,inPath) & tMask;
+	
+	while (inJournal->keys[tIndex]!=NULL)
+	{
+		const char * tKey=inJournal->keys[tIndex];
+		
+		if (tKey[0]==inType && strcmp(tKey+1,inPath)==0)
+			break;
+		
+		tIndex=(tIndex+1) & tMask;
+	}
+	
+	return tIndex;
+}
+
+static int GoldinJournalInsert(GoldinJournalRef inJournal,char inType,const char * inPath)
+{
+	size_t tIndex;
+	size_t tLength;
+	char * tKey;
+	
+	if ((inJournal->count+1)*2>inJournal->capacity)
+	{
+		char ** tOldKeys=inJournal->keys;
+		size_t tOldCapacity=inJournal->capacity;
+		size_t i;
+		
+		inJournal->keys=(char **) calloc(tOldCapacity*2,sizeof(char *));
+		
+		if (inJournal->keys==NULL)
+		{
+			inJournal->keys=tOldKeys;
+			
+			errno=ENOMEM;
+			
+			return -1;
+		}
+		
+		inJournal->capacity=tOldCapacity*2;
+		
+		for(i=0;i<tOldCapacity;i++)
+		{
+			if (tOldKeys[i]!=NULL)
+				inJournal->keys[GoldinJournalFindSlot(inJournal,tOldKeys[i][0],tOldKeys[i]+1)]=tOldKeys[i];
+		}
+		
+		free(tOldKeys);
+	}
+	
+	tIndex=GoldinJournalFindSlot(inJournal,inType,inPath);
+	
+	if (inJournal->keys[tIndex]!=NULL)
+		return 0;
+	
+	tLength=strlen(inPath);
+	
+	tKey=(char *) malloc(tLength+2);
+	
+	if (tKey==NULL)
+	{
+		errno=ENOMEM;
+		
+		return -1;
+	}
+	
+	tKey[0]=inType;
+	memcpy(tKey+1,inPath,tLength+1);
+	
+	inJournal->keys[tIndex]=tKey;
+	inJournal->count++;
+	
+	return 0;
+}
+
+static int GoldinJournalWrite(int inDescriptor,const char * inBuffer,size_t inSize)
+{
+	size_t tWritten=0;
+	
+	while (tWritten<inSize)
+	{
+		ssize_t tCount=write(inDescriptor,inBuffer+tWritten,inSize-tWritten);
+		
+		if (tCount<0)
+		{
+			if (errno==EINTR)
+				continue;
+			
+			return -1;
+		}
+		
+		tWritten+=(size_t) tCount;
+	}
+	
+	return 0;
+}
+
+static int GoldinJournalLoad(GoldinJournalRef inJournal)
+{
+	struct stat tStat;
+	char * tBuffer;
+	size_t tSize=0;
+	size_t tOffset;
+	size_t tValidSize=0;
+	int tDescriptor;
+	
+	tDescriptor=open(inJournal->path,O_RDONLY);
+	
+	if (tDescriptor==-1)
+		return (errno==ENOENT) ? 0 : -1;
+	
+	if (fstat(tDescriptor,&tStat)!=0)
+	{
+		close(tDescriptor);
+		
+		return -1;
+	}
+	
+	tBuffer=(char *) malloc((size_t) tStat.st_size+1);
+	
+	if (tBuffer==NULL)
+	{
+		close(tDescriptor);
+		
+		errno=ENOMEM;
+		
+		return -1;
+	}
+	
+	while (tSize<(size_t) tStat.st_size)
+	{
+		ssize_t tRead=read(tDescriptor,tBuffer+tSize,(size_t) tStat.st_size-tSize);
+		
+		if (tRead<0 && errno==EINTR)
+			continue;
+		
+		if (tRead<=0)
+			break;
+		
+		tSize+=(size_t) tRead;
+	}
+	
+	close(tDescriptor);
+	
+	for(tOffset=0;tOffset<tSize;)
+	{
+		char * tRecord=tBuffer+tOffset;
+		char * tEnd=(char *) memchr(tRecord,'\0',tSize-tOffset);
+		
+		if (tEnd==NULL)
+			break;		/* Incomplete record */
+		
+		if (tEnd-tRecord>=2 && (tRecord[0]==kGoldinJournalDirectory || tRecord[0]==kGoldinJournalFile))
+		{
+			if (GoldinJournalInsert(inJournal,tRecord[0],tRecord+1)!=0)
+			{
+				free(tBuffer);
+				
+				return -1;
+			}
+		}
+		
+		tOffset=(size_t) (tEnd-tBuffer)+1;
+		tValidSize=tOffset;
+	}
+	
+	free(tBuffer);
+	
+	inJournal->loadedCount=inJournal->count;
+	
+	/* An incomplete record would be glued to the next one */
+	
+	if (tValidSize<tSize && truncate(inJournal->path,(off_t) tValidSize)!=0)
+		return -1;
+	
+	return 0;
+}
+
+GoldinJournalRef GoldinJournalCreate(const char * inPath,Boolean inResume,Boolean inDeferred)
+{
+	GoldinJournalRef tJournal;
+	
+	tJournal=(GoldinJournalRef) calloc(1,sizeof(struct _GoldinJournal));
+	
+	if (tJournal==NULL)
+		return NULL;
+	
+	pthread_mutex_init(&tJournal->mutex,NULL);
+	
+	tJournal->descriptor=-1;
+	tJournal->deferred=inDeferred;
+	tJournal->path=strdup(inPath);
+	tJournal->capacity=GOLDIN_JOURNAL_INITIAL_CAPACITY;
+	tJournal->keys=(char **) calloc(tJournal->capacity,sizeof(char *));
+	
+	if (tJournal->path==NULL || tJournal->keys==NULL)
+	{
+		GoldinJournalRelease(tJournal);
+		
+		errno=ENOMEM;
+		
+		return NULL;
+	}
+	
+	if (inResume==TRUE && GoldinJournalLoad(tJournal)!=0)
+	{
+		int tError=errno;
+		
+		GoldinJournalRelease(tJournal);
+		
+		errno=tError;
+		
+		return NULL;
+	}
+	
+	tJournal->descriptor=open(inPath,O_WRONLY|O_CREAT|O_APPEND|((inResume==TRUE) ? 0 : O_TRUNC),S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	
+	if (tJournal->descriptor==-1)
+	{
+		int tError=errno;
+		
+		GoldinJournalRelease(tJournal);
+		
+		errno=tError;
+		
+		return NULL;
+	}
+	
+	return tJournal;
+}
+
+void GoldinJournalRelease(GoldinJournalRef inJournal)
+{
+	size_t i;
+	
+	if (inJournal==NULL)
+		return;
+	
+	if (inJournal->descriptor!=-1)
+		close(inJournal->descriptor);
+	
+	if (inJournal->keys!=NULL)
+	{
+		for(i=0;i<inJournal->capacity;i++)
+			free(inJournal->keys[i]);
+		
+		free(inJournal->keys);
+	}
+	
+	free(inJournal->pendingRecords);
+	free(inJournal->path);
+	
+	pthread_mutex_destroy(&inJournal->mutex);
+	
+	free(inJournal);
+}
+
+Boolean GoldinJournalContains(GoldinJournalRef inJournal,char inType,const char * inPath)
+{
+	Boolean tContains;
+	
+	pthread_mutex_lock(&inJournal->mutex);
+	
+	tContains=(inJournal->keys[GoldinJournalFindSlot(inJournal,inType,inPath)]!=NULL);
+	
+	pthread_mutex_unlock(&inJournal->mutex);
+	
+	return tContains;
+}
+
+int GoldinJournalRecord(GoldinJournalRef inJournal,char inType,const char * inPath)
+{
+	size_t tLength=strlen(inPath);
+	char * tRecord;
+	int tResult;
+	
+	tRecord=(char *) malloc(tLength+2);
+	
+	if (tRecord==NULL)
+	{
+		errno=ENOMEM;
+		
+		return -1;
+	}
+	
+	tRecord[0]=inType;
+	memcpy(tRecord+1,inPath,tLength+1);
+	
+	if (inJournal->deferred==TRUE)
+	{
+		/* The record is only known once it is written */
+		
+		pthread_mutex_lock(&inJournal->mutex);
+		
+		if (inJournal->pendingSize+tLength+2>inJournal->pendingCapacity)
+		{
+			size_t tCapacity=(inJournal->pendingCapacity==0) ? 64*1024 : inJournal->pendingCapacity;
+			char * tPendingRecords;
+			
+			while (inJournal->pendingSize+tLength+2>tCapacity)
+				tCapacity*=2;
+			
+			tPendingRecords=(char *) realloc(inJournal->pendingRecords,tCapacity);
+			
+			if (tPendingRecords==NULL)
+			{
+				pthread_mutex_unlock(&inJournal->mutex);
+				
+				free(tRecord);
+				
+				errno=ENOMEM;
+				
+				return -1;
+			}
+			
+			inJournal->pendingRecords=tPendingRecords;
+			inJournal->pendingCapacity=tCapacity;
+		}
+		
+		memcpy(inJournal->pendingRecords+inJournal->pendingSize,tRecord,tLength+2);
+		inJournal->pendingSize+=tLength+2;
+		
+		pthread_mutex_unlock(&inJournal->mutex);
+		
+		free(tRecord);
+		
+		return 0;
+	}
+	
+	/* O_APPEND: the records of the workers are not mixed */
+	
+	tResult=GoldinJournalWrite(inJournal->descriptor,tRecord,tLength+2);
+	
+	free(tRecord);
+	
+	if (tResult!=0)
+		return -1;
+	
+	pthread_mutex_lock(&inJournal->mutex);
+	
+	tResult=GoldinJournalInsert(inJournal,inType,inPath);
+	
+	pthread_mutex_unlock(&inJournal->mutex);
+	
+	return tResult;
+}
+
+int GoldinJournalFlush(GoldinJournalRef inJournal,int (*inSyncFunction)(void * inContext),void * inContext)
+{
+	char * tRecords;
+	size_t tSize;
+	size_t tOffset;
+	int tResult=0;
+	
+	/* 1. Take the records of the ._ files written so far */
+	
+	pthread_mutex_lock(&inJournal->mutex);
+	
+	tRecords=inJournal->pendingRecords;
+	tSize=inJournal->pendingSize;
+	
+	inJournal->pendingRecords=NULL;
+	inJournal->pendingSize=0;
+	inJournal->pendingCapacity=0;
+	
+	pthread_mutex_unlock(&inJournal->mutex);
+	
+	/* 2. Flush these ._ files */
+	
+	if (inSyncFunction!=NULL && inSyncFunction(inContext)!=0)
+	{
+		free(tRecords);
+		
+		errno=EIO;
+		
+		return -1;
+	}
+	
+	/* 3. Write the records, then flush the journal */
+	
+	if (tSize>0)
+	{
+		pthread_mutex_lock(&inJournal->mutex);
+		
+		tResult=GoldinJournalWrite(inJournal->descriptor,tRecords,tSize);
+		
+		for(tOffset=0;tOffset<tSize && tResult==0;tOffset+=strlen(tRecords+tOffset)+1)
+			tResult=GoldinJournalInsert(inJournal,tRecords[tOffset],tRecords+tOffset+1);
+		
+		pthread_mutex_unlock(&inJournal->mutex);
+	}
+	
+	free(tRecords);
+	
+	if (tResult==0)
+		tResult=fsync(inJournal->descriptor);
+	
+	return tResult;
+}
+
+size_t GoldinJournalGetLoadedCount(GoldinJournalRef inJournal)
+{
+	return inJournal->loadedCount;
+}
+
+/* Returns TRUE if a folder containing the item has been recorded */
+
+static Boolean GoldinJournalIsCovered(GoldinJournalRef inJournal,const char * inPath)
+{
+	char * tPath=strdup(inPath);
+	char * tSlash;
+	Boolean tCovered=FALSE;
+	
+	if (tPath==NULL)
+		return FALSE;
+	
+	while ((tSlash=strrchr(tPath,'/'))!=NULL && tSlash!=tPath)
+	{
+		*tSlash='\0';
+		
+		if (inJournal->keys[GoldinJournalFindSlot(inJournal,kGoldinJournalDirectory,tPath)]!=NULL)
+		{
+			tCovered=TRUE;
+			break;
+		}
+	}
+	
+	free(tPath);
+	
+	return tCovered;
+}
+
+int GoldinJournalCompact(GoldinJournalRef inJournal)
+{
+	size_t tLength=strlen(inJournal->path);
+	char * tTemporaryPath;
+	int tDescriptor;
+	int tResult=0;
+	size_t i;
+	
+	tTemporaryPath=(char *) malloc(tLength+5);
+	
+	if (tTemporaryPath==NULL)
+	{
+		errno=ENOMEM;
+		
+		return -1;
+	}
+	
+	memcpy(tTemporaryPath,inJournal->path,tLength);
+	memcpy(tTemporaryPath+tLength,".tmp",5);
+	
+	pthread_mutex_lock(&inJournal->mutex);
+	
+	tDescriptor=open(tTemporaryPath,O_WRONLY|O_CREAT|O_TRUNC,S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	
+	if (tDescriptor==-1)
+	{
+		tResult=-1;
+	}
+	else
+	{
+		for(i=0;i<inJournal->capacity && tResult==0;i++)
+		{
+			const char * tKey=inJournal->keys[i];
+			
+			if (tKey==NULL || GoldinJournalIsCovered(inJournal,tKey+1)==TRUE)
+				continue;
+			
+			tResult=GoldinJournalWrite(tDescriptor,tKey,strlen(tKey)+1);
+		}
+		
+		if (tResult==0)
+			tResult=fsync(tDescriptor);
+		
+		if (close(tDescriptor)!=0)
+			tResult=-1;
+		
+		/* The new journal replaces the old one at once */
+		
+		if (tResult==0)
+			tResult=rename(tTemporaryPath,inJournal->path);
+		
+		if (tResult!=0)
+		{
+			int tError=errno;
+			
+			unlink(tTemporaryPath);
+			
+			errno=tError;
+		}
+		else
+		{
+			close(inJournal->descriptor);
+			
+			inJournal->descriptor=open(inJournal->path,O_WRONLY|O_APPEND);
+			
+			if (inJournal->descriptor==-1)
+				tResult=-1;
+		}
+	}
+	
+	pthread_mutex_unlock(&inJournal->mutex);
+	
+	free(tTemporaryPath);
+	
+	return tResult;
+}
@@ -0,0 +1,79 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinJournal.h
+              Project: goldin
+
+    Notes:
+
+    o An append-only journal of the items that have been dealt with, so that a run that died can be resumed.
+    
+    o Every record is a type (D: a folder and all its contents, F: a single item) followed by an absolute path and a
+      NUL character (a path can contain a newline but not a NUL). A record is appended with a single write(2) so
+      that it is on disk as soon as the call returns, even if goldin is killed.
+    
+    o When the ._ files are flushed to disk, the journal is deferred: a record that reached the disk before the ._ files
+      it covers would survive them after a crash. The records are kept in memory and GoldinJournalFlush writes them
+      once the volumes have been flushed.
+    
+    o When the run is over, the journal is compacted: the records covered by the record of a folder are removed.
+*/
+
+#ifndef __GOLDIN_JOURNAL_H__
+#define __GOLDIN_JOURNAL_H__
+
+#include "GoldinCommon.h"
+
+enum
+{
+	kGoldinJournalDirectory='D',
+	kGoldinJournalFile='F'
+};
+
+typedef struct _GoldinJournal * GoldinJournalRef;
+
+/* With inResume, the records of the journal are loaded. Otherwise the journal is emptied. With inDeferred, the records
+   are only written by GoldinJournalFlush. Returns NULL and sets errno on failure */
+
+GoldinJournalRef GoldinJournalCreate(const char * inPath,Boolean inResume,Boolean inDeferred);
+
+void GoldinJournalRelease(GoldinJournalRef inJournal);
+
+/* The functions below can be called from any worker */
+
+Boolean GoldinJournalContains(GoldinJournalRef inJournal,char inType,const char * inPath);
+
+/* Returns 0 on success, -1 and sets errno on failure */
+
+int GoldinJournalRecord(GoldinJournalRef inJournal,char inType,const char * inPath);
+
+/* The records kept in memory so far are written with a single write(2) and flushed to disk once inSyncFunction (which
+   flushes the ._ files they cover) has returned 0. If it fails, they are dropped: their items will be split again by the
+   next run. The records added in the meantime are kept for the next call. Returns 0 on success, -1 and sets errno on failure */
+
+int GoldinJournalFlush(GoldinJournalRef inJournal,int (*inSyncFunction)(void * inContext),void * inContext);
+
+/* Number of records loaded from the journal */
+
+size_t GoldinJournalGetLoadedCount(GoldinJournalRef inJournal);
+
+/* Rewrites the journal without the redundant records. Returns 0 on success, -1 and sets errno on failure */
+
+int GoldinJournalCompact(GoldinJournalRef inJournal);
+
+#endif
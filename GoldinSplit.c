@@ -0,0 +1,2636 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinSplit.c
+              Project: goldin
+*/
+
+#include "GoldinSplit.h"
+
+#include "GoldinAppleDouble.h"
+#include "GoldinAsync.h"
+#include "GoldinCopy.h"
+#include "GoldinCounters.h"
+#include "GoldinDedup.h"
+#include "GoldinEstimate.h"
+#include "GoldinHardLinks.h"
+#include "GoldinTrace.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+/* The Resource Fork copy buffer is per thread as SplitFileIfNeeded can be called by many workers at the same time */
+
+#define GOLDIN_BUFFER_ONE_MEGABYTE_SIZE		1048576
+
+typedef struct _GoldinCopyBuffer
+{
+	UInt8 * bytes;
+	size_t size;
+	
+} GoldinCopyBuffer;
+
+static pthread_key_t sCopyBufferKey;
+static pthread_once_t sCopyBufferKeyOnce=PTHREAD_ONCE_INIT;
+
+static void ReleaseCopyBuffer(void * inCopyBuffer)
+{
+	GoldinCopyBuffer * tCopyBuffer=(GoldinCopyBuffer *) inCopyBuffer;
+	
+	free(tCopyBuffer->bytes);
+	free(tCopyBuffer);
+}
+
+static void CreateCopyBufferKey(void)
+{
+	pthread_key_create(&sCopyBufferKey,ReleaseCopyBuffer);
+}
+
+static GoldinCopyBuffer * GetCopyBuffer(void)
+{
+	GoldinCopyBuffer * tCopyBuffer;
+	
+	pthread_once(&sCopyBufferKeyOnce,CreateCopyBufferKey);
+	
+	tCopyBuffer=(GoldinCopyBuffer *) pthread_getspecific(sCopyBufferKey);
+	
+	if (tCopyBuffer==NULL)
+	{
+		size_t tReadRequestCount=GOLDIN_BUFFER_ONE_MEGABYTE_SIZE;
+		UInt8 * tBuffer;
+		
+		do
+		{
+			tBuffer=(UInt8 *) malloc(tReadRequestCount*sizeof(UInt8));
+		
+			tReadRequestCount/=2;
+		}
+		while (tBuffer==NULL && tReadRequestCount>1);
+		
+		if (tBuffer==NULL)
+			return NULL;
+		
+		tCopyBuffer=(GoldinCopyBuffer *) malloc(sizeof(GoldinCopyBuffer));
+		
+		if (tCopyBuffer==NULL)
+		{
+			free(tBuffer);
+			
+			return NULL;
+		}
+		
+		tCopyBuffer->bytes=tBuffer;
+		tCopyBuffer->size=tReadRequestCount*2;
+		
+		pthread_setspecific(sCopyBufferKey,tCopyBuffer);
+	}
+	
+	return tCopyBuffer;
+}
+
+/* The counters are shared by all the jobs, the statistics of the job only count its own items */
+
+static void SplitForksCountItem(GoldinJobRef inJob,GoldinCounter inCounter)
+{
+	GoldinCounterIncrement(inCounter);
+	
+	switch(inCounter)
+	{
+		case kGoldinCounterSplitItems:
+			__sync_fetch_and_add(&inJob->statistics.splitItems,1);
+			__sync_fetch_and_add(&inJob->writtenCount,1);
+			break;
+		case kGoldinCounterUpToDateItems:
+			__sync_fetch_and_add(&inJob->statistics.upToDateItems,1);
+			break;
+		case kGoldinCounterRewrittenItems:
+			__sync_fetch_and_add(&inJob->statistics.rewrittenItems,1);
+			break;
+		case kGoldinCounterLinkedItems:
+			__sync_fetch_and_add(&inJob->statistics.linkedItems,1);
+			__sync_fetch_and_add(&inJob->writtenCount,1);
+			break;
+		case kGoldinCounterDeduplicatedItems:
+			__sync_fetch_and_add(&inJob->statistics.deduplicatedItems,1);
+			break;
+		case kGoldinCounterJournaledItems:
+			__sync_fetch_and_add(&inJob->statistics.journaledItems,1);
+			break;
+		case kGoldinCounterPrunedItems:
+			__sync_fetch_and_add(&inJob->statistics.prunedItems,1);
+			break;
+		case kGoldinCounterVerifiedItems:
+			__sync_fetch_and_add(&inJob->statistics.verifiedItems,1);
+			break;
+		case kGoldinCounterMismatchedItems:
+			__sync_fetch_and_add(&inJob->statistics.mismatchedItems,1);
+			break;
+		case kGoldinCounterMissingItems:
+			__sync_fetch_and_add(&inJob->statistics.missingItems,1);
+			break;
+		case kGoldinCounterOrphanedItems:
+			__sync_fetch_and_add(&inJob->statistics.orphanedItems,1);
+			break;
+		case kGoldinCounterRemovedItems:
+			__sync_fetch_and_add(&inJob->statistics.removedItems,1);
+			break;
+		default:
+			break;
+	}
+}
+
+/* Once the job has failed, no more work is scheduled and the folders being processed are left as they are */
+
+static void SplitForksFail(GoldinJobRef inJob)
+{
+	__sync_bool_compare_and_swap(&inJob->failed,0,1);
+}
+
+static Boolean SplitForksHasFailed(GoldinJobRef inJob)
+{
+	return (inJob->failed!=0) ? TRUE : FALSE;
+}
+
+static void SplitForksLogCreateError(GoldinJobRef inJob,int inError,const char * inPOSIXPath)
+{
+	switch(inError)
+	{
+		case ENAMETOOLONG:
+			/* The file name is too long */
+			
+			GoldinJobLogError(inJob,"File name is too long. The maximum length allowed is %ld characters\n",inJob->maxFileNameLength+2);
+			
+			break;
+		
+		case ENOSPC:
+			
+			GoldinJobLogError(inJob,"Disk is full\n");
+			
+			break;
+		
+		case EDQUOT:
+			
+			GoldinJobLogError(inJob,"Your quota are exceeded\n");
+			
+			break;
+		
+		default:
+			
+			GoldinJobLogError(inJob,"Unable to create the AppleDouble file of %s\n",inPOSIXPath);
+			
+			break;
+	}
+}
+
+static void SplitForksLogWriteError(GoldinJobRef inJob,int inError,const char * inPOSIXPath)
+{
+	switch(inError)
+	{
+		case ENOSPC:
+			GoldinJobLogError(inJob,"Disk is full\n");
+			break;
+		case EDQUOT:
+			GoldinJobLogError(inJob,"Your quota are exceeded\n");
+			break;
+		default:
+			GoldinJobLogError(inJob,"An unknown error occurred while writing the AppleDouble file of %s\n",inPOSIXPath);
+			break;
+	}
+}
+
+/* The absolute path of an item is only built when a message needs it */
+
+static const char * SplitForksGetPath(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,const GoldinEntry * inEntry,char ioPath[PATH_MAX*2+1])
+{
+	if (ioPath[0]=='\0' && inJob->backend->copyPath(inDirectory,inEntry,ioPath,PATH_MAX*2+1)!=0)
+		snprintf(ioPath,PATH_MAX*2+1,"%s",inEntry->name);
+	
+	return ioPath;
+}
+
+/* The FinderInfo and the size of the resource fork are compared through the header. The contents of the fork are not
+   read: they are assumed unchanged if the item has not changed since the ._ file was written */
+
+static Boolean SplitForksIsUpToDate(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,uint64_t inResourceForkSize,Boolean * outExists)
+{
+	UInt8 tExistingHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE];
+	UInt8 tHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE];
+	uint64_t tModificationTime;
+	uint64_t tStartTime=GoldinTraceBegin();
+	int tError;
+	
+	tError=inJob->backend->readAppleDouble(inDirectory,inEntry,tExistingHeader,&tModificationTime);
+	
+	GoldinTraceEnd(kGoldinPhaseCheckAppleDouble,tStartTime,0,NULL);
+	
+	if (tError!=0)
+		return FALSE;
+	
+	*outExists=TRUE;
+	
+	GoldinAppleDoubleEncodeHeader(tHeader,inEntry->finderInfo,(uint32_t) inResourceForkSize);
+	
+	if (memcmp(tHeader,tExistingHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE)!=0)
+		return FALSE;
+	
+	if (inResourceForkSize==0)
+		return TRUE;
+	
+	return (inEntry->changeTime!=0 && inEntry->changeTime<tModificationTime);
+}
+
+/* The absolute path of the ._ file of an item */
+
+static int SplitForksCopyAppleDoublePath(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,const GoldinEntry * inEntry,char * outPath,size_t inSize)
+{
+	size_t tLength;
+	int tCount;
+	
+	if (inJob->backend->copyPath(inDirectory,NULL,outPath,inSize)!=0)
+		return -1;
+	
+	tLength=strlen(outPath);
+	
+	if (tLength>0 && outPath[tLength-1]=='/')
+		tLength--;
+	
+	tCount=snprintf(outPath+tLength,inSize-tLength,"/._%s",inEntry->name);
+	
+	return (tCount<0 || (size_t) tCount>=inSize-tLength) ? -1 : 0;
+}
+
+/* Once the ._ file of the entry is written, replaces it with a clone or a hard link of an identical ._ file written before:
+   the hash is computed while writing so that the resource fork is read only once. Returns 0 if it was replaced, ENOENT if
+   there is none yet (the ._ file is then recorded for the next ones), another errno value if it is kept as is */
+
+static int SplitForksDeduplicate(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,uint64_t inSize,uint64_t inHash)
+{
+	char tNewAppleDoublePath[PATH_MAX*2+1];
+	GoldinCopyBuffer * tCopyBuffer;
+	char * tAppleDoublePath;
+	size_t tHalfSize;
+	uint64_t tOffset;
+	struct stat tStat;
+	struct stat tNewStat;
+	int tDescriptor;
+	int tNewDescriptor=-1;
+	int tError;
+	
+	if (SplitForksCopyAppleDoublePath(inJob,inDirectory,inEntry,tNewAppleDoublePath,sizeof(tNewAppleDoublePath))!=0)
+		return ENOENT;
+	
+	tAppleDoublePath=GoldinDedupIndexCopyPath(inJob->dedupIndex,inSize,inHash);
+	
+	if (tAppleDoublePath==NULL)
+	{
+		/* The next identical ._ files will share this one */
+		
+		GoldinDedupIndexAdd(inJob->dedupIndex,inSize,inHash,tNewAppleDoublePath);
+		
+		return ENOENT;
+	}
+	
+	/* 1. Compare the two ._ files, the hash only tells they are probably the same (the reads are not throttled) */
+	
+	tError=EEXIST;
+	
+	tDescriptor=open(tAppleDoublePath,O_RDONLY|O_NOFOLLOW|O_CLOEXEC);
+	
+	if (tDescriptor==-1)
+		goto bail;
+	
+	if (fstat(tDescriptor,&tStat)!=0 || S_ISREG(tStat.st_mode)==0 || (uint64_t) tStat.st_size!=inSize)
+		goto bail;
+	
+	tNewDescriptor=open(tNewAppleDoublePath,O_RDONLY|O_NOFOLLOW|O_CLOEXEC);
+	
+	if (tNewDescriptor==-1)
+		goto bail;
+	
+	if (fstat(tNewDescriptor,&tNewStat)!=0 || (uint64_t) tNewStat.st_size!=inSize)
+		goto bail;
+	
+	/* Already the same file */
+	
+	if (tNewStat.st_dev==tStat.st_dev && tNewStat.st_ino==tStat.st_ino)
+		goto bail;
+	
+	tCopyBuffer=GetCopyBuffer();
+	
+	if (tCopyBuffer==NULL)
+		goto bail;
+	
+	tHalfSize=tCopyBuffer->size/2;
+	
+	for(tOffset=0;tOffset<inSize;)
+	{
+		size_t tReadCount=(inSize-tOffset<tHalfSize) ? (size_t) (inSize-tOffset) : tHalfSize;
+		
+		if (pread(tDescriptor,tCopyBuffer->bytes,tReadCount,(off_t) tOffset)!=(ssize_t) tReadCount ||
+			pread(tNewDescriptor,tCopyBuffer->bytes+tHalfSize,tReadCount,(off_t) tOffset)!=(ssize_t) tReadCount)
+			goto bail;
+		
+		if (memcmp(tCopyBuffer->bytes,tCopyBuffer->bytes+tHalfSize,tReadCount)!=0)
+			goto bail;
+		
+		tOffset+=tReadCount;
+	}
+	
+	/* 2. Replace the new ._ file with a clone of the identical one: it keeps its own owner and permissions */
+	
+	if (inJob->currentVolume->cloneUnsupported==0)
+	{
+		GoldinAppleDoubleFileRef tNewFile;
+		
+		if (inJob->backend->createAppleDouble(inDirectory,inEntry,&tNewFile)==0)
+		{
+			off_t tNewFileOffset;
+			int tNewFileDescriptor=inJob->backend->getAppleDoubleDescriptor(tNewFile,&tNewFileOffset);
+			int tCloneError=ENOTSUP;
+			
+			/* The backend can not give a file to clone into: it never will */
+			
+			if (tNewFileDescriptor!=-1 && tNewFileOffset==0)
+				tCloneError=GoldinCopyClone(tDescriptor,tNewFileDescriptor);
+			
+			if (tCloneError==0)
+			{
+				if (inJob->backend->closeAppleDouble(tNewFile,inEntry)==0)
+					tError=0;
+				
+				goto bail;
+			}
+			
+			/* The other errors only concern this file */
+			
+			if (tCloneError==ENOTSUP || tCloneError==EOPNOTSUPP)
+				inJob->currentVolume->cloneUnsupported=1;
+			
+			inJob->backend->closeAppleDouble(tNewFile,NULL);
+		}
+	}
+	
+	/* 3. Or with a hard link to it if it already has the owner and permissions of the new one */
+	
+	if (tStat.st_uid==tNewStat.st_uid && tStat.st_gid==tNewStat.st_gid && (tStat.st_mode & 07777)==(tNewStat.st_mode & 07777))
+	{
+		switch(inJob->backend->linkAppleDouble(inDirectory,inEntry,tAppleDoublePath))
+		{
+			case 0:
+			case EEXIST:
+				
+				tError=0;
+				break;
+			
+			default:
+				break;
+		}
+	}
+	
+bail:
+	
+	if (tNewDescriptor!=-1)
+		close(tNewDescriptor);
+	
+	if (tDescriptor!=-1)
+		close(tDescriptor);
+	
+	free(tAppleDoublePath);
+	
+	return tError;
+}
+
+/* A file of the user can have a name starting with ._ too: only the files starting like an AppleDouble file are taken for
+   orphaned ._ files */
+
+static Boolean SplitForksIsAppleDoubleFile(const char * inPath,uint64_t * outSize)
+{
+	UInt8 tSignature[GOLDIN_APPLEDOUBLE_SIGNATURE_SIZE];
+	struct stat tStat;
+	Boolean tIsAppleDouble=FALSE;
+	int tDescriptor;
+	
+	tDescriptor=open(inPath,O_RDONLY|O_NOFOLLOW|O_CLOEXEC);
+	
+	if (tDescriptor==-1)
+		return FALSE;
+	
+	if (fstat(tDescriptor,&tStat)==0 && S_ISREG(tStat.st_mode)!=0 && pread(tDescriptor,tSignature,GOLDIN_APPLEDOUBLE_SIGNATURE_SIZE,0)==GOLDIN_APPLEDOUBLE_SIGNATURE_SIZE)
+	{
+		tIsAppleDouble=(GoldinAppleDoubleHasSignature(tSignature)!=0);
+		
+		if (outSize!=NULL)
+			*outSize=(uint64_t) tStat.st_size;
+	}
+	
+	close(tDescriptor);
+	
+	return tIsAppleDouble;
+}
+
+/* Removes a ._ file whose item is gone or does not need it anymore */
+
+static void SplitForksRemoveStale(GoldinJobRef inJob,const char * inAppleDoublePath)
+{
+	uint64_t tSize=0;
+	
+	if (SplitForksIsAppleDoubleFile(inAppleDoublePath,&tSize)==FALSE)
+		return;
+	
+	if (inJob->progressCallback!=NULL)
+		inJob->progressCallback(kGoldinProgressRemoving,inAppleDoublePath,tSize,inJob->callbackContext);
+	
+	if (unlink(inAppleDoublePath)!=0)
+	{
+		if (errno!=ENOENT)
+			GoldinJobLogError(inJob,"Unable to remove the stale AppleDouble file %s (%s)\n",inAppleDoublePath,strerror(errno));
+		
+		return;
+	}
+	
+	SplitForksCountItem(inJob,kGoldinCounterRemovedItems);
+}
+
+/* A temporary file that has not been written to for this long can not belong to a run that is still writing it (seconds) */
+
+#define GOLDIN_TEMPORARY_FILE_MAXIMUM_AGE		86400
+
+/* A name made by GoldinAppleDoubleMakeTemporaryName can still be the name of a file of the user: only an empty file (the
+   ._ file was just created) or a file starting like an AppleDouble file is taken for a temporary file. *outIsStale is set
+   to TRUE if it was left by a run of this host that died, and either starts like an AppleDouble file or is old enough:
+   it can then be removed */
+
+static Boolean SplitForksIsTemporaryFile(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,const GoldinEntry * inEntry,char * outPath,size_t inSize,Boolean * outIsStale)
+{
+	UInt8 tSignature[GOLDIN_APPLEDOUBLE_SIGNATURE_SIZE];
+	struct stat tStat;
+	uint32_t tHostIdentifier;
+	pid_t tProcessID;
+	Boolean tHasSignature=FALSE;
+	int tDescriptor;
+	
+	*outIsStale=FALSE;
+	
+	if ((inEntry->flags & (kGoldinEntryIsDirectory|kGoldinEntryIsSymbolicLink))!=0 || GoldinAppleDoubleIsTemporaryName(inEntry->name,&tHostIdentifier,&tProcessID)==0)
+		return FALSE;
+	
+	/* When the file can not be looked at, it is left alone */
+	
+	if (inJob->backend->copyPath(inDirectory,inEntry,outPath,inSize)!=0)
+		return TRUE;
+	
+	tDescriptor=open(outPath,O_RDONLY|O_NOFOLLOW|O_CLOEXEC);
+	
+	if (tDescriptor==-1)
+		return TRUE;
+	
+	if (fstat(tDescriptor,&tStat)!=0)
+	{
+		close(tDescriptor);
+		
+		return TRUE;
+	}
+	
+	if (tStat.st_size>0)
+	{
+		if (pread(tDescriptor,tSignature,GOLDIN_APPLEDOUBLE_SIGNATURE_SIZE,0)==GOLDIN_APPLEDOUBLE_SIGNATURE_SIZE)
+			tHasSignature=(GoldinAppleDoubleHasSignature(tSignature)!=0);
+		
+		if (tHasSignature==FALSE)
+		{
+			/* A file of the user */
+			
+			close(tDescriptor);
+			
+			return FALSE;
+		}
+	}
+	
+	close(tDescriptor);
+	
+	/* The process ID is only meaningful on the host that made the name (the volume can be shared) */
+	
+	if (tHostIdentifier!=GoldinAppleDoubleGetHostIdentifier() || tProcessID==getpid() || kill(tProcessID,0)==0 || errno!=ESRCH)
+		return TRUE;
+	
+	if (tHasSignature==TRUE || time(NULL)-tStat.st_mtime>GOLDIN_TEMPORARY_FILE_MAXIMUM_AGE)
+		*outIsStale=TRUE;
+	
+	return TRUE;
+}
+
+/* Removes a temporary file left in the folder by a run that died (see SplitForksIsTemporaryFile) */
+
+static void SplitForksRemoveTemporary(GoldinJobRef inJob,const char * inPath)
+{
+	if (inJob->progressCallback!=NULL)
+		inJob->progressCallback(kGoldinProgressRemoving,inPath,0,inJob->callbackContext);
+	
+	if (unlink(inPath)!=0)
+	{
+		if (errno!=ENOENT)
+			GoldinJobLogError(inJob,"Unable to remove the temporary file %s (%s)\n",inPath,strerror(errno));
+		
+		return;
+	}
+	
+	SplitForksCountItem(inJob,kGoldinCounterRemovedItems);
+}
+
+/* Compares the ._ file of an item with the one that would be written: the header first, then the resource fork and the
+   ._ file are read side by side one chunk at a time so that neither of them is held in memory. inSplitNeeded is FALSE
+   when the item does not need a ._ file (it is then orphaned if there is one). The differences are reported, they do
+   not make the job fail */
+
+static void SplitForksVerify(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,Boolean inSplitNeeded,GoldinForkRef inFork,uint64_t inResourceForkSize)
+{
+	UInt8 tHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE];
+	UInt8 tExistingHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE];
+	char tPOSIXPath[PATH_MAX*2+1]="";
+	char tAppleDoublePath[PATH_MAX*2+1];
+	const char * tDifference=NULL;
+	GoldinCopyBuffer * tCopyBuffer;
+	struct stat tStat;
+	uint64_t tStartTime;
+	int tDescriptor;
+	
+	if (SplitForksCopyAppleDoublePath(inJob,inDirectory,inEntry,tAppleDoublePath,sizeof(tAppleDoublePath))!=0)
+	{
+		GoldinJobLogError(inJob,"Unable to verify the AppleDouble file of %s\n",SplitForksGetPath(inJob,inDirectory,inEntry,tPOSIXPath));
+		
+		return;
+	}
+	
+	tStartTime=GoldinTraceBegin();
+	
+	if (inSplitNeeded==FALSE)
+	{
+		/* The resource fork has been stripped or the FinderInfo cleared since the ._ file was written */
+		
+		if (SplitForksIsAppleDoubleFile(tAppleDoublePath,NULL)==TRUE)
+		{
+			SplitForksCountItem(inJob,kGoldinCounterOrphanedItems);
+			
+			GoldinJobLogError(inJob,"Orphaned AppleDouble file: %s (no resource fork or FinderInfo)\n",tAppleDoublePath);
+		}
+		
+		GoldinTraceEnd(kGoldinPhaseCheckAppleDouble,tStartTime,0,NULL);
+		
+		return;
+	}
+	
+	tDescriptor=open(tAppleDoublePath,O_RDONLY|O_NOFOLLOW|O_CLOEXEC);
+	
+	if (tDescriptor==-1)
+	{
+		int tError=errno;
+		
+		GoldinTraceEnd(kGoldinPhaseCheckAppleDouble,tStartTime,0,NULL);
+		
+		switch(tError)
+		{
+			case ENOENT:
+				
+				SplitForksCountItem(inJob,kGoldinCounterMissingItems);
+				
+				GoldinJobLogError(inJob,"Missing AppleDouble file: %s\n",tAppleDoublePath);
+				
+				break;
+			
+			case ELOOP:
+				
+				/* A symbolic link is never a ._ file */
+				
+				SplitForksCountItem(inJob,kGoldinCounterMismatchedItems);
+				
+				GoldinJobLogError(inJob,"Mismatched AppleDouble file: %s (symbolic link)\n",tAppleDoublePath);
+				
+				break;
+			
+			default:
+				
+				GoldinJobLogError(inJob,"Unable to open the AppleDouble file %s (%s)\n",tAppleDoublePath,strerror(tError));
+				
+				break;
+		}
+		
+		return;
+	}
+	
+	if (inJob->progressCallback!=NULL)
+		inJob->progressCallback(kGoldinProgressVerifying,SplitForksGetPath(inJob,inDirectory,inEntry,tPOSIXPath),GOLDIN_APPLEDOUBLE_HEADER_SIZE+inResourceForkSize,inJob->callbackContext);
+	
+	/* 1. The header: layout, FinderInfo (big endian) and length of the resource fork */
+	
+	GoldinAppleDoubleEncodeHeader(tHeader,inEntry->finderInfo,(uint32_t) inResourceForkSize);
+	
+	if (fstat(tDescriptor,&tStat)!=0 || S_ISREG(tStat.st_mode)==0)
+	{
+		tDifference="not a file";
+	}
+	else if (pread(tDescriptor,tExistingHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE,0)!=GOLDIN_APPLEDOUBLE_HEADER_SIZE)
+	{
+		tDifference="truncated header";
+	}
+	else if (memcmp(tHeader,tExistingHeader,GOLDIN_APPLEDOUBLE_RESOURCEFORK_ENTRY_OFFSET)!=0)
+	{
+		tDifference="header";
+	}
+	else if (memcmp(tHeader+GOLDIN_APPLEDOUBLE_FINDERINFO_OFFSET,tExistingHeader+GOLDIN_APPLEDOUBLE_FINDERINFO_OFFSET,GOLDIN_APPLEDOUBLE_FINDERINFO_SIZE)!=0)
+	{
+		tDifference="FinderInfo";
+	}
+	else if (memcmp(tHeader,tExistingHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE)!=0)
+	{
+		tDifference="resource fork length";
+	}
+	else if ((uint64_t) tStat.st_size!=GOLDIN_APPLEDOUBLE_HEADER_SIZE+inResourceForkSize)
+	{
+		tDifference="size";
+	}
+	else if (inFork!=NULL)
+	{
+		uint64_t tOffset;
+		size_t tHalfSize;
+		
+		/* 2. The resource fork */
+		
+		tCopyBuffer=GetCopyBuffer();
+		
+		if (tCopyBuffer==NULL)
+		{
+			close(tDescriptor);
+			
+			GoldinJobLogError(inJob,"Unable to verify the AppleDouble file %s (%s)\n",tAppleDoublePath,strerror(ENOMEM));
+			
+			return;
+		}
+		
+		tHalfSize=tCopyBuffer->size/2;
+		
+		for(tOffset=0;tOffset<inResourceForkSize;)
+		{
+			size_t tReadCount;
+			
+			if (inJob->backend->readResourceFork(inFork,tOffset,tCopyBuffer->bytes,tHalfSize,&tReadCount)!=0 || tReadCount==0)
+			{
+				close(tDescriptor);
+				
+				GoldinJobLogError(inJob,"Unable to read the resource fork of %s\n",SplitForksGetPath(inJob,inDirectory,inEntry,tPOSIXPath));
+				
+				return;
+			}
+			
+			GoldinThrottleAcquire(inJob->byteThrottle,tReadCount);
+			
+			if (pread(tDescriptor,tCopyBuffer->bytes+tHalfSize,tReadCount,(off_t) (GOLDIN_APPLEDOUBLE_HEADER_SIZE+tOffset))!=(ssize_t) tReadCount ||
+				memcmp(tCopyBuffer->bytes,tCopyBuffer->bytes+tHalfSize,tReadCount)!=0)
+			{
+				tDifference="resource fork";
+				
+				break;
+			}
+			
+			tOffset+=tReadCount;
+		}
+	}
+	
+	close(tDescriptor);
+	
+	GoldinTraceEnd(kGoldinPhaseCheckAppleDouble,tStartTime,0,NULL);
+	
+	if (tDifference!=NULL)
+	{
+		SplitForksCountItem(inJob,kGoldinCounterMismatchedItems);
+		
+		GoldinJobLogError(inJob,"Mismatched AppleDouble file: %s (%s)\n",tAppleDoublePath,tDifference);
+		
+		return;
+	}
+	
+	SplitForksCountItem(inJob,kGoldinCounterVerifiedItems);
+}
+
+/* *outWrittenSize is the size of the ._ file, 0 if there was no need to write it. *outHasAppleDouble is TRUE if the ._ file
+   is there once done (written or up to date) */
+
+static int SplitForksSplitFile(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,Boolean * outDidSplit,uint64_t * outWrittenSize,Boolean * outHasAppleDouble)
+{
+	int tError=0;
+	Boolean tSplitNeeded=FALSE;
+	GoldinForkRef tFork=NULL;
+	uint64_t tResourceForkSize=0;
+	char tPOSIXPath[PATH_MAX*2+1]="";
+	GoldinAppleDoubleFileRef tNewFile=NULL;
+	Boolean tAppleDoubleExists=FALSE;
+	uint64_t tDedupHash=GOLDIN_DEDUP_HASH_INITIAL_VALUE;
+	uint64_t tStartTime;
+	
+	if (outDidSplit!=NULL)
+		*outDidSplit=FALSE;
+	
+	*outWrittenSize=0;
+	*outHasAppleDouble=FALSE;
+	
+	/* 0. In incremental mode, do not even open the resource fork if the listing tells us enough */
+	
+	if (inJob->incrementalMode==TRUE && inEntry->resourceForkSize!=kGoldinUnknownSize)
+	{
+		if (inEntry->resourceForkSize>0 || GoldinFinderInfoNeedsSplit(inEntry->finderInfo)!=0)
+		{
+			if (SplitForksIsUpToDate(inJob,inDirectory,inEntry,(uint64_t) inEntry->resourceForkSize,&tAppleDoubleExists)==TRUE)
+			{
+				SplitForksCountItem(inJob,kGoldinCounterUpToDateItems);
+				
+				*outHasAppleDouble=TRUE;
+				
+				return 0;
+			}
+		}
+	}
+	
+	/* 1. Check for the presence of a resource fork */
+	
+	if (inEntry->resourceForkSize==0)
+	{
+		/* The listing of the folder already told us there is no resource fork */
+	}
+	else if (inJob->dryRunMode==TRUE && inEntry->resourceForkSize!=kGoldinUnknownSize)
+	{
+		/* The listing of the folder already told us its size: no need to open it */
+		
+		tResourceForkSize=(uint64_t) inEntry->resourceForkSize;
+		
+		if (tResourceForkSize>0xFFFFFFFF)
+		{
+			GoldinJobLogError(inJob,"AppleDouble file format does not support forks bigger than 2 GB\n");
+			
+			return -1;
+		}
+		
+		tSplitNeeded=TRUE;
+	}
+	else
+	{
+		tStartTime=GoldinTraceBegin();
+		
+		tError=inJob->backend->openResourceFork(inDirectory,inEntry,&tFork,&tResourceForkSize);
+		
+		GoldinTraceEnd(kGoldinPhaseOpenFork,tStartTime,0,NULL);
+		
+		GoldinCounterIncrement(kGoldinCounterForkOpens);
+		
+		switch(tError)
+		{
+			case 0:
+				
+				tSplitNeeded=TRUE;
+				break;
+			
+			case ENOENT:
+				/* No resource Fork */
+				
+				tError=0;
+				tFork=NULL;
+				break;
+			
+			case EFBIG:
+				
+				/* AppleDouble File format does not support forks bigger than 2GB */
+				
+				GoldinJobLogError(inJob,"AppleDouble file format does not support forks bigger than 2 GB\n");
+				
+				return -1;
+			
+			default:
+				
+				GoldinJobLogError(inJob,"Unable to open fork\n");
+				
+				return -1;
+		}
+	}
+	
+	/* 2. Check for the presence of FinderInfo or ExtFinderInfo (01/02/07: not the one of a Symbolic link) */
+	
+	if (tSplitNeeded==FALSE)
+		tSplitNeeded=(GoldinFinderInfoNeedsSplit(inEntry->finderInfo)!=0);
+	
+	if (tSplitNeeded==FALSE)
+	{
+		if (inJob->verifyMode==TRUE)
+		{
+			SplitForksVerify(inJob,inDirectory,inEntry,FALSE,NULL,0);
+		}
+		else if (inJob->pruneStale==TRUE)
+		{
+			char tAppleDoublePOSIXPath[PATH_MAX*2+1];
+			
+			/* The ._ file of a folder whose FinderInfo was cleared, or of a file whose resource fork was emptied */
+			
+			if (SplitForksCopyAppleDoublePath(inJob,inDirectory,inEntry,tAppleDoublePOSIXPath,sizeof(tAppleDoublePOSIXPath))==0)
+				SplitForksRemoveStale(inJob,tAppleDoublePOSIXPath);
+		}
+		
+		return 0;
+	}
+	
+	if (inJob->verifyMode==TRUE)
+	{
+		SplitForksVerify(inJob,inDirectory,inEntry,TRUE,tFork,tResourceForkSize);
+		
+		if (tFork!=NULL)
+			inJob->backend->closeResourceFork(tFork);
+		
+		return 0;
+	}
+	
+	if (inJob->incrementalMode==TRUE && inEntry->resourceForkSize==kGoldinUnknownSize)
+	{
+		if (SplitForksIsUpToDate(inJob,inDirectory,inEntry,tResourceForkSize,&tAppleDoubleExists)==TRUE)
+		{
+			SplitForksCountItem(inJob,kGoldinCounterUpToDateItems);
+			
+			*outHasAppleDouble=TRUE;
+			
+			if (tFork!=NULL)
+				inJob->backend->closeResourceFork(tFork);
+			
+			return 0;
+		}
+	}
+	
+	if (inJob->dryRunMode==TRUE)
+	{
+		if (inJob->progressCallback!=NULL)
+			inJob->progressCallback(kGoldinProgressWouldSplit,SplitForksGetPath(inJob,inDirectory,inEntry,tPOSIXPath),GOLDIN_APPLEDOUBLE_HEADER_SIZE+tResourceForkSize,inJob->callbackContext);
+		
+		GoldinEstimateAddItem(inJob->estimate,tResourceForkSize);
+		
+		*outHasAppleDouble=TRUE;
+		
+		if (tFork!=NULL)
+			inJob->backend->closeResourceFork(tFork);
+		
+		return 0;
+	}
+	
+	/* 3. Split */
+	
+	if (inJob->progressCallback!=NULL)
+	{
+		inJob->progressCallback(kGoldinProgressSplitting,SplitForksGetPath(inJob,inDirectory,inEntry,tPOSIXPath),GOLDIN_APPLEDOUBLE_HEADER_SIZE+tResourceForkSize,inJob->callbackContext);
+	}
+	
+	GoldinThrottleAcquire(inJob->fileThrottle,1);
+	
+	/* We need to create a ._file */
+	
+	tStartTime=GoldinTraceBegin();
+	
+	tError=inJob->backend->createAppleDouble(inDirectory,inEntry,&tNewFile);
+	
+	GoldinTraceEnd(kGoldinPhaseCreateAppleDouble,tStartTime,0,NULL);
+	
+	if (tError!=0)
+	{
+		SplitForksLogCreateError(inJob,tError,SplitForksGetPath(inJob,inDirectory,inEntry,tPOSIXPath));
+		
+		tError=-1;
+		
+		goto byebye;
+	}
+	
+	{
+		UInt8 tHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE];
+		UInt8 * tWriteBuffer=tHeader;
+		size_t tWriteCount=GOLDIN_APPLEDOUBLE_HEADER_SIZE;
+		GoldinCopyBuffer * tCopyBuffer=NULL;
+		uint64_t tOffset=0;
+		
+		tStartTime=GoldinTraceBegin();
+		
+		if (tFork!=NULL)
+		{
+			size_t tReadCount;
+			
+			tCopyBuffer=GetCopyBuffer();
+			
+			if (tCopyBuffer==NULL || tCopyBuffer->size<=GOLDIN_APPLEDOUBLE_HEADER_SIZE)
+			{
+				tError=ENOMEM;
+				
+				goto writebail;
+			}
+			
+			/* The header, the entries descriptors and the Finder Info are assembled in memory and written with the first chunk of the Resource Fork */
+			
+			/* (Every write is a round trip on network volumes) */
+			
+			tError=inJob->backend->readResourceFork(tFork,0,tCopyBuffer->bytes+GOLDIN_APPLEDOUBLE_HEADER_SIZE,tCopyBuffer->size-GOLDIN_APPLEDOUBLE_HEADER_SIZE,&tReadCount);
+			
+			if (tError!=0)
+			{
+				/* A problem occurred while reading the Resource Fork */
+				
+				goto writebail;
+			}
+			
+			tWriteBuffer=tCopyBuffer->bytes;
+			tWriteCount+=tReadCount;
+			tOffset=tReadCount;
+			
+			GoldinCounterAdd(kGoldinCounterBytesBuffered,tReadCount);
+		}
+		
+		GoldinAppleDoubleEncodeHeader(tWriteBuffer,inEntry->finderInfo,(uint32_t) tResourceForkSize);
+		
+		if (inJob->dedupIndex!=NULL)
+			tDedupHash=GoldinDedupHash(tDedupHash,tWriteBuffer,tWriteCount);
+		
+		GoldinThrottleAcquire(inJob->byteThrottle,tWriteCount);
+		
+		tError=inJob->backend->writeAppleDouble(tNewFile,tWriteBuffer,tWriteCount);
+		
+		GoldinTraceEnd(kGoldinPhaseWriteHeader,tStartTime,tWriteCount,NULL);
+		
+		if (tError!=0)
+			goto writebail;
+		
+		/* **** Write the rest of the Resource Fork */
+		
+		tStartTime=GoldinTraceBegin();
+		
+		while (tFork!=NULL && tOffset<tResourceForkSize)
+		{
+			size_t tReadCount;
+			
+			tError=inJob->backend->readResourceFork(tFork,tOffset,tCopyBuffer->bytes,tCopyBuffer->size,&tReadCount);
+			
+			if (tError!=0)
+			{
+				/* A problem occurred while reading the Resource Fork */
+				
+				goto writebail;
+			}
+			
+			if (tReadCount==0)
+				break;
+			
+			GoldinCounterAdd(kGoldinCounterBytesBuffered,tReadCount);
+			
+			if (inJob->dedupIndex!=NULL)
+				tDedupHash=GoldinDedupHash(tDedupHash,tCopyBuffer->bytes,tReadCount);
+			
+			GoldinThrottleAcquire(inJob->byteThrottle,tReadCount);
+			
+			tError=inJob->backend->writeAppleDouble(tNewFile,tCopyBuffer->bytes,tReadCount);
+			
+			if (tError!=0)
+			{
+				/* A problem occurred while writing the Resource Fork Data to the AppleDouble file */
+				
+				goto writebail;
+			}
+			
+			tOffset+=tReadCount;
+		}
+		
+		if (tFork!=NULL)
+			GoldinTraceEnd(kGoldinPhaseCopyFork,tStartTime,GOLDIN_APPLEDOUBLE_HEADER_SIZE+tResourceForkSize-tWriteCount,NULL);
+	}
+	
+	/* Set the owner */
+	
+	tStartTime=GoldinTraceBegin();
+	
+	tError=inJob->backend->closeAppleDouble(tNewFile,inEntry);
+	
+	GoldinTraceEnd(kGoldinPhaseSetOwner,tStartTime,0,NULL);
+	
+	if (tError!=0)
+	{
+		/*GoldinJobLogError(inJob,"Permissions, owner and group could not be set for the AppleDouble file of %s\n",tPOSIXPath); */
+		
+		tError=-1;
+		
+		goto byebye;
+	}
+	
+	/* The ._ file shares the blocks of an identical one if there is one */
+	
+	if (inJob->dedupIndex!=NULL && SplitForksDeduplicate(inJob,inDirectory,inEntry,GOLDIN_APPLEDOUBLE_HEADER_SIZE+tResourceForkSize,tDedupHash)==0)
+	{
+		SplitForksCountItem(inJob,kGoldinCounterDeduplicatedItems);
+		GoldinCounterAdd(kGoldinCounterBytesDeduplicated,GOLDIN_APPLEDOUBLE_HEADER_SIZE+tResourceForkSize);
+	}
+	
+	if (outDidSplit!=NULL)
+		*outDidSplit=TRUE;
+	
+	*outWrittenSize=GOLDIN_APPLEDOUBLE_HEADER_SIZE+tResourceForkSize;
+	*outHasAppleDouble=TRUE;
+	
+	SplitForksCountItem(inJob,kGoldinCounterSplitItems);
+	
+	if (tAppleDoubleExists==TRUE)
+		SplitForksCountItem(inJob,kGoldinCounterRewrittenItems);
+	
+	/* Close the Resource Fork if needed */
+	
+	if (tFork!=NULL)
+	{
+		inJob->backend->closeResourceFork(tFork);
+		
+		if (inJob->stripResourceForks==TRUE)
+		{
+			/* Strip the resource fork */
+			
+			tStartTime=GoldinTraceBegin();
+			
+			tError=inJob->backend->deleteResourceFork(inDirectory,inEntry);
+			
+			GoldinTraceEnd(kGoldinPhaseStripFork,tStartTime,tResourceForkSize,NULL);
+			
+			if (tError!=0)
+			{
+				GoldinJobLogError(inJob,"Resource Fork could not be stripped from %s\n",SplitForksGetPath(inJob,inDirectory,inEntry,tPOSIXPath));
+				
+				/* A COMPLETER */
+			}
+		}
+	}
+	
+	return 0;
+	
+writebail:
+
+	SplitForksLogWriteError(inJob,tError,SplitForksGetPath(inJob,inDirectory,inEntry,tPOSIXPath));
+	
+	inJob->backend->closeAppleDouble(tNewFile,NULL);
+	
+	tError=-1;
+	
+byebye:
+
+	if (tFork!=NULL)
+	{
+		inJob->backend->closeResourceFork(tFork);
+	}
+	
+	return tError;
+}
+
+static int SplitForksSplitEntry(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,Boolean * outDidSplit,Boolean * outHasAppleDouble)
+{
+	uint64_t tStartTime=GoldinTraceBegin();
+	uint64_t tWrittenSize;
+	int tError;
+	
+	tError=SplitForksSplitFile(inJob,inDirectory,inEntry,outDidSplit,&tWrittenSize,outHasAppleDouble);
+	
+	GoldinTraceEnd(kGoldinPhaseItem,tStartTime,tWrittenSize,inEntry->name);
+	
+	return tError;
+}
+
+int SplitFileIfNeeded(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,Boolean * outDidSplit)
+{
+	Boolean tHasAppleDouble;
+	
+	return SplitForksSplitEntry(inJob,inDirectory,inEntry,outDidSplit,&tHasAppleDouble);
+}
+
+#pragma mark -
+
+/* Every link to the item gets a ._ file but only the first one found is split: the ._ files of the other links are hard
+   links to the ._ file of the first one */
+
+static int SplitForksSplitHardLink(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry)
+{
+	char tPOSIXPath[PATH_MAX*2+1]="";
+	char * tAppleDoublePath=NULL;
+	Boolean tHasAppleDouble=FALSE;
+	int tError;
+	
+	if (GoldinHardLinkTableClaim(inJob->hardLinkTable,(uint64_t) inJob->currentVolume->device,inEntry->fileID,&tAppleDoublePath)==TRUE)
+	{
+		char tAppleDoublePOSIXPath[PATH_MAX*2+1];
+		
+		tError=SplitForksSplitEntry(inJob,inDirectory,inEntry,NULL,&tHasAppleDouble);
+		
+		if (tError!=0 || tHasAppleDouble==FALSE || SplitForksCopyAppleDoublePath(inJob,inDirectory,inEntry,tAppleDoublePOSIXPath,sizeof(tAppleDoublePOSIXPath))!=0)
+			GoldinHardLinkTableResolve(inJob->hardLinkTable,(uint64_t) inJob->currentVolume->device,inEntry->fileID,NULL);
+		else
+			GoldinHardLinkTableResolve(inJob->hardLinkTable,(uint64_t) inJob->currentVolume->device,inEntry->fileID,tAppleDoublePOSIXPath);
+		
+		return tError;
+	}
+	
+	if (tAppleDoublePath==NULL)
+	{
+		/* The ._ file of the first link could not be written, try again with this one */
+		
+		return SplitFileIfNeeded(inJob,inDirectory,inEntry,NULL);
+	}
+	
+	if (inJob->dryRunMode==TRUE)
+	{
+		if (inJob->progressCallback!=NULL)
+			inJob->progressCallback(kGoldinProgressWouldLink,SplitForksGetPath(inJob,inDirectory,inEntry,tPOSIXPath),0,inJob->callbackContext);
+		
+		GoldinEstimateAddLink(inJob->estimate);
+		
+		free(tAppleDoublePath);
+		
+		return 0;
+	}
+	
+	if (inJob->progressCallback!=NULL)
+	{
+		inJob->progressCallback(kGoldinProgressLinking,SplitForksGetPath(inJob,inDirectory,inEntry,tPOSIXPath),0,inJob->callbackContext);
+	}
+	
+	GoldinThrottleAcquire(inJob->fileThrottle,1);
+	
+	tError=inJob->backend->linkAppleDouble(inDirectory,inEntry,tAppleDoublePath);
+	
+	free(tAppleDoublePath);
+	
+	switch(tError)
+	{
+		case 0:
+			
+			SplitForksCountItem(inJob,kGoldinCounterLinkedItems);
+			break;
+		
+		case EEXIST:
+			
+			/* Already a link to the ._ file of the first link */
+			
+			SplitForksCountItem(inJob,kGoldinCounterUpToDateItems);
+			break;
+		
+		default:
+			
+			/* The volume does not want another link (EXDEV, EMLINK, EPERM...): this link gets its own copy */
+			
+			return SplitFileIfNeeded(inJob,inDirectory,inEntry,NULL);
+	}
+	
+	return 0;
+}
+
+#pragma mark -
+
+/* With a journal, a folder is recorded once its contents and all its subfolders have been split */
+
+typedef struct _SplitForksNode
+{
+	struct _SplitForksNode * parent;
+	
+	long pending;				/* The folder itself and the subfolders not done yet */
+	Boolean incomplete;			/* Some items could not be listed or split */
+	
+	char * path;
+	
+} SplitForksNode;
+
+typedef struct _SplitForksTask
+{
+	GoldinJobRef job;
+	GoldinDirectoryRef directory;
+	SplitForksNode * node;		/* NULL without a journal */
+	unsigned long depth;		/* Depth of the folder, the top items are at depth 0 */
+	
+} SplitForksTask;
+
+static void SplitForksProcessDirectory(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,SplitForksNode * inNode,unsigned long inDepth);
+
+static void SplitForksJournalRecord(GoldinJobRef inJob,char inType,const char * inPath)
+{
+	if (GoldinJournalRecord(inJob->journal,inType,inPath)!=0)
+		GoldinJobLogError(inJob,"An error occurred while writing the journal (%s)\n",strerror(errno));
+}
+
+/* The volumes are flushed, then the journal is written (Goldin.c), by the worker that writes the ._ file reaching the checkpoint */
+
+static Boolean SplitForksClaimCheckpoint(GoldinJobRef inJob)
+{
+	uint64_t tWrittenCount;
+	uint64_t tNextCheckpoint;
+	
+	if (inJob->checkpointInterval==0)
+		return FALSE;
+	
+	tWrittenCount=inJob->writtenCount;
+	
+	tNextCheckpoint=inJob->nextCheckpoint;
+	
+	if (tWrittenCount<((tNextCheckpoint==0) ? inJob->checkpointInterval : tNextCheckpoint))
+		return FALSE;
+	
+	return __sync_bool_compare_and_swap(&inJob->nextCheckpoint,tNextCheckpoint,tWrittenCount+inJob->checkpointInterval);
+}
+
+
+static void SplitForksNodeMarkIncomplete(SplitForksNode * inNode)
+{
+	if (inNode!=NULL)
+		inNode->incomplete=TRUE;
+}
+
+static SplitForksNode * SplitForksNodeCreate(GoldinJobRef inJob,SplitForksNode * inParentNode,GoldinDirectoryRef inDirectory)
+{
+	char tPOSIXPath[PATH_MAX*2+1];
+	SplitForksNode * tNode;
+	
+	if (inJob->journal==NULL)
+		return NULL;
+	
+	tNode=(SplitForksNode *) calloc(1,sizeof(SplitForksNode));
+	
+	if (tNode==NULL || inJob->backend->copyPath(inDirectory,NULL,tPOSIXPath,sizeof(tPOSIXPath))!=0 || (tNode->path=strdup(tPOSIXPath))==NULL)
+	{
+		/* The parent folder will not be recorded, it will be split again by the next run */
+		
+		free(tNode);
+		
+		SplitForksNodeMarkIncomplete(inParentNode);
+		
+		return NULL;
+	}
+	
+	tNode->parent=inParentNode;
+	tNode->pending=1;
+	
+	if (inParentNode!=NULL)
+		__sync_fetch_and_add(&inParentNode->pending,1);
+	
+	return tNode;
+}
+
+static void SplitForksNodeRelease(GoldinJobRef inJob,SplitForksNode * inNode)
+{
+	while (inNode!=NULL && __sync_sub_and_fetch(&inNode->pending,1)==0)
+	{
+		SplitForksNode * tParentNode=inNode->parent;
+		
+		if (inNode->incomplete==FALSE)
+			SplitForksJournalRecord(inJob,kGoldinJournalDirectory,inNode->path);
+		else
+			SplitForksNodeMarkIncomplete(tParentNode);
+		
+		free(inNode->path);
+		free(inNode);
+		
+		inNode=tParentNode;
+	}
+}
+
+#pragma mark -
+
+/* Every thread has its own ring: a ring must only be used by the thread that created it */
+
+#define GOLDIN_ASYNC_QUEUE_DEPTH		256
+
+typedef struct _SplitForksAsyncItem
+{
+	GoldinJobRef job;
+	SplitForksNode * node;			/* The folder of the item waits for the ._ file to be written */
+	
+	Boolean appleDoubleExists;
+	Boolean recordInJournal;
+	
+	uint64_t startTime;				/* The span of the item goes from the submission to the completion */
+	
+	char path[1];
+	
+} SplitForksAsyncItem;
+
+static pthread_key_t sAsyncKey;
+static pthread_once_t sAsyncKeyOnce=PTHREAD_ONCE_INIT;
+
+static void ReleaseAsync(void * inAsync)
+{
+	GoldinAsyncRelease((GoldinAsyncRef) inAsync);
+}
+
+static void CreateAsyncKey(void)
+{
+	pthread_key_create(&sAsyncKey,ReleaseAsync);
+}
+
+static GoldinAsyncRef GetAsync(void)
+{
+	GoldinAsyncRef tAsync;
+	
+	pthread_once(&sAsyncKeyOnce,CreateAsyncKey);
+	
+	tAsync=(GoldinAsyncRef) pthread_getspecific(sAsyncKey);
+	
+	if (tAsync==NULL)
+	{
+		/* If the ring can not be created, the items are split synchronously */
+		
+		tAsync=GoldinAsyncCreate(GOLDIN_ASYNC_QUEUE_DEPTH);
+		
+		if (tAsync!=NULL)
+			pthread_setspecific(sAsyncKey,tAsync);
+	}
+	
+	return tAsync;
+}
+
+static void SplitForksAsyncCompletion(const GoldinAsyncResult * inResult,void * inContext)
+{
+	SplitForksAsyncItem * tItem=(SplitForksAsyncItem *) inContext;
+	GoldinJobRef inJob=tItem->job;
+	Boolean tFailed=TRUE;
+	
+	switch(inResult->stage)
+	{
+		case kGoldinAsyncStageNone:
+			
+			tFailed=FALSE;
+			break;
+		
+		case kGoldinAsyncStageReadFork:
+			
+			if (inResult->error==EFBIG)
+				GoldinJobLogError(inJob,"AppleDouble file format does not support forks bigger than 2 GB\n");
+			else
+				GoldinJobLogError(inJob,"Unable to open fork\n");
+			
+			break;
+		
+		case kGoldinAsyncStageCreate:
+			
+			SplitForksLogCreateError(inJob,inResult->error,tItem->path);
+			
+			break;
+		
+		case kGoldinAsyncStageWrite:
+			
+			SplitForksLogWriteError(inJob,inResult->error,tItem->path);
+			
+			break;
+		
+		case kGoldinAsyncStageClose:
+			
+			/*GoldinJobLogError(inJob,"Permissions, owner and group could not be set for the AppleDouble file of %s\n",tItem->path); */
+			
+			break;
+		
+		case kGoldinAsyncStageStrip:
+			
+			GoldinJobLogError(inJob,"Resource Fork could not be stripped from %s\n",tItem->path);
+			
+			/* A COMPLETER */
+			
+			tFailed=FALSE;
+			break;
+	}
+	
+	if (tFailed==TRUE)
+	{
+		SplitForksFail(inJob);
+		
+		SplitForksNodeMarkIncomplete(tItem->node);
+		SplitForksNodeRelease(inJob,tItem->node);
+		
+		free(tItem);
+		
+		return;
+	}
+	
+	GoldinTraceEnd(kGoldinPhaseItem,tItem->startTime,(inResult->didSplit==TRUE) ? GOLDIN_APPLEDOUBLE_HEADER_SIZE+inResult->resourceForkSize : 0,strrchr(tItem->path,'/')+1);
+	
+	if (inResult->didSplit==TRUE)
+	{
+		SplitForksCountItem(inJob,kGoldinCounterSplitItems);
+		
+		if (tItem->appleDoubleExists==TRUE)
+			SplitForksCountItem(inJob,kGoldinCounterRewrittenItems);
+	}
+	
+	if (tItem->recordInJournal==TRUE)
+		SplitForksJournalRecord(inJob,kGoldinJournalFile,tItem->path);
+	
+	if (SplitForksClaimCheckpoint(inJob)==TRUE)
+		GoldinJobCheckpoint(inJob);
+	
+	SplitForksNodeRelease(inJob,tItem->node);
+	
+	free(tItem);
+}
+
+/* Same as SplitFileIfNeeded but the ._ file is written by the ring of the calling thread */
+
+static int SplitForksQueueItem(GoldinJobRef inJob,GoldinAsyncRef inAsync,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,SplitForksNode * inNode,Boolean inRecordInJournal)
+{
+	char tPOSIXPath[PATH_MAX*2+1];
+	Boolean tAppleDoubleExists=FALSE;
+	SplitForksAsyncItem * tItem;
+	uint64_t tStartTime;
+	int tError;
+	
+	if (inEntry->resourceForkSize==0 && GoldinFinderInfoNeedsSplit(inEntry->finderInfo)==0)
+		return 0;
+	
+	tStartTime=GoldinTraceBegin();
+	
+	if (inJob->incrementalMode==TRUE && SplitForksIsUpToDate(inJob,inDirectory,inEntry,(uint64_t) inEntry->resourceForkSize,&tAppleDoubleExists)==TRUE)
+	{
+		SplitForksCountItem(inJob,kGoldinCounterUpToDateItems);
+		
+		return 0;
+	}
+	
+	if (inJob->backend->copyPath(inDirectory,inEntry,tPOSIXPath,sizeof(tPOSIXPath))!=0)
+	{
+		GoldinJobLogError(inJob,"An error occurred when trying to get the absolute path of a file or directory\n");
+		
+		return -1;
+	}
+	
+	if (inJob->progressCallback!=NULL)
+	{
+		inJob->progressCallback(kGoldinProgressSplitting,tPOSIXPath,GOLDIN_APPLEDOUBLE_HEADER_SIZE+(uint64_t) inEntry->resourceForkSize,inJob->callbackContext);
+	}
+	
+	tItem=(SplitForksAsyncItem *) malloc(sizeof(SplitForksAsyncItem)+strlen(tPOSIXPath));
+	
+	if (tItem==NULL)
+	{
+		GoldinJobLogError(inJob,"Unable to create the AppleDouble file of %s\n",tPOSIXPath);
+		
+		return -1;
+	}
+	
+	tItem->job=inJob;
+	tItem->node=inNode;
+	tItem->appleDoubleExists=tAppleDoubleExists;
+	tItem->recordInJournal=inRecordInJournal;
+	tItem->startTime=tStartTime;
+	strcpy(tItem->path,tPOSIXPath);
+	
+	if (inNode!=NULL)
+		__sync_fetch_and_add(&inNode->pending,1);
+	
+	/* The whole chain is submitted at once */
+	
+	GoldinThrottleAcquire(inJob->fileThrottle,1);
+	GoldinThrottleAcquire(inJob->byteThrottle,GOLDIN_APPLEDOUBLE_HEADER_SIZE+(uint64_t) inEntry->resourceForkSize);
+	
+	tError=GoldinAsyncWriteAppleDouble(inAsync,tItem->path,inEntry,inJob->stripResourceForks,SplitForksAsyncCompletion,tItem);
+	
+	if (tError!=0)
+	{
+		if (tError==EFBIG)
+			GoldinJobLogError(inJob,"AppleDouble file format does not support forks bigger than 2 GB\n");
+		else
+			GoldinJobLogError(inJob,"Unable to create the AppleDouble file of %s (%s)\n",tPOSIXPath,strerror(tError));
+		
+		free(tItem);
+		
+		return -1;
+	}
+	
+	return 0;
+}
+
+/* inJournalPath is the path recorded once the item is split, NULL if it must not be recorded */
+
+static int SplitForksSplitItem(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,SplitForksNode * inNode,const char * inJournalPath)
+{
+	/* Every link has its own ._ file to verify */
+	
+	if ((inEntry->flags & kGoldinEntryIsHardLink)!=0 && (inEntry->flags & kGoldinEntryIsDirectory)==0 && inJob->verifyMode==FALSE)
+	{
+		/* The ._ file of the first link must be there before the other links can be linked to it */
+		
+		if (SplitForksSplitHardLink(inJob,inDirectory,inEntry)!=0)
+			return -1;
+	}
+	else
+	{
+		/* The engine needs the size of the resource fork before it submits the chain */
+		
+		if (inJob->asynchronousMode==TRUE && inEntry->resourceForkSize!=kGoldinUnknownSize)
+		{
+			GoldinAsyncRef tAsync=GetAsync();
+			
+			if (tAsync!=NULL)
+				return SplitForksQueueItem(inJob,tAsync,inDirectory,inEntry,inNode,(inJournalPath!=NULL));
+		}
+		
+		if (SplitFileIfNeeded(inJob,inDirectory,inEntry,NULL)!=0)
+			return -1;
+	}
+	
+	if (inJournalPath!=NULL)
+		SplitForksJournalRecord(inJob,kGoldinJournalFile,inJournalPath);
+	
+	if (SplitForksClaimCheckpoint(inJob)==TRUE)
+		GoldinJobCheckpoint(inJob);
+	
+	return 0;
+}
+
+/* The chains queued by the calling thread must be completed before its folder is released */
+
+static void SplitForksWaitForAsync(GoldinJobRef inJob)
+{
+	GoldinAsyncRef tAsync;
+	int tError;
+	
+	if (inJob->asynchronousMode==FALSE)
+		return;
+	
+	pthread_once(&sAsyncKeyOnce,CreateAsyncKey);
+	
+	tAsync=(GoldinAsyncRef) pthread_getspecific(sAsyncKey);
+	
+	tError=GoldinAsyncWaitUntilDone(tAsync);
+	
+	if (tError!=0)
+	{
+		GoldinJobLogError(inJob,"An error occurred while waiting for the asynchronous operations (%s)\n",strerror(tError));
+		
+		SplitForksFail(inJob);
+	}
+}
+
+#pragma mark -
+
+/* inDepth is the depth of the folder described by inEntry */
+
+static void SplitForksScheduleChildren(GoldinJobRef inJob,GoldinDirectoryRef inParentDirectory,const GoldinEntry * inEntry,SplitForksNode * inParentNode,unsigned long inDepth)
+{
+	GoldinDirectoryRef tDirectory;
+	SplitForksNode * tNode;
+	
+	if (SplitForksHasFailed(inJob)==TRUE)
+	{
+		SplitForksNodeMarkIncomplete(inParentNode);
+		
+		return;
+	}
+	
+	if (GoldinFilterCanDescend(inJob->filter,inDepth)==FALSE)
+	{
+		/* The folder is not even opened. Its contents have not been split so it must not be recorded in the journal */
+		
+		SplitForksCountItem(inJob,kGoldinCounterPrunedItems);
+		
+		SplitForksNodeMarkIncomplete(inParentNode);
+		
+		return;
+	}
+	
+	if (inJob->backend->copyDirectory(inParentDirectory,inEntry,&tDirectory)!=0)
+	{
+		char tPOSIXPath[PATH_MAX*2+1];
+		
+		if (inJob->backend->copyPath(inParentDirectory,inEntry,tPOSIXPath,sizeof(tPOSIXPath))!=0)
+			tPOSIXPath[0]='\0';
+		
+		GoldinJobLogError(inJob,"An error occurred while getting the File System Reference of %s\n",tPOSIXPath);
+		
+		SplitForksNodeMarkIncomplete(inParentNode);
+		
+		return;
+	}
+	
+	tNode=SplitForksNodeCreate(inJob,inParentNode,tDirectory);
+	
+	if (inJob->workQueue!=NULL)
+	{
+		/* The folder becomes a task another worker can steal */
+		
+		SplitForksTask * tTask=(SplitForksTask *) malloc(sizeof(SplitForksTask));
+		
+		if (tTask!=NULL)
+		{
+			tTask->job=inJob;
+			tTask->directory=tDirectory;
+			tTask->node=tNode;
+			tTask->depth=inDepth;
+			
+			if (GoldinWorkQueueAddTask(inJob->workQueue,tTask)==0)
+				return;
+			
+			free(tTask);
+		}
+		
+		/* Not enough memory to queue the folder, proceed with it right now */
+	}
+	
+	SplitForksProcessDirectory(inJob,tDirectory,tNode,inDepth);
+	
+	inJob->backend->releaseDirectory(tDirectory);
+	
+	SplitForksNodeRelease(inJob,tNode);
+}
+
+void SplitForksWorkFunction(GoldinWorkQueueRef inWorkQueue,void * inTask)
+{
+	SplitForksTask * tTask=(SplitForksTask *) inTask;
+	GoldinJobRef inJob=tTask->job;
+	
+	(void) inWorkQueue;
+	
+	SplitForksProcessDirectory(inJob,tTask->directory,tTask->node,tTask->depth);
+	
+	/* Otherwise the queue could be done while some ._ files are still being written */
+	
+	SplitForksWaitForAsync(inJob);
+	
+	inJob->backend->releaseDirectory(tTask->directory);
+	
+	SplitForksNodeRelease(inJob,tTask->node);
+	
+	free(tTask);
+}
+
+/* A verification or a cleanup looks for the orphaned ._ files among the names of all the items of the folder: they are
+   found in the listing made for the split, the folder is not read again */
+
+typedef struct _SplitForksVerifyName
+{
+	char * name;
+	Boolean needsAppleDouble;	/* FALSE if the item has no resource fork or FinderInfo, TRUE otherwise or when it is not ours to tell */
+	
+} SplitForksVerifyName;
+
+typedef struct _SplitForksFilterContext
+{
+	GoldinJobRef job;
+	GoldinDirectoryRef directory;
+	SplitForksNode * node;
+	
+	SplitForksVerifyName * names;	/* NULL unless verifying or removing the stale ._ files */
+	size_t nameCount;
+	size_t nameCapacity;
+	Boolean namesIncomplete;		/* Not enough memory to record them all */
+	
+} SplitForksFilterContext;
+
+static void SplitForksRecordName(SplitForksFilterContext * ioContext,const char * inName,Boolean inNeedsAppleDouble)
+{
+	if ((ioContext->job->verifyMode==FALSE && ioContext->job->pruneStale==FALSE) || ioContext->namesIncomplete==TRUE)
+		return;
+	
+	if (ioContext->nameCount==ioContext->nameCapacity)
+	{
+		size_t tCapacity=(ioContext->nameCapacity==0) ? 64 : ioContext->nameCapacity*2;
+		SplitForksVerifyName * tNames=(SplitForksVerifyName *) realloc(ioContext->names,tCapacity*sizeof(SplitForksVerifyName));
+		
+		if (tNames==NULL)
+		{
+			ioContext->namesIncomplete=TRUE;
+			
+			return;
+		}
+		
+		ioContext->names=tNames;
+		ioContext->nameCapacity=tCapacity;
+	}
+	
+	ioContext->names[ioContext->nameCount].name=strdup(inName);
+	
+	if (ioContext->names[ioContext->nameCount].name==NULL)
+	{
+		ioContext->namesIncomplete=TRUE;
+		
+		return;
+	}
+	
+	ioContext->names[ioContext->nameCount].needsAppleDouble=inNeedsAppleDouble;
+	ioContext->nameCount++;
+}
+
+static void SplitForksReleaseNames(SplitForksFilterContext * ioContext)
+{
+	size_t i;
+	
+	for(i=0;i<ioContext->nameCount;i++)
+		free(ioContext->names[i].name);
+	
+	free(ioContext->names);
+	
+	ioContext->names=NULL;
+	ioContext->nameCount=0;
+	ioContext->nameCapacity=0;
+}
+
+/* Only keep the items we will have to deal with */
+
+static Boolean SplitForksEntryFilter(const GoldinEntry * inEntry,void * inContext)
+{
+	SplitForksFilterContext * tContext=(SplitForksFilterContext *) inContext;
+	GoldinJobRef inJob=tContext->job;
+	Boolean tIsDirectory=((inEntry->flags & kGoldinEntryIsDirectory)!=0);
+	char tTemporaryPath[PATH_MAX*2+1];
+	Boolean tIsStale;
+	
+	/* A file a ._ file is being written to, or was when its run died */
+	
+	if (SplitForksIsTemporaryFile(inJob,tContext->directory,inEntry,tTemporaryPath,sizeof(tTemporaryPath),&tIsStale)==TRUE)
+	{
+		if (tIsStale==TRUE && inJob->pruneStale==TRUE)
+			SplitForksRemoveTemporary(inJob,tTemporaryPath);
+		
+		return FALSE;
+	}
+	
+	if ((inEntry->flags & kGoldinEntryIsUnreadable)!=0)
+	{
+		char tPOSIXPath[PATH_MAX*2+1];
+		
+		tPOSIXPath[0]='\0';
+		
+		GoldinJobLogError(inJob,"Unable to read the attributes of %s (%s)\n",SplitForksGetPath(inJob,tContext->directory,inEntry,tPOSIXPath),strerror(inEntry->error));
+		
+		/* Its ._ file is left alone and the journal must not record the folder as done */
+		
+		SplitForksRecordName(tContext,inEntry->name,TRUE);
+		
+		SplitForksNodeMarkIncomplete(tContext->node);
+		
+		return FALSE;
+	}
+	
+	/* Check this is not a Hard Link (the files are split once for all their links when the links are tracked) */
+	
+	if ((inEntry->flags & kGoldinEntryIsHardLink)!=0 && (inJob->hardLinkTable==NULL || tIsDirectory==TRUE))
+	{
+		SplitForksRecordName(tContext,inEntry->name,TRUE);
+		
+		return FALSE;
+	}
+	
+	if (tIsDirectory==FALSE && inEntry->resourceForkSize==0 && GoldinFinderInfoNeedsSplit(inEntry->finderInfo)==0)
+	{
+		SplitForksRecordName(tContext,inEntry->name,FALSE);
+		
+		return FALSE;
+	}
+	
+	SplitForksRecordName(tContext,inEntry->name,TRUE);
+	
+	/* Only the items we would have dealt with are matched against the patterns */
+	
+	if (GoldinFilterExcludes(inJob->filter,inEntry->name,tIsDirectory)==TRUE)
+	{
+		SplitForksCountItem(inJob,kGoldinCounterPrunedItems);
+		
+		/* The journal must not record the folder as done */
+		
+		SplitForksNodeMarkIncomplete(tContext->node);
+		
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+static int SplitForksCompareVerifyNames(const void * inName1,const void * inName2)
+{
+	return strcmp(((const SplitForksVerifyName *) inName1)->name,((const SplitForksVerifyName *) inName2)->name);
+}
+
+/* A ._ file is orphaned when there is no item with its name or when this item needs no ._ file: it is reported by a
+   verification, removed otherwise. The ._ files of the items that are listed (folders, forks of unknown size) are dealt
+   with with their item. The ._ files matching an exclude pattern are left alone */
+
+static void SplitForksFindOrphans(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,SplitForksFilterContext * inContext)
+{
+	char tPOSIXPath[PATH_MAX*2+1];
+	size_t tLength;
+	size_t i;
+	
+	if (inJob->backend->copyPath(inDirectory,NULL,tPOSIXPath,sizeof(tPOSIXPath))!=0)
+		return;
+	
+	if (inContext->namesIncomplete==TRUE)
+	{
+		GoldinJobLogError(inJob,"Unable to look for the orphaned AppleDouble files of %s (%s)\n",tPOSIXPath,strerror(ENOMEM));
+		
+		return;
+	}
+	
+	tLength=strlen(tPOSIXPath);
+	
+	if (tLength>0 && tPOSIXPath[tLength-1]=='/')
+		tPOSIXPath[tLength-1]='\0';
+	
+	qsort(inContext->names,inContext->nameCount,sizeof(SplitForksVerifyName),SplitForksCompareVerifyNames);
+	
+	for(i=0;i<inContext->nameCount;i++)
+	{
+		const char * tName=inContext->names[i].name;
+		char tAppleDoublePOSIXPath[PATH_MAX*2+1];
+		SplitForksVerifyName tKey;
+		SplitForksVerifyName * tItem;
+		int tCount;
+		
+		if (strncmp(tName,"._",2)!=0 || tName[2]=='\0' || GoldinFilterExcludes(inJob->filter,tName,FALSE)==TRUE)
+			continue;
+		
+		tKey.name=(char *) tName+2;
+		
+		tItem=(SplitForksVerifyName *) bsearch(&tKey,inContext->names,inContext->nameCount,sizeof(SplitForksVerifyName),SplitForksCompareVerifyNames);
+		
+		if (tItem!=NULL && tItem->needsAppleDouble==TRUE)
+			continue;
+		
+		tCount=snprintf(tAppleDoublePOSIXPath,sizeof(tAppleDoublePOSIXPath),"%s/%s",tPOSIXPath,tName);
+		
+		if (tCount<0 || (size_t) tCount>=sizeof(tAppleDoublePOSIXPath))
+			continue;
+		
+		if (inJob->verifyMode==FALSE)
+		{
+			SplitForksRemoveStale(inJob,tAppleDoublePOSIXPath);
+		}
+		else if (SplitForksIsAppleDoubleFile(tAppleDoublePOSIXPath,NULL)==TRUE)
+		{
+			SplitForksCountItem(inJob,kGoldinCounterOrphanedItems);
+			
+			GoldinJobLogError(inJob,"Orphaned AppleDouble file: %s (%s)\n",tAppleDoublePOSIXPath,(tItem==NULL) ? "no item" : "no resource fork or FinderInfo");
+		}
+	}
+}
+
+typedef struct _SplitForksSortKey
+{
+	uint64_t group;				/* Disk order: 0 if the position on the disk is known, 1 otherwise */
+	uint64_t value;
+	size_t index;
+	
+} SplitForksSortKey;
+
+static int SplitForksCompareSortKeys(const void * inKey1,const void * inKey2)
+{
+	const SplitForksSortKey * tKey1=(const SplitForksSortKey *) inKey1;
+	const SplitForksSortKey * tKey2=(const SplitForksSortKey *) inKey2;
+	
+	if (tKey1->group!=tKey2->group)
+		return (tKey1->group<tKey2->group) ? -1 : 1;
+	
+	if (tKey1->value!=tKey2->value)
+		return (tKey1->value<tKey2->value) ? -1 : 1;
+	
+	return (tKey1->index<tKey2->index) ? -1 : (tKey1->index>tKey2->index);
+}
+
+/* The items are left in the order of the listing if there is not enough memory */
+
+static void SplitForksSortEntries(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,GoldinEntryList * ioList)
+{
+	SplitForksSortKey * tKeys;
+	GoldinEntry * tEntries;
+	Boolean tDiskOffsetUnsupported=FALSE;
+	uint64_t tStartTime;
+	size_t i;
+	
+	if (inJob->entryOrder==kGoldinOrderListing || ioList->count<2)
+		return;
+	
+	tStartTime=GoldinTraceBegin();
+	
+	tKeys=(SplitForksSortKey *) malloc(ioList->count*sizeof(SplitForksSortKey));
+	tEntries=(GoldinEntry *) malloc(ioList->count*sizeof(GoldinEntry));
+	
+	if (tKeys==NULL || tEntries==NULL)
+	{
+		free(tKeys);
+		free(tEntries);
+		
+		return;
+	}
+	
+	for(i=0;i<ioList->count;i++)
+	{
+		GoldinEntry * tEntry=&ioList->entries[i];
+		
+		tKeys[i].group=0;
+		tKeys[i].value=tEntry->fileID;
+		tKeys[i].index=i;
+		
+		if (inJob->entryOrder==kGoldinOrderDisk)
+		{
+			uint64_t tOffset;
+			int tError=ENOTSUP;
+			
+			/* The folders are only opened once their turn comes */
+			
+			if (tDiskOffsetUnsupported==FALSE && (tEntry->flags & kGoldinEntryIsDirectory)==0)
+				tError=inJob->backend->getDiskOffset(inDirectory,tEntry,&tOffset);
+			
+			if (tError==0)
+			{
+				tKeys[i].value=tOffset;
+			}
+			else
+			{
+				/* The volume can not tell, no need to ask again for the other items of the folder */
+				
+				if (tError==ENOTSUP)
+					tDiskOffsetUnsupported=TRUE;
+				
+				tKeys[i].group=1;
+			}
+		}
+	}
+	
+	qsort(tKeys,ioList->count,sizeof(SplitForksSortKey),SplitForksCompareSortKeys);
+	
+	for(i=0;i<ioList->count;i++)
+		tEntries[i]=ioList->entries[tKeys[i].index];
+	
+	free(ioList->entries);
+	
+	ioList->entries=tEntries;
+	ioList->capacity=ioList->count;
+	
+	free(tKeys);
+	
+	GoldinTraceEnd(kGoldinPhaseSortFolder,tStartTime,0,NULL);
+}
+
+static void SplitForksProcessDirectory(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,SplitForksNode * inNode,unsigned long inDepth)
+{
+	SplitForksFilterContext tContext;
+	GoldinEntryList tList;
+	uint64_t tStartTime;
+	int tError;
+	size_t i;
+	
+	GoldinCounterIncrement(kGoldinCounterDirectories);
+	
+	/* 1. Take a snapshot of the contents of the folder */
+	
+	/* The ._ files we create while splitting are not part of the snapshot so we do not need to restart the iteration after every split */
+	
+	tStartTime=GoldinTraceBegin();
+	
+	memset(&tContext,0,sizeof(tContext));
+	
+	tContext.job=inJob;
+	tContext.directory=inDirectory;
+	tContext.node=inNode;
+	
+	tError=inJob->backend->copyEntries(inDirectory,SplitForksEntryFilter,&tContext,&tList);
+	
+	GoldinTraceEnd(kGoldinPhaseListFolder,tStartTime,0,NULL);
+	
+	if (tError!=0)
+	{
+		/* A COMPLETER */
+		
+		SplitForksReleaseNames(&tContext);
+		
+		SplitForksNodeMarkIncomplete(inNode);
+		
+		return;
+	}
+	
+	if (inJob->verifyMode==TRUE || inJob->pruneStale==TRUE)
+	{
+		SplitForksFindOrphans(inJob,inDirectory,&tContext);
+		
+		SplitForksReleaseNames(&tContext);
+	}
+	
+	/* 2. Put them in inode or disk order if asked to */
+	
+	SplitForksSortEntries(inJob,inDirectory,&tList);
+	
+	/* 3. Split the items that need it and proceed with the folders */
+	
+	for(i=0;i<tList.count;i++)
+	{
+		GoldinEntry * tEntry=&tList.entries[i];
+		Boolean tIsDirectory=((tEntry->flags & kGoldinEntryIsDirectory)!=0);
+		char tPOSIXPath[PATH_MAX*2+1];
+		
+		if (SplitForksHasFailed(inJob)==TRUE)
+		{
+			SplitForksNodeMarkIncomplete(inNode);
+			
+			break;
+		}
+		
+		if (inJob->journal!=NULL)
+		{
+			if (inJob->backend->copyPath(inDirectory,tEntry,tPOSIXPath,sizeof(tPOSIXPath))!=0)
+			{
+				SplitForksNodeMarkIncomplete(inNode);
+				
+				continue;
+			}
+			
+			/* Skip what a previous run has already done (a folder with all its contents) */
+			
+			if (GoldinJournalContains(inJob->journal,(tIsDirectory==TRUE) ? kGoldinJournalDirectory : kGoldinJournalFile,tPOSIXPath)==TRUE)
+			{
+				SplitForksCountItem(inJob,kGoldinCounterJournaledItems);
+				
+				continue;
+			}
+		}
+		
+		if (SplitForksSplitItem(inJob,inDirectory,tEntry,inNode,(inJob->journal!=NULL && tIsDirectory==FALSE) ? tPOSIXPath : NULL)!=0)
+		{
+			SplitForksFail(inJob);
+			
+			SplitForksNodeMarkIncomplete(inNode);
+			
+			break;
+		}
+		
+		if (tIsDirectory==TRUE)
+		{
+			/* We need to proceed with the contents of the folder */
+			
+			SplitForksScheduleChildren(inJob,inDirectory,tEntry,inNode,inDepth+1);
+		}
+	}
+	
+	GoldinEntryListRelease(&tList);
+}
+
+int SplitForks(GoldinJobRef inJob,const char * inPath,unsigned long inDepth,Boolean inContents)
+{
+	GoldinDirectoryRef tParentDirectory;
+	GoldinEntry tEntry;
+	int tStatus=0;
+	
+	/* We need to split forks of the first level (and it allows us to check whether it's a folder or not) */
+	
+	if (inJob->backend->copyRoot(inPath,&tParentDirectory,&tEntry)!=0)
+	{
+		GoldinJobLogError(inJob,"An error occurred while getting Catalog Information for the File\n");
+		
+		return -1;
+	}
+	
+	/* Check this is not a Hard Link */
+	
+	if ((tEntry.flags & kGoldinEntryIsHardLink)==0 || (inJob->hardLinkTable!=NULL && (tEntry.flags & kGoldinEntryIsDirectory)==0))
+	{
+		Boolean tIsDirectory=((tEntry.flags & kGoldinEntryIsDirectory)!=0);
+		
+		if (inJob->journal!=NULL && GoldinJournalContains(inJob->journal,(tIsDirectory==TRUE) ? kGoldinJournalDirectory : kGoldinJournalFile,inPath)==TRUE)
+		{
+			/* Everything has already been done */
+			
+			SplitForksCountItem(inJob,kGoldinCounterJournaledItems);
+		}
+		else
+		{
+			if (SplitForksSplitItem(inJob,tParentDirectory,&tEntry,NULL,(inJob->journal!=NULL && tIsDirectory==FALSE) ? inPath : NULL)!=0)
+			{
+				SplitForksFail(inJob);
+				
+				tStatus=-1;
+			}
+			else if (tIsDirectory==TRUE && inContents==TRUE)
+			{
+				/* It's a folder */
+				
+				/* We need to proceed with the contents of the folder */
+				
+				SplitForksScheduleChildren(inJob,tParentDirectory,&tEntry,NULL,inDepth);
+			}
+		}
+	}
+	
+	SplitForksWaitForAsync(inJob);
+	
+	free((char *) tEntry.name);
+	
+	inJob->backend->releaseDirectory(tParentDirectory);
+	
+	return tStatus;
+}
+
+#pragma mark -
+
+/* The first link of a file is archived with its data and its ._ file, the other links (and their ._ files) are tar
+   hard links to them. The paths are those of the archive of one top item, and only the links on its volume are looked for */
+
+typedef struct _ArchiveForksLinks
+{
+	GoldinHardLinkTableRef table;		/* NULL if the links are archived as separate files */
+	dev_t device;
+	
+} ArchiveForksLinks;
+
+static int ArchiveForksProcessDirectory(GoldinJobRef inJob,GoldinArchiveRef inArchive,ArchiveForksLinks * ioLinks,GoldinDirectoryRef inDirectory,const char * inArchivePath,unsigned long inDepth);
+
+static void ArchiveForksLogError(GoldinJobRef inJob,int inError)
+{
+	GoldinJobLogError(inJob,"An error occurred while writing the archive (%s)\n",strerror(inError));
+}
+
+/* ._name in the same folder as the item (a folder path ends with a /) */
+
+static void ArchiveForksGetAppleDoublePath(const char * inArchivePath,const char * inName,Boolean inIsDirectory,char * outPath,size_t inSize)
+{
+	size_t tLength=strlen(inArchivePath)-strlen(inName)-((inIsDirectory==TRUE) ? 1 : 0);
+	
+	snprintf(outPath,inSize,"%.*s._%s",(int) tLength,inArchivePath,inName);
+}
+
+/* The ._ file is synthesized in the archive: the header and the resource fork are written from memory.
+   With inFirstLinkPath, it is a hard link to the ._ file of the first link of the file instead */
+
+static int ArchiveForksAddAppleDouble(GoldinJobRef inJob,GoldinArchiveRef inArchive,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,const char * inArchivePath,const struct stat * inStat,const char * inFirstLinkPath)
+{
+	char tArchivePath[PATH_MAX*2+1];
+	char tLinkTarget[PATH_MAX*2+1];
+	UInt8 tHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE];
+	GoldinArchiveItem tItem;
+	GoldinForkRef tFork=NULL;
+	uint64_t tResourceForkSize=0;
+	int tError;
+	
+	/* 1. Check for the presence of a resource fork */
+	
+	if (inEntry->resourceForkSize!=0)
+	{
+		tError=inJob->backend->openResourceFork(inDirectory,inEntry,&tFork,&tResourceForkSize);
+		
+		GoldinCounterIncrement(kGoldinCounterForkOpens);
+		
+		switch(tError)
+		{
+			case 0:
+				break;
+			
+			case ENOENT:
+				/* No resource Fork */
+				
+				tFork=NULL;
+				tResourceForkSize=0;
+				break;
+			
+			case EFBIG:
+				
+				GoldinJobLogError(inJob,"AppleDouble file format does not support forks bigger than 2 GB\n");
+				
+				return -1;
+			
+			default:
+				
+				GoldinJobLogError(inJob,"Unable to open fork\n");
+				
+				return -1;
+		}
+	}
+	
+	/* 2. Check for the presence of FinderInfo or ExtFinderInfo */
+	
+	if (tFork==NULL && GoldinFinderInfoNeedsSplit(inEntry->finderInfo)==0)
+		return 0;
+	
+	/* 3. ._name in the same folder */
+	
+	ArchiveForksGetAppleDoublePath(inArchivePath,inEntry->name,S_ISDIR(inStat->st_mode),tArchivePath,sizeof(tArchivePath));
+	
+	memset(&tItem,0,sizeof(tItem));
+	
+	tItem.path=tArchivePath;
+	tItem.mode=S_IFREG | (inEntry->mode & 07777);
+	tItem.ownerID=inEntry->ownerID;
+	tItem.groupID=inEntry->groupID;
+	tItem.modificationTime=inStat->st_mtime;
+	
+	if (inFirstLinkPath!=NULL)
+	{
+		const char * tName=strrchr(inFirstLinkPath,'/');
+		
+		ArchiveForksGetAppleDoublePath(inFirstLinkPath,(tName!=NULL) ? tName+1 : inFirstLinkPath,FALSE,tLinkTarget,sizeof(tLinkTarget));
+		
+		tItem.linkTarget=tLinkTarget;
+	}
+	else
+	{
+		tItem.size=GOLDIN_APPLEDOUBLE_HEADER_SIZE+tResourceForkSize;
+	}
+	
+	GoldinAppleDoubleEncodeHeader(tHeader,inEntry->finderInfo,(uint32_t) tResourceForkSize);
+	
+	tError=GoldinArchiveBeginItem(inArchive,&tItem);
+	
+	if (tError==0 && inFirstLinkPath==NULL)
+		tError=GoldinArchiveWriteData(inArchive,tHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE);
+	
+	if (tError!=0)
+	{
+		ArchiveForksLogError(inJob,tError);
+		
+		goto bail;
+	}
+	
+	if (tFork!=NULL && inFirstLinkPath==NULL)
+	{
+		off_t tForkOffset;
+		int tForkDescriptor=inJob->backend->getResourceForkDescriptor(tFork,&tForkOffset);
+		
+		if (tForkDescriptor!=-1)
+		{
+			tError=GoldinArchiveCopyData(inArchive,tForkDescriptor,tForkOffset,tResourceForkSize);
+		}
+		else
+		{
+			uint64_t tOffset=0;
+			
+			/* The fork is read right into the buffer of the archive */
+			
+			while (tError==0 && tOffset<tResourceForkSize)
+			{
+				void * tBuffer;
+				size_t tSize;
+				size_t tReadCount;
+				
+				tError=GoldinArchiveGetBuffer(inArchive,&tBuffer,&tSize);
+				
+				if (tError!=0)
+					break;
+				
+				tError=inJob->backend->readResourceFork(tFork,tOffset,tBuffer,tSize,&tReadCount);
+				
+				if (tError==0 && tReadCount==0)
+					tError=EIO;
+				
+				if (tError==0)
+					tError=GoldinArchiveCommitData(inArchive,tReadCount);
+				
+				tOffset+=tReadCount;
+			}
+		}
+		
+		if (tError!=0)
+		{
+			GoldinJobLogError(inJob,"An error occurred while reading the resource fork of %s (%s)\n",inArchivePath,strerror(tError));
+			
+			goto bail;
+		}
+	}
+	
+	tError=GoldinArchiveEndItem(inArchive);
+	
+	if (tError!=0)
+	{
+		ArchiveForksLogError(inJob,tError);
+		
+		goto bail;
+	}
+	
+	SplitForksCountItem(inJob,kGoldinCounterSplitItems);
+	
+	if (tFork!=NULL)
+		inJob->backend->closeResourceFork(tFork);
+	
+	return 0;
+	
+bail:
+	
+	if (tFork!=NULL)
+		inJob->backend->closeResourceFork(tFork);
+	
+	return -1;
+}
+
+/* inArchivePath is the path of the folder of the item in the archive, empty for the top item (at depth 0) */
+
+static int ArchiveForksAddItem(GoldinJobRef inJob,GoldinArchiveRef inArchive,ArchiveForksLinks * ioLinks,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,const char * inArchivePath,unsigned long inDepth)
+{
+	char tPOSIXPath[PATH_MAX*2+1];
+	char tArchivePath[PATH_MAX*2+1];
+	char tLinkTarget[PATH_MAX+1];
+	GoldinArchiveItem tItem;
+	struct stat tStat;
+	int tDescriptor=-1;
+	Boolean tIsFirstLink=FALSE;
+	char * tFirstLinkPath=NULL;
+	int tError;
+	
+	if (inJob->backend->copyPath(inDirectory,inEntry,tPOSIXPath,sizeof(tPOSIXPath))!=0)
+	{
+		GoldinJobLogError(inJob,"An error occurred when trying to get the absolute path of a file or directory\n");
+		
+		return -1;
+	}
+	
+	if (lstat(tPOSIXPath,&tStat)!=0)
+	{
+		GoldinJobLogError(inJob,"Unable to get the information of %s (%s)\n",tPOSIXPath,strerror(errno));
+		
+		return -1;
+	}
+	
+	/* Sockets can not be archived, and the archive must not archive itself */
+	
+	if (S_ISSOCK(tStat.st_mode) || GoldinArchiveIsOutput(inArchive,&tStat)==TRUE)
+		return 0;
+	
+	snprintf(tArchivePath,sizeof(tArchivePath),"%s%s%s%s",inArchivePath,(inArchivePath[0]!='\0') ? "/" : "",inEntry->name,S_ISDIR(tStat.st_mode) ? "/" : "");
+	
+	if (inJob->progressCallback!=NULL)
+		inJob->progressCallback(kGoldinProgressArchiving,tPOSIXPath,0,inJob->callbackContext);
+	
+	memset(&tItem,0,sizeof(tItem));
+	
+	tItem.path=tArchivePath;
+	tItem.mode=tStat.st_mode;
+	tItem.ownerID=tStat.st_uid;
+	tItem.groupID=tStat.st_gid;
+	tItem.modificationTime=tStat.st_mtime;
+	tItem.device=tStat.st_rdev;
+	
+	if (S_ISREG(tStat.st_mode) && tStat.st_nlink>1 && ioLinks->table!=NULL && tStat.st_dev==ioLinks->device)
+	{
+		tIsFirstLink=GoldinHardLinkTableClaim(ioLinks->table,(uint64_t) tStat.st_dev,(uint64_t) tStat.st_ino,&tFirstLinkPath);
+		
+		/* If the first link could not be archived, this one is archived as a separate file */
+		
+		if (tFirstLinkPath!=NULL)
+			tItem.linkTarget=tFirstLinkPath;
+	}
+	
+	if (S_ISREG(tStat.st_mode) && tFirstLinkPath==NULL)
+	{
+		tDescriptor=open(tPOSIXPath,O_RDONLY|O_NOFOLLOW);
+		
+		if (tDescriptor==-1)
+		{
+			GoldinJobLogError(inJob,"Unable to open %s (%s)\n",tPOSIXPath,strerror(errno));
+			
+			goto bail;
+		}
+		
+		tItem.size=(uint64_t) tStat.st_size;
+	}
+	else if (S_ISLNK(tStat.st_mode))
+	{
+		ssize_t tLength=readlink(tPOSIXPath,tLinkTarget,sizeof(tLinkTarget)-1);
+		
+		if (tLength<0)
+		{
+			GoldinJobLogError(inJob,"Unable to read the symbolic link %s (%s)\n",tPOSIXPath,strerror(errno));
+			
+			return -1;
+		}
+		
+		tLinkTarget[tLength]='\0';
+		
+		tItem.linkTarget=tLinkTarget;
+	}
+	
+	/* The ._ file comes first, as with the tar of Mac OS X (the hard links of folders are not split) */
+	
+	if (((inEntry->flags & kGoldinEntryIsHardLink)==0 || S_ISDIR(tStat.st_mode)==0) && ArchiveForksAddAppleDouble(inJob,inArchive,inDirectory,inEntry,tArchivePath,&tStat,tFirstLinkPath)!=0)
+		goto bail;
+	
+	tError=GoldinArchiveBeginItem(inArchive,&tItem);
+	
+	if (tError!=0)
+	{
+		ArchiveForksLogError(inJob,tError);
+		
+		goto bail;
+	}
+	
+	if (tDescriptor!=-1)
+	{
+		tError=GoldinArchiveCopyData(inArchive,tDescriptor,0,tItem.size);
+		
+		if (tError!=0)
+		{
+			GoldinJobLogError(inJob,"An error occurred while archiving %s (%s)\n",tPOSIXPath,strerror(tError));
+			
+			goto bail;
+		}
+		
+		close(tDescriptor);
+		tDescriptor=-1;
+	}
+	
+	tError=GoldinArchiveEndItem(inArchive);
+	
+	if (tError!=0)
+	{
+		ArchiveForksLogError(inJob,tError);
+		
+		goto bail;
+	}
+	
+	if (tIsFirstLink==TRUE)
+		GoldinHardLinkTableResolve(ioLinks->table,(uint64_t) tStat.st_dev,(uint64_t) tStat.st_ino,tArchivePath);
+	
+	free(tFirstLinkPath);
+	
+	if (S_ISDIR(tStat.st_mode))
+	{
+		GoldinDirectoryRef tDirectory;
+		
+		if (GoldinFilterCanDescend(inJob->filter,inDepth)==FALSE)
+		{
+			SplitForksCountItem(inJob,kGoldinCounterPrunedItems);
+			
+			return 0;
+		}
+		
+		if (inJob->backend->copyDirectory(inDirectory,inEntry,&tDirectory)!=0)
+		{
+			GoldinJobLogError(inJob,"An error occurred while getting the File System Reference of %s\n",tPOSIXPath);
+			
+			return -1;
+		}
+		
+		/* Without the trailing / */
+		
+		tArchivePath[strlen(tArchivePath)-1]='\0';
+		
+		tError=ArchiveForksProcessDirectory(inJob,inArchive,ioLinks,tDirectory,tArchivePath,inDepth);
+		
+		inJob->backend->releaseDirectory(tDirectory);
+		
+		return tError;
+	}
+	
+	return 0;
+	
+bail:
+	
+	if (tIsFirstLink==TRUE)
+		GoldinHardLinkTableResolve(ioLinks->table,(uint64_t) tStat.st_dev,(uint64_t) tStat.st_ino,NULL);
+	
+	free(tFirstLinkPath);
+	
+	if (tDescriptor!=-1)
+		close(tDescriptor);
+	
+	return -1;
+}
+
+static int ArchiveForksCompareEntries(const void * inEntry1,const void * inEntry2)
+{
+	return strcmp(((const GoldinEntry *) inEntry1)->name,((const GoldinEntry *) inEntry2)->name);
+}
+
+typedef struct _ArchiveForksFilterContext
+{
+	GoldinJobRef job;
+	GoldinDirectoryRef directory;
+	
+} ArchiveForksFilterContext;
+
+/* Every item goes to the archive unless it is excluded, can not be read or is one of our temporary files */
+
+static Boolean ArchiveForksEntryFilter(const GoldinEntry * inEntry,void * inContext)
+{
+	ArchiveForksFilterContext * tContext=(ArchiveForksFilterContext *) inContext;
+	GoldinJobRef inJob=tContext->job;
+	char tTemporaryPath[PATH_MAX*2+1];
+	Boolean tIsStale;
+	
+	/* The files ._ files are written to are not part of the tree */
+	
+	if (SplitForksIsTemporaryFile(inJob,tContext->directory,inEntry,tTemporaryPath,sizeof(tTemporaryPath),&tIsStale)==TRUE)
+		return FALSE;
+	
+	if ((inEntry->flags & kGoldinEntryIsUnreadable)!=0)
+	{
+		char tPOSIXPath[PATH_MAX*2+1];
+		
+		tPOSIXPath[0]='\0';
+		
+		GoldinJobLogError(inJob,"Unable to read the attributes of %s (%s)\n",SplitForksGetPath(inJob,tContext->directory,inEntry,tPOSIXPath),strerror(inEntry->error));
+		
+		return FALSE;
+	}
+	
+	if (GoldinFilterExcludes(inJob->filter,inEntry->name,((inEntry->flags & kGoldinEntryIsDirectory)!=0))==TRUE)
+	{
+		SplitForksCountItem(inJob,kGoldinCounterPrunedItems);
+		
+		return FALSE;
+	}
+	
+	return TRUE;
+}
+
+static int ArchiveForksProcessDirectory(GoldinJobRef inJob,GoldinArchiveRef inArchive,ArchiveForksLinks * ioLinks,GoldinDirectoryRef inDirectory,const char * inArchivePath,unsigned long inDepth)
+{
+	ArchiveForksFilterContext tContext;
+	GoldinEntryList tList;
+	uint64_t tStartTime;
+	int tError;
+	size_t i;
+	
+	GoldinCounterIncrement(kGoldinCounterDirectories);
+	
+	tStartTime=GoldinTraceBegin();
+	
+	tContext.job=inJob;
+	tContext.directory=inDirectory;
+	
+	tError=inJob->backend->copyEntries(inDirectory,ArchiveForksEntryFilter,&tContext,&tList);
+	
+	GoldinTraceEnd(kGoldinPhaseListFolder,tStartTime,0,NULL);
+	
+	if (tError!=0)
+	{
+		GoldinJobLogError(inJob,"Unable to list the contents of %s\n",inArchivePath);
+		
+		return -1;
+	}
+	
+	/* The same tree always gives the same archive */
+	
+	qsort(tList.entries,tList.count,sizeof(GoldinEntry),ArchiveForksCompareEntries);
+	
+	for(i=0;i<tList.count;i++)
+	{
+		if (ArchiveForksAddItem(inJob,inArchive,ioLinks,inDirectory,&tList.entries[i],inArchivePath,inDepth+1)!=0)
+		{
+			GoldinEntryListRelease(&tList);
+			
+			return -1;
+		}
+	}
+	
+	GoldinEntryListRelease(&tList);
+	
+	return 0;
+}
+
+int ArchiveForks(GoldinJobRef inJob,const char * inPath,GoldinArchiveRef inArchive)
+{
+	GoldinDirectoryRef tParentDirectory;
+	GoldinEntry tEntry;
+	ArchiveForksLinks tLinks;
+	struct stat tStat;
+	int tError;
+	
+	if (inJob->backend->copyRoot(inPath,&tParentDirectory,&tEntry)!=0)
+	{
+		GoldinJobLogError(inJob,"An error occurred while getting Catalog Information for the File\n");
+		
+		return -1;
+	}
+	
+	/* Without memory for the table, the links are archived as separate files */
+	
+	tLinks.table=NULL;
+	tLinks.device=0;
+	
+	if (lstat(inPath,&tStat)==0)
+	{
+		tLinks.table=GoldinHardLinkTableCreate();
+		tLinks.device=tStat.st_dev;
+	}
+	
+	/* The paths in the archive are relative to the folder of the item */
+	
+	tError=ArchiveForksAddItem(inJob,inArchive,&tLinks,tParentDirectory,&tEntry,"",0);
+	
+	GoldinHardLinkTableRelease(tLinks.table);
+	
+	free((char *) tEntry.name);
+	
+	inJob->backend->releaseDirectory(tParentDirectory);
+	
+	return tError;
+}
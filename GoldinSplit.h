@@ -0,0 +1,149 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinSplit.h
+              Project: goldin
+
+    Notes:
+
+    o The split engine: walks a tree and creates the ._ file of every item with a resource fork or some FinderInfo.
+      The volume is only accessed through the backend of the job.
+    
+    o The state of a job is only shared by its workers: the engine has no global state (Goldin.h).
+*/
+
+#ifndef __GOLDIN_SPLIT_H__
+#define __GOLDIN_SPLIT_H__
+
+#include "Goldin.h"
+
+#include "GoldinArchive.h"
+#include "GoldinBackend.h"
+#include "GoldinDedup.h"
+#include "GoldinDiskOrder.h"
+#include "GoldinEstimate.h"
+#include "GoldinFilter.h"
+#include "GoldinHardLinks.h"
+#include "GoldinJournal.h"
+#include "GoldinThrottle.h"
+#include "GoldinWorkQueue.h"
+
+#include <sys/types.h>
+
+/* The setup of a volume (statfs, pathconf...) is done once for all the roots it contains, and only done again when the
+   roots go back and forth between volumes */
+
+typedef struct _GoldinJobVolume
+{
+	dev_t device;
+	int error;
+	
+	Boolean written;			/* Some roots have been split on the volume, it must be flushed when asked to */
+	
+	volatile int cloneUnsupported;	/* Once a clone has failed because the volume can not do it, only hard links are tried (hint) */
+	
+	char * path;				/* The first root found on the volume */
+	
+} GoldinJobVolume;
+
+struct _GoldinJob
+{
+	const GoldinBackend * backend;
+	
+	long maxFileNameLength;				/* Of the current volume */
+	Boolean stripResourceForks;
+	Boolean incrementalMode;			/* Do not rewrite the ._ files that are up to date */
+	Boolean asynchronousMode;			/* Write the ._ files with io_uring (GoldinAsync.h), xattr backend only */
+	Boolean dryRunMode;					/* Only count the ._ files that would be written (GoldinEstimate.h) */
+	Boolean verifyMode;					/* Only compare the existing ._ files with their items */
+	Boolean pruneStale;					/* Remove the ._ files whose item is gone or does not need one anymore */
+	Boolean archiveMode;				/* Only GoldinJobArchive can be used */
+	Boolean syncWhenDone;
+	Boolean finished;
+	
+	GoldinWorkQueueRef workQueue;		/* NULL when the tree is split on the calling thread */
+	
+	GoldinJournalRef journal;			/* NULL when the progress is not recorded */
+	
+	GoldinHardLinkTableRef hardLinkTable;	/* NULL when the hard links are skipped */
+	
+	GoldinDedupIndexRef dedupIndex;		/* NULL when the identical ._ files do not share their blocks */
+	
+	GoldinFilterRef filter;				/* NULL when no item is pruned. Belongs to the client */
+	
+	GoldinOrder entryOrder;				/* Order in which the items of a folder are split (GoldinDiskOrder.h) */
+	
+	unsigned long checkpointInterval;	/* Number of ._ files written between two flushes of the volume (GoldinSync.h), 0 for none */
+	
+	GoldinThrottleRef byteThrottle;		/* NULL when the bytes copied are not limited */
+	GoldinThrottleRef fileThrottle;		/* NULL when the ._ files created are not limited */
+	
+	GoldinEstimateRef estimate;
+	
+	GoldinProgressCallback progressCallback;
+	GoldinErrorCallback errorCallback;
+	void * callbackContext;
+	
+	GoldinJobVolume * volumes;
+	size_t volumeCount;
+	GoldinJobVolume * currentVolume;
+	
+	/* Updated by the workers with atomic operations */
+	
+	GoldinJobStatistics statistics;
+	
+	volatile uint64_t writtenCount;		/* ._ files written or linked */
+	volatile uint64_t nextCheckpoint;
+	
+	volatile int failed;				/* An item could not be split: no more work is scheduled */
+};
+
+/* Sends the message to the error callback of the job (Goldin.c), the final newline is removed */
+
+void GoldinJobLogError(GoldinJobRef inJob,const char * inFormat,...);
+
+/* Flushes the volumes the job has written to. Returns EIO if one of them could not be flushed (the error has been reported) */
+
+int GoldinJobSyncVolumes(GoldinJobRef inJob);
+
+/* Flushes the volumes, then writes the records of the journal covering the ._ files written so far (GoldinJournal.h).
+   Returns EIO on failure (the error has been reported) */
+
+int GoldinJobCheckpoint(GoldinJobRef inJob);
+
+/* Returns 0 on success, -1 if the ._ file could not be created (the error has been reported) */
+
+int SplitFileIfNeeded(GoldinJobRef inJob,GoldinDirectoryRef inDirectory,GoldinEntry * inEntry,Boolean * outDidSplit);
+
+/* inPath must be an absolute path without symbolic links on the volume prepared for the job. inDepth is the depth of
+   the item below the root it was found in (0 for a root), the contents of a folder are only split if inContents is TRUE.
+   Returns -1 if the item could not be found or split */
+
+int SplitForks(GoldinJobRef inJob,const char * inPath,unsigned long inDepth,Boolean inContents);
+
+/* Writes the item and its contents to the archive, each ._ file right before its item: nothing is written on the volume.
+   inPath must be an absolute path without symbolic links. Returns -1 on failure (the error has been reported).
+   The archive is not finished: many items can be written to it */
+
+int ArchiveForks(GoldinJobRef inJob,const char * inPath,GoldinArchiveRef inArchive);
+
+/* The function of the work queue of a job */
+
+void SplitForksWorkFunction(GoldinWorkQueueRef inWorkQueue,void * inTask);
+
+#endif
@@ -0,0 +1,76 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinSync.c
+              Project: goldin
+*/
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "GoldinSync.h"
+
+#include "GoldinCounters.h"
+#include "GoldinTrace.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+int GoldinSyncVolume(const char * inPath)
+{
+	uint64_t tStartTime=GoldinTraceBegin();
+	int tDescriptor;
+	int tError=0;
+	
+	tDescriptor=open(inPath,O_RDONLY|O_NONBLOCK|O_CLOEXEC);
+	
+#ifdef __linux__
+	
+	/* Without a descriptor, all the volumes are flushed */
+	
+	if (tDescriptor==-1)
+		sync();
+	else if (syncfs(tDescriptor)!=0)
+		tError=errno;
+	
+#else
+	
+	sync();
+	
+#ifdef F_FULLFSYNC
+	
+	/* Not all the volumes support it: the data is at least in the cache of the drive */
+	
+	if (tDescriptor!=-1)
+		(void) fcntl(tDescriptor,F_FULLFSYNC);
+	
+#endif
+
+#endif
+	
+	if (tDescriptor!=-1)
+		close(tDescriptor);
+	
+	GoldinCounterIncrement(kGoldinCounterVolumeSyncs);
+	
+	GoldinTraceEnd(kGoldinPhaseSyncVolume,tStartTime,0,NULL);
+	
+	return tError;
+}
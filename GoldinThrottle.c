@@ -0,0 +1,214 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinThrottle.c
+              Project: goldin
+*/
+
+#ifdef __linux__
+#define _GNU_SOURCE
+#endif
+
+#include "GoldinThrottle.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
+#ifdef __APPLE__
+#include <sys/resource.h>
+#endif
+
+struct _GoldinThrottle
+{
+	pthread_mutex_t mutex;
+	
+	double rate;				/* Tokens per nanosecond */
+	double burst;
+	
+	double tokens;				/* Negative when the workers owe tokens: they are asleep until they come back */
+	uint64_t lastTime;			/* When the tokens were last counted (ns) */
+};
+
+static uint64_t GoldinThrottleGetTime(void)
+{
+	struct timespec tTime;
+	
+	clock_gettime(CLOCK_MONOTONIC,&tTime);
+	
+	return ((uint64_t) tTime.tv_sec)*1000000000ULL+(uint64_t) tTime.tv_nsec;
+}
+
+GoldinThrottleRef GoldinThrottleCreate(uint64_t inRate,uint64_t inBurst)
+{
+	GoldinThrottleRef tThrottle;
+	
+	if (inRate==0)
+	{
+		errno=EINVAL;
+		
+		return NULL;
+	}
+	
+	tThrottle=(GoldinThrottleRef) calloc(1,sizeof(struct _GoldinThrottle));
+	
+	if (tThrottle==NULL)
+		return NULL;
+	
+	if (pthread_mutex_init(&tThrottle->mutex,NULL)!=0)
+	{
+		free(tThrottle);
+		
+		errno=ENOMEM;
+		
+		return NULL;
+	}
+	
+	if (inBurst==0)
+	{
+		inBurst=inRate/10;
+		
+		if (inBurst==0)
+			inBurst=1;
+	}
+	
+	tThrottle->rate=((double) inRate)/1e9;
+	tThrottle->burst=(double) inBurst;
+	
+	/* The first burst is not free: the run starts at the rate */
+	
+	tThrottle->tokens=0;
+	tThrottle->lastTime=GoldinThrottleGetTime();
+	
+	return tThrottle;
+}
+
+void GoldinThrottleRelease(GoldinThrottleRef inThrottle)
+{
+	if (inThrottle==NULL)
+		return;
+	
+	pthread_mutex_destroy(&inThrottle->mutex);
+	
+	free(inThrottle);
+}
+
+void GoldinThrottleAcquire(GoldinThrottleRef inThrottle,uint64_t inCount)
+{
+	uint64_t tTime;
+	double tWaitTime=0;
+	
+	if (inThrottle==NULL || inCount==0)
+		return;
+	
+	pthread_mutex_lock(&inThrottle->mutex);
+	
+	tTime=GoldinThrottleGetTime();
+	
+	inThrottle->tokens+=(tTime-inThrottle->lastTime)*inThrottle->rate;
+	
+	if (inThrottle->tokens>inThrottle->burst)
+		inThrottle->tokens=inThrottle->burst;
+	
+	inThrottle->lastTime=tTime;
+	
+	inThrottle->tokens-=(double) inCount;
+	
+	if (inThrottle->tokens<0)
+		tWaitTime=-inThrottle->tokens/inThrottle->rate;
+	
+	pthread_mutex_unlock(&inThrottle->mutex);
+	
+	if (tWaitTime>0)
+	{
+		struct timespec tDelay;
+		
+		tDelay.tv_sec=(time_t) (tWaitTime/1e9);
+		tDelay.tv_nsec=(long) (tWaitTime-((double) tDelay.tv_sec)*1e9);
+		
+		while (nanosleep(&tDelay,&tDelay)!=0 && errno==EINTR)
+			;
+	}
+}
+
+#pragma mark -
+
+int GoldinIOPriorityGetNamed(const char * inName,GoldinIOPriority * outPriority)
+{
+	if (inName==NULL || outPriority==NULL)
+		return -1;
+	
+	if (strcmp(inName,"normal")==0)
+		*outPriority=kGoldinIOPriorityNormal;
+	else if (strcmp(inName,"low")==0)
+		*outPriority=kGoldinIOPriorityLow;
+	else if (strcmp(inName,"idle")==0)
+		*outPriority=kGoldinIOPriorityIdle;
+	else
+		return -1;
+	
+	return 0;
+}
+
+#ifdef __linux__
+
+/* <linux/ioprio.h> is not installed everywhere */
+
+#define GOLDIN_IOPRIO_WHO_PROCESS		1
+
+#define GOLDIN_IOPRIO_CLASS_BE			2
+#define GOLDIN_IOPRIO_CLASS_IDLE		3
+
+#define GOLDIN_IOPRIO_CLASS_SHIFT		13
+
+#define GOLDIN_IOPRIO_VALUE(inClass,inData)	(((inClass)<<GOLDIN_IOPRIO_CLASS_SHIFT) | (inData))
+
+#endif
+
+int GoldinIOPrioritySet(GoldinIOPriority inPriority)
+{
+	if (inPriority==kGoldinIOPriorityNormal)
+		return 0;
+	
+#if defined(__linux__) && defined(SYS_ioprio_set)
+	{
+		int tValue=(inPriority==kGoldinIOPriorityIdle) ? GOLDIN_IOPRIO_VALUE(GOLDIN_IOPRIO_CLASS_IDLE,0) : GOLDIN_IOPRIO_VALUE(GOLDIN_IOPRIO_CLASS_BE,7);
+		
+		/* Who 0 is the calling thread, the threads created afterwards inherit its priority */
+		
+		if (syscall(SYS_ioprio_set,GOLDIN_IOPRIO_WHO_PROCESS,0,tValue)!=0)
+			return errno;
+		
+		return 0;
+	}
+#elif defined(__APPLE__) && defined(IOPOL_TYPE_DISK)
+	if (setiopolicy_np(IOPOL_TYPE_DISK,IOPOL_SCOPE_PROCESS,(inPriority==kGoldinIOPriorityIdle) ? IOPOL_THROTTLE : IOPOL_UTILITY)!=0)
+		return errno;
+	
+	return 0;
+#else
+	return ENOTSUP;
+#endif
+}
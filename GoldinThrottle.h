@@ -0,0 +1,68 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinThrottle.h
+              Project: goldin
+
+    Notes:
+
+    o A throttle is a token bucket shared by the workers of a job: the tokens come back at a constant rate, up to a
+      burst. A worker asking for more tokens than there are left takes them anyway and sleeps until they would have come
+      back, so the next workers wait behind it and the rate is met over any period longer than the burst without
+      polling.
+    
+    o The I/O priority is set with ioprio_set on Linux (the class of ionice) and setiopolicy_np on Mac OS X. It only
+      changes how the disk scheduler orders the requests: the throttles cap the bandwidth whatever the scheduler.
+*/
+
+#ifndef __GOLDIN_THROTTLE_H__
+#define __GOLDIN_THROTTLE_H__
+
+#include <stdint.h>
+
+typedef struct _GoldinThrottle * GoldinThrottleRef;
+
+/* inRate is the number of tokens per second, inBurst the number that can be taken at once without waiting, 0 for a
+   tenth of a second worth of tokens. Returns NULL and sets errno on failure (EINVAL if inRate is 0) */
+
+GoldinThrottleRef GoldinThrottleCreate(uint64_t inRate,uint64_t inBurst);
+
+void GoldinThrottleRelease(GoldinThrottleRef inThrottle);
+
+/* Waits until inCount tokens can be taken. Returns immediately if inThrottle is NULL */
+
+void GoldinThrottleAcquire(GoldinThrottleRef inThrottle,uint64_t inCount);
+
+typedef enum
+{
+	kGoldinIOPriorityNormal=0,
+	kGoldinIOPriorityLow,			/* Linux: best effort class, lowest level. Mac OS X: utility */
+	kGoldinIOPriorityIdle			/* Linux: idle class (only served when the disk has nothing else to do). Mac OS X: throttle */
+	
+} GoldinIOPriority;
+
+/* Returns -1 if the name is unknown (normal, low or idle) */
+
+int GoldinIOPriorityGetNamed(const char * inName,GoldinIOPriority * outPriority);
+
+/* The priority of the calling thread and of the threads it creates afterwards (of the whole process on Mac OS X): it
+   must be set before the jobs are created. Returns 0 or an errno value, ENOTSUP if the system has no I/O priorities */
+
+int GoldinIOPrioritySet(GoldinIOPriority inPriority);
+
+#endif
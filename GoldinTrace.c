@@ -0,0 +1,334 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinTrace.c
+              Project: goldin
+*/
+
+#include "GoldinTrace.h"
+
+#include "GoldinCounters.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+/* Bucket i>=8 holds the latencies in [(4+i%4)<<(i/4-2),(5+i%4)<<(i/4-2)[ nanoseconds, buckets 0 to 3 hold 0 to 3 ns */
+
+#define GOLDIN_TRACE_BUCKET_COUNT		256
+
+typedef struct _GoldinPhaseStatistics
+{
+	uint64_t count;
+	uint64_t bytes;
+	uint64_t totalTime;
+	uint64_t maximumTime;
+	
+	uint64_t buckets[GOLDIN_TRACE_BUCKET_COUNT];
+	
+} GoldinPhaseStatistics;
+
+static const char * sPhaseNames[kGoldinPhaseCount]=
+{
+	"list folder",
+	"sort folder",
+	"check ._ file",
+	"open resource fork",
+	"create ._ file",
+	"write header",
+	"copy resource fork",
+	"set owner",
+	"strip resource fork",
+	"sync volume",
+	"item"
+};
+
+static int sEnabled=0;
+
+static uint64_t sStartTime=0;
+
+static GoldinPhaseStatistics sPhases[kGoldinPhaseCount];
+
+static pthread_mutex_t sTraceMutex=PTHREAD_MUTEX_INITIALIZER;
+static FILE * sTraceFile=NULL;
+static unsigned long sTraceEventCount=0;
+
+static pthread_key_t sThreadIDKey;
+static pthread_once_t sThreadIDKeyOnce=PTHREAD_ONCE_INIT;
+static unsigned long sLastThreadID=0;
+
+static uint64_t GoldinTraceGetTime(void)
+{
+	struct timespec tTime;
+	
+	clock_gettime(CLOCK_MONOTONIC,&tTime);
+	
+	return ((uint64_t) tTime.tv_sec)*1000000000ULL+(uint64_t) tTime.tv_nsec;
+}
+
+static unsigned int GoldinTraceGetBucket(uint64_t inTime)
+{
+	unsigned int tPower;
+	
+	if (inTime<4)
+		return (unsigned int) inTime;
+	
+	tPower=63-(unsigned int) __builtin_clzll(inTime);
+	
+	return tPower*4+(unsigned int) ((inTime>>(tPower-2)) & 3);
+}
+
+/* The middle of the bucket */
+
+static uint64_t GoldinTraceGetBucketTime(unsigned int inBucket)
+{
+	unsigned int tPower;
+	uint64_t tLowerBound;
+	
+	if (inBucket<4)
+		return inBucket;
+	
+	tPower=inBucket/4;
+	tLowerBound=((uint64_t) (4+inBucket%4))<<(tPower-2);
+	
+	return tLowerBound+(((uint64_t) 1)<<(tPower-2))/2;
+}
+
+static void CreateThreadIDKey(void)
+{
+	pthread_key_create(&sThreadIDKey,NULL);
+}
+
+static unsigned long GoldinTraceGetThreadID(void)
+{
+	uintptr_t tThreadID;
+	
+	pthread_once(&sThreadIDKeyOnce,CreateThreadIDKey);
+	
+	tThreadID=(uintptr_t) pthread_getspecific(sThreadIDKey);
+	
+	if (tThreadID==0)
+	{
+		tThreadID=(uintptr_t) __sync_add_and_fetch(&sLastThreadID,1);
+		
+		pthread_setspecific(sThreadIDKey,(void *) tThreadID);
+	}
+	
+	return (unsigned long) tThreadID;
+}
+
+static void GoldinTracePrintString(FILE * inFile,const char * inString)
+{
+	const unsigned char * tCursor;
+	
+	fputc('"',inFile);
+	
+	for(tCursor=(const unsigned char *) inString;*tCursor!='\0';tCursor++)
+	{
+		if (*tCursor=='"' || *tCursor=='\\')
+			fprintf(inFile,"\\%c",*tCursor);
+		else if (*tCursor<0x20)
+			fprintf(inFile,"\\u%04x",*tCursor);
+		else
+			fputc(*tCursor,inFile);
+	}
+	
+	fputc('"',inFile);
+}
+
+void GoldinTraceSetEnabled(int inEnabled)
+{
+	sEnabled=inEnabled;
+	
+	if (sEnabled!=0 && sStartTime==0)
+		sStartTime=GoldinTraceGetTime();
+}
+
+int GoldinTraceOpen(const char * inPath)
+{
+	FILE * tFile=fopen(inPath,"w");
+	
+	if (tFile==NULL)
+		return errno;
+	
+	pthread_mutex_lock(&sTraceMutex);
+	
+	sTraceFile=tFile;
+	sTraceEventCount=0;
+	
+	fprintf(sTraceFile,"{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	
+	pthread_mutex_unlock(&sTraceMutex);
+	
+	GoldinTraceSetEnabled(1);
+	
+	return 0;
+}
+
+int GoldinTraceClose(void)
+{
+	int tError=0;
+	
+	pthread_mutex_lock(&sTraceMutex);
+	
+	if (sTraceFile!=NULL)
+	{
+		fprintf(sTraceFile,"\n]}\n");
+		
+		if (ferror(sTraceFile)!=0)
+			tError=EIO;
+		
+		if (fclose(sTraceFile)!=0 && tError==0)
+			tError=errno;
+		
+		sTraceFile=NULL;
+	}
+	
+	pthread_mutex_unlock(&sTraceMutex);
+	
+	return tError;
+}
+
+uint64_t GoldinTraceBegin(void)
+{
+	if (sEnabled==0)
+		return 0;
+	
+	return GoldinTraceGetTime();
+}
+
+void GoldinTraceEnd(GoldinPhase inPhase,uint64_t inStartTime,uint64_t inBytes,const char * inName)
+{
+	GoldinPhaseStatistics * tStatistics;
+	uint64_t tEndTime;
+	uint64_t tTime;
+	uint64_t tMaximumTime;
+	
+	if (inStartTime==0 || inPhase<0 || inPhase>=kGoldinPhaseCount)
+		return;
+	
+	tEndTime=GoldinTraceGetTime();
+	tTime=tEndTime-inStartTime;
+	
+	tStatistics=&sPhases[inPhase];
+	
+	__sync_fetch_and_add(&tStatistics->count,1);
+	__sync_fetch_and_add(&tStatistics->bytes,inBytes);
+	__sync_fetch_and_add(&tStatistics->totalTime,tTime);
+	__sync_fetch_and_add(&tStatistics->buckets[GoldinTraceGetBucket(tTime)],1);
+	
+	tMaximumTime=tStatistics->maximumTime;
+	
+	while (tTime>tMaximumTime && __sync_bool_compare_and_swap(&tStatistics->maximumTime,tMaximumTime,tTime)==0)
+		tMaximumTime=tStatistics->maximumTime;
+	
+	if (sTraceFile==NULL)
+		return;
+	
+	{
+		unsigned long tThreadID=GoldinTraceGetThreadID();
+		
+		pthread_mutex_lock(&sTraceMutex);
+		
+		if (sTraceFile!=NULL)
+		{
+			/* Complete events ("X"), in microseconds since the start of the run */
+			
+			fprintf(sTraceFile,"%s{\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f,\"cat\":",(sTraceEventCount>0) ? ",\n" : "",
+																												   tThreadID,
+																												   (inStartTime-sStartTime)/1000.0,
+																												   tTime/1000.0);
+			GoldinTracePrintString(sTraceFile,sPhaseNames[inPhase]);
+			fprintf(sTraceFile,",\"name\":");
+			GoldinTracePrintString(sTraceFile,(inName!=NULL) ? inName : sPhaseNames[inPhase]);
+			fprintf(sTraceFile,",\"args\":{\"bytes\":%llu}}",(unsigned long long) inBytes);
+			
+			sTraceEventCount++;
+		}
+		
+		pthread_mutex_unlock(&sTraceMutex);
+	}
+}
+
+static uint64_t GoldinTraceGetPercentile(const GoldinPhaseStatistics * inStatistics,uint64_t inCount,unsigned int inPercent)
+{
+	uint64_t tRank;
+	uint64_t tCumulatedCount=0;
+	unsigned int i;
+	
+	if (inCount==0)
+		return 0;
+	
+	tRank=(inCount*inPercent+99)/100;
+	
+	for(i=0;i<GOLDIN_TRACE_BUCKET_COUNT;i++)
+	{
+		tCumulatedCount+=inStatistics->buckets[i];
+		
+		if (tCumulatedCount>=tRank)
+		{
+			uint64_t tTime=GoldinTraceGetBucketTime(i);
+			
+			return (tTime<inStatistics->maximumTime) ? tTime : inStatistics->maximumTime;
+		}
+	}
+	
+	return inStatistics->maximumTime;
+}
+
+void GoldinTracePrintStatistics(FILE * inFile)
+{
+	int i;
+	
+	if (inFile==NULL)
+		return;
+	
+	fprintf(inFile,"{\n  \"elapsed_ms\": %.3f,\n  \"counters\": {\n",(sStartTime!=0) ? (GoldinTraceGetTime()-sStartTime)/1000000.0 : 0.0);
+	
+	for(i=0;i<kGoldinCounterCount;i++)
+	{
+		fprintf(inFile,"    ");
+		GoldinTracePrintString(inFile,GoldinCounterGetName((GoldinCounter) i));
+		fprintf(inFile,": %llu%s\n",(unsigned long long) GoldinCounterGetValue((GoldinCounter) i),(i<kGoldinCounterCount-1) ? "," : "");
+	}
+	
+	fprintf(inFile,"  },\n  \"phases\": {\n");
+	
+	/* The latencies are in microseconds */
+	
+	for(i=0;i<kGoldinPhaseCount;i++)
+	{
+		const GoldinPhaseStatistics * tStatistics=&sPhases[i];
+		uint64_t tCount=tStatistics->count;
+		
+		fprintf(inFile,"    ");
+		GoldinTracePrintString(inFile,sPhaseNames[i]);
+		fprintf(inFile,": {\"count\": %llu, \"bytes\": %llu, \"total_ms\": %.3f, \"mean_us\": %.3f, \"p50_us\": %.3f, \"p99_us\": %.3f, \"max_us\": %.3f}%s\n",
+					   (unsigned long long) tCount,
+					   (unsigned long long) tStatistics->bytes,
+					   tStatistics->totalTime/1000000.0,
+					   (tCount>0) ? tStatistics->totalTime/1000.0/tCount : 0.0,
+					   GoldinTraceGetPercentile(tStatistics,tCount,50)/1000.0,
+					   GoldinTraceGetPercentile(tStatistics,tCount,99)/1000.0,
+					   tStatistics->maximumTime/1000.0,
+					   (i<kGoldinPhaseCount-1) ? "," : "");
+	}
+	
+	fprintf(inFile,"  }\n}\n");
+}
@@ -0,0 +1,83 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinTrace.h
+              Project: goldin
+
+    Notes:
+
+    o Times the phases of the split of an item and of the walk of the tree. For every phase, the number of calls, the
+      number of bytes and the distribution of the latencies are kept so that the statistics can be written as JSON
+      when the run is over.
+    
+    o The latencies are kept in a histogram with 4 buckets per power of 2 (about 12 % of error on the percentiles)
+      which can be updated by any worker with atomic operations.
+    
+    o The spans can also be written to a trace file in the Chrome trace event format (chrome://tracing, Perfetto).
+    
+    o When nothing has been requested, GoldinTraceBegin returns 0 without reading the clock and GoldinTraceEnd
+      returns right away.
+*/
+
+#ifndef __GOLDIN_TRACE_H__
+#define __GOLDIN_TRACE_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+typedef enum
+{
+	kGoldinPhaseListFolder=0,			/* Contents of a folder (copyEntries) */
+	kGoldinPhaseSortFolder,				/* Items of a folder put in inode or disk order (GoldinDiskOrder.h) */
+	kGoldinPhaseCheckAppleDouble,		/* Header of the existing ._ file (incremental mode, verification) */
+	kGoldinPhaseOpenFork,				/* Opening the resource fork to get its size */
+	kGoldinPhaseCreateAppleDouble,		/* Creation of the ._ file */
+	kGoldinPhaseWriteHeader,			/* Header, FinderInfo and first chunk of the resource fork */
+	kGoldinPhaseCopyFork,				/* Rest of the resource fork */
+	kGoldinPhaseSetOwner,				/* Owner, group and permissions of the ._ file (FSSetCatalogInfo, fchown) and rename */
+	kGoldinPhaseStripFork,				/* Removal of the resource fork (-s) */
+	kGoldinPhaseSyncVolume,				/* Flush of the volume (checkpoints and end of the run) */
+	kGoldinPhaseItem,					/* The whole split of an item */
+	
+	kGoldinPhaseCount
+	
+} GoldinPhase;
+
+/* Turns the timers on. Must be called before the workers are started */
+
+void GoldinTraceSetEnabled(int inEnabled);
+
+/* The spans are written to this file until GoldinTraceClose is called. Returns 0 or an errno value */
+
+int GoldinTraceOpen(const char * inPath);
+
+int GoldinTraceClose(void);
+
+/* Returns the current time in nanoseconds, 0 if the timers are off */
+
+uint64_t GoldinTraceBegin(void);
+
+/* inName is the name of the span in the trace file (the name of the phase if NULL) */
+
+void GoldinTraceEnd(GoldinPhase inPhase,uint64_t inStartTime,uint64_t inBytes,const char * inName);
+
+/* The counters and the statistics of every phase as a JSON object */
+
+void GoldinTracePrintStatistics(FILE * inFile);
+
+#endif
@@ -0,0 +1,1080 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinWatch.c
+              Project: goldin
+*/
+
+#include "GoldinWatch.h"
+
+#include "GoldinAppleDouble.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+
+#define GOLDIN_WATCH_INOTIFY_MASK	(IN_ATTRIB|IN_CREATE|IN_MOVED_TO|IN_MOVED_FROM|IN_DELETE_SELF|IN_MOVE_SELF|IN_DONT_FOLLOW|IN_ONLYDIR)
+
+#define GOLDIN_WATCH_EVENT_BUFFER_SIZE	65536
+
+typedef struct _GoldinWatchDirectory
+{
+	int descriptor;					/* Watch descriptor */
+	char * path;
+	
+} GoldinWatchDirectory;
+
+#endif
+
+#ifdef __APPLE__
+
+#include <CoreServices/CoreServices.h>
+
+#define GOLDIN_WATCH_FSEVENTS_LATENCY		0.05
+
+#endif
+
+typedef struct _GoldinWatchRoot
+{
+	char * path;					/* Absolute, without symbolic links */
+	size_t length;
+	Boolean isDirectory;
+	
+} GoldinWatchRoot;
+
+typedef struct _GoldinWatchItem
+{
+	char * path;
+	unsigned long depth;			/* Below the root it was found in */
+	Boolean contents;				/* A folder created or moved into the tree: its contents must be split too */
+	
+} GoldinWatchItem;
+
+struct _GoldinWatch
+{
+	GoldinJobOptions options;
+	
+	GoldinWatchRoot * roots;
+	size_t rootCount;
+	
+	/* The items changed since the last batch */
+	
+	GoldinWatchItem * items;
+	size_t itemCount;
+	size_t itemCapacity;
+	
+	uint64_t firstChangeTime;		/* In ms */
+	uint64_t lastChangeTime;
+	
+	GoldinJobStatistics statistics;
+	
+	volatile sig_atomic_t stopped;
+	
+#ifdef __linux__
+	int descriptor;					/* inotify */
+	int wakeDescriptors[2];			/* GoldinWatchStop wakes up poll through this pipe */
+	
+	GoldinWatchDirectory * directories;	/* Sorted by watch descriptor */
+	size_t directoryCount;
+	size_t directoryCapacity;
+	
+	Boolean watchLimitReported;
+#endif
+};
+
+static uint64_t GoldinWatchGetTime(void)
+{
+	struct timespec tTime;
+	
+	clock_gettime(CLOCK_MONOTONIC,&tTime);
+	
+	return (uint64_t) tTime.tv_sec*1000+(uint64_t) tTime.tv_nsec/1000000;
+}
+
+static void GoldinWatchLogError(GoldinWatchRef inWatch,const char * inFormat,...)
+{
+	char tMessage[PATH_MAX+256];
+	size_t tLength;
+	va_list tArguments;
+	
+	va_start(tArguments,inFormat);
+	vsnprintf(tMessage,sizeof(tMessage),inFormat,tArguments);
+	va_end(tArguments);
+	
+	tLength=strlen(tMessage);
+	
+	if (tLength>0 && tMessage[tLength-1]=='\n')
+		tMessage[tLength-1]='\0';
+	
+	if (inWatch->options.errorCallback!=NULL)
+		inWatch->options.errorCallback(tMessage,inWatch->options.callbackContext);
+	else
+		logerror("%s\n",tMessage);
+}
+
+/* Our own files: the ._ files and the temporary files they are written to */
+
+static Boolean GoldinWatchIsIgnoredName(const char * inName)
+{
+	if (inName[0]=='.' && inName[1]=='_')
+		return TRUE;
+	
+	return (GoldinAppleDoubleIsTemporaryName(inName,NULL,NULL)!=0) ? TRUE : FALSE;
+}
+
+/* Returns FALSE if the item is not in a tree. When the roots are nested, the closest one wins */
+
+static Boolean GoldinWatchGetDepth(GoldinWatchRef inWatch,const char * inPath,unsigned long * outDepth,const char ** outRelativePath)
+{
+	Boolean tFound=FALSE;
+	size_t i;
+	
+	for(i=0;i<inWatch->rootCount;i++)
+	{
+		const GoldinWatchRoot * tRoot=&inWatch->roots[i];
+		const char * tRelativePath;
+		unsigned long tDepth;
+		
+		if (strcmp(inPath,tRoot->path)==0)
+		{
+			*outDepth=0;
+			*outRelativePath="";
+			
+			return TRUE;
+		}
+		
+		if (tRoot->isDirectory==FALSE || strncmp(inPath,tRoot->path,tRoot->length)!=0)
+			continue;
+		
+		if (tRoot->length==1)
+			tRelativePath=inPath+1;			/* The root is / */
+		else if (inPath[tRoot->length]=='/')
+			tRelativePath=inPath+tRoot->length+1;
+		else
+			continue;
+		
+		for(tDepth=1;*tRelativePath!='\0' && strchr(tRelativePath,'/')!=NULL && tDepth<ULONG_MAX;tDepth++)
+			tRelativePath=strchr(tRelativePath,'/')+1;
+		
+		if (tFound==FALSE || tDepth<*outDepth)
+		{
+			*outDepth=tDepth;
+			*outRelativePath=(tRoot->length==1) ? inPath+1 : inPath+tRoot->length+1;
+			
+			tFound=TRUE;
+		}
+	}
+	
+	return tFound;
+}
+
+/* The split of the whole tree would not have reached the item */
+
+static Boolean GoldinWatchIsPruned(GoldinWatchRef inWatch,const char * inRelativePath,unsigned long inDepth,Boolean inIsDirectory)
+{
+	char tName[PATH_MAX];
+	const char * tComponent=inRelativePath;
+	
+	if (inDepth==0)
+		return FALSE;
+	
+	if (GoldinFilterCanDescend(inWatch->options.filter,inDepth-1)==FALSE)
+		return TRUE;
+	
+	while (*tComponent!='\0')
+	{
+		const char * tEnd=strchr(tComponent,'/');
+		size_t tLength=(tEnd!=NULL) ? (size_t) (tEnd-tComponent) : strlen(tComponent);
+		
+		if (tLength>=sizeof(tName))
+			return TRUE;
+		
+		memcpy(tName,tComponent,tLength);
+		tName[tLength]='\0';
+		
+		if (tEnd==NULL && GoldinWatchIsIgnoredName(tName)==TRUE)
+			return TRUE;
+		
+		if (GoldinFilterExcludes(inWatch->options.filter,tName,(tEnd!=NULL) ? TRUE : inIsDirectory)==TRUE)
+			return TRUE;
+		
+		if (tEnd==NULL)
+			break;
+		
+		tComponent=tEnd+1;
+	}
+	
+	return FALSE;
+}
+
+static Boolean GoldinWatchAccept(GoldinWatchRef inWatch,const char * inPath,Boolean inIsDirectory,unsigned long * outDepth)
+{
+	const char * tRelativePath="";
+	
+	if (GoldinWatchGetDepth(inWatch,inPath,outDepth,&tRelativePath)==FALSE)
+		return FALSE;
+	
+	return (GoldinWatchIsPruned(inWatch,tRelativePath,*outDepth,inIsDirectory)==FALSE) ? TRUE : FALSE;
+}
+
+static void GoldinWatchAddItem(GoldinWatchRef inWatch,const char * inPath,unsigned long inDepth,Boolean inContents)
+{
+	GoldinWatchItem * tItem;
+	uint64_t tNow=GoldinWatchGetTime();
+	
+	if (inWatch->itemCount==inWatch->itemCapacity)
+	{
+		size_t tCapacity=(inWatch->itemCapacity==0) ? 64 : inWatch->itemCapacity*2;
+		GoldinWatchItem * tItems=(GoldinWatchItem *) realloc(inWatch->items,tCapacity*sizeof(GoldinWatchItem));
+		
+		if (tItems==NULL)
+			return;
+		
+		inWatch->items=tItems;
+		inWatch->itemCapacity=tCapacity;
+	}
+	
+	tItem=&inWatch->items[inWatch->itemCount];
+	
+	tItem->path=strdup(inPath);
+	
+	if (tItem->path==NULL)
+		return;
+	
+	/* The contents of a folder are only split if the split of the whole tree would have opened it */
+	
+	tItem->depth=inDepth;
+	tItem->contents=(inContents==TRUE && GoldinFilterCanDescend(inWatch->options.filter,inDepth)==TRUE) ? TRUE : FALSE;
+	
+	if (inWatch->itemCount==0)
+		inWatch->firstChangeTime=tNow;
+	
+	inWatch->lastChangeTime=tNow;
+	
+	inWatch->itemCount++;
+}
+
+static int GoldinWatchCompareItems(const void * inItem1,const void * inItem2)
+{
+	return strcmp(((const GoldinWatchItem *) inItem1)->path,((const GoldinWatchItem *) inItem2)->path);
+}
+
+/* An item inside a folder whose contents are split anyway is dropped */
+
+static Boolean GoldinWatchIsCovered(GoldinWatchRef inWatch,size_t inIndex)
+{
+	const char * tPath=inWatch->items[inIndex].path;
+	size_t i;
+	
+	for(i=0;i<inWatch->itemCount;i++)
+	{
+		size_t tLength;
+		
+		if (i==inIndex || inWatch->items[i].path==NULL || inWatch->items[i].contents==FALSE)
+			continue;
+		
+		tLength=strlen(inWatch->items[i].path);
+		
+		if (strncmp(tPath,inWatch->items[i].path,tLength)==0 && (tPath[tLength]=='/' || (tLength==1 && tPath[1]!='\0')))
+			return TRUE;
+	}
+	
+	return FALSE;
+}
+
+static void GoldinWatchSplitItems(GoldinWatchRef inWatch)
+{
+	GoldinJobStatistics tStatistics;
+	GoldinJobRef tJob;
+	size_t i;
+	
+	if (inWatch->itemCount==0)
+		return;
+	
+	/* 1. Coalesce the changes */
+	
+	qsort(inWatch->items,inWatch->itemCount,sizeof(GoldinWatchItem),GoldinWatchCompareItems);
+	
+	for(i=1;i<inWatch->itemCount;i++)
+	{
+		GoldinWatchItem * tPreviousItem=&inWatch->items[i-1];
+		
+		if (tPreviousItem->path!=NULL && strcmp(tPreviousItem->path,inWatch->items[i].path)==0)
+		{
+			if (tPreviousItem->contents==TRUE)
+				inWatch->items[i].contents=TRUE;
+			
+			free(tPreviousItem->path);
+			tPreviousItem->path=NULL;
+		}
+	}
+	
+	for(i=0;i<inWatch->itemCount;i++)
+	{
+		if (inWatch->items[i].path!=NULL && GoldinWatchIsCovered(inWatch,i)==TRUE)
+		{
+			free(inWatch->items[i].path);
+			inWatch->items[i].path=NULL;
+		}
+	}
+	
+	/* 2. Split them */
+	
+	tJob=GoldinJobCreate(&inWatch->options);
+	
+	if (tJob==NULL)
+		GoldinWatchLogError(inWatch,"An error occurred while creating the job (%s)\n",strerror(errno));
+	
+	for(i=0;i<inWatch->itemCount;i++)
+	{
+		GoldinWatchItem * tItem=&inWatch->items[i];
+		struct stat tStat;
+		
+		if (tItem->path==NULL)
+			continue;
+		
+		/* The items removed or moved away since the change are not errors */
+		
+		if (tJob!=NULL && lstat(tItem->path,&tStat)==0)
+			GoldinJobUpdate(tJob,tItem->path,tItem->depth,tItem->contents);
+		
+		free(tItem->path);
+	}
+	
+	inWatch->itemCount=0;
+	
+	if (tJob==NULL)
+		return;
+	
+	GoldinJobFinish(tJob);
+	
+	GoldinJobGetStatistics(tJob,&tStatistics);
+	
+	inWatch->statistics.splitItems+=tStatistics.splitItems;
+	inWatch->statistics.upToDateItems+=tStatistics.upToDateItems;
+	inWatch->statistics.rewrittenItems+=tStatistics.rewrittenItems;
+	inWatch->statistics.linkedItems+=tStatistics.linkedItems;
+	inWatch->statistics.deduplicatedItems+=tStatistics.deduplicatedItems;
+	inWatch->statistics.journaledItems+=tStatistics.journaledItems;
+	inWatch->statistics.prunedItems+=tStatistics.prunedItems;
+	inWatch->statistics.errors+=tStatistics.errors;
+	
+	GoldinJobRelease(tJob);
+}
+
+/* Returns TRUE if the batch must be split now */
+
+static Boolean GoldinWatchIsBatchReady(GoldinWatchRef inWatch,uint64_t inNow)
+{
+	if (inWatch->itemCount==0)
+		return FALSE;
+	
+	return (inNow>=inWatch->lastChangeTime+GOLDIN_WATCH_QUIET_PERIOD || inNow>=inWatch->firstChangeTime+GOLDIN_WATCH_MAXIMUM_DELAY) ? TRUE : FALSE;
+}
+
+#pragma mark -
+
+#ifdef __linux__
+
+static GoldinWatchDirectory * GoldinWatchFindDirectory(GoldinWatchRef inWatch,int inDescriptor,size_t * outIndex)
+{
+	size_t tLow=0;
+	size_t tHigh=inWatch->directoryCount;
+	
+	while (tLow<tHigh)
+	{
+		size_t tMiddle=tLow+(tHigh-tLow)/2;
+		
+		if (inWatch->directories[tMiddle].descriptor<inDescriptor)
+			tLow=tMiddle+1;
+		else
+			tHigh=tMiddle;
+	}
+	
+	*outIndex=tLow;
+	
+	if (tLow<inWatch->directoryCount && inWatch->directories[tLow].descriptor==inDescriptor)
+		return &inWatch->directories[tLow];
+	
+	return NULL;
+}
+
+static void GoldinWatchRemoveDirectory(GoldinWatchRef inWatch,int inDescriptor)
+{
+	size_t tIndex;
+	GoldinWatchDirectory * tDirectory=GoldinWatchFindDirectory(inWatch,inDescriptor,&tIndex);
+	
+	if (tDirectory==NULL)
+		return;
+	
+	free(tDirectory->path);
+	
+	memmove(tDirectory,tDirectory+1,(inWatch->directoryCount-tIndex-1)*sizeof(GoldinWatchDirectory));
+	
+	inWatch->directoryCount--;
+}
+
+static int GoldinWatchAddDirectory(GoldinWatchRef inWatch,const char * inPath)
+{
+	GoldinWatchDirectory * tDirectory;
+	size_t tIndex;
+	char * tPath;
+	int tDescriptor;
+	
+	tDescriptor=inotify_add_watch(inWatch->descriptor,inPath,GOLDIN_WATCH_INOTIFY_MASK);
+	
+	if (tDescriptor==-1)
+	{
+		int tError=errno;
+		
+		if (tError==ENOSPC)
+		{
+			if (inWatch->watchLimitReported==FALSE)
+				GoldinWatchLogError(inWatch,"Too many folders to watch (fs.inotify.max_user_watches), the changes in %s and other folders will be missed\n",inPath);
+			
+			inWatch->watchLimitReported=TRUE;
+		}
+		
+		return tError;
+	}
+	
+	tPath=strdup(inPath);
+	
+	if (tPath==NULL)
+		return ENOMEM;
+	
+	tDirectory=GoldinWatchFindDirectory(inWatch,tDescriptor,&tIndex);
+	
+	if (tDirectory!=NULL)
+	{
+		/* Already watched (moved or added again) */
+		
+		free(tDirectory->path);
+		tDirectory->path=tPath;
+		
+		return 0;
+	}
+	
+	if (inWatch->directoryCount==inWatch->directoryCapacity)
+	{
+		size_t tCapacity=(inWatch->directoryCapacity==0) ? 256 : inWatch->directoryCapacity*2;
+		GoldinWatchDirectory * tDirectories=(GoldinWatchDirectory *) realloc(inWatch->directories,tCapacity*sizeof(GoldinWatchDirectory));
+		
+		if (tDirectories==NULL)
+		{
+			free(tPath);
+			
+			return ENOMEM;
+		}
+		
+		inWatch->directories=tDirectories;
+		inWatch->directoryCapacity=tCapacity;
+	}
+	
+	memmove(&inWatch->directories[tIndex+1],&inWatch->directories[tIndex],(inWatch->directoryCount-tIndex)*sizeof(GoldinWatchDirectory));
+	
+	inWatch->directories[tIndex].descriptor=tDescriptor;
+	inWatch->directories[tIndex].path=tPath;
+	
+	inWatch->directoryCount++;
+	
+	return 0;
+}
+
+/* inDepth is the depth of the folder. Only the folders the split would open are watched */
+
+static void GoldinWatchAddTree(GoldinWatchRef inWatch,const char * inPath,unsigned long inDepth)
+{
+	struct dirent * tDirectoryEntry;
+	DIR * tDirectory;
+	
+	if (GoldinFilterCanDescend(inWatch->options.filter,inDepth)==FALSE)
+		return;
+	
+	if (GoldinWatchAddDirectory(inWatch,inPath)!=0)
+		return;
+	
+	tDirectory=opendir(inPath);
+	
+	if (tDirectory==NULL)
+		return;
+	
+	while ((tDirectoryEntry=readdir(tDirectory))!=NULL)
+	{
+		const char * tName=tDirectoryEntry->d_name;
+		char tPath[PATH_MAX];
+		Boolean tIsDirectory=(tDirectoryEntry->d_type==DT_DIR);
+		
+		if (strcmp(tName,".")==0 || strcmp(tName,"..")==0 || GoldinWatchIsIgnoredName(tName)==TRUE)
+			continue;
+		
+		if (snprintf(tPath,sizeof(tPath),"%s/%s",(inPath[1]=='\0') ? "" : inPath,tName)>=(int) sizeof(tPath))
+			continue;
+		
+		if (tDirectoryEntry->d_type==DT_UNKNOWN)
+		{
+			struct stat tStat;
+			
+			tIsDirectory=(lstat(tPath,&tStat)==0 && S_ISDIR(tStat.st_mode));
+		}
+		
+		if (tIsDirectory==FALSE || GoldinFilterExcludes(inWatch->options.filter,tName,TRUE)==TRUE)
+			continue;
+		
+		GoldinWatchAddTree(inWatch,tPath,inDepth+1);
+	}
+	
+	closedir(tDirectory);
+}
+
+/* The folder and its subfolders are not in the tree anymore */
+
+static void GoldinWatchRemoveTree(GoldinWatchRef inWatch,const char * inPath)
+{
+	size_t tLength=strlen(inPath);
+	size_t i;
+	
+	for(i=0;i<inWatch->directoryCount;i++)
+	{
+		const char * tPath=inWatch->directories[i].path;
+		
+		/* The records are removed when the IN_IGNORED events are read */
+		
+		if (strncmp(tPath,inPath,tLength)==0 && (tPath[tLength]=='\0' || tPath[tLength]=='/'))
+			inotify_rm_watch(inWatch->descriptor,inWatch->directories[i].descriptor);
+	}
+}
+
+static void GoldinWatchProcessEvent(GoldinWatchRef inWatch,const struct inotify_event * inEvent)
+{
+	GoldinWatchDirectory * tDirectory;
+	char tPath[PATH_MAX];
+	Boolean tIsDirectory=((inEvent->mask & IN_ISDIR)!=0);
+	unsigned long tDepth;
+	size_t tIndex;
+	
+	if ((inEvent->mask & IN_Q_OVERFLOW)!=0)
+	{
+		size_t i;
+		
+		/* Some changes were lost: the trees are split again (the ._ files up to date are not rewritten) */
+		
+		GoldinWatchLogError(inWatch,"Too many changes at once, the trees will be split again\n");
+		
+		for(i=0;i<inWatch->rootCount;i++)
+		{
+			if (inWatch->roots[i].isDirectory==TRUE)
+				GoldinWatchAddTree(inWatch,inWatch->roots[i].path,0);
+			
+			GoldinWatchAddItem(inWatch,inWatch->roots[i].path,0,TRUE);
+		}
+		
+		return;
+	}
+	
+	tDirectory=GoldinWatchFindDirectory(inWatch,inEvent->wd,&tIndex);
+	
+	if (tDirectory==NULL)
+		return;
+	
+	if ((inEvent->mask & IN_IGNORED)!=0)
+	{
+		GoldinWatchRemoveDirectory(inWatch,inEvent->wd);
+		
+		return;
+	}
+	
+	if ((inEvent->mask & IN_MOVE_SELF)!=0)
+	{
+		/* Where the folder went is not known, it is watched again if it was moved within the tree (IN_MOVED_TO) */
+		
+		inotify_rm_watch(inWatch->descriptor,inEvent->wd);
+		
+		return;
+	}
+	
+	if ((inEvent->mask & IN_DELETE_SELF)!=0)
+		return;
+	
+	if (inEvent->len==0 || inEvent->name[0]=='\0')
+	{
+		/* The folder itself */
+		
+		if (GoldinWatchAccept(inWatch,tDirectory->path,TRUE,&tDepth)==TRUE)
+			GoldinWatchAddItem(inWatch,tDirectory->path,tDepth,FALSE);
+		
+		return;
+	}
+	
+	if (snprintf(tPath,sizeof(tPath),"%s/%s",(tDirectory->path[1]=='\0') ? "" : tDirectory->path,inEvent->name)>=(int) sizeof(tPath))
+		return;
+	
+	if ((inEvent->mask & IN_MOVED_FROM)!=0)
+	{
+		if (tIsDirectory==TRUE)
+			GoldinWatchRemoveTree(inWatch,tPath);
+		
+		return;
+	}
+	
+	if (GoldinWatchAccept(inWatch,tPath,tIsDirectory,&tDepth)==FALSE)
+		return;
+	
+	if (tIsDirectory==TRUE && (inEvent->mask & (IN_CREATE|IN_MOVED_TO))!=0)
+	{
+		/* A new folder: its contents may have been there before it was watched */
+		
+		GoldinWatchAddTree(inWatch,tPath,tDepth);
+		
+		GoldinWatchAddItem(inWatch,tPath,tDepth,TRUE);
+		
+		return;
+	}
+	
+	GoldinWatchAddItem(inWatch,tPath,tDepth,FALSE);
+}
+
+static int GoldinWatchReadEvents(GoldinWatchRef inWatch)
+{
+	char tBuffer[GOLDIN_WATCH_EVENT_BUFFER_SIZE] __attribute__((aligned(__alignof__(struct inotify_event))));
+	
+	while (1)
+	{
+		ssize_t tLength=read(inWatch->descriptor,tBuffer,sizeof(tBuffer));
+		char * tCursor;
+		
+		if (tLength<=0)
+		{
+			if (tLength<0 && errno==EINTR)
+				continue;
+			
+			return (tLength<0 && errno!=EAGAIN) ? errno : 0;
+		}
+		
+		for(tCursor=tBuffer;tCursor<tBuffer+tLength;)
+		{
+			const struct inotify_event * tEvent=(const struct inotify_event *) tCursor;
+			
+			GoldinWatchProcessEvent(inWatch,tEvent);
+			
+			tCursor+=sizeof(struct inotify_event)+tEvent->len;
+		}
+	}
+}
+
+#endif
+
+#ifdef __APPLE__
+
+static void GoldinWatchFSEventsCallback(ConstFSEventStreamRef inStream,void * inContext,size_t inEventCount,void * inEventPaths,const FSEventStreamEventFlags inEventFlags[],const FSEventStreamEventId inEventIds[])
+{
+	GoldinWatchRef tWatch=(GoldinWatchRef) inContext;
+	char ** tPaths=(char **) inEventPaths;
+	size_t i;
+	
+	(void) inStream;
+	(void) inEventIds;
+	
+	for(i=0;i<inEventCount;i++)
+	{
+		FSEventStreamEventFlags tFlags=inEventFlags[i];
+		Boolean tIsDirectory=((tFlags & kFSEventStreamEventFlagItemIsDir)!=0);
+		unsigned long tDepth;
+		
+		if ((tFlags & (kFSEventStreamEventFlagMustScanSubDirs|kFSEventStreamEventFlagUserDropped|kFSEventStreamEventFlagKernelDropped))!=0)
+		{
+			/* Some changes were lost: the folder is split again (the ._ files up to date are not rewritten) */
+			
+			if (GoldinWatchAccept(tWatch,tPaths[i],TRUE,&tDepth)==TRUE)
+				GoldinWatchAddItem(tWatch,tPaths[i],tDepth,TRUE);
+			
+			continue;
+		}
+		
+		if (GoldinWatchAccept(tWatch,tPaths[i],tIsDirectory,&tDepth)==FALSE)
+			continue;
+		
+		if (tIsDirectory==TRUE && (tFlags & (kFSEventStreamEventFlagItemCreated|kFSEventStreamEventFlagItemRenamed))!=0)
+		{
+			GoldinWatchAddItem(tWatch,tPaths[i],tDepth,TRUE);
+			
+			continue;
+		}
+		
+		if ((tFlags & (kFSEventStreamEventFlagItemCreated|kFSEventStreamEventFlagItemRenamed|kFSEventStreamEventFlagItemModified|
+					   kFSEventStreamEventFlagItemInodeMetaMod|kFSEventStreamEventFlagItemFinderInfoMod|kFSEventStreamEventFlagItemXattrMod))!=0)
+			GoldinWatchAddItem(tWatch,tPaths[i],tDepth,FALSE);
+	}
+}
+
+#endif
+
+#pragma mark -
+
+GoldinWatchRef GoldinWatchCreate(const GoldinJobOptions * inOptions)
+{
+	GoldinWatchRef tWatch;
+	
+	if (inOptions==NULL)
+	{
+		errno=EINVAL;
+		
+		return NULL;
+	}
+	
+	/* The resource forks stripped would be split again without them */
+	
+	if (inOptions->dryRunMode==TRUE || inOptions->verifyMode==TRUE || inOptions->stripResourceForks==TRUE || inOptions->journalPath!=NULL || inOptions->archiveMode==TRUE)
+	{
+		static const char sConflict[]="The trees can not be watched during a dry run or a verification, with the resource forks stripped, with a journal or to an archive";
+		
+		if (inOptions->errorCallback!=NULL)
+			inOptions->errorCallback(sConflict,inOptions->callbackContext);
+		else
+			logerror("%s\n",sConflict);
+		
+		errno=EINVAL;
+		
+		return NULL;
+	}
+	
+#if !defined(__linux__) && !defined(__APPLE__)
+	errno=ENOTSUP;
+	
+	return NULL;
+#else
+	tWatch=(GoldinWatchRef) calloc(1,sizeof(struct _GoldinWatch));
+	
+	if (tWatch==NULL)
+		return NULL;
+	
+	tWatch->options=*inOptions;
+	
+	/* An item changed many times in a row must not be rewritten every time */
+	
+	tWatch->options.incrementalMode=TRUE;
+	tWatch->options.resume=FALSE;
+	
+#ifdef __linux__
+	tWatch->wakeDescriptors[0]=tWatch->wakeDescriptors[1]=-1;
+	
+	tWatch->descriptor=inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+	
+	if (tWatch->descriptor==-1 || pipe(tWatch->wakeDescriptors)!=0 ||
+		fcntl(tWatch->wakeDescriptors[0],F_SETFL,O_NONBLOCK)!=0 || fcntl(tWatch->wakeDescriptors[1],F_SETFL,O_NONBLOCK)!=0)
+	{
+		int tError=errno;
+		
+		GoldinWatchRelease(tWatch);
+		
+		errno=(tError==ENOSYS) ? ENOTSUP : tError;
+		
+		return NULL;
+	}
+#endif
+	
+	return tWatch;
+#endif
+}
+
+void GoldinWatchRelease(GoldinWatchRef inWatch)
+{
+	size_t i;
+	
+	if (inWatch==NULL)
+		return;
+	
+#ifdef __linux__
+	if (inWatch->descriptor!=-1)
+		close(inWatch->descriptor);
+	
+	if (inWatch->wakeDescriptors[0]!=-1)
+		close(inWatch->wakeDescriptors[0]);
+	
+	if (inWatch->wakeDescriptors[1]!=-1)
+		close(inWatch->wakeDescriptors[1]);
+	
+	for(i=0;i<inWatch->directoryCount;i++)
+		free(inWatch->directories[i].path);
+	
+	free(inWatch->directories);
+#endif
+	
+	for(i=0;i<inWatch->itemCount;i++)
+		free(inWatch->items[i].path);
+	
+	free(inWatch->items);
+	
+	for(i=0;i<inWatch->rootCount;i++)
+		free(inWatch->roots[i].path);
+	
+	free(inWatch->roots);
+	
+	free(inWatch);
+}
+
+int GoldinWatchAddRoot(GoldinWatchRef inWatch,const char * inPath)
+{
+	char tResolvedPath[PATH_MAX];
+	GoldinWatchRoot * tRoots;
+	GoldinWatchRoot * tRoot;
+	struct stat tStat;
+	
+	if (inWatch==NULL || inPath==NULL)
+		return EINVAL;
+	
+	if (realpath(inPath,tResolvedPath)==NULL || lstat(tResolvedPath,&tStat)!=0)
+		return errno;
+	
+	tRoots=(GoldinWatchRoot *) realloc(inWatch->roots,(inWatch->rootCount+1)*sizeof(GoldinWatchRoot));
+	
+	if (tRoots==NULL)
+		return ENOMEM;
+	
+	inWatch->roots=tRoots;
+	
+	tRoot=&inWatch->roots[inWatch->rootCount];
+	
+	tRoot->path=strdup(tResolvedPath);
+	
+	if (tRoot->path==NULL)
+		return ENOMEM;
+	
+	tRoot->length=strlen(tResolvedPath);
+	tRoot->isDirectory=S_ISDIR(tStat.st_mode);
+	
+	inWatch->rootCount++;
+	
+#ifdef __linux__
+	if (tRoot->isDirectory==TRUE)
+	{
+		GoldinWatchAddTree(inWatch,tRoot->path,0);
+	}
+	else
+	{
+		/* A file is watched through its folder, the changes of the other items of the folder are not in a tree */
+		
+		char * tSlash=strrchr(tResolvedPath,'/');
+		
+		if (tSlash==tResolvedPath)
+			tSlash[1]='\0';
+		else
+			tSlash[0]='\0';
+		
+		return GoldinWatchAddDirectory(inWatch,tResolvedPath);
+	}
+#endif
+	
+	return 0;
+}
+
+int GoldinWatchRun(GoldinWatchRef inWatch)
+{
+#ifdef __linux__
+	struct pollfd tDescriptors[2];
+	int tError=0;
+	
+	if (inWatch==NULL)
+		return EINVAL;
+	
+	tDescriptors[0].fd=inWatch->descriptor;
+	tDescriptors[0].events=POLLIN;
+	tDescriptors[1].fd=inWatch->wakeDescriptors[0];
+	tDescriptors[1].events=POLLIN;
+	
+	while (inWatch->stopped==0)
+	{
+		int tTimeout=-1;
+		uint64_t tNow;
+		
+		if (inWatch->itemCount>0)
+		{
+			uint64_t tDeadline=inWatch->lastChangeTime+GOLDIN_WATCH_QUIET_PERIOD;
+			
+			if (tDeadline>inWatch->firstChangeTime+GOLDIN_WATCH_MAXIMUM_DELAY)
+				tDeadline=inWatch->firstChangeTime+GOLDIN_WATCH_MAXIMUM_DELAY;
+			
+			tNow=GoldinWatchGetTime();
+			
+			tTimeout=(tDeadline>tNow) ? (int) (tDeadline-tNow) : 0;
+		}
+		
+		if (poll(tDescriptors,2,tTimeout)<0)
+		{
+			if (errno==EINTR)
+				continue;
+			
+			tError=errno;
+			
+			break;
+		}
+		
+		if ((tDescriptors[1].revents & POLLIN)!=0)
+		{
+			char tByte;
+			
+			while (read(inWatch->wakeDescriptors[0],&tByte,1)==1)
+				;
+		}
+		
+		if ((tDescriptors[0].revents & POLLIN)!=0)
+		{
+			tError=GoldinWatchReadEvents(inWatch);
+			
+			if (tError!=0)
+				break;
+		}
+		
+		if (GoldinWatchIsBatchReady(inWatch,GoldinWatchGetTime())==TRUE)
+			GoldinWatchSplitItems(inWatch);
+	}
+	
+	/* What changed before the end is not lost */
+	
+	GoldinWatchSplitItems(inWatch);
+	
+	return tError;
+#elif defined(__APPLE__)
+	CFMutableArrayRef tPaths;
+	FSEventStreamContext tContext={0,NULL,NULL,NULL,NULL};
+	FSEventStreamRef tStream;
+	size_t i;
+	
+	if (inWatch==NULL)
+		return EINVAL;
+	
+	tPaths=CFArrayCreateMutable(kCFAllocatorDefault,0,&kCFTypeArrayCallBacks);
+	
+	if (tPaths==NULL)
+		return ENOMEM;
+	
+	for(i=0;i<inWatch->rootCount;i++)
+	{
+		char tPath[PATH_MAX];
+		CFStringRef tPathString;
+		
+		/* A file is watched through its folder */
+		
+		snprintf(tPath,sizeof(tPath),"%s",inWatch->roots[i].path);
+		
+		if (inWatch->roots[i].isDirectory==FALSE)
+		{
+			char * tSlash=strrchr(tPath,'/');
+			
+			if (tSlash==tPath)
+				tSlash[1]='\0';
+			else
+				tSlash[0]='\0';
+		}
+		
+		tPathString=CFStringCreateWithFileSystemRepresentation(kCFAllocatorDefault,tPath);
+		
+		if (tPathString!=NULL)
+		{
+			CFArrayAppendValue(tPaths,tPathString);
+			
+			CFRelease(tPathString);
+		}
+	}
+	
+	tContext.info=inWatch;
+	
+	tStream=FSEventStreamCreate(kCFAllocatorDefault,GoldinWatchFSEventsCallback,&tContext,tPaths,kFSEventStreamEventIdSinceNow,GOLDIN_WATCH_FSEVENTS_LATENCY,
+								kFSEventStreamCreateFlagFileEvents|kFSEventStreamCreateFlagNoDefer|kFSEventStreamCreateFlagWatchRoot);
+	
+	CFRelease(tPaths);
+	
+	if (tStream==NULL)
+		return ENOTSUP;
+	
+	FSEventStreamScheduleWithRunLoop(tStream,CFRunLoopGetCurrent(),kCFRunLoopDefaultMode);
+	
+	if (FSEventStreamStart(tStream)==false)
+	{
+		FSEventStreamInvalidate(tStream);
+		FSEventStreamRelease(tStream);
+		
+		return ENOTSUP;
+	}
+	
+	/* The run loop is left regularly to check whether the watch must stop and whether the batch is ready */
+	
+	while (inWatch->stopped==0)
+	{
+		CFRunLoopRunInMode(kCFRunLoopDefaultMode,GOLDIN_WATCH_FSEVENTS_LATENCY,true);
+		
+		if (GoldinWatchIsBatchReady(inWatch,GoldinWatchGetTime())==TRUE)
+			GoldinWatchSplitItems(inWatch);
+	}
+	
+	FSEventStreamStop(tStream);
+	FSEventStreamInvalidate(tStream);
+	FSEventStreamRelease(tStream);
+	
+	GoldinWatchSplitItems(inWatch);
+	
+	return 0;
+#else
+	(void) inWatch;
+	
+	return ENOTSUP;
+#endif
+}
+
+void GoldinWatchStop(GoldinWatchRef inWatch)
+{
+	if (inWatch==NULL)
+		return;
+	
+	inWatch->stopped=1;
+	
+#ifdef __linux__
+	{
+		int tSavedError=errno;
+		
+		if (write(inWatch->wakeDescriptors[1],"",1)<0)
+		{
+			/* The pipe is full: poll will return anyway */
+		}
+		
+		errno=tSavedError;
+	}
+#endif
+}
+
+void GoldinWatchGetStatistics(GoldinWatchRef inWatch,GoldinJobStatistics * outStatistics)
+{
+	if (inWatch==NULL || outStatistics==NULL)
+		return;
+	
+	*outStatistics=inWatch->statistics;
+}
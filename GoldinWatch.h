@@ -0,0 +1,69 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinWatch.h
+              Project: goldin
+
+    Notes:
+
+    o Keeps the ._ files of some trees up to date: the items whose FinderInfo, resource fork or extended attributes
+      change are split again, without walking the trees (inotify on Linux, FSEvents on Mac OS X).
+    
+    o The changes are coalesced: the items are split once nothing has changed for GOLDIN_WATCH_QUIET_PERIOD ms, or
+      GOLDIN_WATCH_MAXIMUM_DELAY ms after the first change of a burst. Every batch is split by its own job in
+      incremental mode, so an item changed many times is split once and the ._ files up to date are not rewritten.
+    
+    o The folders created or moved into the trees are watched and split with their contents. The ._ files and the
+      temporary files of the split are not watched.
+*/
+
+#ifndef __GOLDIN_WATCH_H__
+#define __GOLDIN_WATCH_H__
+
+#include "Goldin.h"
+
+#define GOLDIN_WATCH_QUIET_PERIOD		100
+#define GOLDIN_WATCH_MAXIMUM_DELAY		500
+
+typedef struct _GoldinWatch * GoldinWatchRef;
+
+/* The options of the jobs splitting the batches. A dry run, a verification, a journal, an archive and stripping the resource
+   forks are not supported (EINVAL, the reason is sent to the error callback). Returns NULL and sets errno on failure:
+   ENOTSUP if the changes can not be watched */
+
+GoldinWatchRef GoldinWatchCreate(const GoldinJobOptions * inOptions);
+
+void GoldinWatchRelease(GoldinWatchRef inWatch);
+
+/* Watches a file or a folder and its contents. Must be called before GoldinWatchRun. Returns 0 or an errno value */
+
+int GoldinWatchAddRoot(GoldinWatchRef inWatch,const char * inPath);
+
+/* Splits the changed items until GoldinWatchStop is called. Returns 0 or an errno value */
+
+int GoldinWatchRun(GoldinWatchRef inWatch);
+
+/* Can be called from a signal handler */
+
+void GoldinWatchStop(GoldinWatchRef inWatch);
+
+/* The items split by all the batches so far */
+
+void GoldinWatchGetStatistics(GoldinWatchRef inWatch,GoldinJobStatistics * outStatistics);
+
+#endif
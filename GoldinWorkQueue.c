@@ -0,0 +1,448 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinWorkQueue.c
+              Project: goldin
+
+    Notes:
+
+    o The deques are protected by their own mutex. A lock-free deque would be faster but the tasks are directories,
+      so the cost of a mutex is lost in the noise of the catalog reads.
+*/
+
+#include "GoldinWorkQueue.h"
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+#define GOLDIN_DEQUE_INITIAL_CAPACITY	64
+
+typedef struct _GoldinDeque
+{
+	pthread_mutex_t mutex;
+
+	void ** tasks;
+	size_t capacity;
+	size_t top;			/* Index of the oldest task (steal side) */
+	size_t count;
+
+} GoldinDeque;
+
+struct _GoldinWorkQueue
+{
+	GoldinWorkQueueFunction function;
+
+	unsigned int numberOfWorkers;
+	GoldinDeque * deques;
+	pthread_t * threads;
+
+	pthread_key_t workerIndexKey;
+
+	pthread_mutex_t mutex;
+	pthread_cond_t condition;		/* Signaled when a task is added or the workers must stop */
+	pthread_cond_t doneCondition;	/* Broadcast when the last pending task is finished */
+
+	unsigned long pendingTasks;		/* Tasks added and not finished yet, protected by mutex */
+	unsigned int idleWorkers;
+	unsigned int nextDeque;			/* Round robin for tasks added by non-workers */
+	int done;
+};
+
+typedef struct _GoldinWorkerInfo
+{
+	GoldinWorkQueueRef workQueue;
+	unsigned int index;
+
+} GoldinWorkerInfo;
+
+#pragma mark -
+
+static int GoldinDequeInit(GoldinDeque * inDeque)
+{
+	inDeque->tasks=(void **) malloc(GOLDIN_DEQUE_INITIAL_CAPACITY*sizeof(void *));
+
+	if (inDeque->tasks==NULL)
+		return -1;
+
+	inDeque->capacity=GOLDIN_DEQUE_INITIAL_CAPACITY;
+	inDeque->top=0;
+	inDeque->count=0;
+
+	pthread_mutex_init(&inDeque->mutex,NULL);
+
+	return 0;
+}
+
+static void GoldinDequeDestroy(GoldinDeque * inDeque)
+{
+	pthread_mutex_destroy(&inDeque->mutex);
+
+	free(inDeque->tasks);
+}
+
+/* Returns 0 or ENOMEM if the deque is full and can not grow (the task is then not added) */
+
+static int GoldinDequePushBottom(GoldinDeque * inDeque,void * inTask)
+{
+	pthread_mutex_lock(&inDeque->mutex);
+
+	if (inDeque->count==inDeque->capacity)
+	{
+		void ** tNewTasks;
+		size_t i;
+
+		tNewTasks=(void **) malloc(inDeque->capacity*2*sizeof(void *));
+
+		if (tNewTasks==NULL)
+		{
+			pthread_mutex_unlock(&inDeque->mutex);
+
+			return ENOMEM;
+		}
+
+		for(i=0;i<inDeque->count;i++)
+			tNewTasks[i]=inDeque->tasks[(inDeque->top+i)%inDeque->capacity];
+
+		free(inDeque->tasks);
+
+		inDeque->tasks=tNewTasks;
+		inDeque->capacity*=2;
+		inDeque->top=0;
+	}
+
+	inDeque->tasks[(inDeque->top+inDeque->count)%inDeque->capacity]=inTask;
+	inDeque->count++;
+
+	pthread_mutex_unlock(&inDeque->mutex);
+
+	return 0;
+}
+
+static void * GoldinDequePopBottom(GoldinDeque * inDeque)
+{
+	void * tTask=NULL;
+
+	pthread_mutex_lock(&inDeque->mutex);
+
+	if (inDeque->count>0)
+	{
+		inDeque->count--;
+		tTask=inDeque->tasks[(inDeque->top+inDeque->count)%inDeque->capacity];
+	}
+
+	pthread_mutex_unlock(&inDeque->mutex);
+
+	return tTask;
+}
+
+static void * GoldinDequeStealTop(GoldinDeque * inDeque)
+{
+	void * tTask=NULL;
+
+	pthread_mutex_lock(&inDeque->mutex);
+
+	if (inDeque->count>0)
+	{
+		tTask=inDeque->tasks[inDeque->top];
+		inDeque->top=(inDeque->top+1)%inDeque->capacity;
+		inDeque->count--;
+	}
+
+	pthread_mutex_unlock(&inDeque->mutex);
+
+	return tTask;
+}
+
+#pragma mark -
+
+static void * GoldinWorkQueueFindTask(GoldinWorkQueueRef inWorkQueue,unsigned int inWorkerIndex)
+{
+	void * tTask;
+	unsigned int i;
+
+	/* 1. Our own deque */
+
+	tTask=GoldinDequePopBottom(&inWorkQueue->deques[inWorkerIndex]);
+
+	if (tTask!=NULL)
+		return tTask;
+
+	/* 2. Steal from the others, starting with our neighbour so that the thieves do not all hit the same deque */
+
+	for(i=1;i<inWorkQueue->numberOfWorkers;i++)
+	{
+		tTask=GoldinDequeStealTop(&inWorkQueue->deques[(inWorkerIndex+i)%inWorkQueue->numberOfWorkers]);
+
+		if (tTask!=NULL)
+			return tTask;
+	}
+
+	return NULL;
+}
+
+static void GoldinWorkQueueRunTask(GoldinWorkQueueRef inWorkQueue,void * inTask)
+{
+	inWorkQueue->function(inWorkQueue,inTask);
+
+	pthread_mutex_lock(&inWorkQueue->mutex);
+
+	inWorkQueue->pendingTasks--;
+
+	if (inWorkQueue->pendingTasks==0)
+		pthread_cond_broadcast(&inWorkQueue->doneCondition);
+
+	pthread_mutex_unlock(&inWorkQueue->mutex);
+}
+
+static void * GoldinWorkQueueWorker(void * inWorkerInfo)
+{
+	GoldinWorkerInfo * tWorkerInfo=(GoldinWorkerInfo *) inWorkerInfo;
+	GoldinWorkQueueRef tWorkQueue=tWorkerInfo->workQueue;
+	unsigned int tIndex=tWorkerInfo->index;
+
+	free(tWorkerInfo);
+
+	pthread_setspecific(tWorkQueue->workerIndexKey,(void *) (((size_t) tIndex)+1));
+
+	while (1)
+	{
+		void * tTask=GoldinWorkQueueFindTask(tWorkQueue,tIndex);
+
+		if (tTask==NULL)
+		{
+			pthread_mutex_lock(&tWorkQueue->mutex);
+
+			while (1)
+			{
+				if (tWorkQueue->done!=0)
+				{
+					pthread_mutex_unlock(&tWorkQueue->mutex);
+
+					return NULL;
+				}
+
+				/* The tasks are pushed before the mutex is taken by GoldinWorkQueueAddTask, so a task added after this scan
+				   will signal us once we are waiting */
+
+				tTask=GoldinWorkQueueFindTask(tWorkQueue,tIndex);
+
+				if (tTask!=NULL)
+					break;
+
+				tWorkQueue->idleWorkers++;
+
+				pthread_cond_wait(&tWorkQueue->condition,&tWorkQueue->mutex);
+
+				tWorkQueue->idleWorkers--;
+			}
+
+			pthread_mutex_unlock(&tWorkQueue->mutex);
+		}
+
+		GoldinWorkQueueRunTask(tWorkQueue,tTask);
+	}
+
+	return NULL;
+}
+
+static void GoldinWorkQueueStopWorkers(GoldinWorkQueueRef inWorkQueue,unsigned int inNumberOfRunningWorkers)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&inWorkQueue->mutex);
+
+	inWorkQueue->done=1;
+
+	pthread_cond_broadcast(&inWorkQueue->condition);
+
+	pthread_mutex_unlock(&inWorkQueue->mutex);
+
+	for(i=0;i<inNumberOfRunningWorkers;i++)
+		pthread_join(inWorkQueue->threads[i],NULL);
+
+	pthread_cond_destroy(&inWorkQueue->doneCondition);
+	pthread_cond_destroy(&inWorkQueue->condition);
+	pthread_mutex_destroy(&inWorkQueue->mutex);
+	pthread_key_delete(inWorkQueue->workerIndexKey);
+
+	for(i=0;i<inWorkQueue->numberOfWorkers;i++)
+		GoldinDequeDestroy(&inWorkQueue->deques[i]);
+
+	free(inWorkQueue->deques);
+	free(inWorkQueue->threads);
+	free(inWorkQueue);
+}
+
+#pragma mark -
+
+GoldinWorkQueueRef GoldinWorkQueueCreate(unsigned int inNumberOfWorkers,GoldinWorkQueueFunction inFunction)
+{
+	GoldinWorkQueueRef tWorkQueue;
+	unsigned int i;
+
+	if (inNumberOfWorkers==0 || inFunction==NULL)
+		return NULL;
+
+	tWorkQueue=(GoldinWorkQueueRef) calloc(1,sizeof(struct _GoldinWorkQueue));
+
+	if (tWorkQueue==NULL)
+		return NULL;
+
+	tWorkQueue->function=inFunction;
+	tWorkQueue->numberOfWorkers=inNumberOfWorkers;
+
+	tWorkQueue->deques=(GoldinDeque *) calloc(inNumberOfWorkers,sizeof(GoldinDeque));
+	tWorkQueue->threads=(pthread_t *) calloc(inNumberOfWorkers,sizeof(pthread_t));
+
+	if (tWorkQueue->deques==NULL || tWorkQueue->threads==NULL)
+	{
+		free(tWorkQueue->deques);
+		free(tWorkQueue->threads);
+		free(tWorkQueue);
+
+		return NULL;
+	}
+
+	for(i=0;i<inNumberOfWorkers;i++)
+	{
+		if (GoldinDequeInit(&tWorkQueue->deques[i])!=0)
+		{
+			while (i>0)
+				GoldinDequeDestroy(&tWorkQueue->deques[--i]);
+
+			free(tWorkQueue->deques);
+			free(tWorkQueue->threads);
+			free(tWorkQueue);
+
+			return NULL;
+		}
+	}
+
+	pthread_key_create(&tWorkQueue->workerIndexKey,NULL);
+	pthread_mutex_init(&tWorkQueue->mutex,NULL);
+	pthread_cond_init(&tWorkQueue->condition,NULL);
+	pthread_cond_init(&tWorkQueue->doneCondition,NULL);
+
+	for(i=0;i<inNumberOfWorkers;i++)
+	{
+		GoldinWorkerInfo * tWorkerInfo=(GoldinWorkerInfo *) malloc(sizeof(GoldinWorkerInfo));
+
+		if (tWorkerInfo!=NULL)
+		{
+			tWorkerInfo->workQueue=tWorkQueue;
+			tWorkerInfo->index=i;
+
+			if (pthread_create(&tWorkQueue->threads[i],NULL,GoldinWorkQueueWorker,tWorkerInfo)==0)
+				continue;
+
+			free(tWorkerInfo);
+		}
+
+		/* Stop the workers we already have */
+
+		GoldinWorkQueueStopWorkers(tWorkQueue,i);
+
+		return NULL;
+	}
+
+	return tWorkQueue;
+}
+
+int GoldinWorkQueueAddTask(GoldinWorkQueueRef inWorkQueue,void * inTask)
+{
+	int tWorkerIndex;
+
+	if (inWorkQueue==NULL || inTask==NULL)
+		return EINVAL;
+
+	pthread_mutex_lock(&inWorkQueue->mutex);
+
+	inWorkQueue->pendingTasks++;
+
+	tWorkerIndex=GoldinWorkQueueGetCurrentWorkerIndex(inWorkQueue);
+
+	if (tWorkerIndex<0)
+	{
+		tWorkerIndex=inWorkQueue->nextDeque;
+
+		inWorkQueue->nextDeque=(inWorkQueue->nextDeque+1)%inWorkQueue->numberOfWorkers;
+	}
+
+	pthread_mutex_unlock(&inWorkQueue->mutex);
+
+	if (GoldinDequePushBottom(&inWorkQueue->deques[tWorkerIndex],inTask)!=0)
+	{
+		/* The task was not added, the caller still owns it */
+
+		pthread_mutex_lock(&inWorkQueue->mutex);
+
+		inWorkQueue->pendingTasks--;
+
+		if (inWorkQueue->pendingTasks==0)
+			pthread_cond_broadcast(&inWorkQueue->doneCondition);
+
+		pthread_mutex_unlock(&inWorkQueue->mutex);
+
+		return ENOMEM;
+	}
+
+	pthread_mutex_lock(&inWorkQueue->mutex);
+
+	if (inWorkQueue->idleWorkers>0)
+		pthread_cond_signal(&inWorkQueue->condition);
+
+	pthread_mutex_unlock(&inWorkQueue->mutex);
+
+	return 0;
+}
+
+void GoldinWorkQueueWaitUntilDone(GoldinWorkQueueRef inWorkQueue)
+{
+	if (inWorkQueue==NULL)
+		return;
+
+	pthread_mutex_lock(&inWorkQueue->mutex);
+
+	while (inWorkQueue->pendingTasks>0)
+		pthread_cond_wait(&inWorkQueue->doneCondition,&inWorkQueue->mutex);
+
+	pthread_mutex_unlock(&inWorkQueue->mutex);
+}
+
+void GoldinWorkQueueRelease(GoldinWorkQueueRef inWorkQueue)
+{
+	if (inWorkQueue==NULL)
+		return;
+
+	GoldinWorkQueueWaitUntilDone(inWorkQueue);
+
+	GoldinWorkQueueStopWorkers(inWorkQueue,inWorkQueue->numberOfWorkers);
+}
+
+int GoldinWorkQueueGetCurrentWorkerIndex(GoldinWorkQueueRef inWorkQueue)
+{
+	size_t tValue;
+
+	if (inWorkQueue==NULL)
+		return -1;
+
+	tValue=(size_t) pthread_getspecific(inWorkQueue->workerIndexKey);
+
+	return ((int) tValue)-1;
+}
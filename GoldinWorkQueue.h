@@ -0,0 +1,56 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinWorkQueue.h
+              Project: goldin
+
+    Notes:
+
+    o A small work-stealing pool. Every worker owns a deque: it pushes and pops its own tasks at the bottom (LIFO, so a
+      tree is walked depth first and stays cache friendly) while idle workers steal from the top of the other deques.
+
+    o Tasks are opaque pointers. The task function owns the task once it has been called.
+*/
+
+#ifndef __GOLDIN_WORKQUEUE_H__
+#define __GOLDIN_WORKQUEUE_H__
+
+typedef struct _GoldinWorkQueue * GoldinWorkQueueRef;
+
+typedef void (*GoldinWorkQueueFunction)(GoldinWorkQueueRef inWorkQueue,void * inTask);
+
+/* Returns NULL if the workers could not be created */
+
+GoldinWorkQueueRef GoldinWorkQueueCreate(unsigned int inNumberOfWorkers,GoldinWorkQueueFunction inFunction);
+
+/* Can be called from any thread. When called from a worker, the task is pushed on the deque of this worker. Returns 0,
+   or ENOMEM if there is no memory left to queue the task: it is then not added and the caller still owns it */
+
+int GoldinWorkQueueAddTask(GoldinWorkQueueRef inWorkQueue,void * inTask);
+
+/* Blocks until all the tasks (including the ones added by the tasks) have been processed */
+
+void GoldinWorkQueueWaitUntilDone(GoldinWorkQueueRef inWorkQueue);
+
+void GoldinWorkQueueRelease(GoldinWorkQueueRef inWorkQueue);
+
+/* Index of the calling worker in [0, inNumberOfWorkers[, -1 if the caller is not a worker */
+
+int GoldinWorkQueueGetCurrentWorkerIndex(GoldinWorkQueueRef inWorkQueue);
+
+#endif
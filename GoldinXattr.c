@@ -0,0 +1,331 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinXattr.c
+              Project: goldin
+
+    Notes:
+
+    o There are no *xattrat calls in the C libraries. The items of a folder are reached through the folder descriptor:
+    
+      Linux: /proc/self/fd/<descriptor>/<name>, the lookup starts from the folder instead of the root of the volume
+      Otherwise (or without /proc): the item is opened relative to the folder and the f*xattr calls are used
+*/
+
+#include "GoldinXattr.h"
+
+#include "GoldinCommon.h"
+#include "GoldinCounters.h"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/xattr.h>
+
+#define GOLDIN_XATTR_LIST_BUFFER_SIZE	1024
+
+#ifdef __linux__
+
+/* 0: not checked yet, 1: available, -1: not mounted */
+
+static volatile int sProcFileSystemState=0;
+
+#endif
+
+ssize_t GoldinXattrGet(const char * inPath,const char * inName,void * outValue,size_t inSize)
+{
+	GoldinCounterIncrement(kGoldinCounterAttributeReads);
+	
+#ifdef __APPLE__
+	return getxattr(inPath,inName,outValue,inSize,0,XATTR_NOFOLLOW);
+#else
+	return lgetxattr(inPath,inName,outValue,inSize);
+#endif
+}
+
+ssize_t GoldinXattrSet(const char * inPath,const char * inName,const void * inValue,size_t inSize)
+{
+#ifdef __APPLE__
+	return setxattr(inPath,inName,inValue,inSize,0,XATTR_NOFOLLOW);
+#else
+	return lsetxattr(inPath,inName,inValue,inSize,0);
+#endif
+}
+
+int GoldinXattrRemove(const char * inPath,const char * inName)
+{
+#ifdef __APPLE__
+	return removexattr(inPath,inName,XATTR_NOFOLLOW);
+#else
+	return lremovexattr(inPath,inName);
+#endif
+}
+
+/* The item is either inPath or inDescriptor (when it is not -1) */
+
+static ssize_t GoldinXattrListItem(const char * inPath,int inDescriptor,char * outNames,size_t inSize)
+{
+	GoldinCounterIncrement(kGoldinCounterAttributeReads);
+	
+#ifdef __APPLE__
+	if (inDescriptor!=-1)
+		return flistxattr(inDescriptor,outNames,inSize,0);
+	
+	return listxattr(inPath,outNames,inSize,XATTR_NOFOLLOW);
+#else
+	if (inDescriptor!=-1)
+		return flistxattr(inDescriptor,outNames,inSize);
+	
+	return llistxattr(inPath,outNames,inSize);
+#endif
+}
+
+static ssize_t GoldinXattrGetItem(const char * inPath,int inDescriptor,const char * inName,void * outValue,size_t inSize)
+{
+	if (inDescriptor==-1)
+		return GoldinXattrGet(inPath,inName,outValue,inSize);
+	
+	GoldinCounterIncrement(kGoldinCounterAttributeReads);
+	
+#ifdef __APPLE__
+	return fgetxattr(inDescriptor,inName,outValue,inSize,0,0);
+#else
+	return fgetxattr(inDescriptor,inName,outValue,inSize);
+#endif
+}
+
+/* Returns 0 if the l*xattr calls can be used with outPath, -1 if the item needs to be opened */
+
+static int GoldinXattrMakeRelativePath(int inDirectoryDescriptor,const char * inPath,char * outPath,size_t inSize)
+{
+	if (inDirectoryDescriptor==AT_FDCWD || inPath[0]=='/')
+	{
+		if (strlen(inPath)>=inSize)
+			return -1;
+		
+		strcpy(outPath,inPath);
+		
+		return 0;
+	}
+	
+#ifdef __linux__
+	if (sProcFileSystemState==0)
+		sProcFileSystemState=(access("/proc/self/fd",X_OK)==0) ? 1 : -1;
+	
+	if (sProcFileSystemState==1)
+	{
+		int tLength=snprintf(outPath,inSize,"/proc/self/fd/%d/%s",inDirectoryDescriptor,inPath);
+		
+		if (tLength>0 && (size_t) tLength<inSize)
+			return 0;
+	}
+#endif
+	
+	return -1;
+}
+
+static int GoldinXattrOpenItem(int inDirectoryDescriptor,const char * inPath)
+{
+	/* Only regular files and folders have the attributes we are looking for */
+	
+	return openat(inDirectoryDescriptor,inPath,O_RDONLY|O_NOFOLLOW|O_NONBLOCK|O_CLOEXEC);
+}
+
+static void GoldinXattrCloseItem(int inDescriptor)
+{
+	int tError=errno;
+	
+	close(inDescriptor);
+	
+	errno=tError;
+}
+
+static int GoldinXattrReadItemMetadata(const char * inPath,int inDescriptor,uint8_t outFinderInfo[32],int64_t * outResourceForkSize)
+{
+	char tStaticNames[GOLDIN_XATTR_LIST_BUFFER_SIZE];
+	char * tNames=tStaticNames;
+	ssize_t tNamesSize;
+	Boolean tHasFinderInfo=FALSE;
+	Boolean tHasResourceFork=FALSE;
+	ssize_t tOffset;
+	int tResult=0;
+	
+	memset(outFinderInfo,0,32);
+	*outResourceForkSize=0;
+	
+	tNamesSize=GoldinXattrListItem(inPath,inDescriptor,tNames,GOLDIN_XATTR_LIST_BUFFER_SIZE);
+	
+	if (tNamesSize<0 && errno==ERANGE)
+	{
+		/* A lot of attributes */
+		
+		tNamesSize=GoldinXattrListItem(inPath,inDescriptor,NULL,0);
+		
+		if (tNamesSize>0)
+		{
+			tNames=(char *) malloc(tNamesSize);
+			
+			if (tNames==NULL)
+				return -1;
+			
+			tNamesSize=GoldinXattrListItem(inPath,inDescriptor,tNames,tNamesSize);
+		}
+	}
+	
+	if (tNamesSize<0)
+	{
+		switch(errno)
+		{
+			case ENOTSUP:
+#if ENOTSUP!=EOPNOTSUPP
+			case EOPNOTSUPP:
+#endif
+				/* No extended attributes on this file system or for this kind of item (e.g. symbolic links on Linux) */
+				
+				tNamesSize=0;
+				break;
+			
+			default:
+				
+				tResult=-1;
+				break;
+		}
+	}
+	
+	for(tOffset=0;tOffset<tNamesSize;tOffset+=strlen(tNames+tOffset)+1)
+	{
+		if (strcmp(tNames+tOffset,GOLDIN_XATTR_FINDERINFO)==0)
+			tHasFinderInfo=TRUE;
+		else if (strcmp(tNames+tOffset,GOLDIN_XATTR_RESOURCEFORK)==0)
+			tHasResourceFork=TRUE;
+	}
+	
+	if (tNames!=tStaticNames)
+		free(tNames);
+	
+	if (tResult!=0)
+		return tResult;
+	
+	if (tHasFinderInfo==TRUE)
+	{
+		uint8_t tFinderInfo[32];
+		ssize_t tSize=GoldinXattrGetItem(inPath,inDescriptor,GOLDIN_XATTR_FINDERINFO,tFinderInfo,32);
+		
+		if (tSize>0)
+		{
+			memcpy(outFinderInfo,tFinderInfo,tSize);
+		}
+		else if (tSize<0 && errno!=GOLDIN_XATTR_NOT_FOUND)
+		{
+			return -1;
+		}
+	}
+	
+	if (tHasResourceFork==TRUE)
+	{
+		ssize_t tSize=GoldinXattrGetItem(inPath,inDescriptor,GOLDIN_XATTR_RESOURCEFORK,NULL,0);
+		
+		if (tSize>0)
+		{
+			*outResourceForkSize=tSize;
+		}
+		else if (tSize<0 && errno!=GOLDIN_XATTR_NOT_FOUND)
+		{
+			return -1;
+		}
+	}
+	
+	return 0;
+}
+
+int GoldinXattrReadMetadata(const char * inPath,uint8_t outFinderInfo[32],int64_t * outResourceForkSize)
+{
+	return GoldinXattrReadItemMetadata(inPath,-1,outFinderInfo,outResourceForkSize);
+}
+
+#pragma mark -
+
+ssize_t GoldinXattrGetAt(int inDirectoryDescriptor,const char * inPath,const char * inName,void * outValue,size_t inSize)
+{
+	char tPath[PATH_MAX];
+	int tDescriptor;
+	ssize_t tSize;
+	
+	if (GoldinXattrMakeRelativePath(inDirectoryDescriptor,inPath,tPath,PATH_MAX)==0)
+		return GoldinXattrGet(tPath,inName,outValue,inSize);
+	
+	tDescriptor=GoldinXattrOpenItem(inDirectoryDescriptor,inPath);
+	
+	if (tDescriptor==-1)
+		return -1;
+	
+	tSize=GoldinXattrGetItem(NULL,tDescriptor,inName,outValue,inSize);
+	
+	GoldinXattrCloseItem(tDescriptor);
+	
+	return tSize;
+}
+
+int GoldinXattrRemoveAt(int inDirectoryDescriptor,const char * inPath,const char * inName)
+{
+	char tPath[PATH_MAX];
+	int tDescriptor;
+	int tResult;
+	
+	if (GoldinXattrMakeRelativePath(inDirectoryDescriptor,inPath,tPath,PATH_MAX)==0)
+		return GoldinXattrRemove(tPath,inName);
+	
+	tDescriptor=GoldinXattrOpenItem(inDirectoryDescriptor,inPath);
+	
+	if (tDescriptor==-1)
+		return -1;
+	
+#ifdef __APPLE__
+	tResult=fremovexattr(tDescriptor,inName,0);
+#else
+	tResult=fremovexattr(tDescriptor,inName);
+#endif
+	
+	GoldinXattrCloseItem(tDescriptor);
+	
+	return tResult;
+}
+
+int GoldinXattrReadMetadataAt(int inDirectoryDescriptor,const char * inPath,uint8_t outFinderInfo[32],int64_t * outResourceForkSize)
+{
+	char tPath[PATH_MAX];
+	int tDescriptor;
+	int tResult;
+	
+	if (GoldinXattrMakeRelativePath(inDirectoryDescriptor,inPath,tPath,PATH_MAX)==0)
+		return GoldinXattrReadItemMetadata(tPath,-1,outFinderInfo,outResourceForkSize);
+	
+	tDescriptor=GoldinXattrOpenItem(inDirectoryDescriptor,inPath);
+	
+	if (tDescriptor==-1)
+		return -1;
+	
+	tResult=GoldinXattrReadItemMetadata(NULL,tDescriptor,outFinderInfo,outResourceForkSize);
+	
+	GoldinXattrCloseItem(tDescriptor);
+	
+	return tResult;
+}
@@ -0,0 +1,74 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: GoldinXattr.h
+              Project: goldin
+
+    Notes:
+
+    o The resource fork and the FinderInfo as extended attributes. Mac OS X exposes them as com.apple.ResourceFork
+      and com.apple.FinderInfo; on Linux they are stored (by netatalk, rsync -X, ...) in the user namespace.
+    
+    o The symbolic links are never followed.
+*/
+
+#ifndef __GOLDIN_XATTR_H__
+#define __GOLDIN_XATTR_H__
+
+#include <errno.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __APPLE__
+
+#define GOLDIN_XATTR_FINDERINFO			"com.apple.FinderInfo"
+#define GOLDIN_XATTR_RESOURCEFORK		"com.apple.ResourceFork"
+
+#define GOLDIN_XATTR_NOT_FOUND			ENOATTR
+
+#else
+
+#define GOLDIN_XATTR_FINDERINFO			"user.com.apple.FinderInfo"
+#define GOLDIN_XATTR_RESOURCEFORK		"user.com.apple.ResourceFork"
+
+#define GOLDIN_XATTR_NOT_FOUND			ENODATA
+
+#endif
+
+/* Same as getxattr(2), with a NULL buffer the size of the attribute is returned */
+
+ssize_t GoldinXattrGet(const char * inPath,const char * inName,void * outValue,size_t inSize);
+
+ssize_t GoldinXattrSet(const char * inPath,const char * inName,const void * inValue,size_t inSize);
+
+int GoldinXattrRemove(const char * inPath,const char * inName);
+
+/* FinderInfo (zeroed if there is none) and size of the resource fork (0 if there is none) of an item.
+   Returns 0 on success, -1 and sets errno on failure */
+
+int GoldinXattrReadMetadata(const char * inPath,uint8_t outFinderInfo[32],int64_t * outResourceForkSize);
+
+/* Same as above for an item of a folder: inPath is relative to inDirectoryDescriptor (or absolute with AT_FDCWD) */
+
+ssize_t GoldinXattrGetAt(int inDirectoryDescriptor,const char * inPath,const char * inName,void * outValue,size_t inSize);
+
+int GoldinXattrRemoveAt(int inDirectoryDescriptor,const char * inPath,const char * inName);
+
+int GoldinXattrReadMetadataAt(int inDirectoryDescriptor,const char * inPath,uint8_t outFinderInfo[32],int64_t * outResourceForkSize);
+
+#endif
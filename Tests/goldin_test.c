@@ -0,0 +1,1144 @@
+/*
+Copyright (c) 2006-2014, Stephane Sudre
+All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that the following conditions are met:
+
+- Redistributions of source code must retain the above copyright notice, this list of conditions and the following disclaimer.
+- Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following disclaimer in the documentation and/or other materials provided with the distribution.
+- Neither the name of the WhiteBox nor the names of its contributors may be used to endorse or promote products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY 
+AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF
+SUCH DAMAGE.
+*/
+
+/*
+            File Name: goldin_test.c
+              Project: goldin
+
+    Notes:
+
+    o Checks the behaviour of the split engine. Every test prints ok or FAILED with the reason, the exit status is the
+      number of tests that failed. The names of the tests to run can be given, all of them are run otherwise:
+    
+      appledouble-header   the header of a file and of a folder, with and without a resource fork, byte for byte
+                           against the header SplitForks wrote one field at a time
+      appledouble-file     the ._ files written for a file and a folder, byte for byte
+      parallel-split       a tree split with workers gets the same ._ files as when it is split on the calling thread
+      dedup-split          the ._ files shared with identical ones have the contents they would have been written with
+      journal-checkpoints  with checkpoints, a resumed run finds every record of the journal
+      temporary-files      only the temporary files of a run of this host that died are removed
+      archive-hard-links   the links of a file are archived once, the others as tar hard links
+      option-conflicts     the options that can not be combined are rejected with EINVAL and the reason
+    
+    o The trees are created in a temporary folder (/tmp by default, see -o) with the FinderInfo and the resource forks
+      as extended attributes (user.com.apple.* on Linux): the file system must support them. The resource forks are
+      kept small enough to fit in an extended attribute on ext4.
+    
+    o To build it:
+    
+      Linux:     cc -O2 -I.. -o goldin_test goldin_test.c ../Goldin*.c -lpthread
+      Mac OS X:  cc -O2 -I.. -o goldin_test goldin_test.c ../Goldin*.c -framework CoreServices
+*/
+
+#include "Goldin.h"
+#include "GoldinAppleDouble.h"
+#include "GoldinBackend.h"
+#include "GoldinXattr.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+typedef int (*GoldinTestFunction)(const char * inFolderPath);
+
+typedef struct _GoldinTest
+{
+	const char * name;
+	GoldinTestFunction function;
+	
+} GoldinTest;
+
+/* The reason of the last failure */
+
+static char sFailure[PATH_MAX*2+256];
+
+static int GoldinTestFail(const char * inFormat,...)
+{
+	va_list tArguments;
+	
+	va_start(tArguments,inFormat);
+	vsnprintf(sFailure,sizeof(sFailure),inFormat,tArguments);
+	va_end(tArguments);
+	
+	return -1;
+}
+
+#pragma mark -
+
+/* FinderInfo of a file: type TEXT, creator ttxt, kHasBeenInited */
+
+static const uint8_t sFileFinderInfo[GOLDIN_APPLEDOUBLE_FINDERINFO_SIZE]=
+{
+	0x54,0x45,0x58,0x54,0x74,0x74,0x78,0x74,0x01,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
+};
+
+/* FinderInfo of a folder: window rectangle (16,32,256,512), kHasCustomIcon, location (8,8) */
+
+static const uint8_t sFolderFinderInfo[GOLDIN_APPLEDOUBLE_FINDERINFO_SIZE]=
+{
+	0x00,0x10,0x00,0x20,0x01,0x00,0x02,0x00,0x04,0x00,0x00,0x08,0x00,0x08,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00
+};
+
+#define GOLDIN_TEST_FILE_RESOURCEFORK_SIZE		0x00000A3C
+#define GOLDIN_TEST_FOLDER_RESOURCEFORK_SIZE	0x00000123
+
+/* What SplitForks wrote before the header was assembled in memory: magic number, version, filler, number of entries,
+   FinderInfo entry (9, 0x32, 32), resource fork entry (2, 0x52, length), FinderInfo */
+
+static const uint8_t sFileHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE]=
+{
+	0x00,0x05,0x16,0x07,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x09,0x00,0x00,
+	0x00,0x32,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x52,0x00,0x00,
+	0x00,0x00,0x54,0x45,0x58,0x54,0x74,0x74,0x78,0x74,0x01,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00
+};
+
+static const uint8_t sFileWithResourceForkHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE]=
+{
+	0x00,0x05,0x16,0x07,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x09,0x00,0x00,
+	0x00,0x32,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x52,0x00,0x00,
+	0x0A,0x3C,0x54,0x45,0x58,0x54,0x74,0x74,0x78,0x74,0x01,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00
+};
+
+static const uint8_t sFolderHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE]=
+{
+	0x00,0x05,0x16,0x07,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x09,0x00,0x00,
+	0x00,0x32,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x52,0x00,0x00,
+	0x00,0x00,0x00,0x10,0x00,0x20,0x01,0x00,0x02,0x00,0x04,0x00,0x00,0x08,0x00,0x08,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00
+};
+
+static const uint8_t sFolderWithResourceForkHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE]=
+{
+	0x00,0x05,0x16,0x07,0x00,0x02,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x09,0x00,0x00,
+	0x00,0x32,0x00,0x00,0x00,0x20,0x00,0x00,0x00,0x02,0x00,0x00,0x00,0x52,0x00,0x00,
+	0x01,0x23,0x00,0x10,0x00,0x20,0x01,0x00,0x02,0x00,0x04,0x00,0x00,0x08,0x00,0x08,
+	0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,
+	0x00,0x00
+};
+
+static int GoldinTestCompareBytes(const char * inWhat,const uint8_t * inBytes,const uint8_t * inExpectedBytes,size_t inSize)
+{
+	size_t i;
+	
+	for(i=0;i<inSize;i++)
+	{
+		if (inBytes[i]!=inExpectedBytes[i])
+			return GoldinTestFail("%s: byte 0x%02lx is 0x%02x instead of 0x%02x",inWhat,(unsigned long) i,inBytes[i],inExpectedBytes[i]);
+	}
+	
+	return 0;
+}
+
+/* The contents of a resource fork, different for every size */
+
+static void GoldinTestFillResourceFork(uint8_t * outBytes,size_t inSize)
+{
+	size_t i;
+	
+	for(i=0;i<inSize;i++)
+		outBytes[i]=(uint8_t) ((i*7+inSize)^(i>>8));
+}
+
+static int GoldinTestEncodeHeader(const char * inFolderPath)
+{
+	uint8_t tHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE];
+	uint8_t tResourceFork[GOLDIN_TEST_FILE_RESOURCEFORK_SIZE];
+	uint8_t tAppleDouble[GOLDIN_APPLEDOUBLE_HEADER_SIZE+GOLDIN_TEST_FILE_RESOURCEFORK_SIZE];
+	size_t tSize;
+	
+	(void) inFolderPath;
+	
+	GoldinAppleDoubleEncodeHeader(tHeader,sFileFinderInfo,0);
+	
+	if (GoldinTestCompareBytes("file",tHeader,sFileHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE)!=0)
+		return -1;
+	
+	GoldinAppleDoubleEncodeHeader(tHeader,sFileFinderInfo,GOLDIN_TEST_FILE_RESOURCEFORK_SIZE);
+	
+	if (GoldinTestCompareBytes("file with a resource fork",tHeader,sFileWithResourceForkHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE)!=0)
+		return -1;
+	
+	GoldinAppleDoubleEncodeHeader(tHeader,sFolderFinderInfo,0);
+	
+	if (GoldinTestCompareBytes("folder",tHeader,sFolderHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE)!=0)
+		return -1;
+	
+	GoldinAppleDoubleEncodeHeader(tHeader,sFolderFinderInfo,GOLDIN_TEST_FOLDER_RESOURCEFORK_SIZE);
+	
+	if (GoldinTestCompareBytes("folder with a resource fork",tHeader,sFolderWithResourceForkHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE)!=0)
+		return -1;
+	
+	/* The whole file built in memory */
+	
+	GoldinTestFillResourceFork(tResourceFork,sizeof(tResourceFork));
+	
+	if (GoldinAppleDoubleEncode(sFileFinderInfo,tResourceFork,sizeof(tResourceFork),tAppleDouble,sizeof(tAppleDouble),&tSize)!=0 || tSize!=sizeof(tAppleDouble))
+		return GoldinTestFail("GoldinAppleDoubleEncode failed");
+	
+	if (GoldinTestCompareBytes("encoded file",tAppleDouble,sFileWithResourceForkHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE)!=0 ||
+		GoldinTestCompareBytes("encoded resource fork",tAppleDouble+GOLDIN_APPLEDOUBLE_HEADER_SIZE,tResourceFork,sizeof(tResourceFork))!=0)
+		return -1;
+	
+	if (GoldinAppleDoubleEncode(sFileFinderInfo,tResourceFork,sizeof(tResourceFork),tAppleDouble,sizeof(tAppleDouble)-1,&tSize)!=ENOSPC || tSize!=sizeof(tAppleDouble))
+		return GoldinTestFail("GoldinAppleDoubleEncode did not report that the buffer is too small");
+	
+	return 0;
+}
+
+#pragma mark -
+
+static int GoldinTestMakePath(char outPath[PATH_MAX],const char * inFolderPath,const char * inName)
+{
+	if (snprintf(outPath,PATH_MAX,"%s/%s",inFolderPath,inName)>=PATH_MAX)
+		return GoldinTestFail("%s/%s: path too long",inFolderPath,inName);
+	
+	return 0;
+}
+
+static int GoldinTestSetMetadata(const char * inPath,const uint8_t * inFinderInfo,size_t inResourceForkSize)
+{
+	if (inFinderInfo!=NULL && GoldinXattrSet(inPath,GOLDIN_XATTR_FINDERINFO,inFinderInfo,GOLDIN_APPLEDOUBLE_FINDERINFO_SIZE)!=0)
+		return GoldinTestFail("Unable to set the FinderInfo of %s (%s)",inPath,strerror(errno));
+	
+	if (inResourceForkSize>0)
+	{
+		uint8_t * tBytes=(uint8_t *) malloc(inResourceForkSize);
+		
+		if (tBytes==NULL)
+			return GoldinTestFail("Out of memory");
+		
+		GoldinTestFillResourceFork(tBytes,inResourceForkSize);
+		
+		if (GoldinXattrSet(inPath,GOLDIN_XATTR_RESOURCEFORK,tBytes,inResourceForkSize)!=0)
+		{
+			free(tBytes);
+			
+			return GoldinTestFail("Unable to set the resource fork of %s (%s)",inPath,strerror(errno));
+		}
+		
+		free(tBytes);
+	}
+	
+	return 0;
+}
+
+/* inFinderInfo can be NULL */
+
+static int GoldinTestCreateFile(const char * inPath,const uint8_t * inFinderInfo,size_t inResourceForkSize)
+{
+	int tDescriptor;
+	
+	tDescriptor=open(inPath,O_WRONLY|O_CREAT|O_EXCL,S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+	
+	if (tDescriptor==-1)
+		return GoldinTestFail("Unable to create %s (%s)",inPath,strerror(errno));
+	
+	if (write(tDescriptor,"goldin\n",7)!=7)
+	{
+		close(tDescriptor);
+		
+		return GoldinTestFail("Unable to write %s (%s)",inPath,strerror(errno));
+	}
+	
+	close(tDescriptor);
+	
+	return GoldinTestSetMetadata(inPath,inFinderInfo,inResourceForkSize);
+}
+
+static int GoldinTestCreateFolder(const char * inPath,const uint8_t * inFinderInfo,size_t inResourceForkSize)
+{
+	if (mkdir(inPath,S_IRWXU|S_IRGRP|S_IXGRP|S_IROTH|S_IXOTH)!=0)
+		return GoldinTestFail("Unable to create %s (%s)",inPath,strerror(errno));
+	
+	return GoldinTestSetMetadata(inPath,inFinderInfo,inResourceForkSize);
+}
+
+/* A folder with files and folders, some with FinderInfo, some with a resource fork, some with nothing. The same tree is
+   created every time */
+
+#define GOLDIN_TEST_TREE_DEPTH				2
+#define GOLDIN_TEST_TREE_SPLIT_ITEMS		166		/* 13 folders of 12 files to split, and 10 of the folders */
+
+static int GoldinTestCreateTree(const char * inPath,int inDepth)
+{
+	char tPath[PATH_MAX];
+	char tName[NAME_MAX];
+	int i;
+	
+	if (GoldinTestCreateFolder(inPath,((inDepth%2)==0) ? sFolderFinderInfo : NULL,0)!=0)
+		return -1;
+	
+	for(i=0;i<24;i++)
+	{
+		snprintf(tName,sizeof(tName),"file_%d",i);
+		
+		if (GoldinTestMakePath(tPath,inPath,tName)!=0 ||
+			GoldinTestCreateFile(tPath,((i%3)==0) ? sFileFinderInfo : NULL,((i%4)==0) ? (size_t) (100+i*113+inDepth*7) : 0)!=0)
+			return -1;
+	}
+	
+	if (inDepth==0)
+		return 0;
+	
+	for(i=0;i<3;i++)
+	{
+		snprintf(tName,sizeof(tName),"folder_%d",i);
+		
+		if (GoldinTestMakePath(tPath,inPath,tName)!=0 || GoldinTestCreateTree(tPath,inDepth-1)!=0)
+			return -1;
+	}
+	
+	return 0;
+}
+
+static int GoldinTestRemoveTree(const char * inPath)
+{
+	char tCommand[PATH_MAX+16];
+	
+	if (snprintf(tCommand,sizeof(tCommand),"rm -rf '%s'",inPath)>=(int) sizeof(tCommand))
+		return -1;
+	
+	return system(tCommand);
+}
+
+static int GoldinTestReadFile(const char * inPath,uint8_t * outBytes,size_t inSize,size_t * outSize)
+{
+	ssize_t tRead;
+	int tDescriptor;
+	
+	tDescriptor=open(inPath,O_RDONLY|O_NOFOLLOW);
+	
+	if (tDescriptor==-1)
+		return GoldinTestFail("Unable to open %s (%s)",inPath,strerror(errno));
+	
+	tRead=read(tDescriptor,outBytes,inSize);
+	
+	close(tDescriptor);
+	
+	if (tRead<0)
+		return GoldinTestFail("Unable to read %s (%s)",inPath,strerror(errno));
+	
+	*outSize=(size_t) tRead;
+	
+	return 0;
+}
+
+/* Every item of inPath must be in inOtherPath with the same type, permissions and contents, and the other way round */
+
+static int GoldinTestCompareTrees(const char * inPath,const char * inOtherPath)
+{
+	DIR * tDirectory;
+	struct dirent * tDirectoryEntry;
+	long tCount=0;
+	long tOtherCount=0;
+	int tError=0;
+	
+	tDirectory=opendir(inPath);
+	
+	if (tDirectory==NULL)
+		return GoldinTestFail("Unable to list %s (%s)",inPath,strerror(errno));
+	
+	while (tError==0 && (tDirectoryEntry=readdir(tDirectory))!=NULL)
+	{
+		char tPath[PATH_MAX];
+		char tOtherPath[PATH_MAX];
+		struct stat tStat;
+		struct stat tOtherStat;
+		
+		if (strcmp(tDirectoryEntry->d_name,".")==0 || strcmp(tDirectoryEntry->d_name,"..")==0)
+			continue;
+		
+		tCount++;
+		
+		if (GoldinTestMakePath(tPath,inPath,tDirectoryEntry->d_name)!=0 || GoldinTestMakePath(tOtherPath,inOtherPath,tDirectoryEntry->d_name)!=0)
+		{
+			tError=-1;
+			break;
+		}
+		
+		if (lstat(tPath,&tStat)!=0)
+		{
+			tError=GoldinTestFail("Unable to get the attributes of %s (%s)",tPath,strerror(errno));
+			break;
+		}
+		
+		if (lstat(tOtherPath,&tOtherStat)!=0)
+		{
+			tError=GoldinTestFail("%s is missing",tOtherPath);
+			break;
+		}
+		
+		if ((tStat.st_mode & S_IFMT)!=(tOtherStat.st_mode & S_IFMT) || (tStat.st_mode & 07777)!=(tOtherStat.st_mode & 07777))
+		{
+			tError=GoldinTestFail("%s and %s do not have the same type or permissions",tPath,tOtherPath);
+			break;
+		}
+		
+		if (S_ISDIR(tStat.st_mode))
+		{
+			tError=GoldinTestCompareTrees(tPath,tOtherPath);
+		}
+		else if (S_ISREG(tStat.st_mode))
+		{
+			uint8_t * tBytes;
+			uint8_t * tOtherBytes;
+			size_t tSize=0;
+			size_t tOtherSize=0;
+			
+			if (tStat.st_size!=tOtherStat.st_size)
+			{
+				tError=GoldinTestFail("%s and %s do not have the same size",tPath,tOtherPath);
+				break;
+			}
+			
+			tBytes=(uint8_t *) malloc((size_t) tStat.st_size+1);
+			tOtherBytes=(uint8_t *) malloc((size_t) tStat.st_size+1);
+			
+			if (tBytes==NULL || tOtherBytes==NULL)
+				tError=GoldinTestFail("Out of memory");
+			else if (GoldinTestReadFile(tPath,tBytes,(size_t) tStat.st_size+1,&tSize)!=0 || GoldinTestReadFile(tOtherPath,tOtherBytes,(size_t) tStat.st_size+1,&tOtherSize)!=0)
+				tError=-1;
+			else if (tSize!=tOtherSize || memcmp(tBytes,tOtherBytes,tSize)!=0)
+				tError=GoldinTestFail("%s and %s are different",tPath,tOtherPath);
+			
+			free(tBytes);
+			free(tOtherBytes);
+		}
+	}
+	
+	closedir(tDirectory);
+	
+	if (tError!=0)
+		return tError;
+	
+	/* Nothing more in the other folder */
+	
+	tDirectory=opendir(inOtherPath);
+	
+	if (tDirectory==NULL)
+		return GoldinTestFail("Unable to list %s (%s)",inOtherPath,strerror(errno));
+	
+	while ((tDirectoryEntry=readdir(tDirectory))!=NULL)
+	{
+		if (strcmp(tDirectoryEntry->d_name,".")!=0 && strcmp(tDirectoryEntry->d_name,"..")!=0)
+			tOtherCount++;
+	}
+	
+	closedir(tDirectory);
+	
+	if (tCount!=tOtherCount)
+		return GoldinTestFail("%s has %ld items, %s has %ld",inPath,tCount,inOtherPath,tOtherCount);
+	
+	return 0;
+}
+
+static void GoldinTestErrorCallback(const char * inMessage,void * inContext)
+{
+	(void) inContext;
+	
+	GoldinTestFail("%s",inMessage);
+}
+
+/* Splits the item with the options, which can be NULL for the default ones. Fails if any error is reported */
+
+static int GoldinTestSplit(const char * inPath,const GoldinJobOptions * inOptions,GoldinJobStatistics * outStatistics)
+{
+	GoldinJobOptions tOptions;
+	GoldinJobRef tJob;
+	int tError;
+	
+	if (inOptions!=NULL)
+		tOptions=*inOptions;
+	else
+		GoldinJobOptionsInitialize(&tOptions);
+	
+	tOptions.backendName=kGoldinXattrBackend.name;
+	tOptions.errorCallback=GoldinTestErrorCallback;
+	
+	sFailure[0]='\0';
+	
+	tJob=GoldinJobCreate(&tOptions);
+	
+	if (tJob==NULL)
+		return GoldinTestFail("Unable to create the job (%s)",strerror(errno));
+	
+	tError=GoldinJobSplit(tJob,inPath);
+	
+	if (GoldinJobFinish(tJob)!=0 && tError==0)
+		tError=EIO;
+	
+	if (outStatistics!=NULL)
+		GoldinJobGetStatistics(tJob,outStatistics);
+	
+	GoldinJobRelease(tJob);
+	
+	if (tError!=0)
+		return (sFailure[0]!='\0') ? -1 : GoldinTestFail("Unable to split %s (%s)",inPath,strerror(tError));
+	
+	return (sFailure[0]!='\0') ? -1 : 0;
+}
+
+#pragma mark -
+
+static int GoldinTestWriteAppleDouble(const char * inFolderPath)
+{
+	char tFilePath[PATH_MAX];
+	char tFolderPath[PATH_MAX];
+	char tAppleDoublePath[PATH_MAX];
+	uint8_t tBytes[GOLDIN_APPLEDOUBLE_HEADER_SIZE+GOLDIN_TEST_FILE_RESOURCEFORK_SIZE+1];
+	uint8_t tResourceFork[GOLDIN_TEST_FILE_RESOURCEFORK_SIZE];
+	size_t tSize;
+	
+	if (GoldinTestMakePath(tFolderPath,inFolderPath,"folder")!=0 || GoldinTestCreateFolder(tFolderPath,sFolderFinderInfo,0)!=0)
+		return -1;
+	
+	if (GoldinTestMakePath(tFilePath,tFolderPath,"file")!=0 || GoldinTestCreateFile(tFilePath,sFileFinderInfo,GOLDIN_TEST_FILE_RESOURCEFORK_SIZE)!=0)
+		return -1;
+	
+	if (GoldinTestSplit(tFolderPath,NULL,NULL)!=0)
+		return -1;
+	
+	/* The file */
+	
+	if (GoldinTestMakePath(tAppleDoublePath,tFolderPath,"._file")!=0 || GoldinTestReadFile(tAppleDoublePath,tBytes,sizeof(tBytes),&tSize)!=0)
+		return -1;
+	
+	if (tSize!=GOLDIN_APPLEDOUBLE_HEADER_SIZE+GOLDIN_TEST_FILE_RESOURCEFORK_SIZE)
+		return GoldinTestFail("%s is %lu bytes long instead of %lu",tAppleDoublePath,(unsigned long) tSize,(unsigned long) (GOLDIN_APPLEDOUBLE_HEADER_SIZE+GOLDIN_TEST_FILE_RESOURCEFORK_SIZE));
+	
+	GoldinTestFillResourceFork(tResourceFork,sizeof(tResourceFork));
+	
+	if (GoldinTestCompareBytes(tAppleDoublePath,tBytes,sFileWithResourceForkHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE)!=0 ||
+		GoldinTestCompareBytes(tAppleDoublePath,tBytes+GOLDIN_APPLEDOUBLE_HEADER_SIZE,tResourceFork,sizeof(tResourceFork))!=0)
+		return -1;
+	
+	/* The folder */
+	
+	if (GoldinTestMakePath(tAppleDoublePath,inFolderPath,"._folder")!=0 || GoldinTestReadFile(tAppleDoublePath,tBytes,sizeof(tBytes),&tSize)!=0)
+		return -1;
+	
+	if (tSize!=GOLDIN_APPLEDOUBLE_HEADER_SIZE)
+		return GoldinTestFail("%s is %lu bytes long instead of %lu",tAppleDoublePath,(unsigned long) tSize,(unsigned long) GOLDIN_APPLEDOUBLE_HEADER_SIZE);
+	
+	return GoldinTestCompareBytes(tAppleDoublePath,tBytes,sFolderHeader,GOLDIN_APPLEDOUBLE_HEADER_SIZE);
+}
+
+static int GoldinTestParallelSplit(const char * inFolderPath)
+{
+	char tSerialPath[PATH_MAX];
+	char tParallelPath[PATH_MAX];
+	char tRootPath[PATH_MAX];
+	GoldinJobOptions tOptions;
+	GoldinJobStatistics tStatistics;
+	
+	if (GoldinTestMakePath(tSerialPath,inFolderPath,"serial")!=0 || GoldinTestCreateFolder(tSerialPath,NULL,0)!=0 ||
+		GoldinTestMakePath(tRootPath,tSerialPath,"root")!=0 || GoldinTestCreateTree(tRootPath,GOLDIN_TEST_TREE_DEPTH)!=0)
+		return -1;
+	
+	if (GoldinTestSplit(tRootPath,NULL,&tStatistics)!=0)
+		return -1;
+	
+	if (tStatistics.splitItems!=GOLDIN_TEST_TREE_SPLIT_ITEMS)
+		return GoldinTestFail("%llu ._ files written on the calling thread instead of %d",(unsigned long long) tStatistics.splitItems,GOLDIN_TEST_TREE_SPLIT_ITEMS);
+	
+	if (GoldinTestMakePath(tParallelPath,inFolderPath,"parallel")!=0 || GoldinTestCreateFolder(tParallelPath,NULL,0)!=0 ||
+		GoldinTestMakePath(tRootPath,tParallelPath,"root")!=0 || GoldinTestCreateTree(tRootPath,GOLDIN_TEST_TREE_DEPTH)!=0)
+		return -1;
+	
+	GoldinJobOptionsInitialize(&tOptions);
+	
+	tOptions.numberOfWorkers=4;
+	
+	if (GoldinTestSplit(tRootPath,&tOptions,&tStatistics)!=0)
+		return -1;
+	
+	if (tStatistics.splitItems!=GOLDIN_TEST_TREE_SPLIT_ITEMS)
+		return GoldinTestFail("%llu ._ files written by the workers instead of %d",(unsigned long long) tStatistics.splitItems,GOLDIN_TEST_TREE_SPLIT_ITEMS);
+	
+	return GoldinTestCompareTrees(tSerialPath,tParallelPath);
+}
+
+/* The ._ files shared with identical ones must have the contents they would have been written with */
+
+static int GoldinTestDeduplicatedSplit(const char * inFolderPath)
+{
+	char tSerialPath[PATH_MAX];
+	char tDedupPath[PATH_MAX];
+	char tRootPath[PATH_MAX];
+	GoldinJobOptions tOptions;
+	GoldinJobStatistics tStatistics;
+	
+	if (GoldinTestMakePath(tSerialPath,inFolderPath,"serial")!=0 || GoldinTestCreateFolder(tSerialPath,NULL,0)!=0 ||
+		GoldinTestMakePath(tRootPath,tSerialPath,"root")!=0 || GoldinTestCreateTree(tRootPath,GOLDIN_TEST_TREE_DEPTH)!=0)
+		return -1;
+	
+	if (GoldinTestSplit(tRootPath,NULL,NULL)!=0)
+		return -1;
+	
+	if (GoldinTestMakePath(tDedupPath,inFolderPath,"dedup")!=0 || GoldinTestCreateFolder(tDedupPath,NULL,0)!=0 ||
+		GoldinTestMakePath(tRootPath,tDedupPath,"root")!=0 || GoldinTestCreateTree(tRootPath,GOLDIN_TEST_TREE_DEPTH)!=0)
+		return -1;
+	
+	GoldinJobOptionsInitialize(&tOptions);
+	
+	tOptions.deduplicate=TRUE;
+	
+	if (GoldinTestSplit(tRootPath,&tOptions,&tStatistics)!=0)
+		return -1;
+	
+	if (tStatistics.splitItems!=GOLDIN_TEST_TREE_SPLIT_ITEMS)
+		return GoldinTestFail("%llu ._ files written instead of %d",(unsigned long long) tStatistics.splitItems,GOLDIN_TEST_TREE_SPLIT_ITEMS);
+	
+	/* The folders at the same depth have the same items */
+	
+	if (tStatistics.deduplicatedItems==0)
+		return GoldinTestFail("No ._ file was shared");
+	
+	return GoldinTestCompareTrees(tSerialPath,tDedupPath);
+}
+
+/* With checkpoints, the records reach the journal once the volume is flushed: a resumed run must find all of them */
+
+static int GoldinTestJournalCheckpoints(const char * inFolderPath)
+{
+	char tRootPath[PATH_MAX];
+	char tJournalPath[PATH_MAX];
+	GoldinJobOptions tOptions;
+	GoldinJobStatistics tStatistics;
+	
+	if (GoldinTestMakePath(tRootPath,inFolderPath,"root")!=0 || GoldinTestCreateTree(tRootPath,GOLDIN_TEST_TREE_DEPTH)!=0 ||
+		GoldinTestMakePath(tJournalPath,inFolderPath,"journal")!=0)
+		return -1;
+	
+	GoldinJobOptionsInitialize(&tOptions);
+	
+	tOptions.journalPath=tJournalPath;
+	tOptions.checkpointInterval=10;
+	tOptions.numberOfWorkers=4;
+	
+	if (GoldinTestSplit(tRootPath,&tOptions,&tStatistics)!=0)
+		return -1;
+	
+	if (tStatistics.splitItems!=GOLDIN_TEST_TREE_SPLIT_ITEMS)
+		return GoldinTestFail("%llu ._ files written instead of %d",(unsigned long long) tStatistics.splitItems,GOLDIN_TEST_TREE_SPLIT_ITEMS);
+	
+	tOptions.resume=TRUE;
+	
+	if (GoldinTestSplit(tRootPath,&tOptions,&tStatistics)!=0)
+		return -1;
+	
+	if (tStatistics.splitItems!=0 || tStatistics.journaledItems==0)
+		return GoldinTestFail("%llu ._ files written again by the resumed run",(unsigned long long) tStatistics.splitItems);
+	
+	return 0;
+}
+
+/* The temporary files of a run of this host that died are removed with the stale ._ files, not those of a run in progress,
+   of another host or of the user */
+
+#define GOLDIN_TEST_TEMPORARY_FILES		6
+
+static int GoldinTestTemporaryFiles(const char * inFolderPath)
+{
+	static const char sUserText[]="Not an AppleDouble file";
+	uint8_t tHeader[GOLDIN_APPLEDOUBLE_HEADER_SIZE];
+	char tNames[GOLDIN_TEST_TEMPORARY_FILES][NAME_MAX];
+	char tRootPath[PATH_MAX];
+	char tPath[PATH_MAX];
+	GoldinJobOptions tOptions;
+	GoldinJobStatistics tStatistics;
+	struct stat tStat;
+	uint32_t tHostIdentifier=GoldinAppleDoubleGetHostIdentifier();
+	pid_t tProcessID;
+	int i;
+	
+	/* The process ID of a child that is gone */
+	
+	tProcessID=fork();
+	
+	if (tProcessID==-1)
+		return GoldinTestFail("Unable to create a process (%s)",strerror(errno));
+	
+	if (tProcessID==0)
+		_exit(0);
+	
+	waitpid(tProcessID,NULL,0);
+	
+	/* 0: a file of the user, 1: a ._ file of a run that died (the only one removed), 2: the same on another host,
+	   3: a ._ file of this run, 4: a file of the user with the name of a run that died, 5: an empty file of a run
+	   that died (too recent) */
+	
+	snprintf(tNames[0],NAME_MAX,GOLDIN_APPLEDOUBLE_TEMPORARY_PREFIX "user");
+	snprintf(tNames[1],NAME_MAX,GOLDIN_APPLEDOUBLE_TEMPORARY_PREFIX "%08lx-%lx-0",(unsigned long) tHostIdentifier,(unsigned long) tProcessID);
+	snprintf(tNames[2],NAME_MAX,GOLDIN_APPLEDOUBLE_TEMPORARY_PREFIX "%08lx-%lx-0",(unsigned long) (tHostIdentifier^1),(unsigned long) tProcessID);
+	snprintf(tNames[3],NAME_MAX,GOLDIN_APPLEDOUBLE_TEMPORARY_PREFIX "%08lx-%lx-0",(unsigned long) tHostIdentifier,(unsigned long) getpid());
+	snprintf(tNames[4],NAME_MAX,GOLDIN_APPLEDOUBLE_TEMPORARY_PREFIX "%08lx-%lx-1",(unsigned long) tHostIdentifier,(unsigned long) tProcessID);
+	snprintf(tNames[5],NAME_MAX,GOLDIN_APPLEDOUBLE_TEMPORARY_PREFIX "%08lx-%lx-2",(unsigned long) tHostIdentifier,(unsigned long) tProcessID);
+	
+	GoldinAppleDoubleEncodeHeader(tHeader,sFileFinderInfo,0);
+	
+	if (GoldinTestMakePath(tRootPath,inFolderPath,"root")!=0 || GoldinTestCreateFolder(tRootPath,NULL,0)!=0)
+		return -1;
+	
+	for(i=0;i<GOLDIN_TEST_TEMPORARY_FILES;i++)
+	{
+		const void * tBytes=NULL;
+		size_t tSize=0;
+		int tDescriptor;
+		
+		if (i>=1 && i<=3)
+		{
+			tBytes=tHeader;
+			tSize=sizeof(tHeader);
+		}
+		else if (i==4)
+		{
+			tBytes=sUserText;
+			tSize=sizeof(sUserText)-1;
+		}
+		
+		if (GoldinTestMakePath(tPath,tRootPath,tNames[i])!=0)
+			return -1;
+		
+		tDescriptor=open(tPath,O_WRONLY|O_CREAT|O_EXCL,S_IRUSR|S_IWUSR|S_IRGRP|S_IROTH);
+		
+		if (tDescriptor==-1)
+			return GoldinTestFail("Unable to create %s (%s)",tPath,strerror(errno));
+		
+		if (tSize>0 && write(tDescriptor,tBytes,tSize)!=(ssize_t) tSize)
+		{
+			close(tDescriptor);
+			
+			return GoldinTestFail("Unable to write %s",tPath);
+		}
+		
+		close(tDescriptor);
+	}
+	
+	GoldinJobOptionsInitialize(&tOptions);
+	
+	tOptions.pruneStale=TRUE;
+	
+	if (GoldinTestSplit(tRootPath,&tOptions,&tStatistics)!=0)
+		return -1;
+	
+	if (tStatistics.removedItems!=1)
+		return GoldinTestFail("%llu files removed instead of 1",(unsigned long long) tStatistics.removedItems);
+	
+	for(i=0;i<GOLDIN_TEST_TEMPORARY_FILES;i++)
+	{
+		Boolean tExists;
+		
+		if (GoldinTestMakePath(tPath,tRootPath,tNames[i])!=0)
+			return -1;
+		
+		tExists=(lstat(tPath,&tStat)==0);
+		
+		if (tExists!=(i!=1))
+			return GoldinTestFail("%s %s",tPath,(tExists==TRUE) ? "was not removed" : "was removed");
+	}
+	
+	return 0;
+}
+
+/* The short ustar headers written for the small trees of the tests */
+
+#define GOLDIN_TEST_ARCHIVE_MAX_ENTRIES		16
+
+typedef struct _GoldinTestArchiveEntry
+{
+	char path[101];
+	char type;
+	char linkTarget[101];
+	uint64_t size;
+	
+} GoldinTestArchiveEntry;
+
+static int GoldinTestReadArchive(const char * inPath,GoldinTestArchiveEntry * outEntries,size_t * outCount)
+{
+	static uint8_t sArchive[64*1024];
+	size_t tSize;
+	size_t tOffset=0;
+	
+	*outCount=0;
+	
+	if (GoldinTestReadFile(inPath,sArchive,sizeof(sArchive),&tSize)!=0)
+		return -1;
+	
+	while (tOffset+512<=tSize && sArchive[tOffset]!='\0')
+	{
+		const char * tHeader=(const char *) sArchive+tOffset;
+		GoldinTestArchiveEntry * tEntry;
+		
+		if (*outCount==GOLDIN_TEST_ARCHIVE_MAX_ENTRIES)
+			return GoldinTestFail("%s has more than %d items",inPath,GOLDIN_TEST_ARCHIVE_MAX_ENTRIES);
+		
+		tEntry=&outEntries[(*outCount)++];
+		
+		memcpy(tEntry->path,tHeader,100);
+		tEntry->path[100]='\0';
+		tEntry->type=tHeader[156];
+		memcpy(tEntry->linkTarget,tHeader+157,100);
+		tEntry->linkTarget[100]='\0';
+		tEntry->size=strtoull(tHeader+124,NULL,8);
+		
+		tOffset+=512+((tEntry->size+511)/512)*512;
+	}
+	
+	return 0;
+}
+
+static const GoldinTestArchiveEntry * GoldinTestFindArchiveEntry(const GoldinTestArchiveEntry * inEntries,size_t inCount,const char * inPath)
+{
+	size_t i;
+	
+	for(i=0;i<inCount;i++)
+	{
+		if (strcmp(inEntries[i].path,inPath)==0)
+			return &inEntries[i];
+	}
+	
+	return NULL;
+}
+
+/* The links of a file are archived once: the first link and its ._ file with their data, the others as tar hard links */
+
+static int GoldinTestArchiveHardLinks(const char * inFolderPath)
+{
+	static const char * sLinkPaths[2][2]={{"root/d/hl2","root/d/._hl2"},{"root/hl1","root/._hl1"}};
+	char tRootPath[PATH_MAX];
+	char tPath[PATH_MAX];
+	char tLinkPath[PATH_MAX];
+	char tArchivePath[PATH_MAX];
+	GoldinTestArchiveEntry tEntries[GOLDIN_TEST_ARCHIVE_MAX_ENTRIES];
+	size_t tCount;
+	GoldinJobOptions tOptions;
+	GoldinJobRef tJob;
+	GoldinArchiveRef tArchive;
+	int tDescriptor;
+	int tError;
+	int i;
+	
+	if (GoldinTestMakePath(tRootPath,inFolderPath,"root")!=0 || GoldinTestCreateFolder(tRootPath,NULL,0)!=0 ||
+		GoldinTestMakePath(tPath,tRootPath,"d")!=0 || GoldinTestCreateFolder(tPath,NULL,0)!=0 ||
+		GoldinTestMakePath(tPath,tRootPath,"hl1")!=0 || GoldinTestCreateFile(tPath,sFileFinderInfo,500)!=0)
+		return -1;
+	
+	if (GoldinTestMakePath(tLinkPath,tRootPath,"d/hl2")!=0)
+		return -1;
+	
+	if (link(tPath,tLinkPath)!=0)
+		return GoldinTestFail("Unable to link %s (%s)",tPath,strerror(errno));
+	
+	if (GoldinTestMakePath(tArchivePath,inFolderPath,"root.tar")!=0)
+		return -1;
+	
+	tDescriptor=open(tArchivePath,O_WRONLY|O_CREAT|O_TRUNC,0644);
+	
+	if (tDescriptor==-1)
+		return GoldinTestFail("Unable to create %s (%s)",tArchivePath,strerror(errno));
+	
+	tArchive=GoldinArchiveCreate(tDescriptor);
+	
+	GoldinJobOptionsInitialize(&tOptions);
+	
+	tOptions.backendName=kGoldinXattrBackend.name;
+	tOptions.archiveMode=TRUE;
+	tOptions.errorCallback=GoldinTestErrorCallback;
+	
+	tJob=GoldinJobCreate(&tOptions);
+	
+	tError=(tArchive==NULL || tJob==NULL) ? ENOMEM : GoldinJobArchive(tJob,tRootPath,tArchive);
+	
+	if (tError==0)
+		tError=GoldinArchiveFinish(tArchive);
+	
+	if (tJob!=NULL)
+		GoldinJobRelease(tJob);
+	
+	if (tArchive!=NULL)
+		GoldinArchiveRelease(tArchive);
+	
+	close(tDescriptor);
+	
+	if (tError!=0)
+		return (sFailure[0]!='\0') ? -1 : GoldinTestFail("Unable to archive %s (%s)",tRootPath,strerror(tError));
+	
+	if (GoldinTestReadArchive(tArchivePath,tEntries,&tCount)!=0)
+		return -1;
+	
+	if (tCount!=6)
+		return GoldinTestFail("%lu items in the archive instead of 6",(unsigned long) tCount);
+	
+	/* The items are sorted by name: d/hl2 is the first link found */
+	
+	for(i=0;i<2;i++)
+	{
+		const GoldinTestArchiveEntry * tFirstLink=GoldinTestFindArchiveEntry(tEntries,tCount,sLinkPaths[0][i]);
+		const GoldinTestArchiveEntry * tOtherLink=GoldinTestFindArchiveEntry(tEntries,tCount,sLinkPaths[1][i]);
+		uint64_t tSize=(i==0) ? 7 : GOLDIN_APPLEDOUBLE_HEADER_SIZE+500;
+		
+		if (tFirstLink==NULL || tOtherLink==NULL)
+			return GoldinTestFail("%s or %s is not in the archive",sLinkPaths[0][i],sLinkPaths[1][i]);
+		
+		if (tFirstLink->type!='0' || tFirstLink->size!=tSize)
+			return GoldinTestFail("%s is not a file of %llu bytes",tFirstLink->path,(unsigned long long) tSize);
+		
+		if (tOtherLink->type!='1' || strcmp(tOtherLink->linkTarget,tFirstLink->path)!=0 || tOtherLink->size!=0)
+			return GoldinTestFail("%s is not a hard link to %s",tOtherLink->path,tFirstLink->path);
+	}
+	
+	return 0;
+}
+
+/* The options that can not be combined are rejected by the engine itself, with the reason */
+
+static void GoldinTestConflictCallback(const char * inMessage,void * inContext)
+{
+	*((Boolean *) inContext)=(inMessage[0]!='\0');
+}
+
+static int GoldinTestOptionConflicts(const char * inFolderPath)
+{
+	GoldinJobOptions tOptions;
+	GoldinJobRef tJob;
+	Boolean tReported=FALSE;
+	int i;
+	
+	(void) inFolderPath;
+	
+	for(i=0;i<5;i++)
+	{
+		GoldinJobOptionsInitialize(&tOptions);
+		
+		tOptions.backendName=kGoldinXattrBackend.name;
+		tOptions.errorCallback=GoldinTestConflictCallback;
+		tOptions.callbackContext=&tReported;
+		
+		switch(i)
+		{
+			case 0:
+				tOptions.archiveMode=TRUE;
+				tOptions.numberOfWorkers=2;
+				break;
+			case 1:
+				tOptions.dryRunMode=TRUE;
+				tOptions.deduplicate=TRUE;
+				break;
+			case 2:
+				tOptions.pruneStale=TRUE;
+				tOptions.archiveMode=TRUE;
+				break;
+			case 3:
+				tOptions.verifyMode=TRUE;
+				tOptions.incrementalMode=TRUE;
+				break;
+			default:
+				tOptions.resume=TRUE;
+				break;
+		}
+		
+		tReported=FALSE;
+		
+		tJob=GoldinJobCreate(&tOptions);
+		
+		if (tJob!=NULL)
+		{
+			GoldinJobRelease(tJob);
+			
+			return GoldinTestFail("Conflict %d was accepted",i);
+		}
+		
+		if (errno!=EINVAL || tReported==FALSE)
+			return GoldinTestFail("Conflict %d was not reported as EINVAL (%s)",i,strerror(errno));
+	}
+	
+	/* A job created to write archives can not split a tree */
+	
+	GoldinJobOptionsInitialize(&tOptions);
+	
+	tOptions.backendName=kGoldinXattrBackend.name;
+	tOptions.errorCallback=GoldinTestConflictCallback;
+	tOptions.callbackContext=&tReported;
+	tOptions.archiveMode=TRUE;
+	
+	tJob=GoldinJobCreate(&tOptions);
+	
+	if (tJob==NULL)
+		return GoldinTestFail("Unable to create an archive job (%s)",strerror(errno));
+	
+	i=GoldinJobSplit(tJob,inFolderPath);
+	
+	GoldinJobRelease(tJob);
+	
+	if (i!=EINVAL)
+		return GoldinTestFail("An archive job split a tree (%s)",strerror(i));
+	
+	return 0;
+}
+
+#pragma mark -
+
+static const GoldinTest sTests[]=
+{
+	{"appledouble-header",GoldinTestEncodeHeader},
+	{"appledouble-file",GoldinTestWriteAppleDouble},
+	{"parallel-split",GoldinTestParallelSplit},
+	{"dedup-split",GoldinTestDeduplicatedSplit},
+	{"journal-checkpoints",GoldinTestJournalCheckpoints},
+	{"temporary-files",GoldinTestTemporaryFiles},
+	{"archive-hard-links",GoldinTestArchiveHardLinks},
+	{"option-conflicts",GoldinTestOptionConflicts},
+	{NULL,NULL}
+};
+
+static void usage(const char * inProcessName)
+{
+	int i;
+	
+	printf("usage: %s [-o directory][-k] [<test>...]\n",inProcessName);
+	printf("       -o  --  Folder in which the trees are created (default: /tmp)\n");
+	printf("       -k  --  Keep the trees\n");
+	printf("\n       tests:");
+	
+	for(i=0;sTests[i].name!=NULL;i++)
+		printf(" %s",sTests[i].name);
+	
+	printf("\n");
+	
+	exit(1);
+}
+
+static Boolean GoldinTestIsSelected(const char * inName,int argc,const char * argv[])
+{
+	int i;
+	
+	if (argc==0)
+		return TRUE;
+	
+	for(i=0;i<argc;i++)
+	{
+		if (strcmp(argv[i],inName)==0)
+			return TRUE;
+	}
+	
+	return FALSE;
+}
+
+int main(int argc,const char * argv[])
+{
+	const char * tProcessName=argv[0];
+	const char * tParentPath="/tmp";
+	Boolean tKeepTrees=FALSE;
+	int tFailures=0;
+	int i;
+	int ch;
+	
+	while ((ch=getopt(argc,(char ** const) argv,"o:ku"))!=-1)
+	{
+		switch (ch)
+		{
+			case 'o':
+				tParentPath=optarg;
+				break;
+			case 'k':
+				tKeepTrees=TRUE;
+				break;
+			case 'u':
+			case '?':
+			default:
+				usage(tProcessName);
+				break;
+		}
+	}
+	
+	argc-=optind;
+	argv+=optind;
+	
+	for(i=0;i<argc;i++)
+	{
+		int j;
+		
+		for(j=0;sTests[j].name!=NULL && strcmp(sTests[j].name,argv[i])!=0;j++)
+			;
+		
+		if (sTests[j].name==NULL)
+		{
+			logerror("Unknown test: %s\n",argv[i]);
+			
+			usage(tProcessName);
+		}
+	}
+	
+	for(i=0;sTests[i].name!=NULL;i++)
+	{
+		char tFolderPath[PATH_MAX];
+		char tResolvedPath[PATH_MAX];
+		
+		if (GoldinTestIsSelected(sTests[i].name,argc,argv)==FALSE)
+			continue;
+		
+		/* The split engine expects a path without symbolic links */
+		
+		if (snprintf(tFolderPath,PATH_MAX,"%s/goldin_test.XXXXXX",tParentPath)>=PATH_MAX || mkdtemp(tFolderPath)==NULL ||
+			realpath(tFolderPath,tResolvedPath)==NULL)
+		{
+			logerror("Unable to create a folder in %s\n",tParentPath);
+			
+			return -1;
+		}
+		
+		sFailure[0]='\0';
+		
+		if (sTests[i].function(tResolvedPath)==0)
+		{
+			printf("ok      %s\n",sTests[i].name);
+		}
+		else
+		{
+			printf("FAILED  %s: %s\n",sTests[i].name,sFailure);
+			
+			tFailures++;
+		}
+		
+		if (tKeepTrees==FALSE)
+			GoldinTestRemoveTree(tFolderPath);
+		else
+			logerror("The trees of %s were kept in %s\n",sTests[i].name,tResolvedPath);
+	}
+	
+	return tFailures;
+}
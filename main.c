@@ -71,1042 +71,813 @@ SUCH DAMAGE.
     o To know why this tool is named goldin, see http://en.wikipedia.org/wiki/Sawing_a_woman_in_half
 		
     o This tool purpose is to be compatible with SplitForks and FixupResourceForks as best as possible. This explains why we have to create a Entry ID 2 even when it's not needed.
+    
+    o The split engine (GoldinSplit.c) goes through a backend (GoldinBackend.h). On Linux, the resource forks and the
+      FinderInfo are read from the user.com.apple.* extended attributes. To build it: cc -O2 -o goldin *.c -lpthread
 */
 
-#include <CoreServices/CoreServices.h>
-
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
-
-#include <sys/param.h>
-#include <sys/mount.h>
 #include <sys/stat.h>
 
-long gMaxFileNameLength=0;
-Boolean gStripResourceForks=FALSE;
-Boolean gVerboseMode=FALSE;
+#include "Goldin.h"
+#include "GoldinAsync.h"
+#include "GoldinBackend.h"
+#include "GoldinCounters.h"
+#include "GoldinTrace.h"
+#include "GoldinWatch.h"
 
-/*#define DEBUG	1*/
+#include <signal.h>
 
-#ifdef DEBUG
+Boolean gVerboseMode=FALSE;
+Boolean gPrintCounters=FALSE;
 
-#include <syslog.h>
-#include <stdarg.h>
+static GoldinWatchRef sWatch=NULL;		/* NULL unless the trees are watched once split */
 
-#define logerror(...) syslog(LOG_ERR, __VA_ARGS__);
+static Boolean sVerify=FALSE;
 
-#else
+static struct option sLongOptions[]=
+{
+	{"journal",	required_argument,	NULL,	'J'},
+	{"resume",	no_argument,		NULL,	'R'},
+	{"async",	no_argument,		NULL,	'A'},
+	{"archive",	required_argument,	NULL,	'a'},
+	{"files-from",	required_argument,	NULL,	'T'},
+	{"null",	no_argument,		NULL,	'0'},
+	{"stats",	required_argument,	NULL,	'S'},
+	{"trace",	required_argument,	NULL,	't'},
+	{"dry-run",	no_argument,		NULL,	'n'},
+	{"dedup",	no_argument,		NULL,	'd'},
+	{"sync",	no_argument,		NULL,	'y'},
+	{"checkpoint",	required_argument,	NULL,	'k'},
+	{"exclude",	required_argument,	NULL,	'x'},
+	{"include",	required_argument,	NULL,	'I'},
+	{"max-depth",	required_argument,	NULL,	'm'},
+	{"order",	required_argument,	NULL,	'o'},
+	{"watch",	no_argument,		NULL,	'w'},
+	{"verify",	no_argument,		NULL,	'V'},
+	{"prune-stale",	no_argument,		NULL,	'P'},
+	{"bwlimit",	required_argument,	NULL,	'b'},
+	{"files-per-sec",	required_argument,	NULL,	'F'},
+	{"io-priority",	required_argument,	NULL,	'p'},
+	{NULL,		0,					NULL,	0}
+};
 
-#define logerror(...) (void)fprintf(stderr,__VA_ARGS__)
+static void usage(const char * inProcessName)
+{
+	printf("usage: %s [-s][-i][-n][-d][-v][-c][-u][-A][-y][-k count][-x pattern][-I pattern][-m depth][-o order][-w][-V][-P][-b rate][-F rate][-p priority][-j jobs][-B backend][-J journal [-R]][-a archive][-T list [-0]][-S stats][-t trace] [<file or directory>...]\n",inProcessName);
+	printf("       -s  --  Strip resource fork from source after splitting\n");
+	printf("       -i  --  Incremental mode: do not rewrite the ._ files that are up to date\n");
+	printf("       -n  --  (--dry-run) Only print how many ._ files would be written and the sizes of the resource forks\n");
+	printf("       -d  --  (--dedup) Replace the ._ files identical to one already written with a clone or a hard link of it\n");
+	printf("       -y  --  (--sync) Flush the volumes once everything is split so that the ._ files survive a crash\n");
+	printf("       -k  --  (--checkpoint) Also flush the volumes every <count> ._ files (implies -y)\n");
+	printf("       -x  --  (--exclude) Skip the items whose name matches this pattern, and the contents of the folders (*, ? and [...], a trailing / only matches folders)\n");
+	printf("       -I  --  (--include) Do not skip the items whose name matches this pattern (the first -x or -I pattern matching a name decides)\n");
+	printf("       -m  --  (--max-depth) Do not go deeper than <depth> levels below the files and directories to split\n");
+	printf("       -o  --  (--order) Order in which the items of a folder are split: listing, inode or disk (position of the resource forks, for rotating disks) (default: listing)\n");
+	printf("       -w  --  (--watch) Once split, keep the ._ files up to date: split again the items whose FinderInfo or resource fork change until interrupted\n");
+	printf("       -V  --  (--verify) Only check that the ._ files match their items and report the ones that do not match, are missing or orphaned\n");
+	printf("       -P  --  (--prune-stale) Also remove the ._ files whose item is gone or has no resource fork or FinderInfo anymore, and the temporary files left by a run that died\n");
+	printf("       -b  --  (--bwlimit) Do not copy or read more than <rate> bytes of resource fork per second (K, M or G suffix for kilo, mega or gigabytes)\n");
+	printf("       -F  --  (--files-per-sec) Do not create more than <rate> ._ files per second\n");
+	printf("       -p  --  (--io-priority) I/O priority: normal, low or idle (only served when the disks have nothing else to do) (default: normal)\n");
+	printf("       -j  --  Number of folders processed in parallel (0 for one per CPU)\n");
+	printf("       -A  --  (--async) Write the ._ files with io_uring (Linux, xattr backend)\n");
+	printf("       -B  --  Access to the resource forks and FinderInfo: %s (default: %s)\n",GoldinBackendGetNames(),GoldinBackendGetDefault()->name);
+	printf("       -J  --  (--journal) Record the items and folders done in this file (with -y, only once they have been flushed)\n");
+	printf("       -R  --  (--resume) Skip the items and folders recorded in the journal by a previous run\n");
+	printf("       -a  --  (--archive) Write a tar archive of the tree with the ._ files in it instead of splitting (- for the standard output)\n");
+	printf("       -T  --  (--files-from) Also split the files and directories listed in this file, one per line (- for the standard input)\n");
+	printf("       -0  --  (--null) The list is NUL-delimited (read from the standard input without -T)\n");
+	printf("       -S  --  (--stats) Write the counters and the time spent in every phase to this file as JSON (- for the standard error)\n");
+	printf("       -t  --  (--trace) Write the time spent on every item to this file in the Chrome trace event format\n");
+	printf("       -c  --  Print the number of items and filesystem calls when done\n");
+	printf("       -v  --  Verbose mode\n");
+	printf("       -u  --  Show usage\n");
+	
+	exit(1);
+}
 
-#endif
+/* The archive can be written to the standard output */
 
-#define SWAP_RECT(inRect)   do {												\
-								(inRect).top=CFSwapInt16((inRect).top);			\
-								(inRect).left=CFSwapInt16((inRect).left);		\
-								(inRect).bottom=CFSwapInt16((inRect).bottom);	\
-								(inRect).right=CFSwapInt16((inRect).right);		\
-							} while (0);
-							
-#define SWAP_POINT(inPoint)   do {												\
-								(inPoint).h=CFSwapInt16((inPoint).h);			\
-								(inPoint).v=CFSwapInt16((inPoint).v);			\
-							} while (0);
+static void PrintProgress(GoldinProgressEvent inEvent,const char * inPath,uint64_t inSize,void * inContext)
+{
+	(void) inContext;
+	
+	switch(inEvent)
+	{
+		case kGoldinProgressSplitting:
+			printf("    splitting %s...\n",inPath);
+			break;
+		case kGoldinProgressLinking:
+			printf("    linking %s...\n",inPath);
+			break;
+		case kGoldinProgressWouldSplit:
+			printf("    would split %s (%llu bytes)\n",inPath,(unsigned long long) inSize);
+			break;
+		case kGoldinProgressWouldLink:
+			printf("    would link %s\n",inPath);
+			break;
+		case kGoldinProgressArchiving:
+			fprintf(stderr,"    archiving %s...\n",inPath);
+			break;
+		case kGoldinProgressVerifying:
+			printf("    verifying %s...\n",inPath);
+			break;
+		case kGoldinProgressRemoving:
+			printf("    removing %s...\n",inPath);
+			break;
+	}
+}
 
+static void StopWatching(int inSignal)
+{
+	(void) inSignal;
+	
+	GoldinWatchStop(sWatch);
+}
 
-void SplitForks(FSRef * inItemReferencePtr);
-void SplitForksChildren(FSRef * inFileReferencePtr,FSRef * inParentReferencePtr);
+/* <count>[K|M|G], the suffixes are powers of 1024. Returns -1 if the rate is invalid, 0 or does not fit in 64 bits */
 
-OSErr SplitFileIfNeeded(FSRef * inFileReference,FSRef * inParentReference,FSCatalogInfo * inFileCatalogInfo,HFSUniStr255 * inFileName,Boolean * outDidSplit)
+static int ParseRate(const char * inString,uint64_t * outRate)
 {
-	OSErr tErr;
-	Boolean tSplitNeeded=FALSE;
-	FSIORefNum tForkRefNum;
-	UInt32 tResourceForkSize=0;
-	static HFSUniStr255 sResourceForkName={0,{}};
-	Boolean tHasResourceFork=FALSE;
-	UInt8 tPOSIXPath[PATH_MAX*2+1];
-	UInt32 tPOSIXPathMaxLength=PATH_MAX*2;
-	struct stat tFileStat;
-	FSIORefNum tNewFileRefNum;
+	char * tEnd;
+	unsigned long long tRate;
+	uint64_t tMultiplier=1;
 	
-	if (outDidSplit!=NULL)
-        *outDidSplit=FALSE;
-    
-    if (sResourceForkName.length==0)
-	{
-		tErr=FSGetResourceForkName(&sResourceForkName);
+	if (*inString<'0' || *inString>'9')
+		return -1;
 	
-		if (tErr!=noErr)
-		{
-			logerror("An error occurred when obtaining the ResourceFork name\n");
-			
-			return -1;
-		}
+	errno=0;
+	
+	tRate=strtoull(inString,&tEnd,10);
+	
+	if (errno==ERANGE)
+		return -1;
+	
+	switch(*tEnd)
+	{
+		case 'G':
+		case 'g':
+			tMultiplier*=1024;
+			/* FALLTHROUGH */
+		case 'M':
+		case 'm':
+			tMultiplier*=1024;
+			/* FALLTHROUGH */
+		case 'K':
+		case 'k':
+			tMultiplier*=1024;
+			tEnd++;
+			break;
+		default:
+			break;
 	}
 	
-	/* 1. Check for the presence of a resource fork */
-		
-	tErr=FSOpenFork(inFileReference,sResourceForkName.length,sResourceForkName.unicode,fsRdPerm,&tForkRefNum);
+	if (*tEnd!='\0' || tRate==0 || tRate>UINT64_MAX/tMultiplier)
+		return -1;
+	
+	*outRate=(uint64_t) tRate*tMultiplier;
+	
+	return 0;
+}
+
+/* -1 wins over 254 (or 1 for a verification finding differences) which wins over 0 */
+
+static int MergeStatus(int inStatus,int inNewStatus)
+{
+	if (inStatus==-1 || inNewStatus==-1)
+		return -1;
+	
+	return (inStatus!=0) ? inStatus : inNewStatus;
+}
+
+static int SplitRoot(GoldinJobRef inJob,const char * inPath,GoldinArchiveRef inArchive)
+{
+	int tError;
+	
+	/* Watched before it is split so that the changes made during the split are not missed */
 	
-	if (tErr==noErr)
+	if (sWatch!=NULL)
 	{
-		SInt64 tForkSize;
-		
-		/* Get the size of the resource fork */
-		
-		tErr=FSGetForkSize(tForkRefNum,&tForkSize);
+		tError=GoldinWatchAddRoot(sWatch,inPath);
 		
-		if (tErr!=noErr)
-		{
-			logerror("An error occurred on getting the resource fork size of a file or director\n");
-			
-			FSCloseFork(tForkRefNum);
-			
-			return -1;
-		}
-		
-		if (tForkSize>0xFFFFFFFF)
-		{
-			FSCloseFork(tForkRefNum);
-			
-			/* AppleDouble File format does not support forks bigger than 2GB */
-			
-			logerror("AppleDouble file format does not support forks bigger than 2 GB\n");
-			
-			return -1;
-		}
-		
-		tResourceForkSize=(UInt32) tForkSize;
+		if (tError!=0)
+			logerror("Unable to watch %s (%s)\n",inPath,strerror(tError));
+	}
+	
+	if (inArchive!=NULL)
+	{
+		/* The standard output may be the archive */
 		
-		if (tForkSize>0)
-		{
-			tHasResourceFork=TRUE;
+		if (gVerboseMode==TRUE)
+			fprintf(stderr,"Archiving %s...\n",inPath);
 		
-			tSplitNeeded=TRUE;
-		}
-		else
-		{
-			FSCloseFork(tForkRefNum);
-		}
+		tError=GoldinJobArchive(inJob,inPath,inArchive);
 	}
 	else
 	{
-		switch(tErr)
+		if (gVerboseMode==TRUE)
+			printf("%s %s...\n",(sVerify==TRUE) ? "Verifying" : "Splitting",inPath);
+		
+		tError=GoldinJobSplit(inJob,inPath);
+	}
+	
+	/* Return (-2) if the backend can not deal with this volume (e.g. not a HFS or Extended HFS File System) */
+	
+	if (tError!=0)
+		return (tError==ENOTSUP) ? 254 : -1;
+	
+	return 0;
+}
+
+int main (int argc, const char * argv[])
+{
+    int ch;
+	GoldinJobOptions tOptions;
+	GoldinJobRef tJob;
+	GoldinJobStatistics tStatistics;
+	const GoldinBackend * tBackend;
+	GoldinFilterRef tFilter=NULL;
+	long tNumberOfJobs=-1;
+	const char * tJournalPath=NULL;
+	Boolean tAsynchronous=FALSE;
+	Boolean tWatch=FALSE;
+	const char * tArchivePath=NULL;
+	GoldinArchiveRef tArchive=NULL;
+	int tArchiveDescriptor=STDOUT_FILENO;
+	const char * tListPath=NULL;
+	int tDelimiter='\n';
+	const char * tStatisticsPath=NULL;
+	const char * tTracePath=NULL;
+	GoldinIOPriority tIOPriority=kGoldinIOPriorityNormal;
+	int tStatus=0;
+	int i;
+	
+	GoldinJobOptionsInitialize(&tOptions);
+	
+	tBackend=GoldinBackendGetDefault();
+	
+	while ((ch = getopt_long(argc, (char ** const) argv, "sindyvcuwVPAb:F:p:j:B:J:Ra:T:0S:t:k:x:I:m:o:", sLongOptions, NULL)) != -1)
+	{
+		switch (ch)
 		{
-			case errFSForkNotFound:
-			case eofErr:
-				/* No resource Fork */
+			case 'J':
+				/* Journal */
 				
-				tErr=noErr;
+				tJournalPath=optarg;
 				break;
-			default:
-				
-				logerror("Unable to open fork\n");
+			
+			case 'R':
+				/* Resume */
 				
-				return -1;
+				tOptions.resume=TRUE;
+				break;
+			
+			case 'T':
+				/* List of files or directories */
 				
+				tListPath=optarg;
 				break;
-		}
-	}
-	
-	/* 2. Check for the presence of FinderInfo or ExtFinderInfo */
-	
-	if (tSplitNeeded==FALSE)
-	{
-		UInt32 * tUnsignedInt32Ptr;
-		int i;
-		
-		
-		/* 1. We need to save the Folder(Ext) Info in the ._ file if there are any folder/finder or extend folder/finder info */
 			
-		tUnsignedInt32Ptr= (UInt32 *) inFileCatalogInfo->finderInfo;
-		
-		for(i=0;i<4;i++)
-		{
-			if (tUnsignedInt32Ptr[i]!=0)
-			{
-				/* We need to create a ._file */
+			case '0':
+				/* NUL-delimited list */
+				
+				tDelimiter='\0';
+				break;
 			
-				tSplitNeeded=TRUE;
+			case 'S':
+				/* Statistics */
+				
+				tStatisticsPath=optarg;
 				break;
-			}
-		}
-		
-		if (tSplitNeeded==TRUE)		/* 01/02/07: Symbolic link looks like this */
-		{
-			UInt32 tSymbolicLink;
-
-			tSymbolicLink='s';
-			tSymbolicLink='l'+(tSymbolicLink<<8);
-			tSymbolicLink='n'+(tSymbolicLink<<8);
-			tSymbolicLink='k'+(tSymbolicLink<<8);
-
-			if (tUnsignedInt32Ptr[0]==tSymbolicLink)
-			{
-				tSplitNeeded=FALSE;
-			}
-		}
-		else
-		{
-			tUnsignedInt32Ptr= (UInt32 *) inFileCatalogInfo->extFinderInfo;
-		
-			for(i=0;i<4;i++)
-			{
-				if (tUnsignedInt32Ptr[i]!=0)
-				{
-					/* We need to create a ._file */
+			
+			case 't':
+				/* Trace */
 				
-					tSplitNeeded=TRUE;
-					break;
-				}
-			}
-		}
-	}
-	
-	/* 3. Split if needed */
-	
-	if (tSplitNeeded==TRUE)
-	{
-		FSRef tNewFileReference;
-		HFSUniStr255 tNewFileName;
-	
-		/* Get the absolute Posix Path Name */
-		
-		tErr=FSRefMakePath(inFileReference,tPOSIXPath,tPOSIXPathMaxLength);
-		
-		if (tErr==noErr)
-		{
-			if (lstat((char *) tPOSIXPath,&tFileStat)==-1)
-			{
-				switch(errno)
-				{
-					case ENOENT:
-						/* A COMPLETER */
-						
-						break;
-					default:
-						/* A COMPLETER */
-						
-						break;
-				}
+				tTracePath=optarg;
+				break;
+			
+			case 'a':
+				/* Archive */
 				
-				tErr=-1;
+				tArchivePath=optarg;
+				break;
+			
+			case 'A':
+				/* Asynchronous engine */
 				
-				goto byebye;
-			}
-		}
-		else
-		{
-			logerror("An error occurred when trying to get the absolute path of a file or directory\n");
+				tAsynchronous=TRUE;
+				break;
 			
-			tErr=-1;
+			case 'B':
+				/* Backend */
 				
-			goto byebye;
-		}
-		
-		if (gVerboseMode==TRUE)
-		{
-			printf("    splitting %s...\n",tPOSIXPath);
-		}
-		
-		/* Check that we do not explode the current limit for file names */
-		
-		if (inFileName->length>gMaxFileNameLength)
-		{
-			/* We do not have enough space to add the ._ prefix */
-		
-			/* The file name is too long */
+				tBackend=GoldinBackendGetNamed(optarg);
+				
+				if (tBackend==NULL)
+				{
+					logerror("Unknown backend: %s\n",optarg);
 					
-			/* Write the error */
-			
-			logerror("File name is too long. The maximum length allowed is %ld characters\n",gMaxFileNameLength+2);
+					return -1;
+				}
+				break;
 			
-			return -1;
-		}
-		
-		tNewFileName.length=inFileName->length+2;
-		
-		tNewFileName.unicode[0]='.';
-		tNewFileName.unicode[1]='_';
-		
-		memcpy(tNewFileName.unicode+2,inFileName->unicode,inFileName->length*sizeof(UniChar));
-		
-		/* We need to create a ._file */
-		
-tryagain:
-
-		tErr=FSCreateFileUnicode(inParentReference,tNewFileName.length,tNewFileName.unicode,0,NULL,&tNewFileReference,NULL);
-		
-		if (tErr!=noErr)
-		{
-			switch(tErr)
-			{
-				case bdNamErr:
-				case fsmBadFFSNameErr:
-				case errFSNameTooLong:
-					/* The file name is too long */
-					
-					/* Write the error */
-					
-					logerror("File name is too long. The maximum length allowed is %ld characters\n",gMaxFileNameLength+2);
-					
-					break;
-				case dskFulErr:
-					
-					logerror("Disk is full\n");
-					
-					break;
-					
-				case errFSQuotaExceeded:
-					
-					logerror("Your quota are exceeded\n");
-					
-					break;
-				case dupFNErr:
+			case 'j':
+				/* Number of workers */
 				
-					/* The file already exists, we need to try to delete it before recreating it */
+				{
+					char * tEnd;
 					
-					tErr=FSMakeFSRefUnicode(inParentReference,tNewFileName.length,tNewFileName.unicode,kTextEncodingDefaultFormat,&tNewFileReference);
+					tNumberOfJobs=strtol(optarg,&tEnd,10);
 					
-					if (tErr==noErr)
+					if (*optarg=='\0' || *tEnd!='\0' || tNumberOfJobs<0)
 					{
-						/* Delete the current ._file */
+						logerror("Invalid number of jobs: %s\n",optarg);
 						
-						tErr=FSDeleteObject(&tNewFileReference);
-						
-						if (tErr==noErr)
-						{
-							goto tryagain;
-						}
-						else
-						{
-							/* A COMPLETER */
-						}
+						return -1;
 					}
-					else
+					
+					if (tNumberOfJobs==0)
 					{
-						/* A COMPLETER */
+						tNumberOfJobs=sysconf(_SC_NPROCESSORS_ONLN);
+						
+						if (tNumberOfJobs<1)
+							tNumberOfJobs=1;
 					}
-					
-					break;
-				
-				case afpVolLocked:
-					/* A COMPLETER */
-					break;
-					
-				default:
-					/* A COMPLETER */
-					break;
-			}
-			
-			return -1;
-		}
-		
-		tErr=FSOpenFork(&tNewFileReference,0,NULL,fsWrPerm,&tNewFileRefNum);
-		
-		if (tErr==noErr)
-		{
-			unsigned char tAppleDoubleMagicNumber[4]=  {0x00,0x05,0x16,0x07};
-			unsigned char tAppleDoubleVersionNumber[4]={0x00,0x02,0x00,0x00};
-			unsigned char tAppleDoubleFiller[16]={0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00,0x00};
-			ByteCount tRequestCount;
-			UInt16 tNumberOfEntries;
-			UInt16 tSwappedNumberOfEntries;
-
-			UInt32 tEntryID;
-			UInt32 tEntryOffset;
-			UInt32 tEntryLength;
-			
-			/* Write the Magic Number */
-			
-			tRequestCount=4;
-			
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,tAppleDoubleMagicNumber,NULL);
-			
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
-			
-			/* Write the Version Number */
-			
-			tRequestCount=4;
-			
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,tAppleDoubleVersionNumber,NULL);
-			
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
-			
-			/* Write the Filler */
-			
-			tRequestCount=16;
-			
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,tAppleDoubleFiller,NULL);
-			
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
-			
-			/* Compute the Number of Entries */
-			
-			tNumberOfEntries=0x0002;
-			
-			tSwappedNumberOfEntries=tNumberOfEntries;
-			
-#ifdef __LITTLE_ENDIAN__
-			
-			/* Swap for Intel processor */
-			
-			tSwappedNumberOfEntries=CFSwapInt16(tSwappedNumberOfEntries);
-
-#endif			
-			tRequestCount=2;
-			
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,&tSwappedNumberOfEntries,NULL);
-			
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
-			
-			/* Write the Entries Descriptor */
-			
-			/* **** Finder Info */
-			
-			tEntryID=0x00000009;		/* Finder Info ID */
-			
-			tEntryOffset=0x0000001A+tNumberOfEntries*12;
-			
-			tEntryLength=0x00000020;	/* 32 bytes */
-			
-#ifdef __LITTLE_ENDIAN__
-			
-			/* Swap for Intel processor */
-			
-			tEntryID=CFSwapInt32(tEntryID);
-			
-			tEntryOffset=CFSwapInt32(tEntryOffset);
-			
-			tEntryLength=CFSwapInt32(tEntryLength);
-			
-#endif			
-			tRequestCount=4;
-			
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,&tEntryID,NULL);
-			
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
-			
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,&tEntryOffset,NULL);
-			
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
-			
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,&tEntryLength,NULL);
-			
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
+				}
+				break;
 			
-			tEntryID=0x00000002;		/* Resource Fork ID */
-				
-			tEntryOffset=0x00000052;
+			case 's':
+				/* Strip the resource fork */
 				
-			if (tHasResourceFork==TRUE)
-			{
-				/* **** Finder Info */
-			
-				tEntryLength=tResourceForkSize;	/* As you can see the AppleDouble format file is not ready for forks bigger than 2 GB */
-			}
-			else
-			{
-				tEntryLength=0;
-			}
+				tOptions.stripResourceForks=TRUE;
+				break;
 			
-#ifdef __LITTLE_ENDIAN__
+			case 'i':
+				/* Incremental mode */
 				
-			/* Swap for Intel processor */
-		
-			tEntryID=CFSwapInt32(tEntryID);
-			
-			tEntryOffset=CFSwapInt32(tEntryOffset);
-			
-			tEntryLength=CFSwapInt32(tEntryLength);
-#endif
-
-			tRequestCount=4;
-			
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,&tEntryID,NULL);
-			
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
-			
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,&tEntryOffset,NULL);
-			
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
-		
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,&tEntryLength,NULL);
-		
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
-			
-			/* Write the Entries */
-			
-			/* **** Write Finder Info */
-			
-#ifdef __LITTLE_ENDIAN__
-
-			/* Intel Processors */
-			
-			/* Even though it's referenced as a bytes field in the File API, this is actually a structure we need to swap... */
-
-			if (inFileCatalogInfo->nodeFlags & kFSNodeIsDirectoryMask)
-			{
-				/* It's a fragging folder */
+				tOptions.incrementalMode=TRUE;
+				break;
 			
-				FolderInfo * tFolderInfoStruct;
-				ExtendedFolderInfo * tExtendedFolderInfoStruct;
-				
-				/* Swap FolderInfo Structure */
-				
-				tFolderInfoStruct=(FolderInfo *) inFileCatalogInfo->finderInfo;
-				
-				SWAP_RECT(tFolderInfoStruct->windowBounds);
-				tFolderInfoStruct->finderFlags=CFSwapInt16(tFolderInfoStruct->finderFlags);
-				SWAP_POINT(tFolderInfoStruct->location);
-				tFolderInfoStruct->reservedField=CFSwapInt16(tFolderInfoStruct->reservedField);
-				
-				/* Swap ExtendedFolderInfo Info Structure */
-				
-				tExtendedFolderInfoStruct=(ExtendedFolderInfo *) inFileCatalogInfo->extFinderInfo;
-				
-				SWAP_POINT(tExtendedFolderInfoStruct->scrollPosition);
-				tExtendedFolderInfoStruct->reserved1=CFSwapInt32(tExtendedFolderInfoStruct->reserved1);
-				tExtendedFolderInfoStruct->extendedFinderFlags=CFSwapInt16(tExtendedFolderInfoStruct->extendedFinderFlags);
-				tExtendedFolderInfoStruct->reserved2=CFSwapInt16(tExtendedFolderInfoStruct->reserved2);
-				tExtendedFolderInfoStruct->putAwayFolderID=CFSwapInt32(tExtendedFolderInfoStruct->putAwayFolderID);
-			}
-			else
-			{
-				/* I'm just a file, you know */
-				
-				FileInfo * tFileInfoStruct;
-				ExtendedFileInfo * tExtendedFileInfoStruct;
+			case 'n':
+				/* Dry run */
 				
-				/* Swap FileInfo Structure */
-				
-				tFileInfoStruct=(FileInfo *) inFileCatalogInfo->finderInfo;
-				
-				tFileInfoStruct->fileType=CFSwapInt32(tFileInfoStruct->fileType);
-				tFileInfoStruct->fileCreator=CFSwapInt32(tFileInfoStruct->fileCreator);
-				tFileInfoStruct->finderFlags=CFSwapInt16(tFileInfoStruct->finderFlags);
-				SWAP_POINT(tFileInfoStruct->location);
-				tFileInfoStruct->reservedField=CFSwapInt16(tFileInfoStruct->reservedField);
-				
-				/* Swap ExtendedFileInfo Structure */
-				
-				tExtendedFileInfoStruct=(ExtendedFileInfo *) inFileCatalogInfo->extFinderInfo;
-				
-				tExtendedFileInfoStruct->reserved1[0]=CFSwapInt16(tExtendedFileInfoStruct->reserved1[0]);
-				tExtendedFileInfoStruct->reserved1[1]=CFSwapInt16(tExtendedFileInfoStruct->reserved1[1]);
-				tExtendedFileInfoStruct->reserved1[2]=CFSwapInt16(tExtendedFileInfoStruct->reserved1[2]);
-				tExtendedFileInfoStruct->reserved1[3]=CFSwapInt16(tExtendedFileInfoStruct->reserved1[3]);
-				tExtendedFileInfoStruct->extendedFinderFlags=CFSwapInt16(tExtendedFileInfoStruct->extendedFinderFlags);
-				tExtendedFileInfoStruct->reserved2=CFSwapInt16(tExtendedFileInfoStruct->reserved2);
-				tExtendedFileInfoStruct->putAwayFolderID=CFSwapInt32(tExtendedFileInfoStruct->putAwayFolderID);
-			}
-
-#endif
+				tOptions.dryRunMode=TRUE;
+				break;
 			
-			tRequestCount=16;
-				
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,inFileCatalogInfo->finderInfo,NULL);
-				
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
-				
-			tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tRequestCount,inFileCatalogInfo->extFinderInfo,NULL);
+			case 'd':
+				/* Deduplication */
 				
-			if (tErr!=noErr)
-			{
-				goto writebail;
-			}
-			
-			/* **** Write Resource Fork? */
+				tOptions.deduplicate=TRUE;
+				break;
 			
-			if (tHasResourceFork==TRUE)
-			{
-				/* We need to be clever and copy the Resource Fork by chunks to avoid using too much memory */
+			case 'y':
+				/* Flush the volumes when done */
 				
-				static UInt8 * tBuffer=NULL;
-				static ByteCount tReadRequestCount=0;
-				ByteCount tReadActualCount;
-				OSErr tReadErr;
-
-#define GOLDIN_BUFFER_ONE_MEGABYTE_SIZE		1048576
+				tOptions.syncWhenDone=TRUE;
+				break;
+			
+			case 'k':
+				/* Flush the volume every count ._ files */
 				
-				if (tBuffer==NULL)
 				{
-					tReadRequestCount=GOLDIN_BUFFER_ONE_MEGABYTE_SIZE;
+					char * tEnd;
+					long tCount=strtol(optarg,&tEnd,10);
 					
-					do
+					if (*optarg=='\0' || *tEnd!='\0' || tCount<1)
 					{
-						tBuffer=(UInt8 *) malloc(tReadRequestCount*sizeof(UInt8));
-					
-						tReadRequestCount/=2;
+						logerror("Invalid checkpoint interval: %s\n",optarg);
+						
+						return -1;
 					}
-					while (tBuffer==NULL && tReadRequestCount>1);
 					
-					if (tBuffer!=NULL && tReadRequestCount>1)
-					{
-						tReadRequestCount*=2;
-					}
-					else
-					{
-						/* A COMPLETER */
-					}
+					tOptions.checkpointInterval=(unsigned long) tCount;
+					tOptions.syncWhenDone=TRUE;
+				}
+				break;
+			
+			case 'x':
+			case 'I':
+				/* Exclude or include pattern */
+				
+				if (tFilter==NULL && (tFilter=GoldinFilterCreate())==NULL)
+				{
+					logerror("An error occurred while creating the filter (%s)\n",strerror(errno));
+					
+					return -1;
+				}
+				
+				if (GoldinFilterAddPattern(tFilter,optarg,(ch=='I'))!=0)
+				{
+					logerror("Invalid pattern: %s\n",optarg);
+					
+					return -1;
 				}
+				break;
+			
+			case 'm':
+				/* Maximum depth */
 				
-				do
 				{
-					tReadErr=FSReadFork(tForkRefNum, fsAtMark,0, tReadRequestCount, tBuffer, &tReadActualCount);
+					char * tEnd;
+					long tDepth=strtol(optarg,&tEnd,10);
 					
-					if (tReadErr==noErr || tReadErr==eofErr)
+					if (*optarg=='\0' || *tEnd!='\0' || tDepth<0)
 					{
-						tErr=FSWriteFork(tNewFileRefNum,fsAtMark,0,tReadActualCount,tBuffer,NULL);
+						logerror("Invalid maximum depth: %s\n",optarg);
 						
-						if (tErr!=noErr)
-						{
-							break;
-						}
+						return -1;
 					}
-					else
+					
+					if (tFilter==NULL && (tFilter=GoldinFilterCreate())==NULL)
 					{
-						break;
+						logerror("An error occurred while creating the filter (%s)\n",strerror(errno));
+						
+						return -1;
 					}
-				
-				}
-				while (tReadErr!=eofErr);
-				
-				if (tReadErr!=eofErr)
-				{
-					/* A problem occurred while reading the Resource Fork */
 					
-					goto writebail;
+					GoldinFilterSetMaximumDepth(tFilter,tDepth);
 				}
-				else
-				if (tErr!=noErr)
+				break;
+			
+			case 'o':
+				/* Order of the items */
+				
+				if (GoldinOrderGetNamed(optarg,&tOptions.order)!=0)
 				{
-					/* A problem occurred while writing the Resource Fork Data to the AppleDouble file */
+					logerror("Unknown order: %s\n",optarg);
 					
-					goto writebail;
+					return -1;
 				}
-			}
-		
-			tErr=FSCloseFork(tNewFileRefNum);
-			
-			if (tErr==noErr)
-			{
-                if (outDidSplit!=NULL)
-                    *outDidSplit=TRUE;
-                
-                // A COMPLETER
-            }
-            
-            /* Set the owner */
-			
-			tErr=FSSetCatalogInfo(&tNewFileReference,kFSCatInfoPermissions,inFileCatalogInfo);
+				break;
 			
-			if (tErr!=noErr)
-			{
-				/*logerror("Permissions, owner and group could not be set for the AppleDouble file of %s\n",tPOSIXPath); */
+			case 'w':
+				/* Watch */
 				
-				tErr=-1;
+				tWatch=TRUE;
+				break;
+			
+			case 'V':
+				/* Verify */
 				
-				goto byebye;
-			}
-		}
-		else
-		{
-			/* A COMPLETER */
-		}
-		
-		/* Close the Resource Fork if needed */
-		
-		if (tHasResourceFork==TRUE)
-		{
-			tErr=FSCloseFork(tForkRefNum);
-		
-			if (gStripResourceForks==TRUE && tErr==noErr)
-			{
-				/* Strip the resource fork */
+				tOptions.verifyMode=TRUE;
+				break;
+			
+			case 'P':
+				/* Remove the stale ._ files */
 				
-				tErr=FSDeleteFork(inFileReference,sResourceForkName.length,sResourceForkName.unicode);
+				tOptions.pruneStale=TRUE;
+				break;
+			
+			case 'b':
+			case 'F':
+				/* Rate limits */
 				
-				if (tErr!=noErr)
+				if (ParseRate(optarg,(ch=='b') ? &tOptions.bytesPerSecond : &tOptions.filesPerSecond)!=0)
 				{
-					switch(tErr)
-					{
-						case errFSForkNotFound:
-							/* This is not important */
-							tErr=noErr;
-							break;
-						default:
-							/* A COMPLETER */
-							break;
-					}
+					logerror("Invalid rate: %s\n",optarg);
+					
+					return -1;
 				}
-			}
-			else
-			{
-				if (gStripResourceForks==TRUE && tErr!=noErr)
-				{
-					logerror("Resource Fork could not be stripped from %s\n",tPOSIXPath);
+				break;
+			
+			case 'p':
+				/* I/O priority */
 				
-					/* A COMPLETER */
+				if (GoldinIOPriorityGetNamed(optarg,&tIOPriority)!=0)
+				{
+					logerror("Unknown I/O priority: %s\n",optarg);
+					
+					return -1;
 				}
-			}
+				break;
+			
+			case 'v':
+				/*Verbose */
+			
+				gVerboseMode=TRUE;
+				break;
+			
+			case 'c':
+				/* Counters */
+				
+				gPrintCounters=TRUE;
+				break;
+			
+			case 'u':
+			case '?':
+			default:
+				usage(argv[0]);
+				break;
 		}
 	}
 	
-	return tErr;
+	argv+=optind;
+    argc-=optind;
+    
+	/* -0 alone reads the list from the standard input, like xargs -0 */
+	
+	if (tDelimiter=='\0' && tListPath==NULL)
+		tListPath="-";
 	
-writebail:
-
-	switch(tErr)
+	/* Nothing is written during a dry run or a verification so the folders are listed in parallel unless told otherwise */
+	
+	if (tNumberOfJobs==-1)
 	{
-		case dskFulErr:
-			logerror("Disk is full\n");
-			break;
-		case errFSQuotaExceeded:
-			logerror("Your quota are exceeded\n");
-			break;
-		default:
-			logerror("An unknown error occurred while writing the AppleDouble file of %s\n",tPOSIXPath);
-			break;
+		tNumberOfJobs=1;
+		
+		if (tOptions.dryRunMode==TRUE || tOptions.verifyMode==TRUE)
+		{
+			tNumberOfJobs=sysconf(_SC_NPROCESSORS_ONLN);
+			
+			if (tNumberOfJobs<1)
+				tNumberOfJobs=1;
+		}
 	}
 	
-	FSCloseFork(tNewFileRefNum);
-	
-byebye:
-
-	if (tHasResourceFork==TRUE)
+	if (argc==0 && tListPath==NULL)
 	{
-		FSCloseFork(tForkRefNum);
+		logerror("No file or directory was specified\n");
+		
+		return -1;
 	}
 	
-	return tErr;
-}
-
-void SplitForks(FSRef * inItemReferencePtr)
-{
-	FSCatalogInfo tInfo;
-    HFSUniStr255 tUnicodeFileName;
-    FSRef tParentReference;
-    
-    /* We need to split forks of the first level (and it allows us to check whether it's a folder or not) */
-    
-    OSErr tErr=FSGetCatalogInfo(inItemReferencePtr,kFSCatInfoFinderInfo+kFSCatInfoFinderXInfo+kFSCatInfoPermissions+kFSCatInfoNodeFlags,&tInfo,&tUnicodeFileName,NULL,&tParentReference);
-    
-    if (tErr==noErr)
-    {
-        /* Check this is not a Hard Link */
-        
-        if ((tInfo.nodeFlags & kFSNodeHardLinkMask)==0)
-        {
-            tErr=SplitFileIfNeeded(inItemReferencePtr,&tParentReference,&tInfo,&tUnicodeFileName,NULL);
-            
-            if (tErr==noErr)
-            {
-                if (tInfo.nodeFlags & kFSNodeIsDirectoryMask)
-                {
-                    /* It's a folder */
-                    
-                    /* We need to proceed with the contents of the folder */
-                    
-                    SplitForksChildren(inItemReferencePtr,&tParentReference);
-                }
-            }
-            else
-            {
-                exit(-1);
-            }
-        }
-    }
-    else
-    {
-        logerror("An error occurred while getting Catalog Information for the File\n");
-    }
-}
-
-void SplitForksChildren(FSRef * inFileReferencePtr,FSRef * inParentReferencePtr)
-{
-	FSIterator tIterator;
-    
-	OSErr tErr=FSOpenIterator(inFileReferencePtr,kFSIterateFlat,&tIterator);
+	/* 1. What all the roots share */
+	
+	if (tStatisticsPath!=NULL)
+		GoldinTraceSetEnabled(1);
 	
-	if (tErr==noErr)
+	if (tTracePath!=NULL)
 	{
-		FSRef * tFoundReferences=(FSRef *) malloc(sizeof(FSRef));
+		int tError=GoldinTraceOpen(tTracePath);
 		
-		do
+		if (tError!=0)
 		{
-			ItemCount tFoundItems;
-            
-            tErr=FSGetCatalogInfoBulk(tIterator, 1, &tFoundItems,NULL, 0, NULL,tFoundReferences, NULL, NULL);
+			logerror("Unable to create the trace file %s (%s)\n",tTracePath,strerror(tError));
 			
-			if (tErr==noErr)
-			{
-                FSCatalogInfo tInfo;
-                HFSUniStr255 tUnicodeFileName;
-                
-                /* Retrieve the CatalogInfo with FSGetCatalogInfo because FSGetCatalogInfoBulk is buggy on Yosemite */
-                
-                tErr=FSGetCatalogInfo(&tFoundReferences[0],kFSCatInfoFinderInfo+kFSCatInfoFinderXInfo+kFSCatInfoPermissions+kFSCatInfoNodeFlags,&tInfo,&tUnicodeFileName,NULL,NULL);
-                
-                if (tErr==noErr)
-                {
-                    /* Check this is not a Hard Link */
-                    
-                    if ((tInfo.nodeFlags & kFSNodeHardLinkMask)==0)
-                    {
-                        Boolean tDidSplit=FALSE;
-                        
-                        tErr=SplitFileIfNeeded(&tFoundReferences[0],inFileReferencePtr,&tInfo,&tUnicodeFileName,&tDidSplit);
-                            
-                        if (tErr==noErr)
-                        {
-                            if (tInfo.nodeFlags & kFSNodeIsDirectoryMask)
-                            {				
-                                /* 2. We need to proceed with the contents of the folder */
-                            
-                                SplitForksChildren(&tFoundReferences[0],inFileReferencePtr);
-                            }
-                            
-                            /* 3. Check whether the filesystem item was split (i.e. the valence of the folder changed) */
-                            
-                            if (tDidSplit==TRUE)
-                            {
-                                FSCloseIterator(tIterator);
-                                
-                                tErr=FSOpenIterator(inFileReferencePtr,kFSIterateFlat,&tIterator);
-                                
-                                if (tErr==noErr)
-                                {
-                                    FSRef tPreviousCacheRef=tFoundReferences[0];
-                                    
-                                    do
-                                    {
-                                        tErr=FSGetCatalogInfoBulk(tIterator, 1, &tFoundItems,NULL, 0, NULL,tFoundReferences, NULL, NULL);
-                                        
-                                        if (tErr==noErr)
-                                        {
-                                            OSErr tCompareErr=FSCompareFSRefs(&tPreviousCacheRef,&tFoundReferences[0]);
-                                            
-                                            if (tCompareErr==noErr)
-                                            {
-                                                break;
-                                            }
-                                        }
-                                    }
-                                    while (tErr==noErr);
-                                }
-                            }
-                        }
-                        else
-                        {
-                            exit(-1);
-                        }
-                    }
-                }
-                else
-                {
-                    logerror("An error occurred while getting Catalog Information for the File\n");
-                }
-			}
+			return -1;
 		}
-		while (tErr==noErr);
-		
-		free(tFoundReferences);
+	}
+	
+	/* Before the workers are created so that they inherit it */
+	
+	{
+		int tError=GoldinIOPrioritySet(tIOPriority);
 		
-		FSCloseIterator (tIterator);
+		if (tError!=0)
+			logerror("Unable to lower the I/O priority (%s)\n",strerror(tError));
 	}
 	
-	if (tErr!=noErr)
+	tOptions.backendName=tBackend->name;
+	tOptions.numberOfWorkers=(unsigned long) tNumberOfJobs;
+	tOptions.journalPath=tJournalPath;
+	tOptions.filter=tFilter;
+	tOptions.asynchronousMode=tAsynchronous;
+	tOptions.archiveMode=(tArchivePath!=NULL);
+	
+	sVerify=tOptions.verifyMode;
+	
+	if (gVerboseMode==TRUE)
+		tOptions.progressCallback=PrintProgress;
+	
+	/* The options that can not be combined are reported by GoldinJobCreate and GoldinWatchCreate */
+	
+	tJob=GoldinJobCreate(&tOptions);
+	
+	if (tJob==NULL)
 	{
-		switch(tErr)
-		{
-			case errFSNoMoreItems:
-				/* No more items in the folder, this is perfectly ok */
-				break;
-			case afpAccessDenied:
-				break;
-			default:
-				/* A COMPLETER */
+		if (errno==EINVAL)
+			return -1;
 		
-				break;
-		}
+		if (tJournalPath!=NULL)
+			logerror("An error occurred while opening the journal %s or creating the workers (%s)\n",tJournalPath,strerror(errno));
+		else
+			logerror("An error occurred while creating the workers (%s)\n",strerror(errno));
+		
+		return -1;
 	}
-}
-
-static void usage(const char * inProcessName)
-{
-	printf("usage: %s [-s][-v][-u] <file or directory>\n",inProcessName);
-	printf("       -s  --  Strip resource fork from source after splitting\n");
-	printf("       -v  --  Verbose mode\n");
-	printf("       -u  --  Show usage\n");
 	
-	exit(1);
-}
-
-int main (int argc, const char * argv[])
-{
-    char ch;
+	/* Without io_uring, the ._ files are written as usual */
+	
+	if (tOptions.asynchronousMode==TRUE && GoldinAsyncIsAvailable()==FALSE)
+		logerror("io_uring is not available (%s), the ._ files will be written synchronously\n",strerror(errno));
 	
-	while ((ch = getopt(argc, (char ** const) argv, "svu")) != -1)
+	if (tWatch==TRUE)
 	{
-		switch (ch)
+		sWatch=GoldinWatchCreate(&tOptions);
+		
+		if (sWatch==NULL)
 		{
-			case 's':
-				/* Strip the resource fork */
-				
-				gStripResourceForks=TRUE;
-				break;
-			
-			case 'v':
-				/*Verbose */
+			if (errno!=EINVAL)
+				logerror("Unable to watch the changes (%s)\n",strerror(errno));
 			
-				gVerboseMode=TRUE;
-				break;
-			case 'u':
-			case '?':
-			default:
-				usage(argv[0]);
-				break;
+			return -1;
 		}
 	}
 	
-	argv+=optind;
-    argc-=optind;
-    
-    if (argc != 1)
-    {
-        if (argc==0)
-			logerror("No file or directory was specified\n");
-		else
-			logerror("Only one file or directory may be specified\n");
-		
-		return -1;
-    }
-	else
+	if (tArchivePath!=NULL)
 	{
-		char tResolvedPath[PATH_MAX];
-		
-		if (realpath(argv[0],tResolvedPath)!=NULL)
+		if (strcmp(tArchivePath,"-")!=0)
 		{
-			struct statfs tStatFileSystem;
+			tArchiveDescriptor=open(tArchivePath,O_WRONLY|O_CREAT|O_TRUNC,S_IRUSR|S_IWUSR|S_IRGRP|S_IWGRP|S_IROTH|S_IWOTH);
 			
-			if (statfs(tResolvedPath,&tStatFileSystem)!=0)
+			if (tArchiveDescriptor==-1)
 			{
-				switch(errno)
-				{
-					case ENOTDIR:
-						/* A COMPLETER */
-						break;
-					case ENAMETOOLONG:
-						/* A COMPLETER */
-						break;
-					case ENOENT:
-						/* No such file or directory */
-					
-						logerror("\"%s\" was not found\n",tResolvedPath);
-						break;
-					case EACCES:
-						/* A COMPLETER */
-						break;
-					case EIO:
-						/* A COMPLETER */
-						break;
-					default:
-						/* A COMPLETER */
-						break;
-				}
+				logerror("Unable to create the archive %s (%s)\n",tArchivePath,strerror(errno));
 				
 				return -1;
 			}
+		}
+		
+		tArchive=GoldinArchiveCreate(tArchiveDescriptor);
+		
+		if (tArchive==NULL)
+		{
+			logerror("Unable to create the archive %s (%s)\n",tArchivePath,strerror(errno));
+			
+			return -1;
+		}
+	}
+	
+	if (gVerboseMode==TRUE && tOptions.resume==TRUE)
+		printf("Resuming: %lu records found in %s\n",(unsigned long) GoldinJobGetResumedRecordCount(tJob),tJournalPath);
+	
+	/* 2. The roots of the command line, then the ones of the list */
+	
+	for(i=0;i<argc;i++)
+		tStatus=MergeStatus(tStatus,SplitRoot(tJob,argv[i],tArchive));
+	
+	if (tListPath!=NULL)
+	{
+		FILE * tFile=stdin;
+		
+		if (strcmp(tListPath,"-")!=0)
+			tFile=fopen(tListPath,"r");
+		
+		if (tFile==NULL)
+		{
+			logerror("Unable to open the list %s (%s)\n",tListPath,strerror(errno));
+			
+			tStatus=-1;
+		}
+		else
+		{
+			char * tLine=NULL;
+			size_t tCapacity=0;
+			ssize_t tLength;
 			
-			if (strcmp(tStatFileSystem.f_fstypename,"hfs")!=0)
+			while ((tLength=getdelim(&tLine,&tCapacity,tDelimiter,tFile))!=-1)
 			{
-				/* Return (-2) if this is not a HFS or Extended HFS File System */
+				if (tLength>0 && tLine[tLength-1]==tDelimiter)
+					tLine[--tLength]='\0';
 				
-				logerror("\"%s\" is not on an hfs disk\n",argv[0]);
+				if (tLength==0)
+					continue;
 				
-				return 254;
+				tStatus=MergeStatus(tStatus,SplitRoot(tJob,tLine,tArchive));
 			}
 			
-			gMaxFileNameLength=pathconf(tResolvedPath,_PC_NAME_MAX);
-			
-			if (gMaxFileNameLength<0)
+			if (ferror(tFile)!=0)
 			{
-				logerror("An error occurred while getting the File System Reference maximum length for a file name\n");
+				logerror("An error occurred while reading the list %s\n",tListPath);
 				
-				return -1;
+				tStatus=-1;
 			}
 			
-			gMaxFileNameLength-=2;
+			free(tLine);
 			
-			FSRef tFileReference;
-			OSStatus tErr=FSPathMakeRef((const UInt8 *) tResolvedPath,&tFileReference,NULL);
+			if (tFile!=stdin)
+				fclose(tFile);
+		}
+	}
+	
+	/* 3. Wait for the workers and close everything */
+	
+	if (GoldinJobFinish(tJob)!=0)
+		tStatus=-1;
+	
+	GoldinJobGetStatistics(tJob,&tStatistics);
+	
+	if (tOptions.deduplicate==TRUE)
+		printf("Deduplication: %llu ._ files shared, %llu bytes saved\n",(unsigned long long) tStatistics.deduplicatedItems,(unsigned long long) GoldinCounterGetValue(kGoldinCounterBytesDeduplicated));
+	
+	if (tOptions.pruneStale==TRUE)
+		printf("Cleanup: %llu stale ._ files removed\n",(unsigned long long) tStatistics.removedItems);
+	
+	if (tFilter!=NULL)
+	{
+		/* The archive can be written to the standard output */
 		
-			if (tErr!=noErr)
-			{
-				logerror("An error occurred while getting the File System Reference of %s\n",argv[0]);
-				
-				return -1;
-			}
+		fprintf((tArchive!=NULL) ? stderr : stdout,"Pruning: %llu items skipped\n",(unsigned long long) tStatistics.prunedItems);
+	}
+	
+	if (tArchive!=NULL)
+	{
+		int tError=GoldinArchiveFinish(tArchive);
+		
+		GoldinArchiveRelease(tArchive);
+		
+		if (tArchiveDescriptor!=STDOUT_FILENO && close(tArchiveDescriptor)!=0 && tError==0)
+			tError=errno;
+		
+		if (tError!=0)
+		{
+			logerror("An error occurred while writing the archive (%s)\n",strerror(tError));
 			
-			if (gVerboseMode==TRUE)
-				printf("Splitting %s...\n",argv[0]);
+			tStatus=-1;
+		}
+	}
+	
+	if (tOptions.dryRunMode==TRUE)
+		GoldinEstimatePrint(GoldinJobGetEstimate(tJob),stdout);
+	
+	if (tOptions.verifyMode==TRUE)
+	{
+		printf("Verification: %llu ._ files match, %llu mismatched, %llu missing, %llu orphaned\n",(unsigned long long) tStatistics.verifiedItems,(unsigned long long) tStatistics.mismatchedItems,(unsigned long long) tStatistics.missingItems,(unsigned long long) tStatistics.orphanedItems);
+		
+		/* 1 if some ._ files need to be split again or deleted */
+		
+		if (tStatistics.mismatchedItems>0 || tStatistics.missingItems>0 || tStatistics.orphanedItems>0)
+			tStatus=MergeStatus(tStatus,1);
+	}
+	
+	GoldinJobRelease(tJob);
+	
+	/* 4. Keep the ._ files up to date until interrupted */
+	
+	if (sWatch!=NULL)
+	{
+		struct sigaction tAction;
+		GoldinJobStatistics tWatchStatistics;
+		int tError;
+		
+		memset(&tAction,0,sizeof(tAction));
+		tAction.sa_handler=StopWatching;
+		sigemptyset(&tAction.sa_mask);
+		
+		sigaction(SIGINT,&tAction,NULL);
+		sigaction(SIGTERM,&tAction,NULL);
+		
+		if (gVerboseMode==TRUE)
+		{
+			printf("Watching for changes...\n");
+			fflush(stdout);
+		}
+		
+		tError=GoldinWatchRun(sWatch);
+		
+		if (tError!=0)
+		{
+			logerror("An error occurred while watching the changes (%s)\n",strerror(tError));
 			
-			SplitForks(&tFileReference);
+			tStatus=-1;
+		}
+		
+		GoldinWatchGetStatistics(sWatch,&tWatchStatistics);
+		
+		if (gVerboseMode==TRUE)
+			printf("Watching: %llu ._ files written, %llu up to date\n",(unsigned long long) (tWatchStatistics.splitItems+tWatchStatistics.linkedItems),(unsigned long long) tWatchStatistics.upToDateItems);
+		
+		GoldinWatchRelease(sWatch);
+		
+		sWatch=NULL;
+	}
+	
+	GoldinFilterRelease(tFilter);
+	
+	if (gPrintCounters==TRUE)
+		GoldinCountersPrint(stderr);
+	
+	if (tTracePath!=NULL && GoldinTraceClose()!=0)
+		logerror("An error occurred while writing the trace file %s\n",tTracePath);
+	
+	if (tStatisticsPath!=NULL)
+	{
+		FILE * tFile=stderr;
+		
+		if (strcmp(tStatisticsPath,"-")!=0)
+			tFile=fopen(tStatisticsPath,"w");
+		
+		if (tFile==NULL)
+		{
+			logerror("Unable to create the statistics file %s (%s)\n",tStatisticsPath,strerror(errno));
 		}
 		else
 		{
-			switch(errno)
-			{
-				case ENOENT:
-					/* No such file or directory */
-					
-					logerror("\"%s\" was not found\n",argv[0]);
-					break;
-				
-				/* A COMPLETER */
-				
-				default:
-					/* A COMPLETER */
-					break;
-			}
+			GoldinTracePrintStatistics(tFile);
 			
-			return -1;
+			if (tFile!=stderr)
+				fclose(tFile);
 		}
 	}
 	
-    return 0;
+	return tStatus;
 }